@@ -0,0 +1,62 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * aabb.c
+ * Benchmarks aabb.h bounds against merging one point at a time
+ *
+ */
+
+#include "bench.h"
+#include <gmath/aabb.h>
+
+#define POINTS 65536
+#define BOXES 65536
+
+/* The usual loop, one aabb_merge_point per point. */
+static aabb bounds_merge(const vec3 *p, int count)
+{
+	aabb out = aabb_empty();
+	for (int i = 0; i < count; i++)
+		out = aabb_merge_point(out, p[i]);
+	return out;
+}
+
+int main(void)
+{
+	vec3 *p = malloc(sizeof(vec3) * POINTS);
+	aabb *a = malloc(sizeof(aabb) * BOXES), *t = malloc(sizeof(aabb) * BOXES);
+	mat4 m = mat4_from_angles(0.3f, -0.7f, 1.1f);
+	unsigned int seed = 1;
+	volatile float sink = 0.0f;
+	aabb b;
+
+	/* a mesh sized cloud of points, and boxes scattered through it */
+	for (int i = 0; i < POINTS; i++)
+		p[i] = _mm_setr_ps(bench_randf(&seed) * 20.0f - 10.0f,
+			bench_randf(&seed) * 4.0f, bench_randf(&seed) * 6.0f - 3.0f,
+			0.0f);
+	for (int i = 0; i < BOXES; i++) {
+		a[i].min = p[i];
+		a[i].max = _mm_add_ps(p[i], _mm_set1_ps(bench_randf(&seed)));
+	}
+	m.col[0] = _mm_mul_ps(m.col[0], _mm_set1_ps(2.0f));
+	m.col[3] = _mm_setr_ps(5.0f, -1.0f, 3.0f, 1.0f);
+	b = aabb_from_points(p, POINTS);
+	printf("bounds of %d points, x from %.2f to %.2f\n", POINTS,
+		fidx(b.min, 0), fidx(b.max, 0));
+
+	BENCH("aabb_merge_point loop, points", POINTS,
+		b = bounds_merge(p, POINTS); sink += fidx(b.max, 0));
+	BENCH("aabb_from_points, points", POINTS,
+		b = aabb_from_points(p, POINTS); sink += fidx(b.max, 0));
+	BENCH("aabb_transform_array, boxes", BOXES,
+		aabb_transform_array(t, m, a, BOXES); sink += fidx(t[0].max, 0));
+
+	free(p);
+	free(a);
+	free(t);
+	(void)sink;
+	return 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * anim.c
+ * Benchmarks anim.h against per bone key search and slerp
+ *
+ */
+
+#include "bench.h"
+#include <gmath/anim.h>
+
+#define TRACKS 128
+#define FRAMES 300
+#define INSTANCES 64
+
+/* The usual uncompressed path: search the keys, slerp and lerp. */
+static void sample_keys(const float *times, const quat *rot,
+		const vec3 *trans, float time, quat *out_rot, vec3 *out_trans)
+{
+	for (int i = 0; i < TRACKS; i++) {
+		int lo = 0, hi = FRAMES - 1;
+		while (hi - lo > 1) {
+			int mid = (lo + hi) / 2;
+			if (times[mid] <= time)
+				lo = mid;
+			else
+				hi = mid;
+		}
+		float t = (time - times[lo]) / (times[hi] - times[lo]);
+		t = t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+		out_rot[i] = quat_slerp(rot[lo * TRACKS + i], rot[hi * TRACKS + i], t);
+		out_trans[i] = vec4_lerp(trans[lo * TRACKS + i],
+			trans[hi * TRACKS + i], t);
+	}
+}
+
+int main(void)
+{
+	unsigned int seed = 1;
+	float *times = malloc(sizeof(float) * FRAMES);
+	float sample[INSTANCES];
+	quat *rot = malloc(sizeof(quat) * FRAMES * TRACKS);
+	vec3 *trans = malloc(sizeof(vec3) * FRAMES * TRACKS);
+	quat *out_rot = malloc(sizeof(quat) * TRACKS);
+	vec3 *out_trans = malloc(sizeof(vec3) * TRACKS);
+	anim_clip clip;
+
+	for (int f = 0; f < FRAMES; f++) {
+		times[f] = f / 30.0f;
+		for (int i = 0; i < TRACKS; i++) {
+			rot[f * TRACKS + i] = quat_normalize(_mm_setr_ps(
+				sinf(0.05f * f + i), cosf(0.03f * f * i), 0.2f, 1.0f));
+			trans[f * TRACKS + i] = _mm_setr_ps(bench_randf(&seed),
+				bench_randf(&seed), bench_randf(&seed), 0.0f);
+		}
+	}
+	for (int i = 0; i < INSTANCES; i++)
+		sample[i] = bench_randf(&seed) * times[FRAMES - 1];
+	anim_clip_build(&clip, rot, trans, TRACKS, FRAMES, 30.0f);
+
+	printf("animation sampling, %d tracks, %d frames, %d instances\n",
+		TRACKS, FRAMES, INSTANCES);
+	printf("keys %zu bytes, clip %zu bytes\n",
+		(sizeof(quat) + sizeof(vec3) + sizeof(float)) * FRAMES * TRACKS,
+		clip.segment_size * clip.segments);
+	BENCH("search+slerp+lerp", TRACKS * INSTANCES,
+		for (int i = 0; i < INSTANCES; i++)
+			sample_keys(times, rot, trans, sample[i], out_rot, out_trans));
+	BENCH("anim_sample", TRACKS * INSTANCES,
+		for (int i = 0; i < INSTANCES; i++)
+			anim_sample(&clip, sample[i], out_rot, out_trans));
+
+	anim_clip_free(&clip);
+	free(times);
+	free(rot);
+	free(trans);
+	free(out_rot);
+	free(out_trans);
+	return 0;
+}
@@ -0,0 +1,48 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * bench.h
+ * Timing helpers shared by the benchmarks
+ *
+ */
+
+#ifndef _GMATH_BENCH_H_
+#define _GMATH_BENCH_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static inline double bench_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Deterministic xorshift so runs are comparable. */
+static inline float bench_randf(unsigned int *seed)
+{
+	unsigned int x = *seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*seed = x;
+	return (x & 0xffffff) / (float)0x1000000;
+}
+
+/* Runs STMT for at least 0.25s and prints ITEMS per second. */
+#define BENCH(NAME, ITEMS, STMT) do { \
+	double b_start = bench_now(), b_end; \
+	long b_iter = 0; \
+	do { \
+		STMT; \
+		b_iter++; \
+	} while ((b_end = bench_now()) - b_start < 0.25); \
+	printf("%-32s %10.2f M/s\n", NAME, \
+		(double)(ITEMS) * b_iter / (b_end - b_start) * 1e-6); \
+} while (0)
+
+#endif /* _GMATH_BENCH_H_ */
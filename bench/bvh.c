@@ -0,0 +1,167 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * bvh.c
+ * Benchmarks bvh.h builds and queries on a generated terrain mesh
+ *
+ */
+
+#include <pthread.h>
+#include "bench.h"
+#include <gmath/bvh.h>
+
+/* Two triangles per grid cell, 1048352 in all. */
+#define GRID 724
+#define TRIS (2 * GRID * GRID)
+#define RAYS 65536
+#define THREADS 4
+
+typedef struct {
+	bvh_builder *b;
+	int *next;
+} worker;
+
+/* Workers take tasks from a shared counter until none are left. */
+static void *worker_build(void *arg)
+{
+	worker *w = arg;
+	int t;
+	while ((t = __sync_fetch_and_add(w->next, 1)) < w->b->tasks)
+		bvh_build_task(w->b, t);
+	return NULL;
+}
+
+static void build_threaded(bvh *tree, const aabb *boxes, int count)
+{
+	pthread_t thread[THREADS];
+	bvh_builder b;
+	worker w;
+	int next = 0;
+
+	bvh_build_begin(&b, boxes, count, THREADS * 4);
+	w.b = &b;
+	w.next = &next;
+	for (int i = 0; i < THREADS; i++)
+		pthread_create(&thread[i], NULL, worker_build, &w);
+	for (int i = 0; i < THREADS; i++)
+		pthread_join(thread[i], NULL);
+	bvh_build_end(&b, tree);
+}
+
+static vec3 height(int x, int z, float phase)
+{
+	float fx = x * 0.25f, fz = z * 0.25f;
+	float y = sinf(fx * 0.13f + phase) * 6.0f + cosf(fz * 0.07f) * 9.0f +
+		sinf((fx + fz) * 0.9f) * 0.5f;
+	return _mm_setr_ps(fx, y, fz, 0.0f);
+}
+
+static void make_mesh(vec3 *v0, vec3 *v1, vec3 *v2, float phase)
+{
+	for (int z = 0; z < GRID; z++)
+		for (int x = 0; x < GRID; x++) {
+			int i = 2 * (z * GRID + x);
+			vec3 a = height(x, z, phase), b = height(x + 1, z, phase);
+			vec3 c = height(x, z + 1, phase), d = height(x + 1, z + 1, phase);
+			v0[i] = a;
+			v1[i] = b;
+			v2[i] = c;
+			v0[i + 1] = b;
+			v1[i + 1] = d;
+			v2[i + 1] = c;
+		}
+}
+
+int main(void)
+{
+	unsigned int seed = 1;
+	vec3 *v0 = malloc(sizeof(vec3) * TRIS);
+	vec3 *v1 = malloc(sizeof(vec3) * TRIS);
+	vec3 *v2 = malloc(sizeof(vec3) * TRIS);
+	aabb *boxes = malloc(sizeof(aabb) * TRIS);
+	ray *rays = malloc(sizeof(ray) * RAYS);
+	ray *coherent = malloc(sizeof(ray) * RAYS);
+	volatile int sink = 0;
+	double start;
+	bvh tree;
+
+	make_mesh(v0, v1, v2, 0.0f);
+	bvh_triangle_boxes(boxes, v0, v1, v2, TRIS);
+	/* rays from above at grazing to steep angles, most hit */
+	for (int i = 0; i < RAYS; i++) {
+		float s = GRID * 0.25f;
+		rays[i].origin = _mm_setr_ps(bench_randf(&seed) * s, 30.0f,
+			bench_randf(&seed) * s, 0.0f);
+		rays[i].dir = vec3_normalize(_mm_setr_ps(bench_randf(&seed) - 0.5f,
+			-0.1f - bench_randf(&seed), bench_randf(&seed) - 0.5f, 0.0f));
+	}
+	/* a camera's worth in raster order, neighbours share nodes */
+	for (int i = 0; i < RAYS; i++) {
+		float x = (i % 256) / 256.0f - 0.5f, y = (i / 256) / 256.0f - 0.5f;
+		coherent[i].origin = _mm_setr_ps(10.0f, 25.0f, 10.0f, 0.0f);
+		coherent[i].dir = vec3_normalize(_mm_setr_ps(1.0f + x, -0.4f + y,
+			1.0f - x, 0.0f));
+	}
+
+	bvh_build(&tree, boxes, TRIS);
+	printf("bvh, %d triangles, %d nodes of %d\n", TRIS, tree.nodes,
+		BVH_WIDTH);
+	BENCH("bvh_build", TRIS, bvh_free(&tree); bvh_build(&tree, boxes, TRIS));
+	BENCH("bvh_build, 4 threads", TRIS,
+		bvh_free(&tree); build_threaded(&tree, boxes, TRIS));
+
+	/* the linear scan is far too slow for M/s, time a few rays */
+	start = bench_now();
+	for (int i = 0; i < 16; i++) {
+		float t, u, v;
+		sink += ray_triangles_closest(&rays[i], v0, v1, v2, TRIS, 1e30f,
+			&t, &u, &v);
+	}
+	printf("%-32s %10.2f ms/ray\n", "ray_triangles_closest, brute",
+		(bench_now() - start) / 16 * 1e3);
+	BENCH("bvh_closest_triangle, random", RAYS,
+		for (int i = 0; i < RAYS; i++) {
+			float t;
+			float u;
+			float v;
+			sink += bvh_closest_triangle(&tree, v0, v1, v2, &rays[i],
+				1e30f, &t, &u, &v);
+		});
+	BENCH("bvh_any_triangle, random", RAYS,
+		for (int i = 0; i < RAYS; i++)
+			sink += bvh_any_triangle(&tree, v0, v1, v2, &rays[i], 1e30f));
+	BENCH("bvh_closest_triangle, coherent", RAYS,
+		for (int i = 0; i < RAYS; i++) {
+			float t;
+			float u;
+			float v;
+			sink += bvh_closest_triangle(&tree, v0, v1, v2, &coherent[i],
+				1e30f, &t, &u, &v);
+		});
+	BENCH("bvh_any_triangle, coherent", RAYS,
+		for (int i = 0; i < RAYS; i++)
+			sink += bvh_any_triangle(&tree, v0, v1, v2, &coherent[i],
+				1e30f));
+
+	make_mesh(v0, v1, v2, 1.0f);
+	BENCH("bvh_refit_triangles", TRIS, bvh_refit_triangles(&tree, v0, v1, v2));
+	BENCH("bvh_closest_triangle, coherent refit", RAYS,
+		for (int i = 0; i < RAYS; i++) {
+			float t;
+			float u;
+			float v;
+			sink += bvh_closest_triangle(&tree, v0, v1, v2, &coherent[i],
+				1e30f, &t, &u, &v);
+		});
+
+	bvh_free(&tree);
+	free(v0);
+	free(v1);
+	free(v2);
+	free(boxes);
+	free(rays);
+	free(coherent);
+	return 0;
+}
@@ -0,0 +1,74 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * frustum.c
+ * Benchmarks frustum.h against a per object plane loop
+ *
+ */
+
+#include "bench.h"
+#include <gmath/frustum.h>
+
+#define OBJECTS 1048576
+
+/* The usual loop, one vec4_dot per plane with an early out. */
+static int cull_dot(const frustum *f, const vec4 *s, int count, int *visible)
+{
+	__m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	__m128 w = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+	int n = 0;
+	for (int i = 0; i < count; i++) {
+		vec4 c = _mm_or_ps(_mm_and_ps(s[i], xyz), w);
+		int in = 1;
+		for (int p = 0; p < 6 && in; p++)
+			in = vec4_dot(f->plane[p], c) >= -fidx(s[i], 3);
+		if (in)
+			visible[n++] = i;
+	}
+	return n;
+}
+
+int main(void)
+{
+	unsigned int seed = 1;
+	mat4 proj = {{{1.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f, 0.0f},
+		{0.0f, 0.0f, -1.002f, -1.0f}, {0.0f, 0.0f, -0.2002f, 0.0f}}};
+	vec4 *s = malloc(sizeof(vec4) * OBJECTS);
+	aabb *b = malloc(sizeof(aabb) * OBJECTS);
+	int *visible = malloc(sizeof(int) * OBJECTS);
+	unsigned char *mask = malloc(OBJECTS / 8);
+	frustum f = frustum_from_mat4(proj);
+	int n;
+
+	/* objects all around the camera, about a quarter visible */
+	for (int i = 0; i < OBJECTS; i++) {
+		vec4 c = _mm_setr_ps(bench_randf(&seed) * 200.0f - 100.0f,
+			bench_randf(&seed) * 200.0f - 100.0f,
+			bench_randf(&seed) * 200.0f - 100.0f, 0.0f);
+		float r = bench_randf(&seed) * 2.0f;
+		s[i] = _mm_add_ps(c, _mm_setr_ps(0.0f, 0.0f, 0.0f, r));
+		b[i].min = _mm_sub_ps(c, _mm_set1_ps(r));
+		b[i].max = _mm_add_ps(c, _mm_set1_ps(r));
+	}
+
+	n = frustum_cull_spheres(&f, s, OBJECTS, visible);
+	printf("frustum culling, %d objects, %d spheres visible (%d)\n",
+		OBJECTS, n, cull_dot(&f, s, OBJECTS, visible));
+	BENCH("vec4_dot loop, spheres", OBJECTS, cull_dot(&f, s, OBJECTS, visible));
+	BENCH("frustum_cull_spheres", OBJECTS,
+		frustum_cull_spheres(&f, s, OBJECTS, visible));
+	BENCH("frustum_cull_spheres_mask", OBJECTS,
+		frustum_cull_spheres_mask(&f, s, OBJECTS, mask));
+	BENCH("frustum_cull_aabbs", OBJECTS,
+		frustum_cull_aabbs(&f, b, OBJECTS, visible));
+	BENCH("frustum_cull_aabbs_mask", OBJECTS,
+		frustum_cull_aabbs_mask(&f, b, OBJECTS, mask));
+
+	free(s);
+	free(b);
+	free(visible);
+	free(mask);
+	return 0;
+}
@@ -0,0 +1,92 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * gjk.c
+ * Benchmarks gjk.h queries over pairs of mixed convex shapes
+ *
+ */
+
+#include "bench.h"
+#include <gmath/gjk.h>
+
+#define PAIRS 16384
+
+static vec3 hull[32];
+
+/* Random shapes of kind % 4: box, capsule, sphere or hull. */
+static gjk_shape make_shape(unsigned int *seed, int kind, float spread)
+{
+	vec3 p = _mm_setr_ps((bench_randf(seed) - 0.5f) * spread,
+		(bench_randf(seed) - 0.5f) * spread,
+		(bench_randf(seed) - 0.5f) * spread, 0.0f);
+	quat q = quat_normalize(_mm_setr_ps(bench_randf(seed) - 0.5f,
+		bench_randf(seed) - 0.5f, bench_randf(seed) - 0.5f,
+		bench_randf(seed) - 0.5f));
+	vec3 h = _mm_setr_ps(0.3f + bench_randf(seed), 0.3f + bench_randf(seed),
+		0.3f + bench_randf(seed), 0.0f);
+	switch (kind % 4) {
+	case 0:
+		return gjk_box(p, q, h);
+	case 1:
+		return gjk_capsule(p, q, fidx(h, 0), fidx(h, 1) * 0.5f);
+	case 2:
+		return gjk_sphere(p, fidx(h, 2));
+	default:
+		return gjk_hull(p, q, hull, 32);
+	}
+}
+
+static void run(const char *name, const gjk_shape *a, const gjk_shape *b,
+		gjk_contact *out)
+{
+	volatile float sink = 0.0f;
+	int overlaps = 0;
+
+	for (int i = 0; i < PAIRS; i++)
+		overlaps += gjk_distance(&a[i], &b[i], NULL) <= 0.0f;
+	printf("%s, %d%% overlapping\n", name, overlaps * 100 / PAIRS);
+	BENCH("  gjk_overlap", PAIRS,
+		for (int i = 0; i < PAIRS; i++)
+			sink += gjk_overlap(&a[i], &b[i]));
+	BENCH("  gjk_distance", PAIRS,
+		for (int i = 0; i < PAIRS; i++)
+			gjk_distance(&a[i], &b[i], &out[i]));
+	(void)sink;
+}
+
+int main(void)
+{
+	unsigned int seed = 1;
+	gjk_shape *a = malloc(sizeof(gjk_shape) * PAIRS);
+	gjk_shape *b = malloc(sizeof(gjk_shape) * PAIRS);
+	gjk_contact *out = malloc(sizeof(gjk_contact) * PAIRS);
+
+	for (int i = 0; i < 32; i++)
+		hull[i] = vec3_scale(vec3_normalize(_mm_setr_ps(
+			bench_randf(&seed) - 0.5f, bench_randf(&seed) - 0.5f,
+			bench_randf(&seed) - 0.5f, 0.0f)), 0.8f);
+
+	/* broadphase pairs: close, a third or so touching */
+	for (int i = 0; i < PAIRS; i++) {
+		a[i] = make_shape(&seed, i % 3, 0.0f);
+		b[i] = make_shape(&seed, i / 3 % 3, 5.0f);
+	}
+	run("boxes, capsules and spheres", a, b, out);
+	for (int i = 0; i < PAIRS; i++) {
+		a[i] = make_shape(&seed, 0, 0.0f);
+		b[i] = make_shape(&seed, 0, 5.0f);
+	}
+	run("boxes", a, b, out);
+	for (int i = 0; i < PAIRS; i++) {
+		a[i] = make_shape(&seed, i % 4, 0.0f);
+		b[i] = make_shape(&seed, 3, 5.0f);
+	}
+	run("hulls of 32 points against all", a, b, out);
+
+	free(a);
+	free(b);
+	free(out);
+	return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * grid.c
+ * Benchmarks grid.h builds and radius queries over a million points
+ *
+ */
+
+#include <pthread.h>
+#include "bench.h"
+#include <gmath/grid.h>
+
+#define POINTS (1 << 20)
+#define QUERIES 65536
+#define THREADS 4
+
+typedef struct {
+	grid_builder *b;
+	int t;
+	int scatter;
+} worker;
+
+static void *worker_build(void *arg)
+{
+	worker *w = arg;
+	if (w->scatter)
+		grid_build_scatter(w->b, w->t);
+	else
+		grid_build_count(w->b, w->t);
+	return NULL;
+}
+
+/* One thread per task for each pass, the offsets in between. */
+static void build_threaded(grid *g, const vec3 *points, int count, float cell)
+{
+	pthread_t thread[THREADS];
+	worker w[THREADS];
+	grid_builder b;
+
+	grid_build_begin(&b, g, points, count, cell, THREADS);
+	for (int pass = 0; pass < 2; pass++) {
+		if (pass)
+			grid_build_offsets(&b);
+		for (int i = 0; i < THREADS; i++) {
+			w[i].b = &b;
+			w[i].t = i;
+			w[i].scatter = pass;
+			pthread_create(&thread[i], NULL, worker_build, &w[i]);
+		}
+		for (int i = 0; i < THREADS; i++)
+			pthread_join(thread[i], NULL);
+	}
+	grid_build_end(&b);
+}
+
+int main(void)
+{
+	unsigned int seed = 1;
+	vec3 *points = malloc(sizeof(vec3) * POINTS);
+	vec3 *queries = malloc(sizeof(vec3) * QUERIES);
+	int *out = malloc(sizeof(int) * POINTS);
+	float side = 100.0f, radius = 2.0f;
+	volatile int sink = 0;
+	double start;
+	long found = 0;
+	grid g;
+
+	/* about one point per unit cube, 33 within the radius */
+	for (int i = 0; i < POINTS; i++)
+		points[i] = _mm_setr_ps(bench_randf(&seed) * side,
+			bench_randf(&seed) * side, bench_randf(&seed) * side, 0.0f);
+	for (int i = 0; i < QUERIES; i++)
+		queries[i] = points[(int)(bench_randf(&seed) * POINTS)];
+
+	grid_build(&g, points, POINTS, radius);
+	for (int i = 0; i < QUERIES; i++)
+		found += grid_radius(&g, queries[i], radius, out, POINTS);
+	printf("grid, %d points, radius %.1f, %.1f found per query\n", POINTS,
+		radius, (double)found / QUERIES);
+	BENCH("grid_build", POINTS,
+		grid_free(&g); grid_build(&g, points, POINTS, radius));
+	BENCH("grid_build, 4 threads", POINTS,
+		grid_free(&g); build_threaded(&g, points, POINTS, radius));
+
+	start = bench_now();
+	for (int q = 0; q < 16; q++) {
+		int n = 0;
+		for (int i = 0; i < POINTS; i++) {
+			vec3 d = vec3_sub(points[i], queries[q]);
+			n += vec3_dot(d, d) <= radius * radius;
+		}
+		sink += n;
+	}
+	printf("%-32s %10.2f ms/query\n", "linear scan",
+		(bench_now() - start) / 16 * 1e3);
+	BENCH("grid_radius, cell = r", QUERIES,
+		for (int i = 0; i < QUERIES; i++)
+			sink += grid_radius(&g, queries[i], radius, out, POINTS));
+	grid_free(&g);
+	grid_build(&g, points, POINTS, radius * 2.0f);
+	BENCH("grid_radius, cell = 2r", QUERIES,
+		for (int i = 0; i < QUERIES; i++)
+			sink += grid_radius(&g, queries[i], radius, out, POINTS));
+	/* every point in grid order, neighbours share buckets */
+	BENCH("grid_radius, all in grid order", POINTS,
+		for (int i = 0; i < POINTS; i++)
+			sink += grid_radius(&g, _mm_setr_ps(g.x[i], g.y[i], g.z[i], 0.0f),
+				radius, out, POINTS));
+
+	grid_free(&g);
+	free(points);
+	free(queries);
+	free(out);
+	return 0;
+}
@@ -0,0 +1,168 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * lbvh.c
+ * Benchmarks lbvh.h rebuilds and packet traversal on a terrain mesh
+ *
+ */
+
+#include <pthread.h>
+#include "bench.h"
+#include <gmath/lbvh.h>
+
+/* Two triangles per grid cell, 1048352 in all. */
+#define GRID 724
+#define TRIS (2 * GRID * GRID)
+#define RAYS 65536
+#define THREADS 4
+
+typedef struct {
+	lbvh_builder *lb;
+	int t;
+	int pass;
+} worker;
+
+static void *worker_build(void *arg)
+{
+	worker *w = arg;
+	if (w->pass)
+		lbvh_build_bounds(w->lb, w->t);
+	else
+		lbvh_build_nodes(w->lb, w->t);
+	return NULL;
+}
+
+/* One thread per task for each pass, the subtree pick in between. */
+static void build_threaded(bvh *tree, const aabb *boxes, int count)
+{
+	pthread_t thread[THREADS];
+	worker w[THREADS];
+	lbvh_builder lb;
+
+	lbvh_build_begin(&lb, boxes, count, THREADS);
+	for (int pass = 0; pass < 2; pass++) {
+		if (pass)
+			lbvh_build_subtrees(&lb);
+		for (int i = 0; i < THREADS; i++) {
+			w[i].lb = &lb;
+			w[i].t = i;
+			w[i].pass = pass;
+			pthread_create(&thread[i], NULL, worker_build, &w[i]);
+		}
+		for (int i = 0; i < THREADS; i++)
+			pthread_join(thread[i], NULL);
+	}
+	lbvh_build_end(&lb, tree);
+}
+
+static vec3 height(int x, int z, float phase)
+{
+	float fx = x * 0.25f, fz = z * 0.25f;
+	float y = sinf(fx * 0.13f + phase) * 6.0f + cosf(fz * 0.07f) * 9.0f +
+		sinf((fx + fz) * 0.9f) * 0.5f;
+	return _mm_setr_ps(fx, y, fz, 0.0f);
+}
+
+static void make_mesh(vec3 *v0, vec3 *v1, vec3 *v2, float phase)
+{
+	for (int z = 0; z < GRID; z++)
+		for (int x = 0; x < GRID; x++) {
+			int i = 2 * (z * GRID + x);
+			vec3 a = height(x, z, phase), b = height(x + 1, z, phase);
+			vec3 c = height(x, z + 1, phase), d = height(x + 1, z + 1, phase);
+			v0[i] = a;
+			v1[i] = b;
+			v2[i] = c;
+			v0[i + 1] = b;
+			v1[i + 1] = d;
+			v2[i + 1] = c;
+		}
+}
+
+static int trace(const bvh *tree, const vec3 *v0, const vec3 *v1,
+		const vec3 *v2, const ray *rays)
+{
+	int hits = 0;
+	for (int i = 0; i < RAYS; i++) {
+		float t, u, v;
+		hits += bvh_closest_triangle(tree, v0, v1, v2, &rays[i], 1e30f,
+			&t, &u, &v) >= 0;
+	}
+	return hits;
+}
+
+static int trace4(const bvh *tree, const vec3 *v0, const vec3 *v1,
+		const vec3 *v2, const ray *rays)
+{
+	int hits = 0;
+	for (int i = 0; i < RAYS; i += 4) {
+		int prim[4];
+		float t[4], u[4], v[4];
+		hits += __builtin_popcount(bvh_closest_triangle4(tree, v0, v1, v2,
+			&rays[i], 1e30f, prim, t, u, v));
+	}
+	return hits;
+}
+
+int main(void)
+{
+	vec3 *v0 = malloc(sizeof(vec3) * TRIS);
+	vec3 *v1 = malloc(sizeof(vec3) * TRIS);
+	vec3 *v2 = malloc(sizeof(vec3) * TRIS);
+	aabb *boxes = malloc(sizeof(aabb) * TRIS);
+	ray *coherent = malloc(sizeof(ray) * RAYS);
+	volatile int sink = 0;
+	double start, times[4];
+	lbvh_builder lb;
+	bvh tree, sah;
+
+	make_mesh(v0, v1, v2, 0.0f);
+	bvh_triangle_boxes(boxes, v0, v1, v2, TRIS);
+	/* a camera's worth in 2x2 pixel quads, each quad a packet */
+	for (int i = 0; i < RAYS; i++) {
+		int q = i / 4, px = (q % 128) * 2 + (i & 1);
+		int py = (q / 128) * 2 + ((i >> 1) & 1);
+		float x = px / 256.0f - 0.5f, y = py / 256.0f - 0.5f;
+		coherent[i].origin = _mm_setr_ps(10.0f, 25.0f, 10.0f, 0.0f);
+		coherent[i].dir = vec3_normalize(_mm_setr_ps(1.0f + x, -0.4f + y,
+			1.0f - x, 0.0f));
+	}
+
+	start = bench_now();
+	lbvh_build_begin(&lb, boxes, TRIS, 1);
+	times[0] = bench_now();
+	lbvh_build_nodes(&lb, 0);
+	times[1] = bench_now();
+	lbvh_build_subtrees(&lb);
+	lbvh_build_bounds(&lb, 0);
+	times[2] = bench_now();
+	lbvh_build_end(&lb, &tree);
+	times[3] = bench_now();
+	printf("lbvh, %d triangles, %d nodes of %d\n", TRIS, tree.nodes,
+		BVH_WIDTH);
+	printf("sort %.1f ms, nodes %.1f ms, bounds %.1f ms, collapse %.1f ms\n",
+		(times[0] - start) * 1e3, (times[1] - times[0]) * 1e3,
+		(times[2] - times[1]) * 1e3, (times[3] - times[2]) * 1e3);
+	BENCH("lbvh_build", TRIS, bvh_free(&tree); lbvh_build(&tree, boxes, TRIS));
+	BENCH("lbvh_build, 4 threads", TRIS,
+		bvh_free(&tree); build_threaded(&tree, boxes, TRIS));
+	BENCH("bvh_build", TRIS, bvh_build(&sah, boxes, TRIS); bvh_free(&sah));
+	bvh_build(&sah, boxes, TRIS);
+
+	BENCH("lbvh, single rays", RAYS, sink += trace(&tree, v0, v1, v2, coherent));
+	BENCH("lbvh, packets of 4", RAYS,
+		sink += trace4(&tree, v0, v1, v2, coherent));
+	BENCH("bvh, single rays", RAYS, sink += trace(&sah, v0, v1, v2, coherent));
+	BENCH("bvh, packets of 4", RAYS, sink += trace4(&sah, v0, v1, v2, coherent));
+
+	bvh_free(&tree);
+	bvh_free(&sah);
+	free(v0);
+	free(v1);
+	free(v2);
+	free(boxes);
+	free(coherent);
+	return 0;
+}
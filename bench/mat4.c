@@ -0,0 +1,53 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * mat4.c
+ * Benchmarks the projection inverses in mat4.h against mat4_inverse
+ *
+ */
+
+#include "bench.h"
+#include <gmath/mat4.h>
+
+#define COUNT 4096
+
+int main(void)
+{
+	mat4 *p = malloc(sizeof(mat4) * COUNT), *o = malloc(sizeof(mat4) * COUNT);
+	mat4 *out = malloc(sizeof(mat4) * COUNT);
+	unsigned int seed = 1;
+	volatile float sink = 0.0f;
+
+	/* cameras with different fields of view, as in split screen */
+	for (int i = 0; i < COUNT; i++) {
+		float fov = 0.5f + bench_randf(&seed), near = 0.1f + bench_randf(&seed);
+		p[i] = mat4_perspective(fov, 1.0f + bench_randf(&seed), near,
+			near * 1000.0f);
+		o[i] = mat4_ortho(-fov, fov, -near, near, near, near * 1000.0f);
+	}
+
+	BENCH("mat4_inverse of perspectives", COUNT,
+		for (int i = 0; i < COUNT; i++)
+			out[i] = mat4_inverse(p[i]);
+		sink += fidx(out[0].col[0], 0));
+	BENCH("mat4_perspective_inverse", COUNT,
+		for (int i = 0; i < COUNT; i++)
+			out[i] = mat4_perspective_inverse(p[i]);
+		sink += fidx(out[0].col[0], 0));
+	BENCH("mat4_inverse of orthographics", COUNT,
+		for (int i = 0; i < COUNT; i++)
+			out[i] = mat4_inverse(o[i]);
+		sink += fidx(out[0].col[0], 0));
+	BENCH("mat4_ortho_inverse", COUNT,
+		for (int i = 0; i < COUNT; i++)
+			out[i] = mat4_ortho_inverse(o[i]);
+		sink += fidx(out[0].col[0], 0));
+
+	free(p);
+	free(o);
+	free(out);
+	(void)sink;
+	return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * morton.c
+ * Benchmarks morton.h encoders, key sorts and permutes
+ *
+ */
+
+#include "bench.h"
+#include <gmath/morton.h>
+
+#define POINTS (1 << 20)
+
+/* One point at a time through the scalar interleave. */
+static void scalar30(uint32_t *out, const vec3 *p, int count, const aabb b)
+{
+	vec3 extent = vec3_sub(b.max, b.min);
+	for (int i = 0; i < count; i++) {
+		uint32_t c[3];
+		for (int j = 0; j < 3; j++) {
+			float q = (fidx(p[i], j) - fidx(b.min, j)) * 1023.0f /
+				fidx(extent, j);
+			q = q > 0.0f ? q : 0.0f;
+			c[j] = (uint32_t)(q < 1023.0f ? q : 1023.0f);
+		}
+		out[i] = morton30(c[0], c[1], c[2]);
+	}
+}
+
+static int cmp30(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+int main(void)
+{
+	unsigned int seed = 1;
+	vec3 *points = malloc(sizeof(vec3) * POINTS);
+	vec3 *sorted = malloc(sizeof(vec3) * POINTS);
+	uint32_t *code30 = malloc(sizeof(uint32_t) * POINTS);
+	uint32_t *keys30 = malloc(sizeof(uint32_t) * POINTS);
+	uint64_t *code63 = malloc(sizeof(uint64_t) * POINTS);
+	uint64_t *keys63 = malloc(sizeof(uint64_t) * POINTS);
+	int *perm = malloc(sizeof(int) * POINTS);
+	aabb bounds;
+
+	for (int i = 0; i < POINTS; i++)
+		points[i] = _mm_setr_ps(bench_randf(&seed) * 100.0f,
+			bench_randf(&seed) * 20.0f, bench_randf(&seed) * 60.0f, 0.0f);
+	bounds = aabb_from_points(points, POINTS);
+
+	BENCH("morton30, scalar", POINTS, scalar30(code30, points, POINTS, bounds));
+	BENCH("morton30_encode", POINTS,
+		morton30_encode(code30, points, POINTS, bounds));
+	BENCH("morton63_encode", POINTS,
+		morton63_encode(code63, points, POINTS, bounds));
+	BENCH("hilbert30_encode", POINTS,
+		hilbert30_encode(code30, points, POINTS, bounds));
+	BENCH("hilbert63_encode", POINTS,
+		hilbert63_encode(code63, points, POINTS, bounds));
+
+	morton30_encode(code30, points, POINTS, bounds);
+	morton63_encode(code63, points, POINTS, bounds);
+	BENCH("qsort, 30 bit keys", POINTS,
+		memcpy(keys30, code30, sizeof(uint32_t) * POINTS);
+		qsort(keys30, POINTS, sizeof(uint32_t), cmp30));
+	BENCH("morton_sort30", POINTS,
+		memcpy(keys30, code30, sizeof(uint32_t) * POINTS);
+		morton_sort30(keys30, perm, POINTS));
+	BENCH("morton_sort63", POINTS,
+		memcpy(keys63, code63, sizeof(uint64_t) * POINTS);
+		morton_sort63(keys63, perm, POINTS));
+	BENCH("morton_permute, vec3", POINTS,
+		morton_permute(sorted, points, sizeof(vec3), perm, POINTS));
+
+	free(points);
+	free(sorted);
+	free(code30);
+	free(keys30);
+	free(code63);
+	free(keys63);
+	free(perm);
+	return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * obb.c
+ * Benchmarks obb.h against the scalar separating axis test
+ *
+ */
+
+#include "bench.h"
+#include <gmath/quat.h>
+#include <gmath/obb.h>
+
+#define PAIRS 65536
+#define CLOUD 64
+
+/* Ericson's 4.4.1 as written, one axis at a time with early outs. */
+static int overlap_scalar(const obb *a, const obb *b)
+{
+	float R[3][3], AbsR[3][3], t[3], ra, rb;
+	float ea[3] = {fidx(a->half, 0), fidx(a->half, 1), fidx(a->half, 2)};
+	float eb[3] = {fidx(b->half, 0), fidx(b->half, 1), fidx(b->half, 2)};
+	vec3 d = vec3_sub(b->center, a->center);
+
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++) {
+			R[i][j] = vec3_dot(a->axis[i], b->axis[j]);
+			AbsR[i][j] = fabsf(R[i][j]) + OBB_EPSILON;
+		}
+	for (int i = 0; i < 3; i++)
+		t[i] = vec3_dot(d, a->axis[i]);
+	for (int i = 0; i < 3; i++) {
+		rb = eb[0] * AbsR[i][0] + eb[1] * AbsR[i][1] + eb[2] * AbsR[i][2];
+		if (fabsf(t[i]) > ea[i] + rb)
+			return 0;
+	}
+	for (int j = 0; j < 3; j++) {
+		ra = ea[0] * AbsR[0][j] + ea[1] * AbsR[1][j] + ea[2] * AbsR[2][j];
+		if (fabsf(t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j]) >
+				ra + eb[j])
+			return 0;
+	}
+	for (int i = 0; i < 3; i++) {
+		int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+		for (int j = 0; j < 3; j++) {
+			int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+			ra = ea[i1] * AbsR[i2][j] + ea[i2] * AbsR[i1][j];
+			rb = eb[j1] * AbsR[i][j2] + eb[j2] * AbsR[i][j1];
+			if (fabsf(t[i2] * R[i1][j] - t[i1] * R[i2][j]) > ra + rb)
+				return 0;
+		}
+	}
+	return 1;
+}
+
+static obb make_obb(unsigned int *seed, float spread)
+{
+	mat4 m = quat_to_mat4(quat_normalize(_mm_setr_ps(
+		bench_randf(seed) - 0.5f, bench_randf(seed) - 0.5f,
+		bench_randf(seed) - 0.5f, bench_randf(seed) - 0.5f)));
+	m.col[3] = _mm_setr_ps((bench_randf(seed) - 0.5f) * spread,
+		(bench_randf(seed) - 0.5f) * spread,
+		(bench_randf(seed) - 0.5f) * spread, 1.0f);
+	/* long thin gameplay volumes */
+	return obb_from_mat4(m, _mm_setr_ps(0.2f + 2.0f * bench_randf(seed),
+		0.1f + 0.3f * bench_randf(seed), 0.1f + bench_randf(seed), 0.0f));
+}
+
+int main(void)
+{
+	unsigned int seed = 1;
+	obb *a = malloc(sizeof(obb) * PAIRS), *b = malloc(sizeof(obb) * PAIRS);
+	aabb *ba = malloc(sizeof(aabb) * PAIRS), *bb = malloc(sizeof(aabb) * PAIRS);
+	ray *r = malloc(sizeof(ray) * PAIRS);
+	vec3 *cloud = malloc(sizeof(vec3) * CLOUD * 64);
+	volatile float sink = 0.0f;
+	int hits = 0, boxes = 0, same = 0;
+	float t;
+
+	for (int i = 0; i < PAIRS; i++) {
+		a[i] = make_obb(&seed, 0.0f);
+		b[i] = make_obb(&seed, 6.0f);
+		ba[i] = obb_bounds(&a[i]);
+		bb[i] = obb_bounds(&b[i]);
+		r[i].origin = _mm_setr_ps(bench_randf(&seed) * 8.0f - 4.0f, 5.0f,
+			bench_randf(&seed) * 8.0f - 4.0f, 0.0f);
+		r[i].dir = _mm_setr_ps(0.0f, -1.0f, 0.0f, 0.0f);
+	}
+	for (int i = 0; i < PAIRS; i++) {
+		hits += obb_overlap(&a[i], &b[i]);
+		boxes += aabb_overlap(ba[i], bb[i]);
+		same += obb_overlap(&a[i], &b[i]) == overlap_scalar(&a[i], &b[i]);
+	}
+	printf("obb pairs, %d%% overlap, %d%% of their bounds, %d/%d agree\n",
+		hits * 100 / PAIRS, boxes * 100 / PAIRS, same, PAIRS);
+	BENCH("aabb_overlap of the bounds", PAIRS,
+		for (int i = 0; i < PAIRS; i++)
+			sink += aabb_overlap(ba[i], bb[i]));
+	BENCH("scalar separating axes", PAIRS,
+		for (int i = 0; i < PAIRS; i++)
+			sink += overlap_scalar(&a[i], &b[i]));
+	BENCH("obb_overlap", PAIRS,
+		for (int i = 0; i < PAIRS; i++)
+			sink += obb_overlap(&a[i], &b[i]));
+	BENCH("obb_ray", PAIRS,
+		for (int i = 0; i < PAIRS; i++)
+			sink += obb_ray(&a[i], &r[i], 100.0f, &t));
+
+	/* clouds of points on rotated boxes */
+	for (int c = 0; c < 64; c++) {
+		obb o = make_obb(&seed, 10.0f);
+		for (int i = 0; i < CLOUD; i++) {
+			vec3 p = o.center;
+			for (int k = 0; k < 3; k++)
+				p = vec3_add(p, vec3_scale(o.axis[k], fidx(o.half, k) *
+					(bench_randf(&seed) * 2.0f - 1.0f)));
+			cloud[c * CLOUD + i] = p;
+		}
+	}
+	BENCH("obb_from_points, 64 points", 64,
+		for (int c = 0; c < 64; c++) {
+			obb f = obb_from_points(cloud + c * CLOUD, CLOUD);
+			sink += obb_volume(&f);
+		});
+
+	free(a);
+	free(b);
+	free(ba);
+	free(bb);
+	free(r);
+	free(cloud);
+	(void)sink;
+	return 0;
+}
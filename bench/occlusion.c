@@ -0,0 +1,140 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * occlusion.c
+ * Benchmarks occlusion.h on a city block seen from the street
+ *
+ */
+
+#include <pthread.h>
+#include "bench.h"
+#include <gmath/frustum.h>
+#include <gmath/occlusion.h>
+
+#define WIDTH 320
+#define HEIGHT 192
+#define BLOCKS 24
+#define OBJECTS 16384
+#define THREADS 4
+#define FRAMES 64
+
+typedef struct {
+	occlusion_buffer *b;
+	pthread_barrier_t *barrier;
+	int id;
+} worker;
+
+/* Persistent workers binning and drawing FRAMES frames. */
+static void *worker_draw(void *arg)
+{
+	worker *w = arg;
+	occlusion_buffer *b = w->b;
+	for (int f = 0; f < FRAMES; f++) {
+		occlusion_bin_count(b, w->id);
+		pthread_barrier_wait(w->barrier);
+		if (w->id == 0)
+			occlusion_bin_offsets(b);
+		pthread_barrier_wait(w->barrier);
+		occlusion_bin_scatter(b, w->id);
+		pthread_barrier_wait(w->barrier);
+		occlusion_render(b, task_first(b->tiles, THREADS, w->id),
+			task_first(b->tiles, THREADS, w->id + 1));
+		pthread_barrier_wait(w->barrier);
+	}
+	return NULL;
+}
+
+static void draw_threaded(occlusion_buffer *b)
+{
+	pthread_t thread[THREADS];
+	pthread_barrier_t barrier;
+	worker w[THREADS];
+
+	pthread_barrier_init(&barrier, NULL, THREADS);
+	for (int i = 0; i < THREADS; i++) {
+		w[i].b = b;
+		w[i].barrier = &barrier;
+		w[i].id = i;
+		pthread_create(&thread[i], NULL, worker_draw, &w[i]);
+	}
+	for (int i = 0; i < THREADS; i++)
+		pthread_join(thread[i], NULL);
+	pthread_barrier_destroy(&barrier);
+}
+
+/* The twelve triangles of box b from vertex base. */
+static void box_mesh(vec3 *v, int *idx, const aabb *b, int base)
+{
+	static const int face[36] = {0, 2, 3, 0, 3, 1, 4, 5, 7, 4, 7, 6,
+		0, 1, 5, 0, 5, 4, 2, 6, 7, 2, 7, 3, 0, 4, 6, 0, 6, 2,
+		1, 3, 7, 1, 7, 5};
+	vec3 c[2] = {b->min, b->max};
+	for (int i = 0; i < 8; i++)
+		v[i] = _mm_setr_ps(fidx(c[i & 1], 0), fidx(c[i >> 1 & 1], 1),
+			fidx(c[i >> 2], 2), 0.0f);
+	for (int i = 0; i < 36; i++)
+		idx[i] = base + face[i];
+}
+
+int main(void)
+{
+	int buildings = BLOCKS * BLOCKS;
+	vec3 *v = malloc(sizeof(vec3) * 8 * buildings);
+	int *idx = malloc(sizeof(int) * 36 * buildings);
+	aabb *obj = malloc(sizeof(aabb) * OBJECTS);
+	int *visible = malloc(sizeof(int) * OBJECTS);
+	vec3 eye = {2.0f, 1.7f, 2.0f, 0.0f}, at = {60.0f, 1.7f, 40.0f, 0.0f};
+	vec3 up = {0.0f, 1.0f, 0.0f, 0.0f};
+	mat4 vp = mat4_mul(mat4_perspective(1.2f, (float)WIDTH / HEIGHT, 0.5f,
+		500.0f), mat4_look_at(eye, at, up));
+	frustum f = frustum_from_mat4(vp);
+	occlusion_buffer b, bt;
+	unsigned int seed = 1;
+	volatile int sink = 0;
+	int n, in_view;
+
+	/* blocks of 16 with 4 wide streets, buildings 6 to 40 high */
+	for (int i = 0; i < buildings; i++) {
+		float x = (i % BLOCKS) * 20.0f + 4.0f, z = (i / BLOCKS) * 20.0f + 4.0f;
+		aabb a = {{x, 0.0f, z, 0.0f},
+			{x + 16.0f, 6.0f + 34.0f * bench_randf(&seed), z + 16.0f, 0.0f}};
+		box_mesh(v + 8 * i, idx + 36 * i, &a, 8 * i);
+	}
+	/* street furniture and cars, some on roofs */
+	for (int i = 0; i < OBJECTS; i++) {
+		float x = bench_randf(&seed) * BLOCKS * 20.0f;
+		float z = bench_randf(&seed) * BLOCKS * 20.0f;
+		float y = bench_randf(&seed) < 0.9f ? 0.0f : 40.0f;
+		obj[i].min = _mm_setr_ps(x, y, z, 0.0f);
+		obj[i].max = _mm_setr_ps(x + 2.0f, y + 2.0f, z + 2.0f, 0.0f);
+	}
+
+	occlusion_init(&b, WIDTH, HEIGHT, 1);
+	occlusion_init(&bt, WIDTH, HEIGHT, THREADS);
+	occlusion_draw(&b, vp, v, idx, 12 * buildings);
+	in_view = frustum_cull_aabbs(&f, obj, OBJECTS, visible);
+	n = occlusion_cull_aabbs(&b, vp, obj, OBJECTS, visible);
+	printf("%d occluder triangles, %d objects, %d in the frustum, "
+		"%d past the occluders\n", 12 * buildings, OBJECTS, in_view, n);
+
+	BENCH("occlusion_draw, triangles", 12 * buildings,
+		occlusion_draw(&b, vp, v, idx, 12 * buildings));
+	occlusion_bin_begin(&bt, vp, v, idx, 12 * buildings);
+	BENCH("occlusion_draw, 4 threads, triangles", 12 * buildings * FRAMES,
+		draw_threaded(&bt));
+	BENCH("frustum_cull_aabbs", OBJECTS,
+		sink += frustum_cull_aabbs(&f, obj, OBJECTS, visible));
+	BENCH("occlusion_cull_aabbs", OBJECTS,
+		sink += occlusion_cull_aabbs(&b, vp, obj, OBJECTS, visible));
+
+	occlusion_free(&b);
+	occlusion_free(&bt);
+	free(v);
+	free(idx);
+	free(obj);
+	free(visible);
+	(void)sink;
+	return 0;
+}
@@ -0,0 +1,50 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * project.c
+ * Benchmarks project.h against projecting one point at a time
+ *
+ */
+
+#include "bench.h"
+#include <gmath/project.h>
+
+#define POINTS 65536
+
+int main(void)
+{
+	vec3 *p = malloc(sizeof(vec3) * POINTS), *s = malloc(sizeof(vec3) * POINTS);
+	unsigned char *codes = malloc(POINTS);
+	viewport v = {0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f};
+	vec3 eye = {0.0f, 20.0f, 0.0f, 0.0f}, at = {100.0f, 0.0f, 100.0f, 0.0f};
+	vec3 up = {0.0f, 1.0f, 0.0f, 0.0f};
+	mat4 vp = mat4_mul(mat4_perspective(1.0f, 16.0f / 9.0f, 0.5f, 500.0f),
+		mat4_look_at(eye, at, up));
+	unsigned int seed = 1;
+	volatile float sink = 0.0f;
+	int n = 0;
+
+	/* markers over a city block around the camera */
+	for (int i = 0; i < POINTS; i++)
+		p[i] = _mm_setr_ps(bench_randf(&seed) * 600.0f - 300.0f,
+			bench_randf(&seed) * 40.0f, bench_randf(&seed) * 600.0f - 300.0f,
+			0.0f);
+	for (int i = 0; i < POINTS; i++)
+		n += project_point(&s[i], vp, &v, p[i]) == 0;
+	printf("%d%% of the points on screen\n", n * 100 / POINTS);
+
+	BENCH("project_point", POINTS,
+		for (int i = 0; i < POINTS; i++)
+			codes[i] = (unsigned char)project_point(&s[i], vp, &v, p[i]);
+		sink += fidx(s[0], 0));
+	BENCH("project_points", POINTS,
+		sink += project_points(s, codes, vp, &v, p, POINTS));
+
+	free(p);
+	free(s);
+	free(codes);
+	(void)sink;
+	return 0;
+}
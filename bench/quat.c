@@ -0,0 +1,57 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * quat.c
+ * Benchmarks mat4 decomposition and composition in quat.h
+ *
+ */
+
+#include "bench.h"
+#include <gmath/quat.h>
+
+#define COUNT 4096
+
+int main(void)
+{
+	mat4 *m = malloc(sizeof(mat4) * COUNT), *o = malloc(sizeof(mat4) * COUNT);
+	vec3 *t = malloc(sizeof(vec3) * COUNT), *s = malloc(sizeof(vec3) * COUNT);
+	quat *r = malloc(sizeof(quat) * COUNT);
+	unsigned int seed = 1;
+	volatile float sink = 0.0f;
+
+	/* world matrices of a scene graph, some of them mirrored */
+	for (int i = 0; i < COUNT; i++) {
+		quat q = quat_normalize(_mm_setr_ps(bench_randf(&seed) - 0.5f,
+			bench_randf(&seed) - 0.5f, bench_randf(&seed) - 0.5f,
+			bench_randf(&seed) - 0.5f));
+		vec3 sc = _mm_setr_ps(0.5f + bench_randf(&seed),
+			0.5f + bench_randf(&seed), 0.5f + bench_randf(&seed), 0.0f);
+		if (i % 8 == 0)
+			sc = vec3_mul(sc, _mm_setr_ps(1.0f, -1.0f, 1.0f, 0.0f));
+		m[i] = mat4_compose(_mm_setr_ps(bench_randf(&seed) * 100.0f,
+			bench_randf(&seed) * 100.0f, bench_randf(&seed) * 100.0f, 0.0f),
+			q, sc);
+	}
+
+	BENCH("mat4_decompose", COUNT,
+		for (int i = 0; i < COUNT; i++) {
+			mat4_decompose(&t[i], &r[i], &s[i], m[i]);
+			sink += fidx(s[i], 0);
+		});
+	BENCH("mat4_decompose_array", COUNT,
+		mat4_decompose_array(t, r, s, m, COUNT);
+		sink += fidx(s[0], 0));
+	BENCH("mat4_compose_array", COUNT,
+		mat4_compose_array(o, t, r, s, COUNT);
+		sink += fidx(o[0].col[0], 0));
+
+	free(m);
+	free(o);
+	free(t);
+	free(s);
+	free(r);
+	(void)sink;
+	return 0;
+}
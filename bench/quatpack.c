@@ -0,0 +1,51 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * quatpack.c
+ * Benchmarks quatpack.h decoding against one quaternion at a time
+ *
+ */
+
+#include "bench.h"
+#include <gmath/quatpack.h>
+
+#define COUNT 4096
+
+int main(void)
+{
+	quat *q = malloc(sizeof(quat) * COUNT), *out = malloc(sizeof(quat) * COUNT);
+	quat32 *p32 = malloc(sizeof(quat32) * COUNT);
+	quat48 *p48 = malloc(sizeof(quat48) * COUNT);
+	unsigned int seed = 1;
+	volatile float sink = 0.0f;
+
+	/* the rotations of a clip's worth of keys */
+	for (int i = 0; i < COUNT; i++)
+		q[i] = quat_normalize(_mm_setr_ps(bench_randf(&seed) - 0.5f,
+			bench_randf(&seed) - 0.5f, bench_randf(&seed) - 0.5f,
+			bench_randf(&seed) - 0.5f));
+	quat_pack32_array(p32, q, COUNT);
+	quat_pack48_array(p48, q, COUNT);
+
+	BENCH("quat_unpack32 loop", COUNT,
+		for (int i = 0; i < COUNT; i++)
+			out[i] = quat_unpack32(p32[i]);
+		sink += fidx(out[0], 0));
+	BENCH("quat_unpack32_array", COUNT,
+		quat_unpack32_array(out, p32, COUNT); sink += fidx(out[0], 0));
+	BENCH("quat_unpack48 loop", COUNT,
+		for (int i = 0; i < COUNT; i++)
+			out[i] = quat_unpack48(p48[i]);
+		sink += fidx(out[0], 0));
+	BENCH("quat_unpack48_array", COUNT,
+		quat_unpack48_array(out, p48, COUNT); sink += fidx(out[0], 0));
+
+	free(q);
+	free(out);
+	free(p32);
+	free(p48);
+	(void)sink;
+	return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * radix.c
+ * Benchmarks radix.h sorts against qsort over a million keys
+ *
+ */
+
+#include <pthread.h>
+#include "bench.h"
+#include <gmath/radix.h>
+
+#define KEYS (1 << 20)
+#define THREADS 4
+
+typedef struct {
+	radix_sorter *rs;
+	int t;
+	int scatter;
+} worker;
+
+typedef struct {
+	float key;
+	int index;
+} keyed;
+
+static void *worker_sort(void *arg)
+{
+	worker *w = arg;
+	if (w->scatter)
+		radix_sort_scatter(w->rs, w->t);
+	else
+		radix_sort_count(w->rs, w->t);
+	return NULL;
+}
+
+/* One thread per task for each phase, the offsets in between. */
+static void sort_threaded(float *keys, int *perm, int count)
+{
+	pthread_t thread[THREADS];
+	worker w[THREADS];
+	radix_sorter rs;
+
+	radix_sortf_begin(&rs, keys, perm, count, THREADS);
+	do {
+		for (int phase = 0; phase < 2; phase++) {
+			if (phase)
+				radix_sort_offsets(&rs);
+			for (int i = 0; i < THREADS; i++) {
+				w[i].rs = &rs;
+				w[i].t = i;
+				w[i].scatter = phase;
+				pthread_create(&thread[i], NULL, worker_sort, &w[i]);
+			}
+			for (int i = 0; i < THREADS; i++)
+				pthread_join(thread[i], NULL);
+		}
+	} while (radix_sort_next(&rs));
+	radix_sort_end(&rs);
+}
+
+static int cmp_keyed(const void *a, const void *b)
+{
+	float x = ((const keyed *)a)->key, y = ((const keyed *)b)->key;
+	return (x > y) - (x < y);
+}
+
+int main(void)
+{
+	unsigned int seed = 1;
+	float *depth = malloc(sizeof(float) * KEYS);
+	float *fkeys = malloc(sizeof(float) * KEYS);
+	uint32_t *code = malloc(sizeof(uint32_t) * KEYS);
+	uint32_t *keys = malloc(sizeof(uint32_t) * KEYS);
+	keyed *pairs = malloc(sizeof(keyed) * KEYS);
+	int *perm = malloc(sizeof(int) * KEYS);
+
+	/* view depths, and 30 bit codes like morton30_encode's */
+	for (int i = 0; i < KEYS; i++) {
+		depth[i] = (bench_randf(&seed) - 0.1f) * 500.0f;
+		code[i] = (uint32_t)(bench_randf(&seed) * (1 << 24)) << 6 |
+			(uint32_t)(bench_randf(&seed) * 64);
+	}
+
+	BENCH("qsort, float keys", KEYS,
+		for (int i = 0; i < KEYS; i++) {
+			pairs[i].key = depth[i];
+			pairs[i].index = i;
+		}
+		qsort(pairs, KEYS, sizeof(keyed), cmp_keyed));
+	BENCH("radix_sortf", KEYS,
+		memcpy(fkeys, depth, sizeof(float) * KEYS);
+		radix_sortf(fkeys, perm, KEYS));
+	BENCH("radix_sortf, 4 tasks", KEYS,
+		memcpy(fkeys, depth, sizeof(float) * KEYS);
+		sort_threaded(fkeys, perm, KEYS));
+	BENCH("radix_sort, 30 bit keys", KEYS,
+		memcpy(keys, code, sizeof(uint32_t) * KEYS);
+		radix_sort(keys, perm, KEYS));
+
+	free(depth);
+	free(fkeys);
+	free(code);
+	free(keys);
+	free(pairs);
+	free(perm);
+	return 0;
+}
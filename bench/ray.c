@@ -0,0 +1,150 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * ray.c
+ * Benchmarks ray.h tests of one ray against many triangles and boxes
+ *
+ */
+
+#include "bench.h"
+#include <gmath/ray.h>
+
+#define TRIS 4096
+#define BOXES 4096
+
+/* static, as malloc does not align the AVX packets */
+static vec3 v0[TRIS], v1[TRIS], v2[TRIS];
+static tri_soa t4[TRIS / 4];
+static aabb box[BOXES];
+static aabb_soa b4[BOXES / 4];
+#ifdef __AVX__
+static tri_soa8 t8[TRIS / 8];
+static aabb_soa8 b8[BOXES / 8];
+#endif
+
+/* A point in the box of size spread about c. */
+static vec3 random_point(unsigned int *seed, const vec3 c, float spread)
+{
+	return vec3_add(c, _mm_setr_ps((bench_randf(seed) - 0.5f) * spread,
+		(bench_randf(seed) - 0.5f) * spread,
+		(bench_randf(seed) - 0.5f) * spread, 0.0f));
+}
+
+static int tris_scalar(const ray *r, const vec3 *v0, const vec3 *v1,
+		const vec3 *v2)
+{
+	int hits = 0;
+	for (int i = 0; i < TRIS; i++) {
+		float t, u, v;
+		hits += ray_triangle(r, v0[i], v1[i], v2[i], INFINITY, &t, &u, &v);
+	}
+	return hits;
+}
+
+static int tris_soa(const ray *r, const tri_soa *tri)
+{
+	int hits = 0;
+	for (int i = 0; i < TRIS / 4; i++) {
+		__m128 t, u, v;
+		hits += ray_tri_soa(r, &tri[i], INFINITY, &t, &u, &v) != 0;
+	}
+	return hits;
+}
+
+#ifdef __AVX__
+static int tris_soa8(const ray *r, const tri_soa8 *tri)
+{
+	int hits = 0;
+	for (int i = 0; i < TRIS / 8; i++) {
+		__m256 t, u, v;
+		hits += ray_tri_soa8(r, &tri[i], INFINITY, &t, &u, &v) != 0;
+	}
+	return hits;
+}
+#endif
+
+static int boxes_scalar(const ray_slab *r, const aabb *b)
+{
+	int hits = 0;
+	for (int i = 0; i < BOXES; i++) {
+		float t;
+		hits += ray_aabb(r, &b[i], INFINITY, &t);
+	}
+	return hits;
+}
+
+static int boxes_soa(const ray_slab *r, const aabb_soa *b)
+{
+	int hits = 0;
+	for (int i = 0; i < BOXES / 4; i++) {
+		__m128 t;
+		hits += ray_aabb_soa(r, &b[i], INFINITY, &t) != 0;
+	}
+	return hits;
+}
+
+#ifdef __AVX__
+static int boxes_soa8(const ray_slab *r, const aabb_soa8 *b)
+{
+	int hits = 0;
+	for (int i = 0; i < BOXES / 8; i++) {
+		__m256 t;
+		hits += ray_aabb_soa8(r, &b[i], INFINITY, &t) != 0;
+	}
+	return hits;
+}
+#endif
+
+int main(void)
+{
+	ray r = {{0.0f, 0.0f, 0.0f, 0.0f}, {0.05f, -0.02f, 1.0f, 0.0f}};
+	ray_slab slab = ray_slab_init(&r);
+	unsigned int seed = 1;
+	volatile int sink = 0;
+	int hits = 0;
+
+	/* small triangles scattered along the ray, a few of them hit */
+	for (int i = 0; i < TRIS; i++) {
+		vec3 c = random_point(&seed, _mm_setr_ps(0.0f, 0.0f, 6.0f, 0.0f),
+			8.0f);
+		v0[i] = random_point(&seed, c, 1.0f);
+		v1[i] = random_point(&seed, c, 1.0f);
+		v2[i] = random_point(&seed, c, 1.0f);
+	}
+	/* and boxes half a unit wide, scattered the same way */
+	for (int i = 0; i < BOXES; i++) {
+		vec3 c = random_point(&seed, _mm_setr_ps(0.0f, 0.0f, 6.0f, 0.0f),
+			8.0f);
+		box[i].min = random_point(&seed, c, 0.5f);
+		box[i].max = vec3_add(box[i].min, _mm_set1_ps(0.5f));
+	}
+	for (int i = 0; i < TRIS / 4; i++)
+		t4[i] = tri_soa_load(v0 + 4 * i, v1 + 4 * i, v2 + 4 * i);
+	for (int i = 0; i < BOXES / 4; i++)
+		b4[i] = aabb_soa_load(box + 4 * i);
+	for (int i = 0; i < BOXES; i++) {
+		float t;
+		hits += ray_aabb(&slab, &box[i], INFINITY, &t);
+	}
+	printf("one ray against %d triangles, %d hit, and %d boxes, %d hit\n",
+		TRIS, tris_scalar(&r, v0, v1, v2), BOXES, hits);
+
+	BENCH("ray_triangle, tests", TRIS, sink += tris_scalar(&r, v0, v1, v2));
+	BENCH("ray_tri_soa, tests", TRIS, sink += tris_soa(&r, t4));
+#ifdef __AVX__
+	for (int i = 0; i < TRIS / 8; i++)
+		t8[i] = tri_soa8_load(v0 + 8 * i, v1 + 8 * i, v2 + 8 * i);
+	BENCH("ray_tri_soa8, tests", TRIS, sink += tris_soa8(&r, t8));
+#endif
+	BENCH("ray_aabb, tests", BOXES, sink += boxes_scalar(&slab, box));
+	BENCH("ray_aabb_soa, tests", BOXES, sink += boxes_soa(&slab, b4));
+#ifdef __AVX__
+	for (int i = 0; i < BOXES / 8; i++)
+		b8[i] = aabb_soa8_load(box + 8 * i);
+	BENCH("ray_aabb_soa8, tests", BOXES, sink += boxes_soa8(&slab, b8));
+#endif
+	(void)sink;
+	return 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * sap.c
+ * Benchmarks sap.h frame updates as the body count grows
+ *
+ */
+
+#include "bench.h"
+#include <gmath/sap.h>
+
+#define FRAMES 32
+
+typedef struct {
+	vec3 pos, vel;
+} body;
+
+/* Unit boxes in a cube sized for about two neighbours each. */
+static void make_bodies(body *b, int count, unsigned int *seed)
+{
+	float side = cbrtf(count * 4.0f);
+	for (int i = 0; i < count; i++) {
+		b[i].pos = _mm_setr_ps(bench_randf(seed) * side,
+			bench_randf(seed) * side, bench_randf(seed) * side, 0.0f);
+		b[i].vel = _mm_setr_ps(bench_randf(seed) - 0.5f,
+			bench_randf(seed) - 0.5f, bench_randf(seed) - 0.5f, 0.0f);
+	}
+}
+
+/* One frame of motion, a tenth of a box each step at most. */
+static void step(aabb *boxes, body *b, int count)
+{
+	vec3 h = _mm_set1_ps(0.5f);
+	for (int i = 0; i < count; i++) {
+		b[i].pos = vec3_add(b[i].pos, vec3_scale(b[i].vel, 0.2f));
+		boxes[i].min = vec3_sub(b[i].pos, h);
+		boxes[i].max = vec3_add(b[i].pos, h);
+	}
+}
+
+static int brute(const aabb *boxes, int count)
+{
+	int found = 0;
+	for (int i = 0; i < count; i++)
+		for (int j = i + 1; j < count; j++)
+			found += aabb_overlap(boxes[i], boxes[j]);
+	return found;
+}
+
+int main(void)
+{
+	static const int counts[] = {1000, 5000, 10000, 50000, 100000};
+	unsigned int seed = 1;
+
+	printf("%-8s %10s %12s %12s %12s %12s\n", "bodies", "pairs",
+		"update ms", "pairs ms", "reinit ms", "brute ms");
+	for (int c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+		int count = counts[c], found = 0;
+		body *b = malloc(sizeof(body) * count);
+		aabb *boxes = malloc(sizeof(aabb) * count);
+		sap_pair *pairs = malloc(sizeof(sap_pair) * count * 8);
+		double update = 0.0, sweep = 0.0, reinit, naive = -1.0, t;
+		sap s;
+
+		make_bodies(b, count, &seed);
+		step(boxes, b, count);
+		sap_init(&s, boxes, count);
+		for (int f = 0; f < FRAMES; f++) {
+			step(boxes, b, count);
+			t = bench_now();
+			sap_update(&s, boxes);
+			update += bench_now() - t;
+			t = bench_now();
+			found = sap_pairs(&s, pairs, count * 8);
+			sweep += bench_now() - t;
+		}
+		/* sorting from scratch each frame instead */
+		t = bench_now();
+		for (int f = 0; f < 4; f++) {
+			sap_free(&s);
+			sap_init(&s, boxes, count);
+		}
+		reinit = (bench_now() - t) / 4;
+		if (count <= 10000) {
+			t = bench_now();
+			if (brute(boxes, count) != found)
+				printf("mismatch\n");
+			naive = bench_now() - t;
+		}
+		printf("%-8d %10d %12.3f %12.3f %12.3f ", count, found,
+			update / FRAMES * 1e3, sweep / FRAMES * 1e3, reinit * 1e3);
+		if (naive >= 0.0)
+			printf("%12.3f\n", naive * 1e3);
+		else
+			printf("%12s\n", "-");
+		sap_free(&s);
+		free(b);
+		free(boxes);
+		free(pairs);
+	}
+	return 0;
+}
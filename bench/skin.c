@@ -0,0 +1,84 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * skin.c
+ * Benchmarks skin.h on a synthetic mesh
+ *
+ */
+
+#include "bench.h"
+#include <gmath/quat.h>
+#include <gmath/skin.h>
+
+#define VERTICES 65536
+#define BONES 128
+
+int main(void)
+{
+	unsigned int seed = 1;
+	mat4 *palette = malloc(sizeof(mat4) * BONES);
+	dquat *dpalette = malloc(sizeof(dquat) * BONES);
+	skin_influence *inf = malloc(sizeof(skin_influence) * VERTICES);
+	vec3 *pos = malloc(sizeof(vec3) * VERTICES);
+	vec3 *nrm = malloc(sizeof(vec3) * VERTICES);
+	vec4 *tan = malloc(sizeof(vec4) * VERTICES);
+	vec3 *out_pos = malloc(sizeof(vec3) * VERTICES);
+	vec3 *out_nrm = malloc(sizeof(vec3) * VERTICES);
+	vec4 *out_tan = malloc(sizeof(vec4) * VERTICES);
+
+	for (int i = 0; i < BONES; i++) {
+		quat q = quat_normalize(_mm_setr_ps(bench_randf(&seed) - 0.5f,
+			bench_randf(&seed) - 0.5f, bench_randf(&seed) - 0.5f, 1.0f));
+		palette[i] = quat_to_mat4(q);
+		palette[i].col[3] = _mm_setr_ps(bench_randf(&seed),
+			bench_randf(&seed), bench_randf(&seed), 1.0f);
+	}
+	for (int i = 0; i < VERTICES; i++) {
+		float w = 0.0f;
+		for (int j = 0; j < 4; j++) {
+			inf[i].index[j] = (i / 64 + j * 7) % BONES;
+			inf[i].weight[j] = bench_randf(&seed);
+			w += inf[i].weight[j];
+		}
+		for (int j = 0; j < 4; j++)
+			inf[i].weight[j] /= w;
+		pos[i] = _mm_setr_ps(bench_randf(&seed), bench_randf(&seed),
+			bench_randf(&seed), 1.0f);
+		nrm[i] = vec3_normalize(_mm_setr_ps(bench_randf(&seed),
+			bench_randf(&seed), bench_randf(&seed), 0.0f));
+		tan[i] = _mm_setr_ps(fidx(nrm[i], 1), -fidx(nrm[i], 0), 0.0f, 1.0f);
+	}
+
+	skin_dquat_palette(dpalette, palette, BONES);
+
+	printf("linear blend skinning, %d vertices, %d bones\n",
+		VERTICES, BONES);
+	BENCH("position", VERTICES, skin_lbs(out_pos, NULL, NULL,
+		palette, inf, pos, NULL, NULL, VERTICES));
+	BENCH("position+normal", VERTICES, skin_lbs(out_pos, out_nrm, NULL,
+		palette, inf, pos, nrm, NULL, VERTICES));
+	BENCH("position+normal+tangent", VERTICES, skin_lbs(out_pos, out_nrm,
+		out_tan, palette, inf, pos, nrm, tan, VERTICES));
+
+	printf("dual quaternion skinning, %d vertices, %d bones\n",
+		VERTICES, BONES);
+	BENCH("position", VERTICES, skin_dqs(out_pos, NULL, NULL,
+		dpalette, inf, pos, NULL, NULL, VERTICES));
+	BENCH("position+normal", VERTICES, skin_dqs(out_pos, out_nrm, NULL,
+		dpalette, inf, pos, nrm, NULL, VERTICES));
+	BENCH("position+normal+tangent", VERTICES, skin_dqs(out_pos, out_nrm,
+		out_tan, dpalette, inf, pos, nrm, tan, VERTICES));
+
+	free(palette);
+	free(dpalette);
+	free(inf);
+	free(pos);
+	free(nrm);
+	free(tan);
+	free(out_pos);
+	free(out_nrm);
+	free(out_tan);
+	return 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * svd.c
+ * Benchmarks svd.h against a scalar cyclic Jacobi
+ *
+ */
+
+#include "bench.h"
+#include <gmath/svd.h>
+
+#define COUNT 4096
+
+/* Textbook cyclic Jacobi with exact rotations and an early out. */
+static void jacobi_scalar(float a[3][3], float v[3][3])
+{
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			v[i][j] = i == j ? 1.0f : 0.0f;
+	for (int sweep = 0; sweep < 16; sweep++) {
+		float off = a[0][1] * a[0][1] + a[0][2] * a[0][2] +
+			a[1][2] * a[1][2];
+		float on = a[0][0] * a[0][0] + a[1][1] * a[1][1] +
+			a[2][2] * a[2][2];
+		if (off <= 1e-14f * on)
+			break;
+		for (int p = 0; p < 2; p++)
+			for (int q = p + 1; q < 3; q++) {
+				float theta, t, c, s;
+				if (a[p][q] == 0.0f)
+					continue;
+				theta = (a[q][q] - a[p][p]) / (2.0f * a[p][q]);
+				t = copysignf(1.0f, theta) /
+					(fabsf(theta) + sqrtf(theta * theta + 1.0f));
+				c = 1.0f / sqrtf(t * t + 1.0f);
+				s = t * c;
+				for (int k = 0; k < 3; k++) {
+					float kp = a[k][p], kq = a[k][q];
+					a[k][p] = c * kp - s * kq;
+					a[k][q] = s * kp + c * kq;
+				}
+				for (int k = 0; k < 3; k++) {
+					float pk = a[p][k], qk = a[q][k];
+					a[p][k] = c * pk - s * qk;
+					a[q][k] = s * pk + c * qk;
+				}
+				for (int k = 0; k < 3; k++) {
+					float kp = v[k][p], kq = v[k][q];
+					v[k][p] = c * kp - s * kq;
+					v[k][q] = s * kp + c * kq;
+				}
+			}
+	}
+}
+
+int main(void)
+{
+	static float a[COUNT][3][3], sym[COUNT][3][3], u[COUNT][3][3];
+	static float v[COUNT][3][3], s[COUNT][3];
+	unsigned int seed = 1;
+	volatile float sink = 0.0f;
+
+	/* deformation gradients near a rotation, as in a soft body */
+	for (int i = 0; i < COUNT; i++) {
+		for (int r = 0; r < 3; r++)
+			for (int c = 0; c < 3; c++)
+				a[i][r][c] = (r == c) + 0.6f * (bench_randf(&seed) - 0.5f);
+		for (int r = 0; r < 3; r++)
+			for (int c = 0; c < 3; c++)
+				sym[i][r][c] = a[i][0][r] * a[i][0][c] +
+					a[i][1][r] * a[i][1][c] + a[i][2][r] * a[i][2][c];
+	}
+
+	BENCH("scalar cyclic jacobi", COUNT,
+		for (int i = 0; i < COUNT; i++) {
+			float t[3][3];
+			memcpy(t, sym[i], sizeof(t));
+			jacobi_scalar(t, v[i]);
+			sink += t[0][0];
+		});
+	BENCH("eig3_sym", COUNT,
+		for (int i = 0; i < COUNT; i++) {
+			eig3_sym(v[i], s[i], sym[i]);
+			sink += s[i][0];
+		});
+	BENCH("eig3_sym_array", COUNT,
+		eig3_sym_array(v, s, (const float (*)[3][3])sym, COUNT);
+		sink += s[0][0]);
+	BENCH("svd3", COUNT,
+		for (int i = 0; i < COUNT; i++) {
+			svd3(u[i], s[i], v[i], a[i]);
+			sink += s[i][0];
+		});
+	BENCH("svd3_array", COUNT,
+		svd3_array(u, s, v, (const float (*)[3][3])a, COUNT);
+		sink += s[0][0]);
+	BENCH("polar3_array", COUNT,
+		polar3_array(u, (const float (*)[3][3])a, COUNT);
+		sink += u[0][0][0]);
+	(void)sink;
+	return 0;
+}
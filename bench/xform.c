@@ -0,0 +1,136 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * xform.c
+ * Benchmarks xform.h against recursive pointer based updates
+ *
+ */
+
+#include <pthread.h>
+#include "bench.h"
+#include <gmath/xform.h>
+
+#define NODES 65536
+#define THREADS 4
+#define FRAMES 64
+
+/* The pointer chasing layout xform.h replaces. */
+typedef struct node {
+	mat4 local, world;
+	int children;
+	struct node **child;
+} node;
+
+static void node_update(node *n, const mat4 parent)
+{
+	n->world = mat4_mul(parent, n->local);
+	for (int i = 0; i < n->children; i++)
+		node_update(n->child[i], n->world);
+}
+
+typedef struct {
+	xform_tree *tree;
+	pthread_barrier_t *barrier;
+	int id;
+} worker;
+
+/* Persistent workers updating FRAMES fully dirty frames. */
+static void *worker_update(void *arg)
+{
+	worker *w = arg;
+	xform_tree *tree = w->tree;
+	for (int f = 0; f < FRAMES; f++) {
+		int n = tree->count;
+		memset(tree->dirty + n * w->id / THREADS, 1,
+			n * (w->id + 1) / THREADS - n * w->id / THREADS);
+		pthread_barrier_wait(w->barrier);
+		for (int l = 0; l < tree->levels; l++) {
+			int first = tree->level[l], count = tree->level[l + 1] - first;
+			xform_update_range(tree, first + count * w->id / THREADS,
+				first + count * (w->id + 1) / THREADS);
+			pthread_barrier_wait(w->barrier);
+		}
+	}
+	return NULL;
+}
+
+static void update_threaded(xform_tree *tree)
+{
+	pthread_t thread[THREADS];
+	pthread_barrier_t barrier;
+	worker w[THREADS];
+
+	pthread_barrier_init(&barrier, NULL, THREADS);
+	for (int i = 0; i < THREADS; i++) {
+		w[i].tree = tree;
+		w[i].barrier = &barrier;
+		w[i].id = i;
+		pthread_create(&thread[i], NULL, worker_update, &w[i]);
+	}
+	for (int i = 0; i < THREADS; i++)
+		pthread_join(thread[i], NULL);
+	pthread_barrier_destroy(&barrier);
+	xform_tree_clean(tree);
+}
+
+int main(void)
+{
+	unsigned int seed = 1;
+	mat4 identity = MAT4_IDENTITY;
+	int *parent = malloc(sizeof(int) * NODES);
+	int *remap = malloc(sizeof(int) * NODES);
+	node **nodes = malloc(sizeof(node *) * NODES);
+	node **child = malloc(sizeof(node *) * NODES);
+	node **next = child;
+	xform_tree tree;
+
+	/* a wide forest, up to eight children per node, allocated scattered */
+	parent[0] = -1;
+	for (int i = 1; i < NODES; i++)
+		parent[i] = (int)(bench_randf(&seed) * (i < 8 ? i : i / 8 * 7));
+	for (int i = 0; i < NODES; i++) {
+		nodes[i] = malloc(sizeof(node) + bench_randf(&seed) * 256);
+		nodes[i]->children = 0;
+	}
+	for (int i = 1; i < NODES; i++)
+		nodes[parent[i]]->children++;
+	for (int i = 0; i < NODES; i++) {
+		nodes[i]->child = next;
+		next += nodes[i]->children;
+		nodes[i]->children = 0;
+	}
+	for (int i = 1; i < NODES; i++) {
+		node *p = nodes[parent[i]];
+		p->child[p->children++] = nodes[i];
+	}
+
+	xform_tree_init(&tree, parent, NODES, remap);
+	for (int i = 0; i < NODES; i++) {
+		mat4 m = mat4_from_angles(bench_randf(&seed), bench_randf(&seed),
+			bench_randf(&seed));
+		m.col[3] = _mm_setr_ps(bench_randf(&seed), bench_randf(&seed),
+			bench_randf(&seed), 1.0f);
+		nodes[i]->local = m;
+		xform_set_local(&tree, remap[i], m);
+	}
+
+	printf("transform hierarchy, %d nodes, %d levels\n", NODES, tree.levels);
+	BENCH("recursive", NODES, node_update(nodes[0], identity));
+	BENCH("xform_tree_update", NODES,
+		memset(tree.dirty, 1, NODES); xform_tree_update(&tree));
+	BENCH("xform_tree_update, 1 dirty root", NODES,
+		tree.dirty[remap[1]] = 1; xform_tree_update(&tree));
+	BENCH("xform_update_range, 4 threads", NODES * FRAMES,
+		update_threaded(&tree));
+
+	xform_tree_free(&tree);
+	for (int i = 0; i < NODES; i++)
+		free(nodes[i]);
+	free(nodes);
+	free(child);
+	free(parent);
+	free(remap);
+	return 0;
+}
@@ -210,7 +210,22 @@ static inline float sin_fast(float a)
 	float s, t;
 
 	s = a * a;
-	
+	t = 1.60590438368216145994e-10f;
+	t *= s;
+	t += -2.50521083854417187751e-8f;
+	t *= s;
+	t += 2.75573192239858906526e-6f;
+	t *= s;
+	t += -1.98412698412698412698e-4f;
+	t *= s;
+	t += 8.33333333333333333333e-3f;
+	t *= s;
+	t += -1.66666666666666666667e-1f;
+	t *= s;
+	t *= a;
+	t += a;
+
+	return t;
 }
 
 #endif /* _CEPHES_SIN_H_ */
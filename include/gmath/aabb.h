@@ -0,0 +1,199 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * aabb.h
+ * Handles axis aligned bounding boxes
+ *
+ */
+
+#ifndef _GMATH_AABB_H_
+#define _GMATH_AABB_H_
+
+#include <float.h>
+#include "constants.h"
+#include "vec3.h"
+#include "mat4.h"
+
+static inline aabb aabb_empty(void)
+{
+	aabb out;
+#ifndef __SSE__
+	for (int i = 0; i < 4; i++) {
+		out.min[i] = FLT_MAX;
+		out.max[i] = -FLT_MAX;
+	}
+#else
+	out.min = _mm_set1_ps(FLT_MAX);
+	out.max = _mm_set1_ps(-FLT_MAX);
+#endif
+	return out;
+}
+
+static inline aabb aabb_merge(const aabb a, const aabb b)
+{
+	aabb out;
+	out.min = vec3_min(a.min, b.min);
+	out.max = vec3_max(a.max, b.max);
+	return out;
+}
+
+static inline aabb aabb_merge_point(const aabb a, const vec3 p)
+{
+	aabb out;
+	out.min = vec3_min(a.min, p);
+	out.max = vec3_max(a.max, p);
+	return out;
+}
+
+static inline vec3 aabb_center(const aabb a)
+{
+	return vec3_scale(vec3_add(a.min, a.max), 0.5f);
+}
+
+/* Half the size along each axis. */
+static inline vec3 aabb_extent(const aabb a)
+{
+	return vec3_scale(vec3_sub(a.max, a.min), 0.5f);
+}
+
+/**
+ * Half the surface area, the measure the surface area heuristic needs.
+ */
+static inline float aabb_half_area(const aabb a)
+{
+	vec3 d = vec3_sub(a.max, a.min);
+	return fidx(d, 0) * fidx(d, 1) + fidx(d, 1) * fidx(d, 2) +
+		fidx(d, 2) * fidx(d, 0);
+}
+
+/**
+ * Tests whether p lies inside or on a.
+ */
+static inline int aabb_contains(const aabb a, const vec3 p)
+{
+#ifndef __SSE__
+	for (int i = 0; i < 3; i++)
+		if (p[i] < a.min[i] || p[i] > a.max[i])
+			return 0;
+	return 1;
+#else
+	__m128 out = _mm_or_ps(_mm_cmplt_ps(p, a.min), _mm_cmpgt_ps(p, a.max));
+	return (_mm_movemask_ps(out) & 7) == 0;
+#endif
+}
+
+/**
+ * Tests whether b lies entirely inside a.
+ */
+static inline int aabb_contains_aabb(const aabb a, const aabb b)
+{
+#ifndef __SSE__
+	for (int i = 0; i < 3; i++)
+		if (b.min[i] < a.min[i] || b.max[i] > a.max[i])
+			return 0;
+	return 1;
+#else
+	__m128 out = _mm_or_ps(_mm_cmplt_ps(b.min, a.min),
+		_mm_cmpgt_ps(b.max, a.max));
+	return (_mm_movemask_ps(out) & 7) == 0;
+#endif
+}
+
+/**
+ * Tests whether two boxes overlap, touching counts.
+ */
+static inline int aabb_overlap(const aabb a, const aabb b)
+{
+#ifndef __SSE__
+	for (int i = 0; i < 3; i++)
+		if (a.min[i] > b.max[i] || b.min[i] > a.max[i])
+			return 0;
+	return 1;
+#else
+	__m128 out = _mm_or_ps(_mm_cmpgt_ps(a.min, b.max),
+		_mm_cmpgt_ps(b.min, a.max));
+	return (_mm_movemask_ps(out) & 7) == 0;
+#endif
+}
+
+/**
+ * Bounds of a box under an affine transform, after Arvo: the centre is
+ * transformed and the extent is scaled by the absolute 3x3 part.
+ */
+static inline aabb aabb_transform(const mat4 m, const aabb a)
+{
+	aabb out;
+	vec3 c = mat4_transform_point(m, aabb_center(a));
+	vec3 e = aabb_extent(a);
+#ifndef __SSE__
+	vec3 r;
+	for (int i = 0; i < 3; i++)
+		r[i] = fabsf(m.col[0][i]) * e[0] + fabsf(m.col[1][i]) * e[1] +
+			fabsf(m.col[2][i]) * e[2];
+#else
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(SIGN_MASK));
+	vec3 r = _mm_add_ps(_mm_add_ps(
+		_mm_mul_ps(_mm_andnot_ps(sign, m.col[0]), VEC4_XXXX(e)),
+		_mm_mul_ps(_mm_andnot_ps(sign, m.col[1]), VEC4_YYYY(e))),
+		_mm_mul_ps(_mm_andnot_ps(sign, m.col[2]), VEC4_ZZZZ(e)));
+#endif
+	out.min = vec3_sub(c, r);
+	out.max = vec3_add(c, r);
+	return out;
+}
+
+/**
+ * Transforms count boxes by one matrix.
+ */
+static inline void aabb_transform_array(aabb *out, const mat4 m,
+		const aabb *a, int count)
+{
+	for (int i = 0; i < count; i++)
+		out[i] = aabb_transform(m, a[i]);
+}
+
+/**
+ * Bounds of count points.  The min and max run vertically over several
+ * accumulators, two points per AVX register, and the lanes are folded
+ * together once at the end.  Returns an empty box for no points.
+ */
+static inline aabb aabb_from_points(const vec3 *p, int count)
+{
+	aabb out = aabb_empty();
+	int i = 0;
+#ifdef __AVX__
+	__m256 lo0 = _mm256_set1_ps(FLT_MAX), hi0 = _mm256_set1_ps(-FLT_MAX);
+	__m256 lo1 = lo0, hi1 = hi0;
+	for (; i + 4 <= count; i += 4) {
+		__m256 a = _mm256_loadu_ps((const float *)(p + i));
+		__m256 b = _mm256_loadu_ps((const float *)(p + i + 2));
+		lo0 = _mm256_min_ps(lo0, a);
+		hi0 = _mm256_max_ps(hi0, a);
+		lo1 = _mm256_min_ps(lo1, b);
+		hi1 = _mm256_max_ps(hi1, b);
+	}
+	lo0 = _mm256_min_ps(lo0, lo1);
+	hi0 = _mm256_max_ps(hi0, hi1);
+	out.min = _mm_min_ps(_mm256_castps256_ps128(lo0),
+		_mm256_extractf128_ps(lo0, 1));
+	out.max = _mm_max_ps(_mm256_castps256_ps128(hi0),
+		_mm256_extractf128_ps(hi0, 1));
+#elif defined(__SSE__)
+	__m128 lo0 = out.min, hi0 = out.max, lo1 = lo0, hi1 = hi0;
+	for (; i + 2 <= count; i += 2) {
+		lo0 = _mm_min_ps(lo0, p[i]);
+		hi0 = _mm_max_ps(hi0, p[i]);
+		lo1 = _mm_min_ps(lo1, p[i + 1]);
+		hi1 = _mm_max_ps(hi1, p[i + 1]);
+	}
+	out.min = _mm_min_ps(lo0, lo1);
+	out.max = _mm_max_ps(hi0, hi1);
+#endif
+	for (; i < count; i++)
+		out = aabb_merge_point(out, p[i]);
+	return out;
+}
+
+#endif /* _GMATH_AABB_H_ */
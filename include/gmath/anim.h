@@ -0,0 +1,234 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * anim.h
+ * Handles compressed animation clips and skeleton sampling
+ *
+ */
+
+#ifndef _GMATH_ANIM_H_
+#define _GMATH_ANIM_H_
+
+#include <stdlib.h>
+#include "constants.h"
+#include "quat.h"
+#include "quatpack.h"
+#include "vec3.h"
+
+/* Frames per segment; each segment also stores the next frame. */
+#define ANIM_SEGMENT_FRAMES 16
+
+/**
+ * A clip sampled at a fixed rate and cut into segments.  Every segment
+ * holds ANIM_SEGMENT_FRAMES + 1 frames of all tracks, frame major, so a
+ * sample reads two adjacent rows of one block and no keys are searched.
+ *
+ * Segment layout, with tracks padded to a multiple of four:
+ *	float range[6][tracks]	translation min and step, x y z
+ *	quat48 rot[frames][tracks]
+ *	unsigned short trans[frames][tracks / 4][3][4]
+ */
+typedef struct {
+	int tracks;
+	int frames;
+	float rate;
+	int segments;
+	size_t segment_size;
+	unsigned char *data;
+} anim_clip;
+
+static inline int anim_clip_padded(const anim_clip *clip)
+{
+	return (clip->tracks + 3) & ~3;
+}
+
+static inline float anim_clip_duration(const anim_clip *clip)
+{
+	return (clip->frames - 1) / clip->rate;
+}
+
+static inline float *anim_segment_range(const anim_clip *clip, int s)
+{
+	return (float *)(clip->data + s * clip->segment_size);
+}
+
+static inline quat48 *anim_segment_rot(const anim_clip *clip, int s)
+{
+	return (quat48 *)(anim_segment_range(clip, s) +
+		6 * anim_clip_padded(clip));
+}
+
+static inline unsigned short *anim_segment_trans(const anim_clip *clip, int s)
+{
+	return (unsigned short *)(anim_segment_rot(clip, s) +
+		(ANIM_SEGMENT_FRAMES + 1) * anim_clip_padded(clip));
+}
+
+/**
+ * Compresses a clip from frame major source keys, rot and trans hold
+ * frames * tracks entries.  Rotations are stored smallest three in 48
+ * bits, translations in 16 bits per axis over each segment's range.
+ * Returns 0 on success, -1 when out of memory.
+ */
+static inline int anim_clip_build(anim_clip *clip, const quat *rot,
+		const vec3 *trans, int tracks, int frames, float rate)
+{
+	const int fs = ANIM_SEGMENT_FRAMES + 1;
+	int padded;
+
+	clip->tracks = tracks;
+	clip->frames = frames;
+	clip->rate = rate;
+	clip->segments = (frames - 1 + ANIM_SEGMENT_FRAMES - 1) /
+		ANIM_SEGMENT_FRAMES;
+	if (clip->segments < 1)
+		clip->segments = 1;
+	padded = anim_clip_padded(clip);
+	clip->segment_size = (6 * sizeof(float) + fs * sizeof(quat48) +
+		fs * 3 * sizeof(unsigned short)) * padded;
+	clip->segment_size = (clip->segment_size + 15) & ~(size_t)15;
+	clip->data = malloc(clip->segment_size * clip->segments);
+	if (!clip->data)
+		return -1;
+
+	for (int s = 0; s < clip->segments; s++) {
+		float *range = anim_segment_range(clip, s);
+		quat48 *r = anim_segment_rot(clip, s);
+		unsigned short *t = anim_segment_trans(clip, s);
+		int first = s * ANIM_SEGMENT_FRAMES;
+
+		for (int i = 0; i < padded; i++) {
+			float lo[3] = {0.0f, 0.0f, 0.0f}, hi[3] = {0.0f, 0.0f, 0.0f};
+			for (int f = 0; f < fs && i < tracks; f++) {
+				int src = first + f < frames ? first + f : frames - 1;
+				for (int c = 0; c < 3; c++) {
+					float v = fidx(trans[src * tracks + i], c);
+					lo[c] = f == 0 || v < lo[c] ? v : lo[c];
+					hi[c] = f == 0 || v > hi[c] ? v : hi[c];
+				}
+			}
+			for (int c = 0; c < 3; c++) {
+				range[c * padded + i] = lo[c];
+				range[(c + 3) * padded + i] = (hi[c] - lo[c]) / 65535.0f;
+			}
+		}
+
+		for (int f = 0; f < fs; f++) {
+			int src = first + f < frames ? first + f : frames - 1;
+			for (int i = 0; i < padded; i++) {
+				unsigned short *tg = t + (f * padded + (i & ~3)) * 3 + (i & 3);
+				if (i >= tracks) {
+					quat identity = {0.0f, 0.0f, 0.0f, 1.0f};
+					r[f * padded + i] = quat_pack48(identity);
+					tg[0] = tg[4] = tg[8] = 0;
+					continue;
+				}
+				r[f * padded + i] = quat_pack48(rot[src * tracks + i]);
+				for (int c = 0; c < 3; c++) {
+					float step = range[(c + 3) * padded + i];
+					float v = fidx(trans[src * tracks + i], c) -
+						range[c * padded + i];
+					float q = step > 0.0f ? v / step + 0.5f : 0.0f;
+					tg[c * 4] = (unsigned short)(q < 65535.0f ? q : 65535.0f);
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+static inline void anim_clip_free(anim_clip *clip)
+{
+	free(clip->data);
+	clip->data = NULL;
+}
+
+/**
+ * Finds the segment, the frame within it and the blend factor for a
+ * time in seconds, clamped to the clip.
+ */
+static inline int anim_clip_locate(const anim_clip *clip, float time,
+		int *frame, float *alpha)
+{
+	float f = time * clip->rate;
+	int s, k;
+
+	f = f < 0.0f ? 0.0f : f > clip->frames - 1 ? clip->frames - 1 : f;
+	s = (int)f / ANIM_SEGMENT_FRAMES;
+	s = s < clip->segments ? s : clip->segments - 1;
+	f -= s * ANIM_SEGMENT_FRAMES;
+	k = (int)f;
+	k = k < ANIM_SEGMENT_FRAMES ? k : ANIM_SEGMENT_FRAMES - 1;
+	*frame = k;
+	*alpha = f - k;
+	return s;
+}
+
+/**
+ * Samples every track of a clip at a time in seconds, writing
+ * clip->tracks rotations and translations.  Rotations are blended with
+ * nlerp, which is accurate between adjacent keys.
+ */
+static inline void anim_sample(const anim_clip *clip, float time,
+		quat *out_rot, vec3 *out_trans)
+{
+	int padded = anim_clip_padded(clip), k;
+	float alpha;
+	int s = anim_clip_locate(clip, time, &k, &alpha);
+	const float *range = anim_segment_range(clip, s);
+	const quat48 *r = anim_segment_rot(clip, s) + k * padded;
+	const unsigned short *t = anim_segment_trans(clip, s) + k * padded * 3;
+
+#ifndef __SSE__
+	for (int i = 0; i < clip->tracks; i++) {
+		const unsigned short *t0 = t + (i & ~3) * 3 + (i & 3);
+		const unsigned short *t1 = t0 + padded * 3;
+		out_rot[i] = quat_nlerp(quat_unpack48(r[i]),
+			quat_unpack48(r[i + padded]), alpha);
+		for (int c = 0; c < 3; c++)
+			out_trans[i][c] = range[c * padded + i] +
+				(t0[c * 4] + (t1[c * 4] - t0[c * 4]) * alpha) *
+				range[(c + 3) * padded + i];
+		out_trans[i][3] = 0.0f;
+	}
+#else
+	__m128 a = _mm_set1_ps(alpha);
+	__m128i zero = _mm_setzero_si128();
+
+	for (int i = 0; i < clip->tracks; i += 4) {
+		quat_soa q = quat_soa_nlerp(quat_soa_unpack48(r + i),
+			quat_soa_unpack48(r + i + padded), a);
+		const unsigned short *t0 = t + i * 3, *t1 = t0 + padded * 3;
+		__m128 v[3];
+
+		for (int c = 0; c < 3; c++) {
+			__m128 v0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(
+				_mm_loadl_epi64((const __m128i *)(t0 + c * 4)), zero));
+			__m128 v1 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(
+				_mm_loadl_epi64((const __m128i *)(t1 + c * 4)), zero));
+			v0 = _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(v1, v0), a));
+			v[c] = _mm_add_ps(_mm_loadu_ps(range + c * padded + i),
+				_mm_mul_ps(v0, _mm_loadu_ps(range + (c + 3) * padded + i)));
+		}
+		vec3_soa p = {v[0], v[1], v[2]};
+
+		if (i + 4 <= clip->tracks) {
+			quat_soa_store(out_rot + i, q);
+			vec3_soa_store(out_trans + i, p);
+		} else {
+			quat qt[4];
+			vec3 pt[4];
+			quat_soa_store(qt, q);
+			vec3_soa_store(pt, p);
+			for (int j = 0; i + j < clip->tracks; j++) {
+				out_rot[i + j] = qt[j];
+				out_trans[i + j] = pt[j];
+			}
+		}
+	}
+#endif
+}
+
+#endif /* _GMATH_ANIM_H_ */
@@ -0,0 +1,861 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * bvh.h
+ * Handles bounding volume hierarchies over boxes and triangles
+ *
+ */
+
+#ifndef _GMATH_BVH_H_
+#define _GMATH_BVH_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include "constants.h"
+#include "aabb.h"
+#include "ray.h"
+
+#ifdef __SSE__
+
+/* Children per node, one box per SIMD lane. */
+#ifdef __AVX__
+#define BVH_WIDTH 8
+#else
+#define BVH_WIDTH 4
+#endif
+
+/* Primitives a leaf holds unless the depth limit forces more. */
+#define BVH_LEAF_MAX 4
+/* Candidate planes per axis for the surface area heuristic. */
+#define BVH_BINS 16
+/* Deepest binary split, which bounds the traversal stack. */
+#define BVH_DEPTH_MAX 64
+#define BVH_STACK (BVH_DEPTH_MAX * (BVH_WIDTH - 1) + 1)
+#define BVH_REF_BIAS 0x00800000
+
+/**
+ * A node with BVH_WIDTH children.  Child boxes are stored as structure
+ * of arrays, min x y z then max x y z, one float per child.  A child
+ * with count > 0 is a leaf over prim[child .. child + count), otherwise
+ * child is a node index, or -1 for an unused slot with an empty box.
+ */
+typedef struct {
+	float bounds[6][BVH_WIDTH];
+	int child[BVH_WIDTH];
+	int count[BVH_WIDTH];
+} bvh_node;
+
+/**
+ * A hierarchy over count primitives.  Node 0 is the root and every
+ * node comes before its children.  prim lists the primitive indices in
+ * leaf order.
+ */
+typedef struct {
+	int count;
+	int nodes;
+	int *prim;
+	bvh_node *node;
+	aabb bounds;
+} bvh;
+
+/* Binary node made during a build, collapsed into bvh_node at the end. */
+typedef struct {
+	aabb box;
+	int left, right;
+	int first, count;
+} bvh_build_node;
+
+/**
+ * A build split into tasks.  bvh_build_begin splits the top of the tree
+ * serially into disjoint primitive ranges, bvh_build_task builds the
+ * subtree of one range and may run on any thread, and bvh_build_end
+ * packs the result once every task is done.  Each range writes its
+ * nodes to its own slots of the node pool, so tasks share nothing.
+ * The tree hangs from node root.
+ *
+ * The ranges partition ref, copies of the boxes with the primitive
+ * index in the unused w lane of min, so every pass streams through
+ * memory instead of gathering boxes by index.  The index is biased by
+ * BVH_REF_BIAS to read as a normal float; denormals in that lane would
+ * slow every add.
+ */
+typedef struct {
+	int count;
+	int tasks;
+	int top;
+	int root;
+	aabb *ref;
+	int *task;
+	int *depth;
+	bvh_build_node *node;
+} bvh_builder;
+
+static inline void bvh_free(bvh *tree)
+{
+	free(tree->prim);
+	free(tree->node);
+	memset(tree, 0, sizeof(*tree));
+}
+
+static inline void bvh_builder_free(bvh_builder *b)
+{
+	free(b->ref);
+	free(b->task);
+	free(b->depth);
+	free(b->node);
+	memset(b, 0, sizeof(*b));
+}
+
+/**
+ * Bounds of count triangles given as three vertex arrays.
+ */
+static inline void bvh_triangle_boxes(aabb *out, const vec3 *v0,
+		const vec3 *v1, const vec3 *v2, int count)
+{
+	for (int i = 0; i < count; i++) {
+		out[i].min = vec3_min(v0[i], vec3_min(v1[i], v2[i]));
+		out[i].max = vec3_max(v0[i], vec3_max(v1[i], v2[i]));
+	}
+}
+
+/* Makes node index a leaf over ref[first .. last) bounded by box. */
+static inline void bvh_build_leaf(bvh_builder *b, int index, int first,
+		int last, const aabb box)
+{
+	bvh_build_node *node = &b->node[index];
+	node->box = box;
+	node->left = node->right = -1;
+	node->first = first;
+	node->count = last - first;
+}
+
+static inline aabb bvh_build_bounds(const bvh_builder *b, int first, int last)
+{
+	aabb box = aabb_empty();
+	for (int i = first; i < last; i++)
+		box = aabb_merge(box, b->ref[i]);
+	return box;
+}
+
+/**
+ * Partitions ref[first .. last) at the cheapest binned plane on each
+ * axis, up to BVH_BINS per axis and fewer for small ranges.  All three
+ * axes are binned at once, one lane each, by min + max, twice the
+ * centroid.  Returns the split point and the bounds of both sides, or
+ * first when a leaf is cheaper.
+ */
+static inline int bvh_build_split(bvh_builder *b, int first, int last,
+		const aabb box, int depth, aabb *lbox, aabb *rbox)
+{
+	aabb bin[3][BVH_BINS], side[BVH_BINS], cbox = aabb_empty(), acc;
+	int cnt[3][BVH_BINS], n = last - first, axis = -1, split = 0;
+	int bins = n < BVH_BINS ? n : BVH_BINS;
+	float right[BVH_BINS], best = FLT_MAX, area = aabb_half_area(box);
+	aabb *ref = b->ref;
+	__m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	__m128 ext, scale;
+
+	if (n <= 1 || depth >= BVH_DEPTH_MAX)
+		return first;
+	for (int i = first; i < last; i++)
+		cbox = aabb_merge_point(cbox,
+			_mm_and_ps(_mm_add_ps(ref[i].min, ref[i].max), xyz));
+	ext = _mm_sub_ps(cbox.max, cbox.min);
+	scale = _mm_and_ps(_mm_cmpgt_ps(ext, _mm_setzero_ps()),
+		_mm_div_ps(_mm_set1_ps(bins * 0.9999f), ext));
+
+	for (int a = 0; a < 3; a++)
+		for (int j = 0; j < bins; j++) {
+			bin[a][j] = aabb_empty();
+			cnt[a][j] = 0;
+		}
+	for (int i = first; i < last; i++) {
+		int k[4];
+		_mm_storeu_si128((__m128i *)k, _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(
+			_mm_and_ps(_mm_add_ps(ref[i].min, ref[i].max), xyz), cbox.min),
+			scale)));
+		for (int a = 0; a < 3; a++) {
+			bin[a][k[a]] = aabb_merge(bin[a][k[a]], ref[i]);
+			cnt[a][k[a]]++;
+		}
+	}
+
+	for (int a = 0; a < 3; a++) {
+		int c = 0;
+		if (fidx(ext, a) <= 0.0f)
+			continue;
+		acc = aabb_empty();
+		for (int j = bins - 1; j > 0; j--) {
+			acc = aabb_merge(acc, bin[a][j]);
+			c += cnt[a][j];
+			right[j] = c * aabb_half_area(acc);
+			side[j] = acc;
+		}
+		acc = aabb_empty();
+		c = 0;
+		for (int j = 0; j < bins - 1; j++) {
+			float cost;
+			acc = aabb_merge(acc, bin[a][j]);
+			c += cnt[a][j];
+			if (!c || c == n)
+				continue;
+			cost = c * aabb_half_area(acc) + right[j + 1];
+			if (cost < best) {
+				best = cost;
+				axis = a;
+				split = j + 1;
+				*lbox = acc;
+				*rbox = side[j + 1];
+			}
+		}
+	}
+
+	/* every centroid coincides, any halving is as good */
+	if (axis < 0) {
+		if (n <= BVH_LEAF_MAX)
+			return first;
+		*lbox = bvh_build_bounds(b, first, first + n / 2);
+		*rbox = bvh_build_bounds(b, first + n / 2, last);
+		return first + n / 2;
+	}
+	/* one traversal step costs about one primitive test */
+	if (n <= BVH_LEAF_MAX && n * area <= area + best)
+		return first;
+
+	{
+		float lo = fidx(cbox.min, axis), s = fidx(scale, axis);
+		int i = first, j = last - 1;
+		while (i <= j) {
+			float c = fidx(ref[i].min, axis) + fidx(ref[i].max, axis);
+			if ((int)((c - lo) * s) < split) {
+				i++;
+			} else {
+				aabb tmp = ref[i];
+				ref[i] = ref[j];
+				ref[j--] = tmp;
+			}
+		}
+		return i;
+	}
+}
+
+/* Splits the leaf at index recursively, new nodes taken from *next. */
+static inline void bvh_build_subtree(bvh_builder *b, int index, int depth,
+		int *next)
+{
+	bvh_build_node *node = &b->node[index];
+	int first = node->first, last = first + node->count;
+	aabb lbox, rbox;
+	int mid = bvh_build_split(b, first, last, node->box, depth, &lbox, &rbox);
+	int left, right;
+
+	if (mid == first)
+		return;
+	left = (*next)++;
+	right = (*next)++;
+	node->left = left;
+	node->right = right;
+	node->count = 0;
+	bvh_build_leaf(b, left, first, mid, lbox);
+	bvh_build_leaf(b, right, mid, last, rbox);
+	bvh_build_subtree(b, left, depth + 1, next);
+	bvh_build_subtree(b, right, depth + 1, next);
+}
+
+/**
+ * Starts a build over count boxes.  The largest range is split until
+ * there are up to tasks ranges; b->tasks holds how many there are.
+ * Returns 0 on success, -1 when out of memory.
+ */
+static inline int bvh_build_begin(bvh_builder *b, const aabb *boxes,
+		int count, int tasks)
+{
+	__m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+
+	memset(b, 0, sizeof(*b));
+	tasks = tasks < 1 ? 1 : tasks;
+	b->count = count;
+	b->ref = malloc(sizeof(aabb) * (count + 1));
+	b->task = malloc(sizeof(int) * tasks);
+	b->depth = malloc(sizeof(int) * tasks);
+	b->node = malloc(sizeof(bvh_build_node) * (2 * count + 2 * tasks));
+	if (!b->ref || !b->task || !b->depth || !b->node)
+		goto fail;
+	if (!count)
+		return 0;
+
+	for (int i = 0; i < count; i++) {
+		__m128 index = _mm_castsi128_ps(_mm_set1_epi32(i + BVH_REF_BIAS));
+		b->ref[i].min = _mm_or_ps(_mm_and_ps(xyz, boxes[i].min),
+			_mm_andnot_ps(xyz, index));
+		b->ref[i].max = boxes[i].max;
+	}
+	/* slots below 2 * count belong to the ranges, the top goes above */
+	b->top = 2 * count;
+	b->root = b->task[0] = b->top++;
+	b->depth[0] = 0;
+	b->tasks = 1;
+	bvh_build_leaf(b, b->task[0], 0, count, bvh_build_bounds(b, 0, count));
+
+	while (b->tasks < tasks) {
+		int t = 0, index, mid, first, last;
+		aabb lbox, rbox;
+		for (int i = 1; i < b->tasks; i++)
+			if (b->node[b->task[i]].count > b->node[b->task[t]].count)
+				t = i;
+		index = b->task[t];
+		first = b->node[index].first;
+		last = first + b->node[index].count;
+		mid = bvh_build_split(b, first, last, b->node[index].box,
+			b->depth[t], &lbox, &rbox);
+		if (mid == first)
+			break;
+		b->node[index].left = b->top;
+		b->node[index].right = b->top + 1;
+		b->node[index].count = 0;
+		bvh_build_leaf(b, b->top, first, mid, lbox);
+		bvh_build_leaf(b, b->top + 1, mid, last, rbox);
+		b->task[t] = b->top++;
+		b->task[b->tasks] = b->top++;
+		b->depth[b->tasks++] = ++b->depth[t];
+	}
+	return 0;
+
+fail:
+	bvh_builder_free(b);
+	return -1;
+}
+
+/**
+ * Builds the subtree of task t.  Different tasks may run concurrently.
+ */
+static inline void bvh_build_task(bvh_builder *b, int t)
+{
+	int index = b->task[t];
+	int next = 2 * b->node[index].first;
+	bvh_build_subtree(b, index, b->depth[t], &next);
+}
+
+/**
+ * Emits the wide node for binary node index and its subtree.  Children
+ * are gathered by repeatedly opening the largest inner child, so each
+ * wide node takes the most useful BVH_WIDTH boxes of its subtree.
+ * Returns the node index, or -1 when out of memory.
+ */
+static inline int bvh_build_collapse(bvh_builder *b, bvh *tree, int index,
+		int *cap)
+{
+	const bvh_build_node *node = b->node;
+	int lane[BVH_WIDTH], n = 0, self;
+
+	if (node[index].left < 0) {
+		lane[n++] = index;
+	} else {
+		lane[n++] = node[index].left;
+		lane[n++] = node[index].right;
+	}
+	while (n < BVH_WIDTH) {
+		int open = -1;
+		float area = -1.0f;
+		for (int i = 0; i < n; i++)
+			if (node[lane[i]].left >= 0 &&
+					aabb_half_area(node[lane[i]].box) > area) {
+				area = aabb_half_area(node[lane[i]].box);
+				open = i;
+			}
+		if (open < 0)
+			break;
+		lane[n++] = node[lane[open]].right;
+		lane[open] = node[lane[open]].left;
+	}
+
+	if (tree->nodes == *cap) {
+		bvh_node *grown = realloc(tree->node, sizeof(bvh_node) * *cap * 2);
+		if (!grown)
+			return -1;
+		tree->node = grown;
+		*cap *= 2;
+	}
+	self = tree->nodes++;
+
+	for (int i = 0; i < BVH_WIDTH; i++) {
+		bvh_node *out = &tree->node[self];
+		aabb box = i < n ? node[lane[i]].box : aabb_empty();
+		for (int c = 0; c < 3; c++) {
+			out->bounds[c][i] = fidx(box.min, c);
+			out->bounds[c + 3][i] = fidx(box.max, c);
+		}
+		out->child[i] = -1;
+		out->count[i] = 0;
+		if (i >= n)
+			continue;
+		if (node[lane[i]].left < 0) {
+			out->child[i] = node[lane[i]].first;
+			out->count[i] = node[lane[i]].count;
+		} else {
+			int c = bvh_build_collapse(b, tree, lane[i], cap);
+			if (c < 0)
+				return -1;
+			tree->node[self].child[i] = c;
+		}
+	}
+	return self;
+}
+
+/**
+ * Finishes a build into tree and frees the builder.  Returns 0 on
+ * success, -1 when out of memory.
+ */
+static inline int bvh_build_end(bvh_builder *b, bvh *tree)
+{
+	int cap = 64;
+
+	memset(tree, 0, sizeof(*tree));
+	tree->count = b->count;
+	tree->bounds = aabb_empty();
+	tree->prim = malloc(sizeof(int) * (b->count + 1));
+	if (!tree->prim)
+		goto fail;
+	for (int i = 0; i < b->count; i++)
+		tree->prim[i] = _mm_cvtsi128_si32(_mm_shuffle_epi32(
+			_mm_castps_si128(b->ref[i].min), 0xff)) - BVH_REF_BIAS;
+	if (b->count) {
+		tree->node = malloc(sizeof(bvh_node) * cap);
+		if (!tree->node ||
+				bvh_build_collapse(b, tree, b->root, &cap) < 0)
+			goto fail;
+		tree->bounds = b->node[b->root].box;
+		tree->bounds.min = _mm_and_ps(tree->bounds.min, _mm_castsi128_ps(
+			_mm_setr_epi32(-1, -1, -1, 0)));
+	}
+	bvh_builder_free(b);
+	return 0;
+
+fail:
+	bvh_builder_free(b);
+	bvh_free(tree);
+	return -1;
+}
+
+/**
+ * Builds a tree over count boxes on the calling thread.  Returns 0 on
+ * success, -1 when out of memory.
+ */
+static inline int bvh_build(bvh *tree, const aabb *boxes, int count)
+{
+	bvh_builder b;
+	if (bvh_build_begin(&b, boxes, count, 1) < 0)
+		return -1;
+	if (b.tasks)
+		bvh_build_task(&b, 0);
+	return bvh_build_end(&b, tree);
+}
+
+static inline int bvh_build_triangles(bvh *tree, const vec3 *v0,
+		const vec3 *v1, const vec3 *v2, int count)
+{
+	aabb *boxes = malloc(sizeof(aabb) * (count + 1));
+	int ret;
+	if (!boxes)
+		return -1;
+	bvh_triangle_boxes(boxes, v0, v1, v2, count);
+	ret = bvh_build(tree, boxes, count);
+	free(boxes);
+	return ret;
+}
+
+/**
+ * Refits every box to moved primitives, keeping the topology, for
+ * animated meshes.  Children come after their parent, so one backwards
+ * pass sees every child finished.  Pass boxes, or NULL and triangles.
+ */
+static inline void bvh_refit_prims(bvh *tree, const aabb *boxes,
+		const vec3 *v0, const vec3 *v1, const vec3 *v2)
+{
+	for (int k = tree->nodes - 1; k >= 0; k--) {
+		bvh_node *node = &tree->node[k];
+		for (int i = 0; i < BVH_WIDTH; i++) {
+			aabb box = aabb_empty();
+			if (node->count[i]) {
+				for (int j = 0; j < node->count[i]; j++) {
+					int p = tree->prim[node->child[i] + j];
+					if (boxes) {
+						box = aabb_merge(box, boxes[p]);
+					} else {
+						box = aabb_merge_point(box, v0[p]);
+						box = aabb_merge_point(box, v1[p]);
+						box = aabb_merge_point(box, v2[p]);
+					}
+				}
+			} else if (node->child[i] >= 0) {
+				const bvh_node *c = &tree->node[node->child[i]];
+				for (int j = 0; j < BVH_WIDTH; j++) {
+					vec3 lo = _mm_setr_ps(c->bounds[0][j], c->bounds[1][j],
+						c->bounds[2][j], 0.0f);
+					vec3 hi = _mm_setr_ps(c->bounds[3][j], c->bounds[4][j],
+						c->bounds[5][j], 0.0f);
+					box.min = vec3_min(box.min, lo);
+					box.max = vec3_max(box.max, hi);
+				}
+			} else {
+				continue;
+			}
+			for (int c = 0; c < 3; c++) {
+				node->bounds[c][i] = fidx(box.min, c);
+				node->bounds[c + 3][i] = fidx(box.max, c);
+			}
+		}
+	}
+	tree->bounds = aabb_empty();
+	for (int i = 0; tree->nodes && i < BVH_WIDTH; i++) {
+		const bvh_node *root = &tree->node[0];
+		tree->bounds.min = vec3_min(tree->bounds.min, _mm_setr_ps(
+			root->bounds[0][i], root->bounds[1][i], root->bounds[2][i], 0.0f));
+		tree->bounds.max = vec3_max(tree->bounds.max, _mm_setr_ps(
+			root->bounds[3][i], root->bounds[4][i], root->bounds[5][i], 0.0f));
+	}
+}
+
+static inline void bvh_refit(bvh *tree, const aabb *boxes)
+{
+	bvh_refit_prims(tree, boxes, NULL, NULL, NULL);
+}
+
+static inline void bvh_refit_triangles(bvh *tree, const vec3 *v0,
+		const vec3 *v1, const vec3 *v2)
+{
+	bvh_refit_prims(tree, NULL, v0, v1, v2);
+}
+
+/**
+ * Slab tests a ray against the children of a node.  Returns the hit
+ * mask and writes the entry distance of every child.
+ */
+static inline int bvh_node_ray(const bvh_node *node, const ray_slab *r,
+		float tmax, float *tnear)
+{
+	int mask;
+#ifdef __AVX__
+	aabb_soa8 b;
+	__m256 t;
+	b.min.x = _mm256_loadu_ps(node->bounds[0]);
+	b.min.y = _mm256_loadu_ps(node->bounds[1]);
+	b.min.z = _mm256_loadu_ps(node->bounds[2]);
+	b.max.x = _mm256_loadu_ps(node->bounds[3]);
+	b.max.y = _mm256_loadu_ps(node->bounds[4]);
+	b.max.z = _mm256_loadu_ps(node->bounds[5]);
+	mask = ray_aabb_soa8(r, &b, tmax, &t);
+	_mm256_storeu_ps(tnear, t);
+#else
+	aabb_soa b;
+	__m128 t;
+	b.min.x = _mm_loadu_ps(node->bounds[0]);
+	b.min.y = _mm_loadu_ps(node->bounds[1]);
+	b.min.z = _mm_loadu_ps(node->bounds[2]);
+	b.max.x = _mm_loadu_ps(node->bounds[3]);
+	b.max.y = _mm_loadu_ps(node->bounds[4]);
+	b.max.z = _mm_loadu_ps(node->bounds[5]);
+	mask = ray_aabb_soa(r, &b, tmax, &t);
+	_mm_storeu_ps(tnear, t);
+#endif
+	return mask;
+}
+
+/**
+ * Returns the mask of children of a node overlapping q, touching counts.
+ */
+static inline int bvh_node_overlap(const bvh_node *node, const aabb q)
+{
+#ifdef __AVX__
+	__m256 out = _mm256_setzero_ps();
+	for (int c = 0; c < 3; c++) {
+		out = _mm256_or_ps(out, _mm256_cmp_ps(_mm256_loadu_ps(node->bounds[c]),
+			_mm256_set1_ps(fidx(q.max, c)), _CMP_GT_OQ));
+		out = _mm256_or_ps(out, _mm256_cmp_ps(_mm256_set1_ps(fidx(q.min, c)),
+			_mm256_loadu_ps(node->bounds[c + 3]), _CMP_GT_OQ));
+	}
+	return ~_mm256_movemask_ps(out) & 0xff;
+#else
+	__m128 out = _mm_setzero_ps();
+	for (int c = 0; c < 3; c++) {
+		out = _mm_or_ps(out, _mm_cmpgt_ps(_mm_loadu_ps(node->bounds[c]),
+			_mm_set1_ps(fidx(q.max, c))));
+		out = _mm_or_ps(out, _mm_cmpgt_ps(_mm_set1_ps(fidx(q.min, c)),
+			_mm_loadu_ps(node->bounds[c + 3])));
+	}
+	return ~_mm_movemask_ps(out) & 0xf;
+#endif
+}
+
+/**
+ * The shared ray traversal.  Hit children are pushed far to near so the
+ * nearest is visited first, and leaves are pushed as ~(node * BVH_WIDTH
+ * + child) to be tested in the same order.  With any set, returns at
+ * the first hit.  Tests triangles, or boxes when v0 is NULL.  Returns
+ * the primitive index, or -1.
+ */
+static inline int bvh_ray_query(const bvh *tree, const aabb *boxes,
+		const vec3 *v0, const vec3 *v1, const vec3 *v2, const ray *r,
+		float tmax, int any, float *t, float *u, float *v)
+{
+	ray_slab rs = ray_slab_init(r);
+	int stack[BVH_STACK], top = 0, best = -1;
+	float dist[BVH_STACK];
+
+	if (!tree->nodes)
+		return -1;
+	stack[top] = 0;
+	dist[top++] = 0.0f;
+	while (top) {
+		const bvh_node *node;
+		float near[BVH_WIDTH];
+		int order[BVH_WIDTH], n = 0, e = stack[--top], mask;
+
+		if (dist[top] >= tmax)
+			continue;
+		if (e < 0) {
+			node = &tree->node[~e / BVH_WIDTH];
+			e = ~e % BVH_WIDTH;
+			for (int j = 0; j < node->count[e]; j++) {
+				int p = tree->prim[node->child[e] + j];
+				float d;
+				int hit;
+				if (v0)
+					hit = ray_triangle(r, v0[p], v1[p], v2[p], tmax, t, u, v);
+				else if ((hit = ray_aabb(&rs, &boxes[p], tmax, &d) && d < tmax))
+					*t = d;
+				if (hit) {
+					tmax = *t;
+					best = p;
+					if (any)
+						return best;
+				}
+			}
+			continue;
+		}
+
+		node = &tree->node[e];
+		mask = bvh_node_ray(node, &rs, tmax, near);
+		for (; mask; mask &= mask - 1) {
+			int i = __builtin_ctz(mask), j = n++;
+			for (; j > 0 && near[order[j - 1]] < near[i]; j--)
+				order[j] = order[j - 1];
+			order[j] = i;
+		}
+		for (int k = 0; k < n; k++) {
+			int i = order[k];
+			stack[top] = node->count[i] ? ~(e * BVH_WIDTH + i) : node->child[i];
+			dist[top++] = near[i];
+		}
+	}
+	return best;
+}
+
+/**
+ * Finds the closest triangle hit before tmax.  Returns its index, or -1
+ * with t, u, v untouched.
+ */
+static inline int bvh_closest_triangle(const bvh *tree, const vec3 *v0,
+		const vec3 *v1, const vec3 *v2, const ray *r, float tmax,
+		float *t, float *u, float *v)
+{
+	return bvh_ray_query(tree, NULL, v0, v1, v2, r, tmax, 0, t, u, v);
+}
+
+/**
+ * Tests whether any triangle is hit before tmax, for shadow rays.
+ */
+static inline int bvh_any_triangle(const bvh *tree, const vec3 *v0,
+		const vec3 *v1, const vec3 *v2, const ray *r, float tmax)
+{
+	float t, u, v;
+	return bvh_ray_query(tree, NULL, v0, v1, v2, r, tmax, 1, &t, &u, &v) >= 0;
+}
+
+/**
+ * Finds the box with the closest entry before tmax, 0 when the ray
+ * starts inside.  Returns its index, or -1.
+ */
+static inline int bvh_closest_aabb(const bvh *tree, const aabb *boxes,
+		const ray *r, float tmax, float *t)
+{
+	float u, v;
+	return bvh_ray_query(tree, boxes, NULL, NULL, NULL, r, tmax, 0, t, &u, &v);
+}
+
+static inline int bvh_any_aabb(const bvh *tree, const aabb *boxes,
+		const ray *r, float tmax)
+{
+	float t, u, v;
+	return bvh_ray_query(tree, boxes, NULL, NULL, NULL, r, tmax, 1,
+		&t, &u, &v) >= 0;
+}
+
+/**
+ * Traces four rays together, for coherent rays such as neighbouring
+ * pixels.  Each node is fetched once for the packet and slab tested per
+ * active ray; a child is pushed with the mask of rays that hit it, and
+ * a leaf tests each triangle against those rays at once.  Writes prim,
+ * t, u, v per ray, prim -1 on a miss, and returns the mask of rays
+ * that hit.  With any set, a ray drops out at its first hit.
+ */
+static inline int bvh_packet_query(const bvh *tree, const vec3 *v0,
+		const vec3 *v1, const vec3 *v2, const ray *r, float tmax, int any,
+		int *prim, float *t, float *u, float *v)
+{
+	ray_slab rs[4];
+	ray_soa rp = ray_soa_load(r);
+	__m128 far = _mm_set1_ps(tmax), bu = _mm_setzero_ps(), bv = bu;
+	int stack[BVH_STACK], active[BVH_STACK], top = 0, done = 0, hit = 0;
+	float dist[BVH_STACK], lim[4];
+
+	for (int k = 0; k < 4; k++) {
+		rs[k] = ray_slab_init(&r[k]);
+		prim[k] = -1;
+	}
+	if (!tree->nodes)
+		return 0;
+	stack[top] = 0;
+	active[top] = 0xf;
+	dist[top++] = 0.0f;
+	while (top) {
+		const bvh_node *node;
+		float near[4][BVH_WIDTH], cnear[BVH_WIDTH], reach = -1.0f;
+		int order[BVH_WIDTH], cmask[BVH_WIDTH] = {0}, n = 0;
+		int e = stack[--top], m = active[top] & ~done;
+
+		_mm_storeu_ps(lim, far);
+		for (int k = 0; k < 4; k++)
+			if ((m >> k) & 1)
+				reach = lim[k] > reach ? lim[k] : reach;
+		if (!m || dist[top] >= reach)
+			continue;
+		if (e < 0) {
+			node = &tree->node[~e / BVH_WIDTH];
+			e = ~e % BVH_WIDTH;
+			for (int j = 0; j < node->count[e]; j++) {
+				int p = tree->prim[node->child[e] + j], h;
+				__m128 tt, uu, vv, sel;
+				h = ray_soa_triangle(&rp, v0[p], v1[p], v2[p], far,
+					&tt, &uu, &vv) & m;
+				if (!h)
+					continue;
+				sel = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_and_si128(
+					_mm_set1_epi32(h), _mm_setr_epi32(1, 2, 4, 8)),
+					_mm_setzero_si128()));
+				far = _mm_or_ps(_mm_and_ps(sel, tt), _mm_andnot_ps(sel, far));
+				bu = _mm_or_ps(_mm_and_ps(sel, uu), _mm_andnot_ps(sel, bu));
+				bv = _mm_or_ps(_mm_and_ps(sel, vv), _mm_andnot_ps(sel, bv));
+				for (int k = 0; k < 4; k++)
+					if ((h >> k) & 1)
+						prim[k] = p;
+				hit |= h;
+				if (any) {
+					done |= h;
+					m &= ~h;
+					if (done == 0xf)
+						break;
+				}
+			}
+			continue;
+		}
+
+		node = &tree->node[e];
+		for (int i = 0; i < BVH_WIDTH; i++)
+			cnear[i] = FLT_MAX;
+		for (int k = 0; k < 4; k++) {
+			int mask;
+			if (!((m >> k) & 1))
+				continue;
+			mask = bvh_node_ray(node, &rs[k], lim[k], near[k]);
+			for (; mask; mask &= mask - 1) {
+				int i = __builtin_ctz(mask);
+				cmask[i] |= 1 << k;
+				cnear[i] = near[k][i] < cnear[i] ? near[k][i] : cnear[i];
+			}
+		}
+		for (int i = 0; i < BVH_WIDTH; i++) {
+			int j = n;
+			if (!cmask[i])
+				continue;
+			for (n++; j > 0 && cnear[order[j - 1]] < cnear[i]; j--)
+				order[j] = order[j - 1];
+			order[j] = i;
+		}
+		for (int k = 0; k < n; k++) {
+			int i = order[k];
+			stack[top] = node->count[i] ? ~(e * BVH_WIDTH + i) : node->child[i];
+			active[top] = cmask[i];
+			dist[top++] = cnear[i];
+		}
+	}
+	_mm_storeu_ps(t, far);
+	_mm_storeu_ps(u, bu);
+	_mm_storeu_ps(v, bv);
+	return hit;
+}
+
+/**
+ * Finds the closest triangle hit before tmax for each of four rays.
+ * Returns the mask of rays that hit; t, u, v are only meaningful there.
+ */
+static inline int bvh_closest_triangle4(const bvh *tree, const vec3 *v0,
+		const vec3 *v1, const vec3 *v2, const ray *r, float tmax,
+		int *prim, float *t, float *u, float *v)
+{
+	return bvh_packet_query(tree, v0, v1, v2, r, tmax, 0, prim, t, u, v);
+}
+
+/**
+ * Returns the mask of four rays that hit any triangle before tmax.
+ */
+static inline int bvh_any_triangle4(const bvh *tree, const vec3 *v0,
+		const vec3 *v1, const vec3 *v2, const ray *r, float tmax)
+{
+	int prim[4];
+	float t[4], u[4], v[4];
+	return bvh_packet_query(tree, v0, v1, v2, r, tmax, 1, prim, t, u, v);
+}
+
+/**
+ * Finds the primitives whose boxes overlap q.  With boxes NULL every
+ * primitive of an overlapping leaf is reported.  Writes at most max
+ * indices to out and returns how many were found.
+ */
+static inline int bvh_overlap(const bvh *tree, const aabb *boxes,
+		const aabb q, int *out, int max)
+{
+	int stack[BVH_STACK], top = 0, found = 0;
+
+	if (!tree->nodes)
+		return 0;
+	stack[top++] = 0;
+	while (top) {
+		const bvh_node *node = &tree->node[stack[--top]];
+		int mask = bvh_node_overlap(node, q);
+		for (; mask; mask &= mask - 1) {
+			int i = __builtin_ctz(mask);
+			if (!node->count[i]) {
+				if (node->child[i] >= 0)
+					stack[top++] = node->child[i];
+				continue;
+			}
+			for (int j = 0; j < node->count[i]; j++) {
+				int p = tree->prim[node->child[i] + j];
+				if (boxes && !aabb_overlap(boxes[p], q))
+					continue;
+				if (found < max)
+					out[found] = p;
+				found++;
+			}
+		}
+	}
+	return found;
+}
+
+#endif
+
+#endif /* _GMATH_BVH_H_ */
@@ -0,0 +1,148 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * dquat.h
+ * Handles unit dual quaternions for rigid transforms
+ *
+ */
+
+#ifndef _GMATH_DQUAT_H_
+#define _GMATH_DQUAT_H_
+
+#include "constants.h"
+#include "quat.h"
+#include "mat4.h"
+
+/**
+ * Builds the dual quaternion rotating by r then translating by t.
+ */
+static inline dquat dquat_from_rt(const quat r, const vec3 t)
+{
+	dquat out;
+	out.real = r;
+#ifndef __SSE__
+	quat tq = {t[0] * 0.5f, t[1] * 0.5f, t[2] * 0.5f, 0.0f};
+#else
+	quat tq = _mm_and_ps(_mm_mul_ps(t, _mm_set1_ps(0.5f)),
+		_mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+#endif
+	out.dual = quat_mul(tq, r);
+	return out;
+}
+
+/**
+ * Converts a rigid transform matrix (rotation and translation only).
+ */
+static inline dquat dquat_from_mat4(const mat4 m)
+{
+	return dquat_from_rt(quat_from_mat4(m), m.col[3]);
+}
+
+static inline vec3 dquat_get_translation(const dquat dq)
+{
+	quat t = quat_mul(dq.dual, quat_conjugate(dq.real));
+	return vec4_add(t, t);
+}
+
+static inline mat4 dquat_to_mat4(const dquat dq)
+{
+	mat4 out = quat_to_mat4(dq.real);
+	out.col[3] = dquat_get_translation(dq);
+	fidx(out.col[3], 3) = 1.0f;
+	return out;
+}
+
+/**
+ * Concatenates two transforms, b is applied first.
+ */
+static inline dquat dquat_mul(const dquat a, const dquat b)
+{
+	dquat out;
+	out.real = quat_mul(a.real, b.real);
+	out.dual = vec4_add(quat_mul(a.real, b.dual), quat_mul(a.dual, b.real));
+	return out;
+}
+
+static inline dquat dquat_conjugate(const dquat dq)
+{
+	dquat out;
+	out.real = quat_conjugate(dq.real);
+	out.dual = quat_conjugate(dq.dual);
+	return out;
+}
+
+/**
+ * Scales to a unit real part and removes the component of the dual
+ * part along the real part, so the result is a rigid transform again.
+ */
+static inline dquat dquat_normalize(const dquat dq)
+{
+	dquat out;
+#ifndef __SSE__
+	float r = 1.0f / sqrtf(vec4_dot(dq.real, dq.real));
+	out.real = vec4_scale(dq.real, r);
+	out.dual = vec4_scale(dq.dual, r);
+	out.dual = vec4_sub(out.dual,
+		vec4_scale(out.real, vec4_dot(out.real, out.dual)));
+#else
+	__m128 r = rsqrt_ps(vec4_dot_m128(dq.real, dq.real));
+	out.real = _mm_mul_ps(dq.real, r);
+	out.dual = _mm_mul_ps(dq.dual, r);
+	out.dual = _mm_sub_ps(out.dual, _mm_mul_ps(out.real,
+		vec4_dot_m128(out.real, out.dual)));
+#endif
+	return out;
+}
+
+/**
+ * Weighted blend of count transforms followed by normalization
+ * (dual quaternion linear blending).  Each transform is flipped into
+ * the hemisphere of the first so the blend takes the shortest path.
+ */
+static inline dquat dquat_blend(const dquat *dq, const float *weight,
+		int count)
+{
+	dquat out;
+	out.real = vec4_scale(dq[0].real, weight[0]);
+	out.dual = vec4_scale(dq[0].dual, weight[0]);
+	for (int i = 1; i < count; i++) {
+		float w = vec4_dot(dq[0].real, dq[i].real) < 0.0f ?
+			-weight[i] : weight[i];
+		out.real = vec4_add(out.real, vec4_scale(dq[i].real, w));
+		out.dual = vec4_add(out.dual, vec4_scale(dq[i].dual, w));
+	}
+	return dquat_normalize(out);
+}
+
+/**
+ * Transforms a point by a unit dual quaternion.  The translation is
+ * 2 (w_r d - w_d r + r x d) over the vector parts.
+ */
+static inline vec3 dquat_transform_point(const dquat dq, const vec3 p)
+{
+#ifndef __SSE__
+	vec3 t, out = quat_rotate_vec3(dq.real, p);
+	const float *r = dq.real, *d = dq.dual;
+	t[0] = r[3] * d[0] - d[3] * r[0] + r[1] * d[2] - r[2] * d[1];
+	t[1] = r[3] * d[1] - d[3] * r[1] + r[2] * d[0] - r[0] * d[2];
+	t[2] = r[3] * d[2] - d[3] * r[2] + r[0] * d[1] - r[1] * d[0];
+	out[0] += 2.0f * t[0];
+	out[1] += 2.0f * t[1];
+	out[2] += 2.0f * t[2];
+	return out;
+#else
+	__m128 t = _mm_sub_ps(_mm_mul_ps(VEC4_WWWW(dq.real), dq.dual),
+		_mm_mul_ps(VEC4_WWWW(dq.dual), dq.real));
+	t = _mm_add_ps(t, vec3_cross(dq.real, dq.dual));
+	return _mm_add_ps(quat_rotate_vec3(dq.real, p), _mm_add_ps(t, t));
+#endif
+}
+
+static inline vec3 dquat_transform_normal(const dquat dq, const vec3 n)
+{
+	return quat_rotate_vec3(dq.real, n);
+}
+
+#endif /* _GMATH_DQUAT_H_ */
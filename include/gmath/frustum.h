@@ -0,0 +1,331 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * frustum.h
+ * Handles view frustum extraction and culling
+ *
+ */
+
+#ifndef _GMATH_FRUSTUM_H_
+#define _GMATH_FRUSTUM_H_
+
+#include "constants.h"
+#include "vec4.h"
+#include "mat4.h"
+#include "aabb.h"
+
+/**
+ * Extracts the planes of a view projection matrix (Gribb and Hartmann),
+ * for clip space -w <= x, y, z <= w.  Planes are normalized so sphere
+ * radii can be compared against the distances.
+ */
+static inline frustum frustum_from_mat4(const mat4 m)
+{
+	mat4 t = mat4_transpose(m);
+	frustum f;
+	f.plane[0] = vec4_add(t.col[3], t.col[0]);
+	f.plane[1] = vec4_sub(t.col[3], t.col[0]);
+	f.plane[2] = vec4_add(t.col[3], t.col[1]);
+	f.plane[3] = vec4_sub(t.col[3], t.col[1]);
+	f.plane[4] = vec4_add(t.col[3], t.col[2]);
+	f.plane[5] = vec4_sub(t.col[3], t.col[2]);
+	for (int i = 0; i < 6; i++)
+		f.plane[i] = vec4_scale(f.plane[i],
+			1.0f / vec3_length(f.plane[i]));
+	return f;
+}
+
+/**
+ * Tests a sphere (centre xyz, radius w), nonzero if any part of it may
+ * be inside.
+ */
+static inline int frustum_test_sphere(const frustum *f, const vec4 s)
+{
+	for (int i = 0; i < 6; i++) {
+		const vec4 p = f->plane[i];
+		if (fidx(p, 0) * fidx(s, 0) + fidx(p, 1) * fidx(s, 1) +
+				fidx(p, 2) * fidx(s, 2) + fidx(p, 3) < -fidx(s, 3))
+			return 0;
+	}
+	return 1;
+}
+
+/**
+ * Tests a box, nonzero unless it is entirely behind one plane.
+ */
+static inline int frustum_test_aabb(const frustum *f, const aabb *b)
+{
+	vec3 c = aabb_center(*b), e = aabb_extent(*b);
+	for (int i = 0; i < 6; i++) {
+		const vec4 p = f->plane[i];
+		if (fidx(p, 0) * fidx(c, 0) + fidx(p, 1) * fidx(c, 1) +
+				fidx(p, 2) * fidx(c, 2) + fidx(p, 3) <
+				-(fabsf(fidx(p, 0)) * fidx(e, 0) +
+				fabsf(fidx(p, 1)) * fidx(e, 1) +
+				fabsf(fidx(p, 2)) * fidx(e, 2)))
+			return 0;
+	}
+	return 1;
+}
+
+/**
+ * Planes prepared for the batch kernels, with the components broadcast
+ * across registers and the absolute normals for the box test.
+ */
+typedef struct {
+	frustum f;
+#ifdef __SSE__
+	__m128 x[6], y[6], z[6], d[6];
+	__m128 ax[6], ay[6], az[6];
+#endif
+#ifdef __AVX__
+	__m256 x8[6], y8[6], z8[6], d8[6];
+	__m256 ax8[6], ay8[6], az8[6];
+#endif
+} frustum_soa;
+
+static inline void frustum_soa_init(frustum_soa *out, const frustum *f)
+{
+	out->f = *f;
+#ifdef __SSE__
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(SIGN_MASK));
+	for (int i = 0; i < 6; i++) {
+		out->x[i] = VEC4_XXXX(f->plane[i]);
+		out->y[i] = VEC4_YYYY(f->plane[i]);
+		out->z[i] = VEC4_ZZZZ(f->plane[i]);
+		out->d[i] = VEC4_WWWW(f->plane[i]);
+		out->ax[i] = _mm_andnot_ps(sign, out->x[i]);
+		out->ay[i] = _mm_andnot_ps(sign, out->y[i]);
+		out->az[i] = _mm_andnot_ps(sign, out->z[i]);
+#ifdef __AVX__
+		out->x8[i] = _mm256_set_m128(out->x[i], out->x[i]);
+		out->y8[i] = _mm256_set_m128(out->y[i], out->y[i]);
+		out->z8[i] = _mm256_set_m128(out->z[i], out->z[i]);
+		out->d8[i] = _mm256_set_m128(out->d[i], out->d[i]);
+		out->ax8[i] = _mm256_set_m128(out->ax[i], out->ax[i]);
+		out->ay8[i] = _mm256_set_m128(out->ay[i], out->ay[i]);
+		out->az8[i] = _mm256_set_m128(out->az[i], out->az[i]);
+#endif
+	}
+#endif
+}
+
+#ifdef __SSE__
+/**
+ * Tests four spheres against all six planes, returning a 4 bit mask
+ * of the visible ones.
+ */
+static inline int frustum_soa_spheres4(const frustum_soa *f, const vec4 *s)
+{
+	__m128 x = s[0], y = s[1], z = s[2], r = s[3];
+	__m128 out = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(x, y, z, r);
+	r = _mm_xor_ps(r, _mm_castsi128_ps(_mm_set1_epi32(SIGN_MASK)));
+	for (int i = 0; i < 6; i++) {
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(f->x[i], x),
+			_mm_mul_ps(f->y[i], y)), _mm_add_ps(_mm_mul_ps(f->z[i], z),
+			f->d[i]));
+		out = _mm_or_ps(out, _mm_cmplt_ps(d, r));
+	}
+	return ~_mm_movemask_ps(out) & 15;
+}
+
+/**
+ * Tests four boxes against all six planes, returning a 4 bit mask of
+ * the visible ones.
+ */
+static inline int frustum_soa_aabbs4(const frustum_soa *f, const aabb *b)
+{
+	__m128 x0 = b[0].min, y0 = b[1].min, z0 = b[2].min, w0 = b[3].min;
+	__m128 x1 = b[0].max, y1 = b[1].max, z1 = b[2].max, w1 = b[3].max;
+	__m128 half = _mm_set1_ps(0.5f), out = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(x0, y0, z0, w0);
+	_MM_TRANSPOSE4_PS(x1, y1, z1, w1);
+	__m128 cx = _mm_mul_ps(_mm_add_ps(x0, x1), half);
+	__m128 cy = _mm_mul_ps(_mm_add_ps(y0, y1), half);
+	__m128 cz = _mm_mul_ps(_mm_add_ps(z0, z1), half);
+	__m128 ex = _mm_mul_ps(_mm_sub_ps(x1, x0), half);
+	__m128 ey = _mm_mul_ps(_mm_sub_ps(y1, y0), half);
+	__m128 ez = _mm_mul_ps(_mm_sub_ps(z1, z0), half);
+	for (int i = 0; i < 6; i++) {
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(f->x[i], cx),
+			_mm_mul_ps(f->y[i], cy)), _mm_add_ps(_mm_mul_ps(f->z[i], cz),
+			f->d[i]));
+		__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(f->ax[i], ex),
+			_mm_mul_ps(f->ay[i], ey)), _mm_mul_ps(f->az[i], ez));
+		out = _mm_or_ps(out, _mm_cmplt_ps(_mm_add_ps(d, r),
+			_mm_setzero_ps()));
+	}
+	return ~_mm_movemask_ps(out) & 15;
+}
+#endif
+
+#ifdef __AVX__
+/* Transposes eight vec4 into four registers of one component each. */
+static inline void frustum_load8(const vec4 *v, __m256 *x, __m256 *y,
+		__m256 *z, __m256 *w)
+{
+	__m256 r0 = _mm256_set_m128(v[4], v[0]), r1 = _mm256_set_m128(v[5], v[1]);
+	__m256 r2 = _mm256_set_m128(v[6], v[2]), r3 = _mm256_set_m128(v[7], v[3]);
+	__m256 t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpackhi_ps(r0, r1);
+	__m256 t2 = _mm256_unpacklo_ps(r2, r3), t3 = _mm256_unpackhi_ps(r2, r3);
+	*x = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1,0,1,0));
+	*y = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3,2,3,2));
+	*z = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1,0,1,0));
+	*w = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3,2,3,2));
+}
+
+static inline int frustum_soa_spheres8(const frustum_soa *f, const vec4 *s)
+{
+	__m256 x, y, z, r, out = _mm256_setzero_ps();
+	frustum_load8(s, &x, &y, &z, &r);
+	r = _mm256_xor_ps(r, _mm256_castsi256_ps(_mm256_set1_epi32(SIGN_MASK)));
+	for (int i = 0; i < 6; i++) {
+		__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(f->x8[i], x),
+			_mm256_mul_ps(f->y8[i], y)), _mm256_add_ps(
+			_mm256_mul_ps(f->z8[i], z), f->d8[i]));
+		out = _mm256_or_ps(out, _mm256_cmp_ps(d, r, _CMP_LT_OQ));
+	}
+	return ~_mm256_movemask_ps(out) & 255;
+}
+
+static inline int frustum_soa_aabbs8(const frustum_soa *f, const aabb *b)
+{
+	vec4 lo[8], hi[8];
+	__m256 x0, y0, z0, w0, x1, y1, z1, w1;
+	__m256 half = _mm256_set1_ps(0.5f), out = _mm256_setzero_ps();
+	for (int i = 0; i < 8; i++) {
+		lo[i] = b[i].min;
+		hi[i] = b[i].max;
+	}
+	frustum_load8(lo, &x0, &y0, &z0, &w0);
+	frustum_load8(hi, &x1, &y1, &z1, &w1);
+	__m256 cx = _mm256_mul_ps(_mm256_add_ps(x0, x1), half);
+	__m256 cy = _mm256_mul_ps(_mm256_add_ps(y0, y1), half);
+	__m256 cz = _mm256_mul_ps(_mm256_add_ps(z0, z1), half);
+	__m256 ex = _mm256_mul_ps(_mm256_sub_ps(x1, x0), half);
+	__m256 ey = _mm256_mul_ps(_mm256_sub_ps(y1, y0), half);
+	__m256 ez = _mm256_mul_ps(_mm256_sub_ps(z1, z0), half);
+	for (int i = 0; i < 6; i++) {
+		__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(f->x8[i], cx),
+			_mm256_mul_ps(f->y8[i], cy)), _mm256_add_ps(
+			_mm256_mul_ps(f->z8[i], cz), f->d8[i]));
+		__m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(f->ax8[i], ex),
+			_mm256_mul_ps(f->ay8[i], ey)), _mm256_mul_ps(f->az8[i], ez));
+		out = _mm256_or_ps(out, _mm256_cmp_ps(_mm256_add_ps(d, r),
+			_mm256_setzero_ps(), _CMP_LT_OQ));
+	}
+	return ~_mm256_movemask_ps(out) & 255;
+}
+#endif
+
+/**
+ * Visibility of n <= 8 spheres starting at s, one bit each.
+ */
+static inline int frustum_spheres8(const frustum_soa *f, const vec4 *s, int n)
+{
+	int mask = 0, i = 0;
+#ifdef __AVX__
+	if (n == 8)
+		return frustum_soa_spheres8(f, s);
+#endif
+#ifdef __SSE__
+	for (; i + 4 <= n; i += 4)
+		mask |= frustum_soa_spheres4(f, s + i) << i;
+#endif
+	for (; i < n; i++)
+		mask |= frustum_test_sphere(&f->f, s[i]) << i;
+	return mask;
+}
+
+static inline int frustum_aabbs8(const frustum_soa *f, const aabb *b, int n)
+{
+	int mask = 0, i = 0;
+#ifdef __AVX__
+	if (n == 8)
+		return frustum_soa_aabbs8(f, b);
+#endif
+#ifdef __SSE__
+	for (; i + 4 <= n; i += 4)
+		mask |= frustum_soa_aabbs4(f, b + i) << i;
+#endif
+	for (; i < n; i++)
+		mask |= frustum_test_aabb(&f->f, &b[i]) << i;
+	return mask;
+}
+
+/* Appends the set bits of a mask as indices, without branches. */
+static inline int frustum_compact(int *visible, int n, int base, int mask,
+		int bits)
+{
+	for (int j = 0; j < bits; j++) {
+		visible[n] = base + j;
+		n += mask >> j & 1;
+	}
+	return n;
+}
+
+/**
+ * Culls count spheres (centre xyz, radius w), writing the indices of
+ * the visible ones in order.  Returns how many were written.
+ */
+static inline int frustum_cull_spheres(const frustum *f, const vec4 *s,
+		int count, int *visible)
+{
+	frustum_soa soa;
+	int n = 0;
+	frustum_soa_init(&soa, f);
+	for (int i = 0; i < count; i += 8) {
+		int k = count - i < 8 ? count - i : 8;
+		n = frustum_compact(visible, n, i, frustum_spheres8(&soa, s + i, k), k);
+	}
+	return n;
+}
+
+/**
+ * Culls count spheres into a bitmask, bit i % 8 of mask[i / 8] is set
+ * when sphere i is visible.
+ */
+static inline void frustum_cull_spheres_mask(const frustum *f, const vec4 *s,
+		int count, unsigned char *mask)
+{
+	frustum_soa soa;
+	frustum_soa_init(&soa, f);
+	for (int i = 0; i < count; i += 8)
+		mask[i / 8] = (unsigned char)frustum_spheres8(&soa, s + i,
+			count - i < 8 ? count - i : 8);
+}
+
+/**
+ * Culls count boxes, writing the indices of the visible ones in order.
+ * Returns how many were written.
+ */
+static inline int frustum_cull_aabbs(const frustum *f, const aabb *b,
+		int count, int *visible)
+{
+	frustum_soa soa;
+	int n = 0;
+	frustum_soa_init(&soa, f);
+	for (int i = 0; i < count; i += 8) {
+		int k = count - i < 8 ? count - i : 8;
+		n = frustum_compact(visible, n, i, frustum_aabbs8(&soa, b + i, k), k);
+	}
+	return n;
+}
+
+/**
+ * Culls count boxes into a bitmask laid out as for spheres.
+ */
+static inline void frustum_cull_aabbs_mask(const frustum *f, const aabb *b,
+		int count, unsigned char *mask)
+{
+	frustum_soa soa;
+	frustum_soa_init(&soa, f);
+	for (int i = 0; i < count; i += 8)
+		mask[i / 8] = (unsigned char)frustum_aabbs8(&soa, b + i,
+			count - i < 8 ? count - i : 8);
+}
+
+#endif /* _GMATH_FRUSTUM_H_ */
@@ -0,0 +1,615 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * gjk.h
+ * Handles distance and penetration queries between convex shapes
+ *
+ */
+
+#ifndef _GMATH_GJK_H_
+#define _GMATH_GJK_H_
+
+#include <string.h>
+#include <math.h>
+#include "constants.h"
+#include "vec3.h"
+#include "quat.h"
+
+#ifdef __SSE__
+
+/* Iteration caps; EPA adds a polytope vertex per iteration. */
+#define GJK_ITER_MAX 64
+#define EPA_ITER_MAX 64
+#define EPA_FACES_MAX 128
+#define EPA_EDGES_MAX 64
+
+/* Relative tolerances of GJK convergence and EPA expansion. */
+#define GJK_EPSILON 1e-6f
+#define EPA_EPSILON 1e-4f
+
+/* Outcomes of a GJK step. */
+#define GJK_CONTINUE 0
+#define GJK_SEPARATED 1
+#define GJK_OVERLAP 2
+
+/**
+ * A convex shape as a core swept by a sphere of radius.  The core is
+ * a box of half extents half, or when point is set the hull of count
+ * points, in the frame rotated by rot about pos.  A sphere has a point
+ * for a core and a capsule a segment along the local y axis; GJK works
+ * on the cores and adds the radii after, so both are exact.
+ */
+typedef struct {
+	vec3 pos, half;
+	quat rot;
+	float radius;
+	const vec3 *point;
+	int count;
+} gjk_shape;
+
+/**
+ * The closest points of two shapes, or the deepest when they overlap,
+ * the unit normal from a to b and the distance, negative on overlap.
+ */
+typedef struct {
+	vec3 pa, pb, normal;
+	float distance;
+} gjk_contact;
+
+/**
+ * A simplex of the difference of two cores, w = a - b, with the point
+ * v closest to the origin at weights l.
+ */
+typedef struct {
+	vec3 w[4], a[4], b[4];
+	float l[4];
+	vec3 v;
+	int count;
+} gjk_simplex;
+
+static inline gjk_shape gjk_sphere(const vec3 centre, float radius)
+{
+	gjk_shape s;
+	memset(&s, 0, sizeof(s));
+	s.pos = centre;
+	s.half = _mm_setzero_ps();
+	s.rot = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+	s.radius = radius;
+	return s;
+}
+
+static inline gjk_shape gjk_box(const vec3 centre, const quat rot,
+		const vec3 half)
+{
+	gjk_shape s = gjk_sphere(centre, 0.0f);
+	s.rot = rot;
+	s.half = half;
+	return s;
+}
+
+/* A capsule of radius around the segment of half_height along y. */
+static inline gjk_shape gjk_capsule(const vec3 centre, const quat rot,
+		float half_height, float radius)
+{
+	gjk_shape s = gjk_sphere(centre, radius);
+	s.rot = rot;
+	s.half = _mm_setr_ps(0.0f, half_height, 0.0f, 0.0f);
+	return s;
+}
+
+/* The hull of count points, which must outlive the shape. */
+static inline gjk_shape gjk_hull(const vec3 pos, const quat rot,
+		const vec3 *point, int count)
+{
+	gjk_shape s = gjk_sphere(pos, 0.0f);
+	s.rot = rot;
+	s.point = point;
+	s.count = count;
+	return s;
+}
+
+/* The point furthest along d, four points at a time. */
+static inline vec3 gjk_hull_support(const vec3 *p, int count, const vec3 d)
+{
+	vec3_soa dd = vec3_soa_splat(d);
+	__m128 best = _mm_set1_ps(-INFINITY), index = _mm_setzero_ps();
+	__m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	float bd = -INFINITY;
+	int i = 0, bi = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 dot = vec3_soa_dot(vec3_soa_load(p + i), dd);
+		__m128 gt = _mm_cmpgt_ps(dot, best);
+		best = _mm_or_ps(_mm_and_ps(gt, dot), _mm_andnot_ps(gt, best));
+		index = _mm_or_ps(_mm_and_ps(gt, lane), _mm_andnot_ps(gt, index));
+		lane = _mm_add_ps(lane, _mm_set1_ps(4.0f));
+	}
+	for (int k = 0; k < 4; k++)
+		if (fidx(best, k) > bd) {
+			bd = fidx(best, k);
+			bi = (int)fidx(index, k);
+		}
+	for (; i < count; i++)
+		if (vec3_dot(p[i], d) > bd) {
+			bd = vec3_dot(p[i], d);
+			bi = i;
+		}
+	return p[bi];
+}
+
+/* The point of the core of s furthest along d. */
+static inline vec3 gjk_support_core(const gjk_shape *s, const vec3 d)
+{
+	vec3 l = quat_rotate_vec3(quat_conjugate(s->rot), d), p;
+	if (s->point)
+		p = gjk_hull_support(s->point, s->count, l);
+	else
+		p = _mm_or_ps(_mm_and_ps(l, _mm_set1_ps(-0.0f)), s->half);
+	return vec3_add(s->pos, quat_rotate_vec3(s->rot, p));
+}
+
+/* The point of s furthest along d, radius included. */
+static inline vec3 gjk_support(const gjk_shape *s, const vec3 d)
+{
+	vec3 p = gjk_support_core(s, d);
+	float dd = vec3_dot(d, d);
+	if (s->radius > 0.0f && dd > 0.0f)
+		p = vec3_add(p, vec3_scale(d, s->radius / sqrtf(dd)));
+	return p;
+}
+
+/* Keeps the n vertices idx of s at weights l and sets v. */
+static inline void gjk_reduce(gjk_simplex *s, const int *idx,
+		const float *l, int n)
+{
+	vec3 w[4], a[4], b[4];
+	for (int i = 0; i < n; i++) {
+		w[i] = s->w[idx[i]];
+		a[i] = s->a[idx[i]];
+		b[i] = s->b[idx[i]];
+	}
+	s->v = _mm_setzero_ps();
+	for (int i = 0; i < n; i++) {
+		s->w[i] = w[i];
+		s->a[i] = a[i];
+		s->b[i] = b[i];
+		s->l[i] = l[i];
+		s->v = vec3_add(s->v, vec3_scale(w[i], l[i]));
+	}
+	s->count = n;
+}
+
+/**
+ * Closest point to the origin on segment i, j of s.  Writes the
+ * vertices it lies on and their weights, and returns how many.
+ */
+static inline int gjk_segment(const gjk_simplex *s, int i, int j,
+		int *idx, float *l)
+{
+	vec3 ab = vec3_sub(s->w[j], s->w[i]);
+	float t = -vec3_dot(s->w[i], ab), den = vec3_dot(ab, ab);
+
+	idx[0] = t < den ? i : j;
+	l[0] = 1.0f;
+	if (t <= 0.0f || t >= den)
+		return 1;
+	idx[1] = j;
+	l[1] = t / den;
+	l[0] = 1.0f - l[1];
+	return 2;
+}
+
+/**
+ * gjk_segment for triangle i, j, k, by its Voronoi regions as in
+ * Ericson's Real-Time Collision Detection 5.1.5.
+ */
+static inline int gjk_triangle(const gjk_simplex *s, int i, int j, int k,
+		int *idx, float *l)
+{
+	vec3 a = s->w[i], b = s->w[j], c = s->w[k];
+	vec3 ab = vec3_sub(b, a), ac = vec3_sub(c, a);
+	float d1 = -vec3_dot(ab, a), d2 = -vec3_dot(ac, a);
+	float d3 = -vec3_dot(ab, b), d4 = -vec3_dot(ac, b);
+	float d5 = -vec3_dot(ab, c), d6 = -vec3_dot(ac, c);
+	float va, vb, vc, den;
+
+	l[0] = 1.0f;
+	if (d1 <= 0.0f && d2 <= 0.0f) {
+		idx[0] = i;
+		return 1;
+	}
+	if (d3 >= 0.0f && d4 <= d3) {
+		idx[0] = j;
+		return 1;
+	}
+	if (d6 >= 0.0f && d5 <= d6) {
+		idx[0] = k;
+		return 1;
+	}
+	vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		return gjk_segment(s, i, j, idx, l);
+	vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		return gjk_segment(s, i, k, idx, l);
+	va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+		return gjk_segment(s, j, k, idx, l);
+	den = 1.0f / (va + vb + vc);
+	idx[0] = i;
+	idx[1] = j;
+	idx[2] = k;
+	l[1] = vb * den;
+	l[2] = vc * den;
+	l[0] = 1.0f - l[1] - l[2];
+	return 3;
+}
+
+/**
+ * gjk_segment for the tetrahedron of s, from the faces the origin is
+ * outside of.  Returns 4 when the origin is inside.
+ */
+static inline int gjk_tetrahedron(const gjk_simplex *s, int *idx, float *l)
+{
+	static const int face[4][4] = {
+		{0, 1, 2, 3}, {0, 3, 1, 2}, {0, 2, 3, 1}, {1, 3, 2, 0}
+	};
+	float bd = INFINITY;
+	int n = 4;
+
+	for (int f = 0; f < 4; f++) {
+		vec3 a = s->w[face[f][0]];
+		vec3 e = vec3_cross(vec3_sub(s->w[face[f][1]], a),
+			vec3_sub(s->w[face[f][2]], a));
+		float sp = -vec3_dot(a, e);
+		float sd = vec3_dot(vec3_sub(s->w[face[f][3]], a), e);
+		/* a flat tetrahedron has no inside */
+		if (sp * sd < 0.0f || sd == 0.0f) {
+			int fi[3];
+			float fl[3], dd;
+			int fn = gjk_triangle(s, face[f][0], face[f][1], face[f][2],
+				fi, fl);
+			vec3 v = _mm_setzero_ps();
+			for (int i = 0; i < fn; i++)
+				v = vec3_add(v, vec3_scale(s->w[fi[i]], fl[i]));
+			dd = vec3_dot(v, v);
+			if (dd < bd) {
+				bd = dd;
+				n = fn;
+				memcpy(idx, fi, sizeof(fi));
+				memcpy(l, fl, sizeof(fl));
+			}
+		}
+	}
+	return n;
+}
+
+/* Starts a simplex at one pair of support points. */
+static inline void gjk_simplex_init(gjk_simplex *s, const vec3 a,
+		const vec3 b)
+{
+	s->count = 1;
+	s->a[0] = a;
+	s->b[0] = b;
+	s->w[0] = s->v = vec3_sub(a, b);
+	s->l[0] = 1.0f;
+}
+
+/**
+ * Adds the support points a and b found along -v and v, then moves v
+ * to the closest point of the new simplex.  Stops when the support
+ * point gets no closer than v, or, once it is margin beyond the origin,
+ * when the cores are known to be further apart than margin.
+ */
+static inline int gjk_step(gjk_simplex *s, const vec3 a, const vec3 b,
+		float margin)
+{
+	vec3 w = vec3_sub(a, b);
+	float vv = vec3_dot(s->v, s->v), vw = vec3_dot(s->v, w), wmax = 0.0f;
+	float l[3];
+	int idx[3], n;
+
+	if (vw > 0.0f && vw * vw > vv * margin * margin)
+		return GJK_SEPARATED;
+	if (vv - vw <= GJK_EPSILON * vv)
+		return GJK_SEPARATED;
+	for (int i = 0; i < s->count; i++)
+		if ((_mm_movemask_ps(_mm_cmpeq_ps(w, s->w[i])) & 7) == 7)
+			return GJK_SEPARATED;
+	s->w[s->count] = w;
+	s->a[s->count] = a;
+	s->b[s->count] = b;
+	switch (++s->count) {
+	case 2:
+		n = gjk_segment(s, 0, 1, idx, l);
+		break;
+	case 3:
+		n = gjk_triangle(s, 0, 1, 2, idx, l);
+		break;
+	default:
+		n = gjk_tetrahedron(s, idx, l);
+	}
+	if (n == 4)
+		return GJK_OVERLAP;
+	for (int i = 0; i < s->count; i++)
+		wmax = fmaxf(wmax, vec3_dot(s->w[i], s->w[i]));
+	gjk_reduce(s, idx, l, n);
+	if (vec3_dot(s->v, s->v) <= GJK_EPSILON * wmax)
+		return GJK_OVERLAP;
+	return GJK_CONTINUE;
+}
+
+/**
+ * Runs GJK between the cores of a and b.  Returns GJK_OVERLAP when
+ * they intersect, else GJK_SEPARATED with s->v from b's core to a's.
+ */
+static inline int gjk_core(const gjk_shape *a, const gjk_shape *b,
+		float margin, gjk_simplex *s)
+{
+	vec3 d = vec3_sub(b->pos, a->pos);
+	if (vec3_dot(d, d) == 0.0f)
+		d = _mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	gjk_simplex_init(s, gjk_support_core(a, d),
+		gjk_support_core(b, vec3_neg(d)));
+	if (vec3_dot(s->v, s->v) == 0.0f)
+		return GJK_OVERLAP;
+	for (int i = 0; i < GJK_ITER_MAX; i++) {
+		int status = gjk_step(s, gjk_support_core(a, vec3_neg(s->v)),
+			gjk_support_core(b, s->v), margin);
+		if (status != GJK_CONTINUE)
+			return status;
+	}
+	return GJK_SEPARATED;
+}
+
+/**
+ * Returns nonzero when a and b intersect, touching included.  Stops as
+ * soon as a plane separates them.
+ */
+static inline int gjk_overlap(const gjk_shape *a, const gjk_shape *b)
+{
+	gjk_simplex s;
+	float r = a->radius + b->radius;
+	return gjk_core(a, b, r, &s) == GJK_OVERLAP ||
+		vec3_dot(s.v, s.v) <= r * r;
+}
+
+/* Fills c from the simplex of separated cores and returns distance. */
+static inline float gjk_separated(const gjk_shape *a, const gjk_shape *b,
+		const gjk_simplex *s, gjk_contact *c)
+{
+	float d = sqrtf(vec3_dot(s->v, s->v));
+	if (c) {
+		vec3 pa = _mm_setzero_ps(), pb = _mm_setzero_ps();
+		for (int i = 0; i < s->count; i++) {
+			pa = vec3_add(pa, vec3_scale(s->a[i], s->l[i]));
+			pb = vec3_add(pb, vec3_scale(s->b[i], s->l[i]));
+		}
+		c->normal = vec3_scale(s->v, -1.0f / d);
+		c->pa = vec3_add(pa, vec3_scale(c->normal, a->radius));
+		c->pb = vec3_sub(pb, vec3_scale(c->normal, b->radius));
+		c->distance = d - a->radius - b->radius;
+	}
+	return d - a->radius - b->radius;
+}
+
+/* A face of the EPA polytope, outward unit normal n at distance d. */
+typedef struct {
+	int v[3];
+	vec3 n;
+	float d;
+} gjk_face;
+
+static inline void gjk_face_init(gjk_face *f, const vec3 *w, int i, int j,
+		int k)
+{
+	vec3 n = vec3_cross(vec3_sub(w[j], w[i]), vec3_sub(w[k], w[i]));
+	float nn = vec3_dot(n, n);
+	f->v[0] = i;
+	f->v[1] = j;
+	f->v[2] = k;
+	/* a sliver is never picked nor seen */
+	f->n = nn > 0.0f ? vec3_scale(n, 1.0f / sqrtf(nn)) : _mm_setzero_ps();
+	f->d = nn > 0.0f ? vec3_dot(f->n, w[i]) : INFINITY;
+}
+
+/**
+ * Grows the simplex of overlapping cores into a tetrahedron with
+ * support points of the whole shapes.  Returns 0 when the shapes are
+ * flat and have no volume to expand into.
+ */
+static inline int gjk_expand(const gjk_shape *a, const gjk_shape *b,
+		gjk_simplex *s)
+{
+	static const float axis[6][3] = {
+		{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}
+	};
+	vec3 w0 = s->w[0];
+
+	for (int k = 0; s->count == 1 && k < 6; k++) {
+		vec3 d = _mm_setr_ps(axis[k][0], axis[k][1], axis[k][2], 0.0f);
+		vec3 pa = gjk_support(a, d), pb = gjk_support(b, vec3_neg(d));
+		vec3 e = vec3_sub(vec3_sub(pa, pb), w0);
+		if (vec3_dot(e, e) > GJK_EPSILON * vec3_dot(w0, w0)) {
+			s->w[1] = vec3_sub(pa, pb);
+			s->a[1] = pa;
+			s->b[1] = pb;
+			s->count = 2;
+		}
+	}
+	if (s->count == 2) {
+		vec3 d = vec3_sub(s->w[1], w0), dir[4];
+		vec3 m = _mm_andnot_ps(_mm_set1_ps(-0.0f), d);
+		int k = fidx(m, 1) < fidx(m, 0) ? 1 : 0;
+		k = fidx(m, 2) < fidx(m, k) ? 2 : k;
+		dir[0] = vec3_cross(d, _mm_setr_ps(axis[2 * k][0], axis[2 * k][1],
+			axis[2 * k][2], 0.0f));
+		dir[1] = vec3_neg(dir[0]);
+		dir[2] = vec3_cross(d, dir[0]);
+		dir[3] = vec3_neg(dir[2]);
+		for (k = 0; s->count == 2 && k < 4; k++) {
+			vec3 pa = gjk_support(a, dir[k]), pb = gjk_support(b,
+				vec3_neg(dir[k]));
+			vec3 e = vec3_sub(vec3_sub(pa, pb), w0), n = vec3_cross(d, e);
+			if (vec3_dot(n, n) > GJK_EPSILON * vec3_dot(d, d) *
+					vec3_dot(e, e)) {
+				s->w[2] = vec3_sub(pa, pb);
+				s->a[2] = pa;
+				s->b[2] = pb;
+				s->count = 3;
+			}
+		}
+	}
+	if (s->count == 3) {
+		vec3 n = vec3_cross(vec3_sub(s->w[1], w0), vec3_sub(s->w[2], w0));
+		for (int k = 0; s->count == 3 && k < 2; k++) {
+			vec3 d = k ? vec3_neg(n) : n;
+			vec3 pa = gjk_support(a, d), pb = gjk_support(b, vec3_neg(d));
+			vec3 e = vec3_sub(vec3_sub(pa, pb), w0);
+			float h = vec3_dot(e, n);
+			if (h * h > GJK_EPSILON * vec3_dot(n, n) * vec3_dot(e, e)) {
+				s->w[3] = vec3_sub(pa, pb);
+				s->a[3] = pa;
+				s->b[3] = pb;
+				s->count = 4;
+			}
+		}
+	}
+	return s->count == 4;
+}
+
+/* Adds edge i, j to the horizon, or cancels it against j, i. */
+static inline int gjk_edge(int (*edge)[2], int *count, int i, int j)
+{
+	for (int k = 0; k < *count; k++)
+		if (edge[k][0] == j && edge[k][1] == i) {
+			edge[k][0] = edge[*count - 1][0];
+			edge[k][1] = edge[*count - 1][1];
+			--*count;
+			return 1;
+		}
+	if (*count == EPA_EDGES_MAX)
+		return 0;
+	edge[*count][0] = i;
+	edge[*count][1] = j;
+	++*count;
+	return 1;
+}
+
+/**
+ * Expanding polytope algorithm from the simplex of overlapping cores:
+ * grows a polytope inside the difference of the whole shapes towards
+ * its face nearest the origin, which gives the depth and normal.
+ */
+static inline float gjk_epa(const gjk_shape *a, const gjk_shape *b,
+		gjk_simplex *s, gjk_contact *c)
+{
+	vec3 w[EPA_ITER_MAX + 4], pa[EPA_ITER_MAX + 4], pb[EPA_ITER_MAX + 4];
+	gjk_face face[EPA_FACES_MAX], f;
+	int edge[EPA_EDGES_MAX][2];
+	int nv = 4, nf = 4;
+	float u, v, t, d00, d01, d11, d20, d21, den;
+	vec3 e0, e1, e2;
+
+	if (!gjk_expand(a, b, s)) {
+		if (c) {
+			c->pa = c->pb = s->a[0];
+			c->normal = _mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f);
+			c->distance = 0.0f;
+		}
+		return 0.0f;
+	}
+	for (int i = 0; i < 4; i++) {
+		w[i] = s->w[i];
+		pa[i] = s->a[i];
+		pb[i] = s->b[i];
+	}
+	/* the fourth vertex below face 0, 1, 2 */
+	if (vec3_dot(vec3_cross(vec3_sub(w[1], w[0]), vec3_sub(w[2], w[0])),
+			vec3_sub(w[3], w[0])) > 0.0f) {
+		vec3 tw = w[1], ta = pa[1], tb = pb[1];
+		w[1] = w[2], pa[1] = pa[2], pb[1] = pb[2];
+		w[2] = tw, pa[2] = ta, pb[2] = tb;
+	}
+	gjk_face_init(&face[0], w, 0, 1, 2);
+	gjk_face_init(&face[1], w, 0, 3, 1);
+	gjk_face_init(&face[2], w, 0, 2, 3);
+	gjk_face_init(&face[3], w, 1, 3, 2);
+
+	for (int iter = 0;; iter++) {
+		int best = 0, ne = 0, ok = 1;
+		vec3 sa, sb, p;
+		for (int i = 1; i < nf; i++)
+			if (face[i].d < face[best].d)
+				best = i;
+		f = face[best];
+		if (iter == EPA_ITER_MAX || f.d == INFINITY)
+			break;
+		sa = gjk_support(a, f.n);
+		sb = gjk_support(b, vec3_neg(f.n));
+		p = vec3_sub(sa, sb);
+		if (vec3_dot(p, f.n) - f.d <= EPA_EPSILON * fabsf(vec3_dot(p, f.n)))
+			break;
+		w[nv] = p;
+		pa[nv] = sa;
+		pb[nv] = sb;
+		for (int i = 0; i < nf && ok;) {
+			if (vec3_dot(face[i].n, vec3_sub(p, w[face[i].v[0]])) > 0.0f) {
+				ok = gjk_edge(edge, &ne, face[i].v[0], face[i].v[1]) &&
+					gjk_edge(edge, &ne, face[i].v[1], face[i].v[2]) &&
+					gjk_edge(edge, &ne, face[i].v[2], face[i].v[0]);
+				face[i] = face[--nf];
+			} else {
+				i++;
+			}
+		}
+		if (!ok || nf + ne > EPA_FACES_MAX)
+			break;
+		for (int i = 0; i < ne; i++)
+			gjk_face_init(&face[nf++], w, edge[i][0], edge[i][1], nv);
+		nv++;
+	}
+
+	/* weights of the origin's projection on the face */
+	e0 = vec3_sub(w[f.v[1]], w[f.v[0]]);
+	e1 = vec3_sub(w[f.v[2]], w[f.v[0]]);
+	e2 = vec3_sub(vec3_scale(f.n, f.d), w[f.v[0]]);
+	d00 = vec3_dot(e0, e0);
+	d01 = vec3_dot(e0, e1);
+	d11 = vec3_dot(e1, e1);
+	d20 = vec3_dot(e2, e0);
+	d21 = vec3_dot(e2, e1);
+	den = d00 * d11 - d01 * d01;
+	v = den != 0.0f ? (d11 * d20 - d01 * d21) / den : 0.0f;
+	t = den != 0.0f ? (d00 * d21 - d01 * d20) / den : 0.0f;
+	u = 1.0f - v - t;
+	if (c) {
+		c->pa = vec3_add(vec3_add(vec3_scale(pa[f.v[0]], u),
+			vec3_scale(pa[f.v[1]], v)), vec3_scale(pa[f.v[2]], t));
+		c->pb = vec3_add(vec3_add(vec3_scale(pb[f.v[0]], u),
+			vec3_scale(pb[f.v[1]], v)), vec3_scale(pb[f.v[2]], t));
+		c->normal = f.n;
+		c->distance = -f.d;
+	}
+	return -f.d;
+}
+
+/**
+ * Signed distance between a and b, negative when they overlap, and the
+ * contact in c when not NULL.  Separated and shallow rounded shapes
+ * need GJK alone; EPA runs once the cores overlap.
+ */
+static inline float gjk_distance(const gjk_shape *a, const gjk_shape *b,
+		gjk_contact *c)
+{
+	gjk_simplex s;
+	if (gjk_core(a, b, INFINITY, &s) == GJK_OVERLAP)
+		return gjk_epa(a, b, &s, c);
+	return gjk_separated(a, b, &s, c);
+}
+
+#endif
+
+#endif /* _GMATH_GJK_H_ */
@@ -14,5 +14,26 @@
 #include "vec3.h"
 #include "vec4.h"
 #include "quat.h"
+#include "mat4.h"
+#include "dquat.h"
+#include "quatpack.h"
+#include "anim.h"
+#include "xform.h"
+#include "aabb.h"
+#include "frustum.h"
+#include "project.h"
+#include "occlusion.h"
+#include "ray.h"
+#include "svd.h"
+#include "obb.h"
+#include "bvh.h"
+#include "task.h"
+#include "radix.h"
+#include "sap.h"
+#include "grid.h"
+#include "morton.h"
+#include "lbvh.h"
+#include "gjk.h"
+#include "skin.h"
 
 #endif /* _GMATH_H_ */
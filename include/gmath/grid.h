@@ -0,0 +1,325 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * grid.h
+ * Handles uniform grid hashing of points for radius queries
+ *
+ */
+
+#ifndef _GMATH_GRID_H_
+#define _GMATH_GRID_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "task.h"
+#include "vec3.h"
+#include "aabb.h"
+
+/* Floats of padding after each position array, one AVX register. */
+#define GRID_PAD 8
+
+/**
+ * Points bucketed by hashed cell.  Cells are cubes of side cell from
+ * the min corner of the points' bounds; dim clamps cell coordinates to
+ * the bounds.  Bucket b holds sorted points [start[b], start[b + 1]),
+ * with the positions kept as structure of arrays in that order and
+ * index mapping them back to the input.
+ */
+typedef struct {
+	int count, mask;
+	int dim[3];
+	float cell, inv_cell;
+	vec3 origin;
+	int *start;
+	int *index;
+	float *x, *y, *z;
+} grid;
+
+/**
+ * Build state, so the two passes of the counting sort can be split
+ * into ranges of points and run on as many threads.
+ */
+typedef struct {
+	grid *g;
+	const vec3 *points;
+	int tasks;
+	int *key;
+	int *hist;
+} grid_builder;
+
+static inline void grid_free(grid *g)
+{
+	free(g->start);
+	free(g->index);
+	free(g->x);
+	memset(g, 0, sizeof(*g));
+}
+
+static inline void grid_builder_free(grid_builder *b)
+{
+	free(b->key);
+	free(b->hist);
+	memset(b, 0, sizeof(*b));
+}
+
+/* Cell coordinate of p along axis, clamped to the grid. */
+static inline int grid_coord(const grid *g, float p, int axis)
+{
+	float f = (p - fidx(g->origin, axis)) * g->inv_cell;
+	f = f < 0.0f ? 0.0f : f;
+	return f < (float)(g->dim[axis] - 1) ? (int)f : g->dim[axis] - 1;
+}
+
+/* Neighbours along x land in neighbouring buckets. */
+static inline int grid_hash(const grid *g, int i, int j, int k)
+{
+	return (int)((((unsigned int)j * 73856093u ^ (unsigned int)k * 19349663u) +
+		(unsigned int)i) & (unsigned int)g->mask);
+}
+
+/**
+ * Sizes the grid for count points and sets up tasks ranges for
+ * grid_build_count and grid_build_scatter.  The table has a bucket per
+ * point rounded up to a power of two.  Returns 0 on success, -1 when
+ * out of memory.
+ */
+static inline int grid_build_begin(grid_builder *b, grid *g,
+		const vec3 *points, int count, float cell, int tasks)
+{
+	int stride = count + GRID_PAD, buckets = 1;
+	aabb box = aabb_from_points(points, count);
+
+	memset(b, 0, sizeof(*b));
+	memset(g, 0, sizeof(*g));
+	while (buckets < count)
+		buckets <<= 1;
+	tasks = tasks < 1 ? 1 : tasks;
+	g->count = count;
+	g->mask = buckets - 1;
+	g->cell = cell;
+	g->inv_cell = 1.0f / cell;
+	g->origin = count ? box.min : _mm_setzero_ps();
+	for (int i = 0; i < 3; i++) {
+		float extent = count ? (fidx(box.max, i) - fidx(box.min, i)) *
+			g->inv_cell : 0.0f;
+		g->dim[i] = (extent < (float)(1 << 30) ? (int)extent : 1 << 30) + 1;
+	}
+	g->start = malloc(sizeof(int) * (buckets + 1));
+	g->index = malloc(sizeof(int) * (count + 1));
+	g->x = malloc(sizeof(float) * 3 * stride);
+	b->g = g;
+	b->points = points;
+	b->tasks = tasks;
+	b->key = malloc(sizeof(int) * (count + 1));
+	b->hist = calloc((size_t)tasks * buckets, sizeof(int));
+	if (!g->start || !g->index || !g->x || !b->key || !b->hist)
+		goto fail;
+	g->y = g->x + stride;
+	g->z = g->y + stride;
+	return 0;
+
+fail:
+	grid_builder_free(b);
+	grid_free(g);
+	return -1;
+}
+
+/**
+ * First pass over the points of task t: hashes each into its bucket
+ * and counts the bucket sizes for the task.
+ */
+static inline void grid_build_count(grid_builder *b, int t)
+{
+	const grid *g = b->g;
+	int *hist = b->hist + (size_t)t * (g->mask + 1);
+	int last = task_first(g->count, b->tasks, t + 1);
+
+	for (int i = task_first(g->count, b->tasks, t); i < last; i++) {
+		vec3 p = b->points[i];
+		int key = grid_hash(g, grid_coord(g, fidx(p, 0), 0),
+			grid_coord(g, fidx(p, 1), 1), grid_coord(g, fidx(p, 2), 2));
+		b->key[i] = key;
+		hist[key]++;
+	}
+}
+
+/**
+ * Turns the counts of every task into bucket starts and each task's
+ * write offsets, so points keep their input order within a bucket.
+ * Runs once, after all counts and before any scatter.
+ */
+static inline void grid_build_offsets(grid_builder *b)
+{
+	grid *g = b->g;
+	int buckets = g->mask + 1, sum = 0;
+
+	for (int k = 0; k < buckets; k++) {
+		g->start[k] = sum;
+		for (int t = 0; t < b->tasks; t++) {
+			int *h = &b->hist[(size_t)t * buckets + k];
+			int n = *h;
+			*h = sum;
+			sum += n;
+		}
+	}
+	g->start[buckets] = sum;
+}
+
+/* Second pass over the points of task t, moving them into place. */
+static inline void grid_build_scatter(grid_builder *b, int t)
+{
+	grid *g = b->g;
+	int *offset = b->hist + (size_t)t * (g->mask + 1);
+	int last = task_first(g->count, b->tasks, t + 1);
+
+	for (int i = task_first(g->count, b->tasks, t); i < last; i++) {
+		int j = offset[b->key[i]]++;
+		vec3 p = b->points[i];
+		g->index[j] = i;
+		g->x[j] = fidx(p, 0);
+		g->y[j] = fidx(p, 1);
+		g->z[j] = fidx(p, 2);
+	}
+}
+
+/* Pads the position arrays and releases the build state. */
+static inline void grid_build_end(grid_builder *b)
+{
+	grid *g = b->g;
+	for (int i = g->count; i < g->count + GRID_PAD; i++) {
+		g->x[i] = 0.0f;
+		g->y[i] = 0.0f;
+		g->z[i] = 0.0f;
+	}
+	grid_builder_free(b);
+}
+
+/**
+ * Builds a grid over count points on the calling thread.  Returns 0 on
+ * success, -1 when out of memory.
+ */
+static inline int grid_build(grid *g, const vec3 *points, int count,
+		float cell)
+{
+	grid_builder b;
+	if (grid_build_begin(&b, g, points, count, cell, 1))
+		return -1;
+	grid_build_count(&b, 0);
+	grid_build_offsets(&b);
+	grid_build_scatter(&b, 0);
+	grid_build_end(&b);
+	return 0;
+}
+
+/* Appends the points of the set bits of mask at j in the row of c. */
+static inline int grid_emit(const grid *g, const int c[3], int j, int mask,
+		int *out, int found, int max)
+{
+	for (; mask; mask &= mask - 1) {
+		int p = j + __builtin_ctz(mask);
+		/* rows sharing buckets report each point once, from its own */
+		if (grid_coord(g, g->y[p], 1) != c[1] ||
+				grid_coord(g, g->z[p], 2) != c[2])
+			continue;
+		if (found < max)
+			out[found] = g->index[p];
+		found++;
+	}
+	return found;
+}
+
+/* Distance tests the sorted points [first, last) against centre. */
+static inline int grid_scan(const grid *g, const vec3 centre, float r2,
+		const int c[3], int first, int last, int *out, int found, int max)
+{
+#ifdef __AVX__
+	vec3_soa8 q;
+	__m256 rr = _mm256_set1_ps(r2);
+	__m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+	q.x = _mm256_set1_ps(fidx(centre, 0));
+	q.y = _mm256_set1_ps(fidx(centre, 1));
+	q.z = _mm256_set1_ps(fidx(centre, 2));
+	for (int j = first; j < last; j += 8) {
+		vec3_soa8 p, d;
+		__m256 in;
+		p.x = _mm256_loadu_ps(g->x + j);
+		p.y = _mm256_loadu_ps(g->y + j);
+		p.z = _mm256_loadu_ps(g->z + j);
+		d = vec3_soa8_sub(p, q);
+		in = _mm256_cmp_ps(vec3_soa8_dot(d, d), rr, _CMP_LE_OQ);
+		in = _mm256_and_ps(in, _mm256_cmp_ps(lane,
+			_mm256_set1_ps((float)(last - j)), _CMP_LT_OQ));
+		found = grid_emit(g, c, j, _mm256_movemask_ps(in), out, found, max);
+	}
+#elif defined(__SSE__)
+	vec3_soa q = vec3_soa_splat(centre);
+	__m128 rr = _mm_set1_ps(r2);
+	__m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+	for (int j = first; j < last; j += 4) {
+		vec3_soa p, d;
+		__m128 in;
+		p.x = _mm_loadu_ps(g->x + j);
+		p.y = _mm_loadu_ps(g->y + j);
+		p.z = _mm_loadu_ps(g->z + j);
+		d = vec3_soa_sub(p, q);
+		in = _mm_cmple_ps(vec3_soa_dot(d, d), rr);
+		in = _mm_and_ps(in, _mm_castsi128_ps(_mm_cmpgt_epi32(
+			_mm_set1_epi32(last - j), lane)));
+		found = grid_emit(g, c, j, _mm_movemask_ps(in), out, found, max);
+	}
+#else
+	for (int j = first; j < last; j++) {
+		float dx = g->x[j] - centre[0], dy = g->y[j] - centre[1];
+		float dz = g->z[j] - centre[2];
+		if (dx * dx + dy * dy + dz * dz <= r2)
+			found = grid_emit(g, c, j, 1, out, found, max);
+	}
+#endif
+	return found;
+}
+
+/**
+ * Finds the points within radius of centre, inclusive, by distance
+ * tests of a register of points at a time.  A row of cells along x
+ * hashes to consecutive buckets, so each row the sphere touches is one
+ * run of sorted points, or two where it wraps around the table.
+ * Writes at most max input indices to out and returns how many were
+ * found.
+ */
+static inline int grid_radius(const grid *g, const vec3 centre, float radius,
+		int *out, int max)
+{
+	int lo[3], hi[3], c[3], found = 0;
+	float r2 = radius * radius;
+
+	if (!g->count)
+		return 0;
+	for (int i = 0; i < 3; i++) {
+		lo[i] = grid_coord(g, fidx(centre, i) - radius, i);
+		hi[i] = grid_coord(g, fidx(centre, i) + radius, i);
+	}
+	c[0] = lo[0];
+	for (c[2] = lo[2]; c[2] <= hi[2]; c[2]++)
+	for (c[1] = lo[1]; c[1] <= hi[1]; c[1]++) {
+		int first = grid_hash(g, lo[0], c[1], c[2]);
+		int last = grid_hash(g, hi[0], c[1], c[2]);
+		if (hi[0] - lo[0] >= g->mask) {
+			/* the row covers the whole table */
+			found = grid_scan(g, centre, r2, c, 0, g->count, out, found, max);
+		} else if (first <= last) {
+			found = grid_scan(g, centre, r2, c, g->start[first],
+				g->start[last + 1], out, found, max);
+		} else {
+			found = grid_scan(g, centre, r2, c, g->start[first], g->count,
+				out, found, max);
+			found = grid_scan(g, centre, r2, c, 0, g->start[last + 1], out,
+				found, max);
+		}
+	}
+	return found;
+}
+
+#endif /* _GMATH_GRID_H_ */
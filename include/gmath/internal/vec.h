@@ -161,7 +161,7 @@ static inline VEC_TYPE VEC_PREFIX(_lerp_m128)(const VEC_TYPE v1, const VEC_TYPE
 #else
 	VEC_TYPE v;
 	__m128 tmp0 = _mm_sub_ps(v2, v1);
-	__m128 tmp1 = _mm_mul_ps(tmp1, f);
+	__m128 tmp1 = _mm_mul_ps(tmp0, f);
 	v = _mm_add_ps(v1, tmp1);
 	return v;
 #endif
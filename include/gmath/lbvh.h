@@ -0,0 +1,264 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * lbvh.h
+ * Handles linear bounding volume hierarchy builds from Morton codes
+ *
+ */
+
+#ifndef _GMATH_LBVH_H_
+#define _GMATH_LBVH_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "task.h"
+#include "bvh.h"
+#include "morton.h"
+
+#ifdef __SSE__
+
+/**
+ * A linear build split into tasks, for trees rebuilt every frame.  The
+ * primitives are sorted by the Morton code of their centroid, and every
+ * inner node of the binary radix tree over the codes (Karras 2012) is
+ * found from the codes alone, so lbvh_build_nodes may run on any split
+ * of the node indices at once.  lbvh_build_subtrees then picks disjoint
+ * subtrees for lbvh_build_bounds to sum up, and lbvh_build_end collapses
+ * the result into a bvh through bvh_build_end.
+ *
+ * Inner node i takes slot i of the node pool and leaf j slot count - 1
+ * + j, so the root is slot 0 either way.  Ranges of up to BVH_LEAF_MAX
+ * primitives become leaves.  Duplicate codes split by index, which
+ * keeps the depth under 30 + log2(count), inside BVH_DEPTH_MAX.
+ */
+typedef struct {
+	bvh_builder b;
+	uint32_t *code;
+	int tasks;
+} lbvh_builder;
+
+static inline void lbvh_builder_free(lbvh_builder *lb)
+{
+	bvh_builder_free(&lb->b);
+	free(lb->code);
+	lb->code = NULL;
+}
+
+/* Length of the common prefix of keys i and j, indices breaking ties. */
+static inline int lbvh_delta(const uint32_t *code, int count, int i, int j)
+{
+	if (j < 0 || j >= count)
+		return -1;
+	if (code[i] == code[j])
+		return 32 + __builtin_clz((unsigned int)(i ^ j));
+	return __builtin_clz(code[i] ^ code[j]);
+}
+
+/**
+ * Starts a build over count boxes with node passes split into tasks.
+ * Sorts the primitives by Morton code.  Returns 0 on success, -1 when
+ * out of memory.
+ */
+static inline int lbvh_build_begin(lbvh_builder *lb, const aabb *boxes,
+		int count, int tasks)
+{
+	bvh_builder *b = &lb->b;
+	__m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	__m128 half = _mm_set1_ps(0.5f);
+	vec3 *centre = malloc(sizeof(vec3) * (count + 1));
+	int *perm = malloc(sizeof(int) * (count + 1));
+
+	memset(lb, 0, sizeof(*lb));
+	lb->tasks = tasks < 1 ? 1 : tasks;
+	b->count = count;
+	b->ref = malloc(sizeof(aabb) * (count + 1));
+	b->node = malloc(sizeof(bvh_build_node) * (2 * count + 1));
+	b->task = malloc(sizeof(int) * lb->tasks);
+	b->depth = malloc(sizeof(int) * lb->tasks);
+	lb->code = malloc(sizeof(uint32_t) * (count + 1));
+	if (!centre || !perm || !b->ref || !b->node || !b->task || !b->depth ||
+			!lb->code)
+		goto fail;
+
+	for (int i = 0; i < count; i++)
+		centre[i] = _mm_mul_ps(_mm_add_ps(boxes[i].min, boxes[i].max), half);
+	morton30_encode(lb->code, centre, count,
+		aabb_from_points(centre, count));
+	if (morton_sort30(lb->code, perm, count) < 0)
+		goto fail;
+	for (int i = 0; i < count; i++) {
+		const aabb *box = &boxes[perm[i]];
+		__m128 index = _mm_castsi128_ps(
+			_mm_set1_epi32(perm[i] + BVH_REF_BIAS));
+		b->ref[i].min = _mm_or_ps(_mm_and_ps(xyz, box->min),
+			_mm_andnot_ps(xyz, index));
+		b->ref[i].max = box->max;
+	}
+	free(centre);
+	free(perm);
+	return 0;
+
+fail:
+	free(centre);
+	free(perm);
+	lbvh_builder_free(lb);
+	return -1;
+}
+
+/**
+ * Finds inner nodes and leaves [first, last) of task t, each on its
+ * own: the direction of the node's range from the longer prefix among
+ * its neighbours, the far end by an exponential then a binary search,
+ * and the split at the last key sharing the range's prefix.
+ */
+static inline void lbvh_build_nodes(lbvh_builder *lb, int t)
+{
+	const uint32_t *c = lb->code;
+	bvh_build_node *node = lb->b.node;
+	int n = lb->b.count;
+	int first = task_first(n, lb->tasks, t);
+	int last = task_first(n, lb->tasks, t + 1);
+
+	for (int i = first; i < last; i++) {
+		node[n - 1 + i].left = node[n - 1 + i].right = -1;
+		node[n - 1 + i].first = i;
+		node[n - 1 + i].count = 1;
+	}
+	last = last < n - 1 ? last : n - 1;
+	for (int i = first; i < last; i++) {
+		int d = lbvh_delta(c, n, i, i + 1) > lbvh_delta(c, n, i, i - 1) ?
+			1 : -1;
+		int dmin = lbvh_delta(c, n, i, i - d), dnode;
+		int lmax = 2, l = 0, s = 0, step, j, lo, hi, split;
+
+		while (lbvh_delta(c, n, i, i + lmax * d) > dmin)
+			lmax <<= 1;
+		for (step = lmax >> 1; step; step >>= 1)
+			if (lbvh_delta(c, n, i, i + (l + step) * d) > dmin)
+				l += step;
+		j = i + l * d;
+		dnode = lbvh_delta(c, n, i, j);
+		step = l;
+		do {
+			step = (step + 1) >> 1;
+			if (lbvh_delta(c, n, i, i + (s + step) * d) > dnode)
+				s += step;
+		} while (step > 1);
+		split = i + s * d + (d < 0 ? -1 : 0);
+		lo = i < j ? i : j;
+		hi = i < j ? j : i;
+		node[i].left = lo == split ? n - 1 + split : split;
+		node[i].right = hi == split + 1 ? n + split : split + 1;
+		node[i].first = lo;
+		node[i].count = hi - lo + 1;
+	}
+}
+
+/**
+ * Picks up to tasks disjoint subtrees for lbvh_build_bounds, opening
+ * the largest from the root down.  Runs once, after every node task.
+ */
+static inline void lbvh_build_subtrees(lbvh_builder *lb)
+{
+	bvh_builder *b = &lb->b;
+	const bvh_build_node *node = b->node;
+
+	b->root = 0;
+	b->tasks = b->count ? 1 : 0;
+	b->task[0] = 0;
+	while (b->tasks && b->tasks < lb->tasks) {
+		int t = 0, index;
+		for (int i = 1; i < b->tasks; i++)
+			if (node[b->task[i]].count > node[b->task[t]].count)
+				t = i;
+		index = b->task[t];
+		if (node[index].left < 0 || node[index].count <= BVH_LEAF_MAX)
+			break;
+		b->task[t] = node[index].left;
+		b->task[b->tasks++] = node[index].right;
+	}
+}
+
+/* Bounds the subtree at index, turning small ranges into leaves. */
+static inline aabb lbvh_build_box(bvh_builder *b, int index)
+{
+	bvh_build_node *node = &b->node[index];
+	if (node->count <= BVH_LEAF_MAX)
+		node->left = node->right = -1;
+	if (node->left < 0)
+		node->box = bvh_build_bounds(b, node->first,
+			node->first + node->count);
+	else
+		node->box = aabb_merge(lbvh_build_box(b, node->left),
+			lbvh_build_box(b, node->right));
+	return node->box;
+}
+
+/**
+ * Bounds the subtree of task t.  Different tasks may run concurrently.
+ */
+static inline void lbvh_build_bounds(lbvh_builder *lb, int t)
+{
+	if (t < lb->b.tasks)
+		lbvh_build_box(&lb->b, lb->b.task[t]);
+}
+
+/* Bounds the nodes above the task subtrees. */
+static inline aabb lbvh_build_top(bvh_builder *b, int index)
+{
+	bvh_build_node *node = &b->node[index];
+	for (int t = 0; t < b->tasks; t++)
+		if (b->task[t] == index)
+			return node->box;
+	node->box = aabb_merge(lbvh_build_top(b, node->left),
+		lbvh_build_top(b, node->right));
+	return node->box;
+}
+
+/**
+ * Finishes a build into tree and frees the builder.  Returns 0 on
+ * success, -1 when out of memory.
+ */
+static inline int lbvh_build_end(lbvh_builder *lb, bvh *tree)
+{
+	if (lb->b.count)
+		lbvh_build_top(&lb->b, 0);
+	free(lb->code);
+	lb->code = NULL;
+	return bvh_build_end(&lb->b, tree);
+}
+
+/**
+ * Builds a tree over count boxes on the calling thread.  Returns 0 on
+ * success, -1 when out of memory.
+ */
+static inline int lbvh_build(bvh *tree, const aabb *boxes, int count)
+{
+	lbvh_builder lb;
+	if (lbvh_build_begin(&lb, boxes, count, 1) < 0)
+		return -1;
+	lbvh_build_nodes(&lb, 0);
+	lbvh_build_subtrees(&lb);
+	lbvh_build_bounds(&lb, 0);
+	return lbvh_build_end(&lb, tree);
+}
+
+static inline int lbvh_build_triangles(bvh *tree, const vec3 *v0,
+		const vec3 *v1, const vec3 *v2, int count)
+{
+	aabb *boxes = malloc(sizeof(aabb) * (count + 1));
+	int ret;
+	if (!boxes)
+		return -1;
+	bvh_triangle_boxes(boxes, v0, v1, v2, count);
+	ret = lbvh_build(tree, boxes, count);
+	free(boxes);
+	return ret;
+}
+
+#endif
+
+#endif /* _GMATH_LBVH_H_ */
@@ -3,7 +3,7 @@
  * (C) 2009 Tai Chi Minh Ralph Eastwood
  * Released under the MIT license.
  *
- * mat4.h 
+ * mat4.h
  * Handles matrices which are 4x4 in column major order.
  *
  */
@@ -12,237 +12,252 @@
 #define _GMATH_MAT4_H_
 
 #include "constants.h"
+#include "cephes/sincos.h"
+#include "cephes/rsqrt.h"
+#include "vec3.h"
 #include "vec4.h"
 
-#define MAT4_IDENTITY {{1,0,0,0},{0,1,0,0},{0,0,1,0},{0,0,0,1}}
-#define MAT4_SCALE(x,y,z) {{x,0,0,0},{0,y,0,0},{0,0,z,0},{0,0,0,1}}
-#define MAT4_SCALE_VEC3(v) {{v[0],0,0,0},{0,v[1],0,0},{0,0,v[2],0},{0,0,0,1}}
-#define MAT4_FROM_AXIS(x,y,z) {                 \
-	{x[0],x[1],x[2],0}, {y[0],y[1],y[2],0}, \
-	{y[0],y[1],y[2],0}, {0,0,0,1}           \
-}
-#define MAT4_MAKE_TRANSFORM(r,t) {r[0],r[1],r[2],{t[0],t[1],t[2],1}}
+#define MAT4_IDENTITY {{{1,0,0,0},{0,1,0,0},{0,0,1,0},{0,0,0,1}}}
+#define MAT4_SCALE(x,y,z) {{{x,0,0,0},{0,y,0,0},{0,0,z,0},{0,0,0,1}}}
+#define MAT4_SCALE_VEC3(v) {{{fidx(v,0),0,0,0},{0,fidx(v,1),0,0}, \
+	{0,0,fidx(v,2),0},{0,0,0,1}}}
+#define MAT4_FROM_AXIS(x,y,z) {{                                \
+	{fidx(x,0),fidx(x,1),fidx(x,2),0},                      \
+	{fidx(y,0),fidx(y,1),fidx(y,2),0},                      \
+	{fidx(z,0),fidx(z,1),fidx(z,2),0}, {0,0,0,1}            \
+}}
+#define MAT4_MAKE_TRANSFORM(r,t) {{(r).col[0],(r).col[1],(r).col[2], \
+	{fidx(t,0),fidx(t,1),fidx(t,2),1}}}
 
 /**
- *  Defined as an array of 16 floats
- *  Remember, to access it as 4x4 do:
- *  m[y * 4 + x]
+ *  Defined as four column vectors so it can be passed and returned
+ *  by value.  Remember, to access it as 4x4 do:
+ *  fidx(m.col[x], y)
  */
-typedef vec4[4] mat4;
+typedef struct {
+	vec4 col[4];
+} mat4;
 
-static inline mat4 mat4_mul(mat4 a, mat4 b)
+static inline mat4 mat4_mul(const mat4 a, const mat4 b)
 {
-  mat4 out;
-  for (int i = 0; i < 4; i++) {
+	mat4 out;
+	for (int i = 0; i < 4; i++) {
 #ifndef __SSE__
-    vec4 x; for (int j = 0; j < 4; j++) x[j] = b[j] * a[0];
-    vec4 y; for (int j = 0; j < 4; j++) y[j] = b[j] * a[1];
-    vec4 z; for (int j = 0; j < 4; j++) z[j] = b[j] * a[2];
-    vec4 w; for (int j = 0; j < 4; j++) w[j] = b[j] * a[3];
+		for (int j = 0; j < 4; j++)
+			out.col[i][j] = a.col[0][j] * b.col[i][0] +
+			                a.col[1][j] * b.col[i][1] +
+			                a.col[2][j] * b.col[i][2] +
+			                a.col[3][j] * b.col[i][3];
 #else
-    vec4 x = vec4_scale(VEC4_WWWW(b[i]), a[0]);
-    vec4 y = vec4_scale(VEC4_ZZZZ(b[i]), a[1]);
-    vec4 z = vec4_scale(VEC4_YYYY(b[i]), a[2]);
-    vec4 w = vec4_scale(VEC4_XXXX(b[i]), a[3]);
+		vec4 x = vec4_mul(VEC4_XXXX(b.col[i]), a.col[0]);
+		vec4 y = vec4_mul(VEC4_YYYY(b.col[i]), a.col[1]);
+		vec4 z = vec4_mul(VEC4_ZZZZ(b.col[i]), a.col[2]);
+		vec4 w = vec4_mul(VEC4_WWWW(b.col[i]), a.col[3]);
+		out.col[i] = vec4_add(vec4_add(x, y), vec4_add(z, w));
 #endif
-    out[i] = vec_add(vec_add(vec4_add(x, y), z), w)
-  }
+	}
+	return out;
 }
 
-static inline mat4 mat4_transpose(mat4 a)
+static inline mat4 mat4_transpose(const mat4 a)
 {
 	mat4 out;
 #ifdef __SSE__
-	vec4 tmp0 = _mm_unpacklo_ps(a[0], a[1]);
-	vec4 tmp1 = _mm_unpacklo_ps(a[2], a[3]);
-	vec4 tmp2 = _mm_unpackhi_ps(a[0], a[1]);
-	vec4 tmp3 = _mm_unpackhi_ps(a[2], a[3]);
-	out[0] = _mm_movelh_ps(tmp0, tmp1);
-	out[1] = _mm_movehl_ps(tmp1, tmp0);
-	out[2] = _mm_movelh_ps(tmp2, tmp3);
-	out[3] = _mm_movehl_ps(tmp3, tmp2);
+	vec4 tmp0 = _mm_unpacklo_ps(a.col[0], a.col[1]);
+	vec4 tmp1 = _mm_unpacklo_ps(a.col[2], a.col[3]);
+	vec4 tmp2 = _mm_unpackhi_ps(a.col[0], a.col[1]);
+	vec4 tmp3 = _mm_unpackhi_ps(a.col[2], a.col[3]);
+	out.col[0] = _mm_movelh_ps(tmp0, tmp1);
+	out.col[1] = _mm_movehl_ps(tmp1, tmp0);
+	out.col[2] = _mm_movelh_ps(tmp2, tmp3);
+	out.col[3] = _mm_movehl_ps(tmp3, tmp2);
 #else
-	out[0] = {a[0][0], a[1][0], a[2][0], a[3][0]};
-	out[1] = {a[0][1], a[1][1], a[2][1], a[3][1]};
-	out[2] = {a[0][2], a[1][2], a[2][2], a[3][2]};
-	out[3] = {a[0][3], a[1][3], a[2][3], a[3][3]};
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			out.col[i][j] = a.col[j][i];
 #endif
-  return out;
+	return out;
 }
 
-static inline mat4 mat4_inverse(mat4 a)
-{
-	mat4 out;
-	vec4 tmp;
-	vec4 A, B, C, D;
-	vec4 iA, iB, iC, iD, DC, AB;
-	float dA, dB, dC, dD;
-	float det, d, d1, d2;
-	Vector4 rd;
-
 #ifdef __SSE__
-	A = _mm_movelh_ps(a[0], a[1]);
-	B = _mm_movehl_ps(a[1], a[0]);
-	C = _mm_movelh_ps(a[2], a[3]);
-	D = _mm_movehl_ps(a[3], a[2]);
-#else
-	A = {a[0][0], a[0][1], a[1][0], a[2][1]};
-	B = {a[0][2], a[0][3], a[1][2], a[1][3]};
-	C = {a[2][0], a[2][1], a[3][0], a[3][1]};
-	D = {a[2][2], a[2][3], a[3][2], a[3][3]};
-#endif
-
-	AB = vec4_sub(vec4_mul(VEC4_WWXX(A), B),
-			vec4_mul(VEC4_YYZZ(A), VEC4_ZWXY(B)));
-	DC = vec4_sub(vec4_mul(VEC4_WWXX(D), C),
-			vec4_mul(VEC4_YYZZ(D), VEC4_ZWXY(C)));
-
-	tmp = vec4_mul(VEC4_WWYY(A), A);
-	dA = tmp[0] - tmp[2];
-	tmp = vec4_mul(VEC4_WWYY(B), B);
-	dB = tmp[0] - tmp[2];
-	tmp = vec4_mul(VEC4_WWYY(C), C);
-	dC = tmp[0] - tmp[2];
-	tmp = vec4_mul(VEC4_WWYY(D), D);
-	dD = tmp[0] - tmp[2];
-
-	tmp = vec4_mul(AB, VEC4_XZYW(DC));
-
-	iD = vec4_add(vec4_mul(VEC4_XXZZ(C), VEC4_XYXY(AB)),
-			vec4_mul(VEC4_YYWW(C), VEC4_ZWZW(AB)));
-	iA = vec4_add(vec4_mul(VEC4_XXZZ(B), VEC4_XYXY(DC)),
-			vec4_mul(VEC4_YYWW(B), VEC4_ZWZW(DC)));
-
-#ifdef __SSE3__
-	tmp = _mm_hadd_ps(tmp, tmp);
-	tmp = _mm_hadd_ps(tmp, tmp);
-	d = tmp[0];
-#else
-	d = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-#endif
-	d1 = dA * dD;
-	d2 = dB * dC;
-
-	iD = vec4_sub(vec4_scale(D, dA), iD);
-	iA = vec4_sub(vec4_scale(A, dD), iA);
-
-	det = 1 / (d1 + d2 - d);
-
-	iB = vec4_sub(vec4_mul(D, VEC4_WXWX(AB)),
-			vec4_mul(VEC4_YXWZ(D), VEC4_ZYZY(AB)));
-	iC = vec4_sub(vec4_mul(A, VEC4_WXWX(DC)),
-			vec4_mul(VEC4_YXWZ(A), VEC4_ZYZY(DC)));
+/* 2x2 matrix products on (m00, m01, m10, m11) packed vectors */
+static inline vec4 mat4_mat2_mul(const vec4 a, const vec4 b)
+{
+	return vec4_add(vec4_mul(a, VEC4_XWXW(b)),
+			vec4_mul(VEC4_YXWZ(a), VEC4_ZYZY(b)));
+}
 
-	rd = {det, det, det, det};
+/* adj(a) * b */
+static inline vec4 mat4_mat2_adj_mul(const vec4 a, const vec4 b)
+{
+	return vec4_sub(vec4_mul(VEC4_WWXX(a), b),
+			vec4_mul(VEC4_YYZZ(a), VEC4_ZWXY(b)));
+}
 
-#ifdef __SSE2__
-	rd = _mm_xor_ps(mm_castsi128_ps(_mm_set_epi32
-		(0x00000000, 0x80000000, 0x80000000, 0x00000000)), v1);
-#else
-	rd[1] = -rd[1];
-	rd[2] = -rd[2];
+/* a * adj(b) */
+static inline vec4 mat4_mat2_mul_adj(const vec4 a, const vec4 b)
+{
+	return vec4_sub(vec4_mul(a, VEC4_WXWX(b)),
+			vec4_mul(VEC4_YXWZ(a), VEC4_ZYZY(b)));
+}
 #endif
 
-	iB = vec4_sub(vec4_scale(C, dB), iB);
-	iC = vec4_sub(vec4_scale(B, dC), iC);
+/**
+ * General inverse using the 2x2 block method.
+ */
+static inline mat4 mat4_inverse(const mat4 a)
+{
+	mat4 out;
+#ifdef __SSE__
+	vec4 A = _mm_movelh_ps(a.col[0], a.col[1]);
+	vec4 B = _mm_movehl_ps(a.col[1], a.col[0]);
+	vec4 C = _mm_movelh_ps(a.col[2], a.col[3]);
+	vec4 D = _mm_movehl_ps(a.col[3], a.col[2]);
+
+	/* determinants of the blocks as (|A| |B| |C| |D|) */
+	vec4 det = vec4_sub(
+		vec4_mul(_mm_shuffle_ps(a.col[0], a.col[2], _MM_SHUFFLE(2,0,2,0)),
+			_mm_shuffle_ps(a.col[1], a.col[3], _MM_SHUFFLE(3,1,3,1))),
+		vec4_mul(_mm_shuffle_ps(a.col[0], a.col[2], _MM_SHUFFLE(3,1,3,1)),
+			_mm_shuffle_ps(a.col[1], a.col[3], _MM_SHUFFLE(2,0,2,0))));
+	vec4 dA = VEC4_XXXX(det);
+	vec4 dB = VEC4_YYYY(det);
+	vec4 dC = VEC4_ZZZZ(det);
+	vec4 dD = VEC4_WWWW(det);
+
+	vec4 DC = mat4_mat2_adj_mul(D, C);
+	vec4 AB = mat4_mat2_adj_mul(A, B);
+	vec4 iA = vec4_sub(vec4_mul(dD, A), mat4_mat2_mul(B, DC));
+	vec4 iD = vec4_sub(vec4_mul(dA, D), mat4_mat2_mul(C, AB));
+	vec4 iB = vec4_sub(vec4_mul(dB, C), mat4_mat2_mul_adj(D, AB));
+	vec4 iC = vec4_sub(vec4_mul(dC, B), mat4_mat2_mul_adj(A, DC));
+
+	/* |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C) */
+	vec4 tr = vec4_mul(AB, VEC4_XZYW(DC));
+	tr = vec4_add(tr, VEC4_ZWXY(tr));
+	tr = vec4_add(tr, VEC4_YXWZ(tr));
+	vec4 d = vec4_sub(vec4_add(vec4_mul(dA, dD), vec4_mul(dB, dC)), tr);
+	vec4 rd = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), d);
 
 	iA = vec4_mul(iA, rd);
-	iB = vec4_mul(iA, rd);
-	iC = vec4_mul(iA, rd);
-	iD = vec4_mul(iA, rd);
-
-#ifdef __SSE__
-	out[0] = _mm_shuffle_ps(iA, iB, 0x77);
-	out[1] = _mm_shuffle_ps(iA, iB, 0x22);
-	out[2] = _mm_shuffle_ps(iC, iD, 0x77);
-	out[3] = _mm_shuffle_ps(iC, iD, 0x22);
+	iB = vec4_mul(iB, rd);
+	iC = vec4_mul(iC, rd);
+	iD = vec4_mul(iD, rd);
+
+	out.col[0] = _mm_shuffle_ps(iA, iB, _MM_SHUFFLE(1,3,1,3));
+	out.col[1] = _mm_shuffle_ps(iA, iB, _MM_SHUFFLE(0,2,0,2));
+	out.col[2] = _mm_shuffle_ps(iC, iD, _MM_SHUFFLE(1,3,1,3));
+	out.col[3] = _mm_shuffle_ps(iC, iD, _MM_SHUFFLE(0,2,0,2));
 #else
-	out[0] = {iA[3], iA[1], iB[3], iB[1]};
-	out[1] = {iA[2], iA[0], iB[2], iB[0]};
-	out[2] = {iC[3], iC[1], iD[3], iD[1]};
-	out[3] = {iC[2], iC[0], iD[2], iB[0]};
+	float *m = (float *)a.col, *o = (float *)out.col;
+	float s[6], c[6], det;
+	s[0] = m[0] * m[5] - m[4] * m[1];
+	s[1] = m[0] * m[6] - m[4] * m[2];
+	s[2] = m[0] * m[7] - m[4] * m[3];
+	s[3] = m[1] * m[6] - m[5] * m[2];
+	s[4] = m[1] * m[7] - m[5] * m[3];
+	s[5] = m[2] * m[7] - m[6] * m[3];
+	c[0] = m[8] * m[13] - m[12] * m[9];
+	c[1] = m[8] * m[14] - m[12] * m[10];
+	c[2] = m[8] * m[15] - m[12] * m[11];
+	c[3] = m[9] * m[14] - m[13] * m[10];
+	c[4] = m[9] * m[15] - m[13] * m[11];
+	c[5] = m[10] * m[15] - m[14] * m[11];
+	det = 1.0f / (s[0] * c[5] - s[1] * c[4] + s[2] * c[3] +
+	              s[3] * c[2] - s[4] * c[1] + s[5] * c[0]);
+	o[0] = ( m[5] * c[5] - m[6] * c[4] + m[7] * c[3]) * det;
+	o[1] = (-m[1] * c[5] + m[2] * c[4] - m[3] * c[3]) * det;
+	o[2] = ( m[13] * s[5] - m[14] * s[4] + m[15] * s[3]) * det;
+	o[3] = (-m[9] * s[5] + m[10] * s[4] - m[11] * s[3]) * det;
+	o[4] = (-m[4] * c[5] + m[6] * c[2] - m[7] * c[1]) * det;
+	o[5] = ( m[0] * c[5] - m[2] * c[2] + m[3] * c[1]) * det;
+	o[6] = (-m[12] * s[5] + m[14] * s[2] - m[15] * s[1]) * det;
+	o[7] = ( m[8] * s[5] - m[10] * s[2] + m[11] * s[1]) * det;
+	o[8] = ( m[4] * c[4] - m[5] * c[2] + m[7] * c[0]) * det;
+	o[9] = (-m[0] * c[4] + m[1] * c[2] - m[3] * c[0]) * det;
+	o[10] = ( m[12] * s[4] - m[13] * s[2] + m[15] * s[0]) * det;
+	o[11] = (-m[8] * s[4] + m[9] * s[2] - m[11] * s[0]) * det;
+	o[12] = (-m[4] * c[3] + m[5] * c[1] - m[6] * c[0]) * det;
+	o[13] = ( m[0] * c[3] - m[1] * c[1] + m[2] * c[0]) * det;
+	o[14] = (-m[12] * s[3] + m[13] * s[1] - m[14] * s[0]) * det;
+	o[15] = ( m[8] * s[3] - m[9] * s[1] + m[10] * s[0]) * det;
 #endif
-
 	return out;
 }
 
-static inline mat4 mat4_affine_inverse(mat4 a)
+/**
+ * Inverse of a rigid transform (rotation and translation only).
+ */
+static inline mat4 mat4_affine_inverse(const mat4 a)
 {
 	mat4 out;
 	// Transpose the 3x3 inner matrix
 #ifdef __SSE__
-	vec4 tmp0 = _mm_unpacklo_ps(a[0], a[1]);
-	vec4 tmp1 = _mm_unpacklo_ps(a[2], _mm_setzero_ps());
-	vec4 tmp2 = _mm_unpackhi_ps(a[0], a[1]);
-	vec4 tmp3 = _mm_unpackhi_ps(a[2], _mm_setzero_ps());
-	out[0] = _mm_movelh_ps(tmp0, tmp1);
-	out[1] = _mm_movehl_ps(tmp1, tmp0);
-	out[2] = _mm_movelh_ps(tmp2, tmp3);
+	vec4 tmp0 = _mm_unpacklo_ps(a.col[0], a.col[1]);
+	vec4 tmp1 = _mm_unpacklo_ps(a.col[2], _mm_setzero_ps());
+	vec4 tmp2 = _mm_unpackhi_ps(a.col[0], a.col[1]);
+	vec4 tmp3 = _mm_unpackhi_ps(a.col[2], _mm_setzero_ps());
+	out.col[0] = _mm_movelh_ps(tmp0, tmp1);
+	out.col[1] = _mm_movehl_ps(tmp1, tmp0);
+	out.col[2] = _mm_movelh_ps(tmp2, tmp3);
 #else
-	out[0] = {a[0][0], a[1][0], a[2][0], 0};
-	out[1] = {a[0][1], a[1][1], a[2][1], 0};
-	out[2] = {a[0][2], a[1][2], a[2][2], 0};
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++)
+			out.col[i][j] = a.col[j][i];
+		out.col[i][3] = 0;
+	}
 #endif
 
 	// Transform the translation vector with the transposed matrix
-	vec4 x = vec4_mul(VEC4_XXXX(a[3]), out[0]);
-	vec4 y = vec4_mul(VEC4_YYYY(a[3]), out[1]);
-	vec4 z = vec4_mul(VEC4_ZZZZ(a[3]), out[2]);
-	out[3] = vec4_neg(vec4_add(x, vec4_add(y, z)))
-	out[3][3] = 1;
+	vec4 x = vec4_mul(VEC4_XXXX(a.col[3]), out.col[0]);
+	vec4 y = vec4_mul(VEC4_YYYY(a.col[3]), out.col[1]);
+	vec4 z = vec4_mul(VEC4_ZZZZ(a.col[3]), out.col[2]);
+	out.col[3] = vec4_neg(vec4_add(x, vec4_add(y, z)));
+	fidx(out.col[3], 3) = 1;
 
 	return out;
 }
 
-static inline vec4 mat4_transform4(mat4 a, vec4 v)
+static inline vec4 mat4_transform4(const mat4 a, const vec4 v)
 {
-	vec3 x = vec4_mul(VEC4_XXXX(v), a[0]);
-	vec3 y = vec4_mul(VEC4_YYYY(v), a[1]);
-	vec3 z = vec4_mul(VEC4_ZZZZ(v), a[2]);
-	vec3 w = vec4_mul(VEC4_WWWW(v), a[3]);
+	vec4 x = vec4_mul(VEC4_XXXX(v), a.col[0]);
+	vec4 y = vec4_mul(VEC4_YYYY(v), a.col[1]);
+	vec4 z = vec4_mul(VEC4_ZZZZ(v), a.col[2]);
+	vec4 w = vec4_mul(VEC4_WWWW(v), a.col[3]);
 	return vec4_add(x, vec4_add(y, vec4_add(z, w)));
 }
 
-static inline vec3 mat4_transform_normal(mat4 a, vec3 v)
+static inline vec3 mat4_transform_normal(const mat4 a, const vec3 v)
 {
-	vec3 x = vec3_mul(VEC4_XXXX(v), a[0]);
-	vec3 y = vec3_mul(VEC4_YYYY(v), a[1]);
-	vec3 z = vec3_mul(VEC4_ZZZZ(v), a[2]);
+	vec3 x = vec3_mul(VEC4_XXXX(v), a.col[0]);
+	vec3 y = vec3_mul(VEC4_YYYY(v), a.col[1]);
+	vec3 z = vec3_mul(VEC4_ZZZZ(v), a.col[2]);
 	return vec3_add(x, vec3_add(y, z));
 }
 
-static inline vec3 mat4_transform_point(mat4 a, vec3 v)
+static inline vec3 mat4_transform_point(const mat4 a, const vec3 v)
 {
-	vec3 x = vec3_mul(VEC4_XXXX(v), a[0]);
-	vec3 y = vec3_mul(VEC4_YYYY(v), a[1]);
-	vec3 z = vec3_mul(VEC4_ZZZZ(v), a[2]);
-	return vec3_add(x, vec3_add(y, z));
+	vec3 x = vec3_mul(VEC4_XXXX(v), a.col[0]);
+	vec3 y = vec3_mul(VEC4_YYYY(v), a.col[1]);
+	vec3 z = vec3_mul(VEC4_ZZZZ(v), a.col[2]);
+	return vec3_add(vec3_add(x, y), vec3_add(z, a.col[3]));
 }
 
-static inline mat4 mat4_from_angles(mat4 a, float yaw, float pitch, float roll)
+static inline mat4 mat4_from_angles(float yaw, float pitch, float roll)
 {
 	mat4 out;
+	float sr, sp, sy, cr, cp, cy;
 #ifdef __SSE__
 	vec4 v = {roll, pitch, yaw, 0};
 	vec4 s, c;
 	sincos_ps(v, &s, &c);
-	vec4 Z0 = _mm_unpackhi_ps(c, s);
-	vec4 Z1 = _mm_unpackhi_ps(-s, c);
-	Z1 = _mm_and_ps(Z1, mm_castsi128_ps(_mm_set_epi32
-		(0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff)));
-	vec4 X0 = VEC4_XXXX(s);
-	vec4 X1 = VEC4_XXXX(c);
-	vec4 Y1 = _mm_shuffle_ps(s, c, _MM_SHUFFLE(0, 1, 1, 1));
-	vec4 Y0 = _mm_shuffle_ps(c, -s, _MM_SHUFFLE(0, 1, 1, 1));
-	vec4 tmp = vec4_mul(Z0, Y1);
-
-	out[0] = vec4_mul(Z0, Y0);
-	out[1] = vec4_add(vec4_mul(tmp, X0), vec4_mul(Z1, X1));
-	out[2] = vec4_sub(vec4_mul(tmp, X1), vec4_mul(Z1, X0));
-	out[3] = {0, 0, 0, 1};
+	sr = fidx(s, 0); sp = fidx(s, 1); sy = fidx(s, 2);
+	cr = fidx(c, 0); cp = fidx(c, 1); cy = fidx(c, 2);
+	out.col[0] = _mm_setr_ps(cp*cy, cp*sy, -sp, 0);
+	out.col[1] = _mm_setr_ps(sr*sp*cy - cr*sy, sr*sp*sy + cr*cy, sr*cp, 0);
+	out.col[2] = _mm_setr_ps(cr*sp*cy + sr*sy, cr*sp*sy - sr*cy, cr*cp, 0);
+	out.col[3] = _mm_setr_ps(0, 0, 0, 1);
 #else
-	float sr, sp, sy, cr, cp, cy;
-
 	sy = sin(yaw);
 	sp = sin(pitch);
 	sr = sin(roll);
@@ -250,13 +265,164 @@ static inline mat4 mat4_from_angles(mat4 a, float yaw, float pitch, float roll)
 	cp = cos(pitch);
 	cr = cos(roll);
 
-	out[0] = {cp*cy, cp*sy, -sp, 0};
-	out[1] = {sr*sp*cy - cr*sy, sr*sp*sy + cr*cy, sr*cp, 0};
-	out[2] = {cr*sp*cy + sr*sy, cr*sp*sy - sr*cy, cr*cp, 0};
-	out[3] = {0, 0, 0, 1};
+	out.col[0] = {cp*cy, cp*sy, -sp, 0};
+	out.col[1] = {sr*sp*cy - cr*sy, sr*sp*sy + cr*cy, sr*cp, 0};
+	out.col[2] = {cr*sp*cy + sr*sy, cr*sp*sy - sr*cy, cr*cp, 0};
+	out.col[3] = {0, 0, 0, 1};
+#endif
+	return out;
+
+}
+
+/**
+ * Right handed perspective projection looking down -z onto clip space
+ * -w <= z <= w, as glFrustum and frustum_from_mat4 expect.  fovy is the
+ * full vertical angle in radians.
+ */
+static inline mat4 mat4_perspective(float fovy, float aspect, float near,
+		float far)
+{
+	float f = 1.0f / tanf(0.5f * fovy), d = 1.0f / (near - far);
+	mat4 out = {{
+		{f / aspect, 0, 0, 0},
+		{0, f, 0, 0},
+		{0, 0, (far + near) * d, -1},
+		{0, 0, 2.0f * far * near * d, 0}
+	}};
+	return out;
+}
+
+/**
+ * Perspective with the far plane at infinity and depth reversed to run
+ * from 1 at near to 0 at infinity.  Pair it with a 0 <= z <= w clip
+ * space (glClipControl or D3D) and a greater depth test; the float
+ * depth buffer then keeps its precision in the distance.
+ */
+static inline mat4 mat4_perspective_reverse_z(float fovy, float aspect,
+		float near)
+{
+	float f = 1.0f / tanf(0.5f * fovy);
+	mat4 out = {{
+		{f / aspect, 0, 0, 0},
+		{0, f, 0, 0},
+		{0, 0, 0, -1},
+		{0, 0, near, 0}
+	}};
+	return out;
+}
+
+/**
+ * Orthographic projection of the box between (l, b, -n) and (r, t, -f)
+ * onto clip space -1..1, as glOrtho.
+ */
+static inline mat4 mat4_ortho(float l, float r, float b, float t,
+		float n, float f)
+{
+	mat4 out;
+#ifdef __SSE__
+	vec4 lo = _mm_setr_ps(l, b, n, 0.0f), hi = _mm_setr_ps(r, t, f, 1.0f);
+	vec4 d = _mm_div_ps(_mm_set1_ps(1.0f), vec4_sub(hi, lo));
+	vec4 s = vec4_mul(d, _mm_setr_ps(2.0f, 2.0f, -2.0f, 0.0f));
+	out.col[0] = _mm_move_ss(_mm_setzero_ps(), s);
+	out.col[1] = _mm_and_ps(s, _mm_castsi128_ps(_mm_setr_epi32(0, -1, 0, 0)));
+	out.col[2] = _mm_and_ps(s, _mm_castsi128_ps(_mm_setr_epi32(0, 0, -1, 0)));
+	out.col[3] = vec4_neg(vec4_mul(vec4_add(hi, lo), d));
+	fidx(out.col[3], 3) = 1;
+#else
+	mat4 o = {{
+		{2.0f / (r - l), 0, 0, 0},
+		{0, 2.0f / (t - b), 0, 0},
+		{0, 0, -2.0f / (f - n), 0},
+		{-(r + l) / (r - l), -(t + b) / (t - b), -(f + n) / (f - n), 1}
+	}};
+	out = o;
 #endif
 	return out;
+}
 
+/* v scaled to unit length. */
+static inline vec3 mat4_unit(const vec3 v)
+{
+#ifdef __SSE__
+	return vec3_mul(v, rsqrt_ps(vec3_dot_m128(v, v)));
+#else
+	return vec3_scale(v, 1.0f / sqrtf(vec3_dot(v, v)));
+#endif
+}
+
+/**
+ * View matrix at eye looking at center with up roughly above, right
+ * handed with -z forward.  It is rigid, so mat4_affine_inverse gives
+ * the camera's world matrix back.
+ */
+static inline mat4 mat4_look_at(const vec3 eye, const vec3 center,
+		const vec3 up)
+{
+	vec3 f = mat4_unit(vec3_sub(center, eye));
+	vec3 s = mat4_unit(vec3_cross(f, up));
+	mat4 basis = {{s, vec3_cross(s, f), vec3_neg(f), {0}}};
+	mat4 out = mat4_transpose(basis);
+	out.col[3] = vec4_neg(mat4_transform_normal(out, eye));
+	fidx(out.col[3], 3) = 1;
+	return out;
+}
+
+/**
+ * Inverse of any right handed perspective built above, including
+ * off-centre and infinite ones.  Only the five entries such a matrix
+ * can hold are read.
+ */
+static inline mat4 mat4_perspective_inverse(const mat4 m)
+{
+	mat4 out;
+	float a = fidx(m.col[0], 0), b = fidx(m.col[1], 1);
+	float d = fidx(m.col[3], 2);
+#ifdef __SSE__
+	vec4 r = _mm_div_ps(_mm_set1_ps(1.0f), _mm_setr_ps(a, b, 1.0f, d));
+	out.col[0] = _mm_move_ss(_mm_setzero_ps(), r);
+	out.col[1] = _mm_and_ps(r, _mm_castsi128_ps(_mm_setr_epi32(0, -1, 0, 0)));
+	out.col[2] = _mm_and_ps(r, _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1)));
+	/* (c, d, -1, C) with the off-centre terms under x and y */
+	out.col[3] = vec4_mul(VEC4_XYWZ(m.col[2]), r);
+#else
+	float c = fidx(m.col[2], 2);
+	mat4 o = {{
+		{1.0f / a, 0, 0, 0},
+		{0, 1.0f / b, 0, 0},
+		{0, 0, 0, 1.0f / d},
+		{fidx(m.col[2], 0) / a, fidx(m.col[2], 1) / b, -1, c / d}
+	}};
+	out = o;
+#endif
+	return out;
+}
+
+/**
+ * Inverse of an orthographic projection: a scale and a translation.
+ */
+static inline mat4 mat4_ortho_inverse(const mat4 m)
+{
+	mat4 out;
+	float a = fidx(m.col[0], 0), b = fidx(m.col[1], 1);
+	float c = fidx(m.col[2], 2);
+#ifdef __SSE__
+	vec4 r = _mm_div_ps(_mm_set1_ps(1.0f), _mm_setr_ps(a, b, c, 1.0f));
+	out.col[0] = _mm_move_ss(_mm_setzero_ps(), r);
+	out.col[1] = _mm_and_ps(r, _mm_castsi128_ps(_mm_setr_epi32(0, -1, 0, 0)));
+	out.col[2] = _mm_and_ps(r, _mm_castsi128_ps(_mm_setr_epi32(0, 0, -1, 0)));
+	out.col[3] = vec4_mul(m.col[3],
+		_mm_xor_ps(r, _mm_setr_ps(-0.0f, -0.0f, -0.0f, 0.0f)));
+#else
+	mat4 o = {{
+		{1.0f / a, 0, 0, 0},
+		{0, 1.0f / b, 0, 0},
+		{0, 0, 1.0f / c, 0},
+		{-fidx(m.col[3], 0) / a, -fidx(m.col[3], 1) / b,
+			-fidx(m.col[3], 2) / c, 1}
+	}};
+	out = o;
+#endif
+	return out;
 }
 
 #endif /* _GMATH_MAT4_H_ */
@@ -0,0 +1,566 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * morton.h
+ * Handles Morton and Hilbert codes of points for spatial sorting
+ *
+ */
+
+#ifndef _GMATH_MORTON_H_
+#define _GMATH_MORTON_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "constants.h"
+#include "vec3.h"
+#include "aabb.h"
+#include "radix.h"
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+/* Bits of each coordinate in the 30 and 63 bit codes. */
+#define MORTON30_BITS 10
+#define MORTON63_BITS 21
+
+/* Spreads the low 10 bits of x to every third bit. */
+static inline uint32_t morton_spread10(uint32_t x)
+{
+	x &= 0x3ff;
+	x = (x | x << 16) & 0x030000ff;
+	x = (x | x << 8) & 0x0300f00f;
+	x = (x | x << 4) & 0x030c30c3;
+	x = (x | x << 2) & 0x09249249;
+	return x;
+}
+
+/* Spreads the low 21 bits of x to every third bit. */
+static inline uint64_t morton_spread21(uint64_t x)
+{
+	x &= 0x1fffff;
+	x = (x | x << 32) & 0x001f00000000ffffull;
+	x = (x | x << 16) & 0x001f0000ff0000ffull;
+	x = (x | x << 8) & 0x100f00f00f00f00full;
+	x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+	x = (x | x << 2) & 0x1249249249249249ull;
+	return x;
+}
+
+/**
+ * Interleaves three 10 bit coordinates, x in the lowest bit of each
+ * group of three.
+ */
+static inline uint32_t morton30(uint32_t x, uint32_t y, uint32_t z)
+{
+#ifdef __BMI2__
+	return _pdep_u32(x, 0x09249249) | _pdep_u32(y, 0x12492492) |
+		_pdep_u32(z, 0x24924924);
+#else
+	return morton_spread10(x) | morton_spread10(y) << 1 |
+		morton_spread10(z) << 2;
+#endif
+}
+
+/* Interleaves three 21 bit coordinates. */
+static inline uint64_t morton63(uint32_t x, uint32_t y, uint32_t z)
+{
+#ifdef __BMI2__
+	return _pdep_u64(x, 0x1249249249249249ull) |
+		_pdep_u64(y, 0x2492492492492492ull) |
+		_pdep_u64(z, 0x4924924924924924ull);
+#else
+	return morton_spread21(x) | morton_spread21(y) << 1 |
+		morton_spread21(z) << 2;
+#endif
+}
+
+/**
+ * Skilling's transform of cell coordinates into the transposed Hilbert
+ * index: the index is x[0], x[1], x[2] interleaved, x[0] highest.
+ */
+static inline void hilbert_transpose(uint32_t x[3], int bits)
+{
+	uint32_t t = 0;
+	for (uint32_t q = 1u << (bits - 1); q > 1; q >>= 1) {
+		uint32_t p = q - 1;
+		for (int i = 0; i < 3; i++) {
+			if (x[i] & q) {
+				x[0] ^= p;
+			} else {
+				uint32_t s = (x[0] ^ x[i]) & p;
+				x[0] ^= s;
+				x[i] ^= s;
+			}
+		}
+	}
+	x[1] ^= x[0];
+	x[2] ^= x[1];
+	for (uint32_t q = 1u << (bits - 1); q > 1; q >>= 1)
+		if (x[2] & q)
+			t ^= q - 1;
+	x[0] ^= t;
+	x[1] ^= t;
+	x[2] ^= t;
+}
+
+/* Hilbert index of three 10 bit coordinates. */
+static inline uint32_t hilbert30(uint32_t x, uint32_t y, uint32_t z)
+{
+	uint32_t h[3] = {x, y, z};
+	hilbert_transpose(h, MORTON30_BITS);
+	return morton30(h[2], h[1], h[0]);
+}
+
+/* Hilbert index of three 21 bit coordinates. */
+static inline uint64_t hilbert63(uint32_t x, uint32_t y, uint32_t z)
+{
+	uint32_t h[3] = {x, y, z};
+	hilbert_transpose(h, MORTON63_BITS);
+	return morton63(h[2], h[1], h[0]);
+}
+
+#ifdef __SSE__
+/* Four points' cell coordinates, one axis per register. */
+typedef struct {
+	__m128i x, y, z;
+} morton_cells;
+
+/**
+ * Maps bounds onto cells of the given bits per axis.  A flat axis maps
+ * everything to cell 0.
+ */
+static inline void morton_bounds(const aabb bounds, int bits, vec3 *min,
+		vec3 *scale)
+{
+	vec3 extent = vec3_sub(bounds.max, bounds.min);
+	vec3 top = _mm_set1_ps((float)((1 << bits) - 1));
+	*min = bounds.min;
+	*scale = _mm_and_ps(_mm_div_ps(top, extent),
+		_mm_cmpgt_ps(extent, _mm_setzero_ps()));
+}
+
+/* Scales one axis of four points to cells, clamped to [0, top]. */
+static inline __m128i morton_quantize4(__m128 v, __m128 min, __m128 scale,
+		__m128 top)
+{
+	__m128 q = _mm_mul_ps(_mm_sub_ps(v, min), scale);
+	/* NaN takes the second operand and lands in cell 0 */
+	q = _mm_min_ps(_mm_max_ps(q, _mm_setzero_ps()), top);
+	return _mm_cvttps_epi32(q);
+}
+
+/**
+ * Quantizes points [i, i + 4) of count, padding past the end with the
+ * first of them.
+ */
+static inline morton_cells morton_cells4(const vec3 *p, int i, int count,
+		const vec3 min, const vec3 scale, int bits)
+{
+	vec3 tmp[4];
+	vec3_soa v, lo = vec3_soa_splat(min), sc = vec3_soa_splat(scale);
+	__m128 top = _mm_set1_ps((float)((1 << bits) - 1));
+	morton_cells c;
+
+	if (count - i < 4) {
+		for (int j = 0; j < 4; j++)
+			tmp[j] = p[i + (i + j < count ? j : 0)];
+		v = vec3_soa_load(tmp);
+	} else {
+		v = vec3_soa_load(p + i);
+	}
+	c.x = morton_quantize4(v.x, lo.x, sc.x, top);
+	c.y = morton_quantize4(v.y, lo.y, sc.y, top);
+	c.z = morton_quantize4(v.z, lo.z, sc.z, top);
+	return c;
+}
+
+static inline __m128i morton_spread10_4(__m128i x)
+{
+	x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi32(x, 16)),
+		_mm_set1_epi32(0x030000ff));
+	x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi32(x, 8)),
+		_mm_set1_epi32(0x0300f00f));
+	x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi32(x, 4)),
+		_mm_set1_epi32(0x030c30c3));
+	x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi32(x, 2)),
+		_mm_set1_epi32(0x09249249));
+	return x;
+}
+
+/* Spreads the two 21 bit values in the 64 bit lanes of x. */
+static inline __m128i morton_spread21_2(__m128i x)
+{
+	x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi64(x, 32)),
+		_mm_set_epi32(0x001f0000, 0x0000ffff, 0x001f0000, 0x0000ffff));
+	x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi64(x, 16)),
+		_mm_set_epi32(0x001f0000, 0xff0000ff, 0x001f0000, 0xff0000ff));
+	x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi64(x, 8)),
+		_mm_set_epi32(0x100f00f0, 0x0f00f00f, 0x100f00f0, 0x0f00f00f));
+	x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi64(x, 4)),
+		_mm_set_epi32(0x10c30c30, 0xc30c30c3, 0x10c30c30, 0xc30c30c3));
+	x = _mm_and_si128(_mm_or_si128(x, _mm_slli_epi64(x, 2)),
+		_mm_set_epi32(0x12492492, 0x49249249, 0x12492492, 0x49249249));
+	return x;
+}
+
+static inline __m128i morton_interleave10_4(const morton_cells c)
+{
+	return _mm_or_si128(morton_spread10_4(c.x), _mm_or_si128(
+		_mm_slli_epi32(morton_spread10_4(c.y), 1),
+		_mm_slli_epi32(morton_spread10_4(c.z), 2)));
+}
+
+/* Interleaves four sets of 21 bit cells into lo (0, 1) and hi (2, 3). */
+static inline void morton_interleave21_4(const morton_cells c, __m128i *lo,
+		__m128i *hi)
+{
+	__m128i zero = _mm_setzero_si128();
+	*lo = _mm_or_si128(morton_spread21_2(_mm_unpacklo_epi32(c.x, zero)),
+		_mm_or_si128(
+		_mm_slli_epi64(morton_spread21_2(_mm_unpacklo_epi32(c.y, zero)), 1),
+		_mm_slli_epi64(morton_spread21_2(_mm_unpacklo_epi32(c.z, zero)), 2)));
+	*hi = _mm_or_si128(morton_spread21_2(_mm_unpackhi_epi32(c.x, zero)),
+		_mm_or_si128(
+		_mm_slli_epi64(morton_spread21_2(_mm_unpackhi_epi32(c.y, zero)), 1),
+		_mm_slli_epi64(morton_spread21_2(_mm_unpackhi_epi32(c.z, zero)), 2)));
+}
+
+/* hilbert_transpose on four sets of cells, then swaps x and z. */
+static inline morton_cells hilbert_transpose4(morton_cells c, int bits)
+{
+	__m128i t = _mm_setzero_si128(), set, s;
+	morton_cells out;
+
+	for (int q = 1 << (bits - 1); q > 1; q >>= 1) {
+		__m128i qq = _mm_set1_epi32(q), p = _mm_set1_epi32(q - 1);
+		/* x swaps with itself, so only its invert is left */
+		set = _mm_cmpeq_epi32(_mm_and_si128(c.x, qq), qq);
+		c.x = _mm_xor_si128(c.x, _mm_and_si128(set, p));
+		set = _mm_cmpeq_epi32(_mm_and_si128(c.y, qq), qq);
+		s = _mm_andnot_si128(set, _mm_and_si128(_mm_xor_si128(c.x, c.y), p));
+		c.x = _mm_xor_si128(c.x, _mm_or_si128(s, _mm_and_si128(set, p)));
+		c.y = _mm_xor_si128(c.y, s);
+		set = _mm_cmpeq_epi32(_mm_and_si128(c.z, qq), qq);
+		s = _mm_andnot_si128(set, _mm_and_si128(_mm_xor_si128(c.x, c.z), p));
+		c.x = _mm_xor_si128(c.x, _mm_or_si128(s, _mm_and_si128(set, p)));
+		c.z = _mm_xor_si128(c.z, s);
+	}
+	c.y = _mm_xor_si128(c.y, c.x);
+	c.z = _mm_xor_si128(c.z, c.y);
+	for (int q = 1 << (bits - 1); q > 1; q >>= 1) {
+		__m128i qq = _mm_set1_epi32(q);
+		set = _mm_cmpeq_epi32(_mm_and_si128(c.z, qq), qq);
+		t = _mm_xor_si128(t, _mm_and_si128(set, _mm_set1_epi32(q - 1)));
+	}
+	out.x = _mm_xor_si128(c.z, t);
+	out.y = _mm_xor_si128(c.y, t);
+	out.z = _mm_xor_si128(c.x, t);
+	return out;
+}
+
+#ifdef __AVX2__
+typedef struct {
+	__m256i x, y, z;
+} morton_cells8;
+
+/* Quantizes points [0, 8) of p, one axis per register. */
+static inline __m256i morton_quantize8(__m256 v, float min, float scale,
+		__m256 top)
+{
+	__m256 q = _mm256_mul_ps(_mm256_sub_ps(v, _mm256_set1_ps(min)),
+		_mm256_set1_ps(scale));
+	q = _mm256_min_ps(_mm256_max_ps(q, _mm256_setzero_ps()), top);
+	return _mm256_cvttps_epi32(q);
+}
+
+static inline morton_cells8 morton_cells8_load(const vec3 *p,
+		const vec3 min, const vec3 scale, int bits)
+{
+	vec3_soa8 v = vec3_soa8_load(p);
+	__m256 top = _mm256_set1_ps((float)((1 << bits) - 1));
+	morton_cells8 c;
+	c.x = morton_quantize8(v.x, fidx(min, 0), fidx(scale, 0), top);
+	c.y = morton_quantize8(v.y, fidx(min, 1), fidx(scale, 1), top);
+	c.z = morton_quantize8(v.z, fidx(min, 2), fidx(scale, 2), top);
+	return c;
+}
+
+static inline __m256i morton_spread10_8(__m256i x)
+{
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi32(x, 16)),
+		_mm256_set1_epi32(0x030000ff));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi32(x, 8)),
+		_mm256_set1_epi32(0x0300f00f));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi32(x, 4)),
+		_mm256_set1_epi32(0x030c30c3));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi32(x, 2)),
+		_mm256_set1_epi32(0x09249249));
+	return x;
+}
+
+static inline __m256i morton_spread21_4(__m256i x)
+{
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 32)),
+		_mm256_set1_epi64x(0x001f00000000ffffll));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 16)),
+		_mm256_set1_epi64x(0x001f0000ff0000ffll));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 8)),
+		_mm256_set1_epi64x(0x100f00f00f00f00fll));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 4)),
+		_mm256_set1_epi64x(0x10c30c30c30c30c3ll));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 2)),
+		_mm256_set1_epi64x(0x1249249249249249ll));
+	return x;
+}
+
+static inline __m256i morton_interleave10_8(const morton_cells8 c)
+{
+	return _mm256_or_si256(morton_spread10_8(c.x), _mm256_or_si256(
+		_mm256_slli_epi32(morton_spread10_8(c.y), 1),
+		_mm256_slli_epi32(morton_spread10_8(c.z), 2)));
+}
+
+/* Interleaves the 21 bit cells of four lanes, from lane 4 * half. */
+static inline __m256i morton_interleave21_8(const morton_cells8 c, int half)
+{
+	__m128i x = half ? _mm256_extracti128_si256(c.x, 1) :
+		_mm256_castsi256_si128(c.x);
+	__m128i y = half ? _mm256_extracti128_si256(c.y, 1) :
+		_mm256_castsi256_si128(c.y);
+	__m128i z = half ? _mm256_extracti128_si256(c.z, 1) :
+		_mm256_castsi256_si128(c.z);
+	return _mm256_or_si256(morton_spread21_4(_mm256_cvtepu32_epi64(x)),
+		_mm256_or_si256(
+		_mm256_slli_epi64(morton_spread21_4(_mm256_cvtepu32_epi64(y)), 1),
+		_mm256_slli_epi64(morton_spread21_4(_mm256_cvtepu32_epi64(z)), 2)));
+}
+
+static inline morton_cells8 hilbert_transpose8(morton_cells8 c, int bits)
+{
+	__m256i t = _mm256_setzero_si256(), set, s;
+	morton_cells8 out;
+
+	for (int q = 1 << (bits - 1); q > 1; q >>= 1) {
+		__m256i qq = _mm256_set1_epi32(q), p = _mm256_set1_epi32(q - 1);
+		set = _mm256_cmpeq_epi32(_mm256_and_si256(c.x, qq), qq);
+		c.x = _mm256_xor_si256(c.x, _mm256_and_si256(set, p));
+		set = _mm256_cmpeq_epi32(_mm256_and_si256(c.y, qq), qq);
+		s = _mm256_andnot_si256(set,
+			_mm256_and_si256(_mm256_xor_si256(c.x, c.y), p));
+		c.x = _mm256_xor_si256(c.x,
+			_mm256_or_si256(s, _mm256_and_si256(set, p)));
+		c.y = _mm256_xor_si256(c.y, s);
+		set = _mm256_cmpeq_epi32(_mm256_and_si256(c.z, qq), qq);
+		s = _mm256_andnot_si256(set,
+			_mm256_and_si256(_mm256_xor_si256(c.x, c.z), p));
+		c.x = _mm256_xor_si256(c.x,
+			_mm256_or_si256(s, _mm256_and_si256(set, p)));
+		c.z = _mm256_xor_si256(c.z, s);
+	}
+	c.y = _mm256_xor_si256(c.y, c.x);
+	c.z = _mm256_xor_si256(c.z, c.y);
+	for (int q = 1 << (bits - 1); q > 1; q >>= 1) {
+		__m256i qq = _mm256_set1_epi32(q);
+		set = _mm256_cmpeq_epi32(_mm256_and_si256(c.z, qq), qq);
+		t = _mm256_xor_si256(t, _mm256_and_si256(set,
+			_mm256_set1_epi32(q - 1)));
+	}
+	out.x = _mm256_xor_si256(c.z, t);
+	out.y = _mm256_xor_si256(c.y, t);
+	out.z = _mm256_xor_si256(c.x, t);
+	return out;
+}
+#endif
+
+/* Stores the first n of four 32 bit codes. */
+static inline void morton_store30(uint32_t *out, __m128i code, int n)
+{
+	if (n >= 4) {
+		_mm_storeu_si128((__m128i *)out, code);
+	} else {
+		uint32_t tmp[4];
+		_mm_storeu_si128((__m128i *)tmp, code);
+		memcpy(out, tmp, sizeof(uint32_t) * n);
+	}
+}
+
+/* Stores the first n of four 64 bit codes. */
+static inline void morton_store63(uint64_t *out, __m128i lo, __m128i hi,
+		int n)
+{
+	uint64_t tmp[4];
+	if (n >= 4) {
+		_mm_storeu_si128((__m128i *)out, lo);
+		_mm_storeu_si128((__m128i *)(out + 2), hi);
+	} else {
+		_mm_storeu_si128((__m128i *)tmp, lo);
+		_mm_storeu_si128((__m128i *)(tmp + 2), hi);
+		memcpy(out, tmp, sizeof(uint64_t) * n);
+	}
+}
+
+/**
+ * Morton codes of count points quantized to 1024 cells per axis of
+ * bounds.  Points outside bounds clamp to the nearest cell.
+ */
+static inline void morton30_encode(uint32_t *out, const vec3 *p, int count,
+		const aabb bounds)
+{
+	vec3 min, scale;
+	int i = 0;
+	morton_bounds(bounds, MORTON30_BITS, &min, &scale);
+#ifdef __AVX2__
+	for (; i + 8 <= count; i += 8) {
+		morton_cells8 c = morton_cells8_load(p + i, min, scale,
+			MORTON30_BITS);
+		_mm256_storeu_si256((__m256i *)(out + i), morton_interleave10_8(c));
+	}
+#endif
+	for (; i < count; i += 4) {
+		morton_cells c = morton_cells4(p, i, count, min, scale,
+			MORTON30_BITS);
+		morton_store30(out + i, morton_interleave10_4(c), count - i);
+	}
+}
+
+/**
+ * Morton codes of count points quantized to 2^21 cells per axis of
+ * bounds.  With BMI2 the cells are interleaved by pdep.
+ */
+static inline void morton63_encode(uint64_t *out, const vec3 *p, int count,
+		const aabb bounds)
+{
+	vec3 min, scale;
+	int i = 0;
+	morton_bounds(bounds, MORTON63_BITS, &min, &scale);
+#if defined(__AVX2__) && !defined(__BMI2__)
+	for (; i + 8 <= count; i += 8) {
+		morton_cells8 c = morton_cells8_load(p + i, min, scale,
+			MORTON63_BITS);
+		_mm256_storeu_si256((__m256i *)(out + i), morton_interleave21_8(c, 0));
+		_mm256_storeu_si256((__m256i *)(out + i + 4),
+			morton_interleave21_8(c, 1));
+	}
+#endif
+	for (; i < count; i += 4) {
+		morton_cells c = morton_cells4(p, i, count, min, scale,
+			MORTON63_BITS);
+#ifdef __BMI2__
+		uint32_t x[4], y[4], z[4];
+		_mm_storeu_si128((__m128i *)x, c.x);
+		_mm_storeu_si128((__m128i *)y, c.y);
+		_mm_storeu_si128((__m128i *)z, c.z);
+		for (int j = 0; j < 4 && i + j < count; j++)
+			out[i + j] = morton63(x[j], y[j], z[j]);
+#else
+		__m128i lo, hi;
+		morton_interleave21_4(c, &lo, &hi);
+		morton_store63(out + i, lo, hi, count - i);
+#endif
+	}
+}
+
+/**
+ * Hilbert codes of count points quantized to 1024 cells per axis of
+ * bounds.  Neighbouring codes are always neighbouring cells.
+ */
+static inline void hilbert30_encode(uint32_t *out, const vec3 *p, int count,
+		const aabb bounds)
+{
+	vec3 min, scale;
+	int i = 0;
+	morton_bounds(bounds, MORTON30_BITS, &min, &scale);
+#ifdef __AVX2__
+	for (; i + 8 <= count; i += 8) {
+		morton_cells8 c = hilbert_transpose8(morton_cells8_load(p + i, min,
+			scale, MORTON30_BITS), MORTON30_BITS);
+		_mm256_storeu_si256((__m256i *)(out + i), morton_interleave10_8(c));
+	}
+#endif
+	for (; i < count; i += 4) {
+		morton_cells c = hilbert_transpose4(morton_cells4(p, i, count, min,
+			scale, MORTON30_BITS), MORTON30_BITS);
+		morton_store30(out + i, morton_interleave10_4(c), count - i);
+	}
+}
+
+/* Hilbert codes of count points quantized to 2^21 cells per axis. */
+static inline void hilbert63_encode(uint64_t *out, const vec3 *p, int count,
+		const aabb bounds)
+{
+	vec3 min, scale;
+	int i = 0;
+	morton_bounds(bounds, MORTON63_BITS, &min, &scale);
+#ifdef __AVX2__
+	for (; i + 8 <= count; i += 8) {
+		morton_cells8 c = hilbert_transpose8(morton_cells8_load(p + i, min,
+			scale, MORTON63_BITS), MORTON63_BITS);
+		_mm256_storeu_si256((__m256i *)(out + i), morton_interleave21_8(c, 0));
+		_mm256_storeu_si256((__m256i *)(out + i + 4),
+			morton_interleave21_8(c, 1));
+	}
+#endif
+	for (; i < count; i += 4) {
+		__m128i lo, hi;
+		morton_cells c = hilbert_transpose4(morton_cells4(p, i, count, min,
+			scale, MORTON63_BITS), MORTON63_BITS);
+		morton_interleave21_4(c, &lo, &hi);
+		morton_store63(out + i, lo, hi, count - i);
+	}
+}
+#endif
+
+/**
+ * Sorts count 32 bit keys in place, least significant digit first, and
+ * writes to perm the input index of each sorted key.  Equal keys keep
+ * their order and digits every key shares are skipped.  Returns 0 on
+ * success, -1 when out of memory.  Threaded callers can drive the
+ * radix_sorter passes themselves.
+ */
+static inline int morton_sort30(uint32_t *keys, int *perm, int count)
+{
+	return radix_sort(keys, perm, count);
+}
+
+/* Sorts count 64 bit keys as morton_sort30 does. */
+static inline int morton_sort63(uint64_t *keys, int *perm, int count)
+{
+	return radix_sort64(keys, perm, count);
+}
+
+/**
+ * Gathers count elements of size bytes, dst[i] = src[perm[i]], to put a
+ * parallel array in the order of sorted keys.  dst and src must not
+ * overlap.
+ */
+static inline void morton_permute(void *dst, const void *src, size_t size,
+		const int *perm, int count)
+{
+	switch (size) {
+	case 4:
+		for (int i = 0; i < count; i++)
+			((uint32_t *)dst)[i] = ((const uint32_t *)src)[perm[i]];
+		break;
+	case 8:
+		for (int i = 0; i < count; i++)
+			((uint64_t *)dst)[i] = ((const uint64_t *)src)[perm[i]];
+		break;
+#ifdef __SSE__
+	case 16:
+		for (int i = 0; i < count; i++)
+			_mm_storeu_ps((float *)dst + 4 * i,
+				_mm_loadu_ps((const float *)src + 4 * perm[i]));
+		break;
+#endif
+	default:
+		for (int i = 0; i < count; i++)
+			memcpy((char *)dst + size * i, (const char *)src + size * perm[i],
+				size);
+	}
+}
+
+#endif /* _GMATH_MORTON_H_ */
@@ -0,0 +1,327 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * obb.h
+ * Handles oriented bounding boxes
+ *
+ */
+
+#ifndef _GMATH_OBB_H_
+#define _GMATH_OBB_H_
+
+#include <float.h>
+#include "constants.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "mat4.h"
+#include "aabb.h"
+#include "ray.h"
+
+#ifdef __SSE__
+
+/**
+ * Added to the absolute rotation terms of the separating axis test so
+ * that the cross of two near parallel edges cannot report a false gap.
+ */
+#define OBB_EPSILON 1e-6f
+
+/* Sweeps of Jacobi rotations when fitting to points. */
+#define OBB_JACOBI_SWEEPS 16
+
+/* Lane i of v from lanes i + 1 and i + 2, mod 3. */
+#define OBB_ROT1(v) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(3,0,2,1))
+#define OBB_ROT2(v) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(3,1,0,2))
+
+/**
+ * Box of half size half in the frame of the affine m.  Scale in the
+ * columns moves into the half size, shear is not kept.
+ */
+static inline obb obb_from_mat4(const mat4 m, const vec3 half)
+{
+	obb out;
+	vec3 len = _mm_setzero_ps();
+	for (int i = 0; i < 3; i++) {
+		float l = vec3_length(m.col[i]);
+		out.axis[i] = vec3_scale(m.col[i], l > 0.0f ? 1.0f / l : 0.0f);
+		fidx(len, i) = l;
+	}
+	out.center = m.col[3];
+	out.half = vec3_mul(half, len);
+	return out;
+}
+
+/* The box a under the affine m, as obb_from_mat4 sees it. */
+static inline obb obb_from_aabb(const mat4 m, const aabb a)
+{
+	obb out = obb_from_mat4(m, aabb_extent(a));
+	out.center = mat4_transform_point(m, aabb_center(a));
+	return out;
+}
+
+/* The affine mapping the cube [-1, 1] onto b. */
+static inline mat4 obb_to_mat4(const obb *b)
+{
+	mat4 out;
+	out.col[0] = vec3_mul(b->axis[0], VEC4_XXXX(b->half));
+	out.col[1] = vec3_mul(b->axis[1], VEC4_YYYY(b->half));
+	out.col[2] = vec3_mul(b->axis[2], VEC4_ZZZZ(b->half));
+	out.col[3] = b->center;
+	for (int i = 0; i < 3; i++)
+		fidx(out.col[i], 3) = 0.0f;
+	fidx(out.col[3], 3) = 1.0f;
+	return out;
+}
+
+/**
+ * The axes of b as rows, so that r[0] x + r[1] y + r[2] z takes a
+ * world direction into b's frame.
+ */
+static inline void obb_rows(const obb *b, vec3 *r)
+{
+	__m128 w = _mm_setzero_ps();
+	r[0] = b->axis[0];
+	r[1] = b->axis[1];
+	r[2] = b->axis[2];
+	_MM_TRANSPOSE4_PS(r[0], r[1], r[2], w);
+}
+
+/* v in the frame with rows r. */
+static inline vec3 obb_local(const vec3 *r, const vec3 v)
+{
+	return vec3_add(vec3_add(vec3_mul(r[0], VEC4_XXXX(v)),
+		vec3_mul(r[1], VEC4_YYYY(v))), vec3_mul(r[2], VEC4_ZZZZ(v)));
+}
+
+/* Bounds of b, its half size scaled by the absolute axes as in Arvo. */
+static inline aabb obb_bounds(const obb *b)
+{
+	aabb out;
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(SIGN_MASK));
+	vec3 r = _mm_add_ps(_mm_add_ps(
+		_mm_mul_ps(_mm_andnot_ps(sign, b->axis[0]), VEC4_XXXX(b->half)),
+		_mm_mul_ps(_mm_andnot_ps(sign, b->axis[1]), VEC4_YYYY(b->half))),
+		_mm_mul_ps(_mm_andnot_ps(sign, b->axis[2]), VEC4_ZZZZ(b->half)));
+	out.min = vec3_sub(b->center, r);
+	out.max = vec3_add(b->center, r);
+	return out;
+}
+
+/**
+ * Tests whether p lies inside or on b.
+ */
+static inline int obb_contains(const obb *b, const vec3 p)
+{
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(SIGN_MASK));
+	vec3 r[3], l;
+	obb_rows(b, r);
+	l = _mm_andnot_ps(sign, obb_local(r, vec3_sub(p, b->center)));
+	return (_mm_movemask_ps(_mm_cmpgt_ps(l, b->half)) & 7) == 0;
+}
+
+/**
+ * Tests whether two boxes overlap, touching counts, on the 15 axes of
+ * Gottschalk's separating axis test as written out in Ericson's
+ * Real-Time Collision Detection 4.4.1.  The rotation from b to a is
+ * kept by columns, so the three face axes of a, the three of b, and the
+ * three edges of a against each edge of b are five tests of three
+ * lanes each, with no early out.
+ */
+static inline int obb_overlap(const obb *a, const obb *b)
+{
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(SIGN_MASK));
+	__m128 eps = _mm_set1_ps(OBB_EPSILON);
+	__m128 w = _mm_setzero_ps(), sep, ra, rb, p;
+	vec3 r[3], c[3], ac[3], row[3], arow[3], t, ea = a->half, eb = b->half;
+
+	/* c[j] lane i is R[i][j] = a_i . b_j */
+	obb_rows(a, r);
+	for (int j = 0; j < 3; j++) {
+		c[j] = obb_local(r, b->axis[j]);
+		ac[j] = _mm_add_ps(_mm_andnot_ps(sign, c[j]), eps);
+	}
+	t = obb_local(r, vec3_sub(b->center, a->center));
+
+	/* the axes of a */
+	rb = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ac[0], VEC4_XXXX(eb)),
+		_mm_mul_ps(ac[1], VEC4_YYYY(eb))), _mm_mul_ps(ac[2], VEC4_ZZZZ(eb)));
+	sep = _mm_cmpgt_ps(_mm_andnot_ps(sign, t), _mm_add_ps(ea, rb));
+
+	/* the axes of b, from the rows of R */
+	row[0] = c[0], row[1] = c[1], row[2] = c[2];
+	_MM_TRANSPOSE4_PS(row[0], row[1], row[2], w);
+	for (int i = 0; i < 3; i++)
+		arow[i] = _mm_add_ps(_mm_andnot_ps(sign, row[i]), eps);
+	p = obb_local(row, t);
+	ra = _mm_add_ps(_mm_add_ps(_mm_mul_ps(arow[0], VEC4_XXXX(ea)),
+		_mm_mul_ps(arow[1], VEC4_YYYY(ea))),
+		_mm_mul_ps(arow[2], VEC4_ZZZZ(ea)));
+	sep = _mm_or_ps(sep, _mm_cmpgt_ps(_mm_andnot_ps(sign, p),
+		_mm_add_ps(ra, eb)));
+
+	/* a_i x b_j for each j, lanes over i */
+	for (int j = 0; j < 3; j++) {
+		int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+		ra = _mm_add_ps(_mm_mul_ps(OBB_ROT1(ea), OBB_ROT2(ac[j])),
+			_mm_mul_ps(OBB_ROT2(ea), OBB_ROT1(ac[j])));
+		rb = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(fidx(eb, j1)), ac[j2]),
+			_mm_mul_ps(_mm_set1_ps(fidx(eb, j2)), ac[j1]));
+		p = _mm_sub_ps(_mm_mul_ps(OBB_ROT2(t), OBB_ROT1(c[j])),
+			_mm_mul_ps(OBB_ROT1(t), OBB_ROT2(c[j])));
+		sep = _mm_or_ps(sep, _mm_cmpgt_ps(_mm_andnot_ps(sign, p),
+			_mm_add_ps(ra, rb)));
+	}
+	return (_mm_movemask_ps(sep) & 7) == 0;
+}
+
+/**
+ * Slab test of a ray against b in b's frame.  On a hit with the entry
+ * before tmax, writes the entry distance (0 when starting inside) and
+ * returns nonzero.
+ */
+static inline int obb_ray(const obb *b, const ray *r, float tmax,
+		float *tnear)
+{
+	vec3 rows[3];
+	ray l;
+	ray_slab s;
+	aabb box;
+
+	obb_rows(b, rows);
+	l.origin = obb_local(rows, vec3_sub(r->origin, b->center));
+	l.dir = obb_local(rows, r->dir);
+	s = ray_slab_init(&l);
+	box.min = vec3_neg(b->half);
+	box.max = b->half;
+	return ray_aabb(&s, &box, tmax, tnear);
+}
+
+/**
+ * Eigenvectors of the symmetric a by cyclic Jacobi rotations, as the
+ * columns of v.  a is left diagonal, holding the eigenvalues.
+ */
+static inline void obb_jacobi(float a[3][3], float v[3][3])
+{
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			v[i][j] = i == j ? 1.0f : 0.0f;
+	for (int sweep = 0; sweep < OBB_JACOBI_SWEEPS; sweep++) {
+		float off = a[0][1] * a[0][1] + a[0][2] * a[0][2] +
+			a[1][2] * a[1][2];
+		float on = a[0][0] * a[0][0] + a[1][1] * a[1][1] +
+			a[2][2] * a[2][2];
+		if (off <= 1e-14f * on)
+			break;
+		for (int p = 0; p < 2; p++) {
+			for (int q = p + 1; q < 3; q++) {
+				float theta, t, c, s;
+				if (a[p][q] == 0.0f)
+					continue;
+				theta = (a[q][q] - a[p][p]) / (2.0f * a[p][q]);
+				t = copysignf(1.0f, theta) /
+					(fabsf(theta) + sqrtf(theta * theta + 1.0f));
+				c = 1.0f / sqrtf(t * t + 1.0f);
+				s = t * c;
+				for (int k = 0; k < 3; k++) {
+					float kp = a[k][p], kq = a[k][q];
+					a[k][p] = c * kp - s * kq;
+					a[k][q] = s * kp + c * kq;
+				}
+				for (int k = 0; k < 3; k++) {
+					float pk = a[p][k], qk = a[q][k];
+					a[p][k] = c * pk - s * qk;
+					a[q][k] = s * pk + c * qk;
+				}
+				for (int k = 0; k < 3; k++) {
+					float kp = v[k][p], kq = v[k][q];
+					v[k][p] = c * kp - s * kq;
+					v[k][q] = s * kp + c * kq;
+				}
+			}
+		}
+	}
+}
+
+/* Sets the centre and half size of b to bound count points. */
+static inline void obb_fit(obb *b, const vec3 *p, int count)
+{
+	vec3 r[3], lo = _mm_set1_ps(FLT_MAX), hi = _mm_set1_ps(-FLT_MAX), m;
+	obb_rows(b, r);
+	for (int i = 0; i < count; i++) {
+		vec3 l = obb_local(r, p[i]);
+		lo = _mm_min_ps(lo, l);
+		hi = _mm_max_ps(hi, l);
+	}
+	m = vec3_scale(vec3_add(lo, hi), 0.5f);
+	b->half = vec3_scale(vec3_sub(hi, lo), 0.5f);
+	b->center = vec3_add(vec3_add(
+		vec3_mul(b->axis[0], VEC4_XXXX(m)),
+		vec3_mul(b->axis[1], VEC4_YYYY(m))),
+		vec3_mul(b->axis[2], VEC4_ZZZZ(m)));
+}
+
+static inline float obb_volume(const obb *b)
+{
+	return 8.0f * fidx(b->half, 0) * fidx(b->half, 1) * fidx(b->half, 2);
+}
+
+/**
+ * Box around count points along the eigenvectors of their covariance,
+ * or the bounds when those are smaller.  The covariance weighs every
+ * point, so points of a convex hull fit tighter than a dense cloud.
+ * The sums run on offsets from the first point to keep precision.
+ */
+static inline obb obb_from_points(const vec3 *p, int count)
+{
+	obb out, box;
+	vec3 s = _mm_setzero_ps(), sq = s, sx = s, m, mx;
+	float a[3][3], v[3][3], n = (float)count;
+	aabb bounds = aabb_from_points(p, count);
+
+	box.center = aabb_center(bounds);
+	box.half = aabb_extent(bounds);
+	box.axis[0] = _mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	box.axis[1] = _mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f);
+	box.axis[2] = _mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f);
+	if (count < 2) {
+		box.center = count ? p[0] : _mm_setzero_ps();
+		box.half = _mm_setzero_ps();
+		return box;
+	}
+
+	/* sums of d, d * d and d * (dy, dz, dx) */
+	for (int i = 1; i < count; i++) {
+		vec3 d = vec3_sub(p[i], p[0]);
+		s = vec3_add(s, d);
+		sq = vec3_add(sq, vec3_mul(d, d));
+		sx = vec3_add(sx, vec3_mul(d, OBB_ROT1(d)));
+	}
+	m = vec3_scale(s, 1.0f / n);
+	mx = vec3_mul(m, OBB_ROT1(m));
+	sq = vec3_sub(vec3_scale(sq, 1.0f / n), vec3_mul(m, m));
+	sx = vec3_sub(vec3_scale(sx, 1.0f / n), mx);
+	a[0][0] = fidx(sq, 0);
+	a[1][1] = fidx(sq, 1);
+	a[2][2] = fidx(sq, 2);
+	a[0][1] = a[1][0] = fidx(sx, 0);
+	a[1][2] = a[2][1] = fidx(sx, 1);
+	a[2][0] = a[0][2] = fidx(sx, 2);
+	obb_jacobi(a, v);
+
+	/* a right handed frame, cleaned of rounding; vec3_normalize is
+	 * only good to the 12 bits of rcpps */
+	out.axis[0] = _mm_setr_ps(v[0][0], v[1][0], v[2][0], 0.0f);
+	out.axis[0] = vec3_scale(out.axis[0], 1.0f / vec3_length(out.axis[0]));
+	out.axis[1] = _mm_setr_ps(v[0][1], v[1][1], v[2][1], 0.0f);
+	out.axis[1] = vec3_sub(out.axis[1], vec3_scale(out.axis[0],
+		vec3_dot(out.axis[0], out.axis[1])));
+	out.axis[1] = vec3_scale(out.axis[1], 1.0f / vec3_length(out.axis[1]));
+	out.axis[2] = vec3_cross(out.axis[0], out.axis[1]);
+	obb_fit(&out, p, count);
+	return obb_volume(&out) < obb_volume(&box) ? out : box;
+}
+
+#endif
+
+#endif /* _GMATH_OBB_H_ */
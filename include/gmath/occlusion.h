@@ -0,0 +1,490 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * occlusion.h
+ * Handles a tiled software depth buffer for occlusion culling
+ *
+ */
+
+#ifndef _GMATH_OCCLUSION_H_
+#define _GMATH_OCCLUSION_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "task.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "mat4.h"
+#include "aabb.h"
+
+#ifdef __SSE__
+
+/* Pixels in a tile; the width is a whole number of AVX registers. */
+#define OCCLUSION_TILE_W 32
+#define OCCLUSION_TILE_H 8
+#define OCCLUSION_TILE (OCCLUSION_TILE_W * OCCLUSION_TILE_H)
+
+#ifdef __AVX__
+#define OCCLUSION_LANES 8
+#else
+#define OCCLUSION_LANES 4
+#endif
+
+/**
+ * An occluder triangle set up for rasterising: three edge functions
+ * and the plane of 1/w over pixel coordinates, all evaluated at pixel
+ * centres, and its pixel bounds [x0, x1) by [y0, y1), empty when it
+ * was dropped.
+ */
+typedef struct {
+	float ex[3], ey[3], e0[3];
+	float zx, zy, z0;
+	int x0, y0, x1, y1;
+} occlusion_tri;
+
+/**
+ * A depth buffer of 1/w, so larger is nearer and 0 is empty, stored
+ * tile by tile with rows from the bottom as glViewport.  tile_far
+ * holds the farthest depth of each tile for rejecting boxes a tile at
+ * a time.  The rest is the binning state: occluder triangles are set
+ * up and counted into the tiles they touch in ranges over tasks, then
+ * tile t draws bin[start[t]] to bin[start[t + 1] - 1].
+ */
+typedef struct {
+	int width, height, tiles_x, tiles_y, tiles;
+	float *depth;
+	float *tile_far;
+	mat4 mvp;
+	const vec3 *vertices;
+	const int *indices;
+	int tri_count, tri_cap, bin_cap, tasks;
+	occlusion_tri *tri;
+	int *start;
+	int *bin;
+	int *hist;
+} occlusion_buffer;
+
+static inline void occlusion_free(occlusion_buffer *b)
+{
+	free(b->depth);
+	free(b->tile_far);
+	free(b->tri);
+	free(b->start);
+	free(b->bin);
+	free(b->hist);
+	memset(b, 0, sizeof(*b));
+}
+
+/**
+ * Sets up an empty buffer of width by height pixels, rounded up to
+ * whole tiles, binned by tasks threads.  Returns 0 on success, -1
+ * when out of memory.
+ */
+static inline int occlusion_init(occlusion_buffer *b, int width, int height,
+		int tasks)
+{
+	memset(b, 0, sizeof(*b));
+	b->width = width;
+	b->height = height;
+	b->tiles_x = (width + OCCLUSION_TILE_W - 1) / OCCLUSION_TILE_W;
+	b->tiles_y = (height + OCCLUSION_TILE_H - 1) / OCCLUSION_TILE_H;
+	b->tiles = b->tiles_x * b->tiles_y;
+	b->tasks = tasks < 1 ? 1 : tasks;
+	b->depth = calloc((size_t)b->tiles * OCCLUSION_TILE, sizeof(float));
+	b->tile_far = calloc(b->tiles, sizeof(float));
+	b->start = calloc(b->tiles + 1, sizeof(int));
+	b->hist = malloc(sizeof(int) * b->tasks * b->tiles);
+	if (!b->depth || !b->tile_far || !b->start || !b->hist) {
+		occlusion_free(b);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Starts binning count triangles, indices holding three vertices for
+ * each, seen through mvp.  Returns 0 on success, -1 when out of memory.
+ */
+static inline int occlusion_bin_begin(occlusion_buffer *b, const mat4 mvp,
+		const vec3 *vertices, const int *indices, int count)
+{
+	if (count > b->tri_cap) {
+		occlusion_tri *tri = realloc(b->tri, sizeof(occlusion_tri) * count);
+		if (!tri)
+			return -1;
+		b->tri = tri;
+		b->tri_cap = count;
+	}
+	b->mvp = mvp;
+	b->vertices = vertices;
+	b->indices = indices;
+	b->tri_count = count;
+	return 0;
+}
+
+/**
+ * Projects triangle i to the screen and sets up its edges and depth.
+ * Triangles reaching behind the near plane are dropped rather than
+ * clipped, which only ever lets more through the test.
+ */
+static inline void occlusion_setup(const occlusion_buffer *b,
+		occlusion_tri *r, int i)
+{
+	float x[3], y[3], iw[3], area, s, d1, d2;
+	float lx, hx, ly, hy;
+
+	r->x0 = r->x1 = r->y0 = r->y1 = 0;
+	for (int k = 0; k < 3; k++) {
+		vec3 v = b->vertices[b->indices[3 * i + k]];
+		vec4 c = mat4_transform4(b->mvp, _mm_setr_ps(fidx(v, 0),
+			fidx(v, 1), fidx(v, 2), 1.0f));
+		float w = fidx(c, 3);
+		if (!(w > 0.0f) || fidx(c, 2) < -w)
+			return;
+		iw[k] = 1.0f / w;
+		x[k] = (fidx(c, 0) * iw[k] + 1.0f) * 0.5f * b->width;
+		y[k] = (fidx(c, 1) * iw[k] + 1.0f) * 0.5f * b->height;
+	}
+	area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (!(fabsf(area) > 0.0f))
+		return;
+	/* both windings are drawn, the edges face inwards either way */
+	s = area > 0.0f ? 1.0f : -1.0f;
+	for (int k = 0; k < 3; k++) {
+		int a = k, c = k == 2 ? 0 : k + 1;
+		r->ex[k] = (y[a] - y[c]) * s;
+		r->ey[k] = (x[c] - x[a]) * s;
+		r->e0[k] = 0.5f * (r->ex[k] + r->ey[k]) -
+			(r->ex[k] * x[a] + r->ey[k] * y[a]);
+	}
+	d1 = iw[1] - iw[0];
+	d2 = iw[2] - iw[0];
+	r->zx = (d1 * (y[2] - y[0]) - d2 * (y[1] - y[0])) / area;
+	r->zy = (d2 * (x[1] - x[0]) - d1 * (x[2] - x[0])) / area;
+	r->z0 = iw[0] - r->zx * x[0] - r->zy * y[0] + 0.5f * (r->zx + r->zy);
+
+	lx = fmaxf(fminf(fminf(x[0], x[1]), x[2]), 0.0f);
+	hx = fminf(fmaxf(fmaxf(x[0], x[1]), x[2]), (float)b->width);
+	ly = fmaxf(fminf(fminf(y[0], y[1]), y[2]), 0.0f);
+	hy = fminf(fmaxf(fmaxf(y[0], y[1]), y[2]), (float)b->height);
+	if (lx < hx && ly < hy) {
+		r->x0 = (int)lx;
+		r->x1 = (int)ceilf(hx);
+		r->y0 = (int)ly;
+		r->y1 = (int)ceilf(hy);
+	}
+}
+
+/**
+ * First pass over the triangles of task t: sets each up and counts
+ * the tiles its bounds touch.  Each task owns its row of counts, so a
+ * frame can start again here without clearing them.
+ */
+static inline void occlusion_bin_count(occlusion_buffer *b, int t)
+{
+	int *hist = b->hist + (size_t)t * b->tiles;
+	int last = task_first(b->tri_count, b->tasks, t + 1);
+
+	memset(hist, 0, sizeof(int) * b->tiles);
+	for (int i = task_first(b->tri_count, b->tasks, t); i < last; i++) {
+		occlusion_tri *r = &b->tri[i];
+		occlusion_setup(b, r, i);
+		if (r->x0 == r->x1)
+			continue;
+		for (int ty = r->y0 / OCCLUSION_TILE_H;
+				ty <= (r->y1 - 1) / OCCLUSION_TILE_H; ty++)
+			for (int tx = r->x0 / OCCLUSION_TILE_W;
+					tx <= (r->x1 - 1) / OCCLUSION_TILE_W; tx++)
+				hist[ty * b->tiles_x + tx]++;
+	}
+}
+
+/**
+ * Turns the counts of every task into bin starts and each task's
+ * write offsets, keeping triangles in submission order within a tile.
+ * Runs once, after all counts and before any scatter.  Returns 0 on
+ * success, -1 when out of memory.
+ */
+static inline int occlusion_bin_offsets(occlusion_buffer *b)
+{
+	int sum = 0;
+
+	for (int k = 0; k < b->tiles; k++) {
+		b->start[k] = sum;
+		for (int t = 0; t < b->tasks; t++) {
+			int *h = &b->hist[(size_t)t * b->tiles + k];
+			int n = *h;
+			*h = sum;
+			sum += n;
+		}
+	}
+	b->start[b->tiles] = sum;
+	if (sum > b->bin_cap) {
+		int *bin = realloc(b->bin, sizeof(int) * sum);
+		if (!bin)
+			return -1;
+		b->bin = bin;
+		b->bin_cap = sum;
+	}
+	return 0;
+}
+
+/* Second pass over the triangles of task t, filling the bins. */
+static inline void occlusion_bin_scatter(occlusion_buffer *b, int t)
+{
+	int *offset = b->hist + (size_t)t * b->tiles;
+	int last = task_first(b->tri_count, b->tasks, t + 1);
+
+	for (int i = task_first(b->tri_count, b->tasks, t); i < last; i++) {
+		const occlusion_tri *r = &b->tri[i];
+		if (r->x0 == r->x1)
+			continue;
+		for (int ty = r->y0 / OCCLUSION_TILE_H;
+				ty <= (r->y1 - 1) / OCCLUSION_TILE_H; ty++)
+			for (int tx = r->x0 / OCCLUSION_TILE_W;
+					tx <= (r->x1 - 1) / OCCLUSION_TILE_W; tx++)
+				b->bin[offset[ty * b->tiles_x + tx]++] = i;
+	}
+}
+
+/**
+ * Draws triangle r into the tile d whose first pixel is (ox, oy),
+ * keeping the nearest depth at the pixel centres it covers.
+ */
+static inline void occlusion_raster(float *d, const occlusion_tri *r,
+		int ox, int oy)
+{
+	int x0 = (r->x0 > ox ? r->x0 : ox) & ~(OCCLUSION_LANES - 1);
+	int x1 = r->x1 < ox + OCCLUSION_TILE_W ? r->x1 : ox + OCCLUSION_TILE_W;
+	int y0 = r->y0 > oy ? r->y0 : oy;
+	int y1 = r->y1 < oy + OCCLUSION_TILE_H ? r->y1 : oy + OCCLUSION_TILE_H;
+
+	for (int y = y0; y < y1; y++) {
+		float *row = d + (y - oy) * OCCLUSION_TILE_W - ox;
+		float fy = (float)y;
+#ifdef __AVX__
+		__m256 px = _mm256_add_ps(_mm256_set1_ps((float)x0),
+			_mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7));
+		__m256 a0 = _mm256_set1_ps(r->ey[0] * fy + r->e0[0]);
+		__m256 a1 = _mm256_set1_ps(r->ey[1] * fy + r->e0[1]);
+		__m256 a2 = _mm256_set1_ps(r->ey[2] * fy + r->e0[2]);
+		__m256 az = _mm256_set1_ps(r->zy * fy + r->z0);
+		for (int x = x0; x < x1; x += 8) {
+			__m256 e0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(
+				r->ex[0]), px), a0);
+			__m256 e1 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(
+				r->ex[1]), px), a1);
+			__m256 e2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(
+				r->ex[2]), px), a2);
+			__m256 z = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(r->zx),
+				px), az);
+			__m256 in = _mm256_min_ps(_mm256_min_ps(e0, e1), e2);
+			in = _mm256_cmp_ps(in, _mm256_setzero_ps(), _CMP_GE_OQ);
+			_mm256_storeu_ps(row + x, _mm256_max_ps(_mm256_loadu_ps(row + x),
+				_mm256_and_ps(in, z)));
+			px = _mm256_add_ps(px, _mm256_set1_ps(8.0f));
+		}
+#else
+		__m128 px = _mm_add_ps(_mm_set1_ps((float)x0),
+			_mm_setr_ps(0, 1, 2, 3));
+		__m128 a0 = _mm_set1_ps(r->ey[0] * fy + r->e0[0]);
+		__m128 a1 = _mm_set1_ps(r->ey[1] * fy + r->e0[1]);
+		__m128 a2 = _mm_set1_ps(r->ey[2] * fy + r->e0[2]);
+		__m128 az = _mm_set1_ps(r->zy * fy + r->z0);
+		for (int x = x0; x < x1; x += 4) {
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(r->ex[0]), px), a0);
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(r->ex[1]), px), a1);
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(r->ex[2]), px), a2);
+			__m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(r->zx), px), az);
+			__m128 in = _mm_min_ps(_mm_min_ps(e0, e1), e2);
+			in = _mm_cmpge_ps(in, _mm_setzero_ps());
+			_mm_storeu_ps(row + x, _mm_max_ps(_mm_loadu_ps(row + x),
+				_mm_and_ps(in, z)));
+			px = _mm_add_ps(px, _mm_set1_ps(4.0f));
+		}
+#endif
+	}
+}
+
+/**
+ * Clears and draws tiles first to last - 1 from their bins, then
+ * updates their farthest depth.  Tiles are independent, so threads
+ * may split them once every task has been scattered.
+ */
+static inline void occlusion_render(occlusion_buffer *b, int first, int last)
+{
+	for (int t = first; t < last; t++) {
+		float *d = b->depth + (size_t)t * OCCLUSION_TILE;
+		int ox = t % b->tiles_x * OCCLUSION_TILE_W;
+		int oy = t / b->tiles_x * OCCLUSION_TILE_H;
+		__m128 lo;
+
+		memset(d, 0, sizeof(float) * OCCLUSION_TILE);
+		for (int j = b->start[t]; j < b->start[t + 1]; j++)
+			occlusion_raster(d, &b->tri[b->bin[j]], ox, oy);
+		lo = _mm_loadu_ps(d);
+		for (int i = 4; i < OCCLUSION_TILE; i += 4)
+			lo = _mm_min_ps(lo, _mm_loadu_ps(d + i));
+		lo = _mm_min_ps(lo, _mm_shuffle_ps(lo, lo, _MM_SHUFFLE(1,0,3,2)));
+		lo = _mm_min_ps(lo, _mm_shuffle_ps(lo, lo, _MM_SHUFFLE(2,3,0,1)));
+		b->tile_far[t] = _mm_cvtss_f32(lo);
+	}
+}
+
+/**
+ * Bins and draws count occluder triangles on the calling thread.
+ * Returns 0 on success, -1 when out of memory.
+ */
+static inline int occlusion_draw(occlusion_buffer *b, const mat4 mvp,
+		const vec3 *vertices, const int *indices, int count)
+{
+	if (occlusion_bin_begin(b, mvp, vertices, indices, count))
+		return -1;
+	for (int t = 0; t < b->tasks; t++)
+		occlusion_bin_count(b, t);
+	if (occlusion_bin_offsets(b))
+		return -1;
+	for (int t = 0; t < b->tasks; t++)
+		occlusion_bin_scatter(b, t);
+	occlusion_render(b, 0, b->tiles);
+	return 0;
+}
+
+/* Clip space of four points through mvp, a register per component. */
+static inline void occlusion_clip4(__m128 c[4], const mat4 mvp,
+		const __m128 x, const __m128 y, const __m128 z)
+{
+	for (int i = 0; i < 4; i++)
+		c[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(
+			fidx(mvp.col[0], i)), x), _mm_mul_ps(_mm_set1_ps(
+			fidx(mvp.col[1], i)), y)), _mm_add_ps(_mm_mul_ps(
+			_mm_set1_ps(fidx(mvp.col[2], i)), z),
+			_mm_set1_ps(fidx(mvp.col[3], i))));
+}
+
+/* Whether a pixel of [x0, x1) by [y0, y1) in tile t is at or behind z. */
+static inline int occlusion_scan(const occlusion_buffer *b, int t,
+		int x0, int x1, int y0, int y1, float z)
+{
+	const float *d = b->depth + (size_t)t * OCCLUSION_TILE;
+	int ox = t % b->tiles_x * OCCLUSION_TILE_W;
+	int oy = t / b->tiles_x * OCCLUSION_TILE_H;
+	__m128 zz = _mm_set1_ps(z);
+	__m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+
+	x0 = x0 > ox ? x0 : ox;
+	x1 = x1 < ox + OCCLUSION_TILE_W ? x1 : ox + OCCLUSION_TILE_W;
+	y0 = y0 > oy ? y0 : oy;
+	y1 = y1 < oy + OCCLUSION_TILE_H ? y1 : oy + OCCLUSION_TILE_H;
+	for (int y = y0; y < y1; y++) {
+		const float *row = d + (y - oy) * OCCLUSION_TILE_W - ox;
+		for (int x = x0 & ~3; x < x1; x += 4) {
+			__m128i px = _mm_add_epi32(_mm_set1_epi32(x), lane);
+			__m128i in = _mm_and_si128(_mm_cmpgt_epi32(px,
+				_mm_set1_epi32(x0 - 1)), _mm_cmplt_epi32(px,
+				_mm_set1_epi32(x1)));
+			__m128 m = _mm_and_ps(_mm_castsi128_ps(in),
+				_mm_cmple_ps(_mm_loadu_ps(row + x), zz));
+			if (_mm_movemask_ps(m))
+				return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Whether any of box may be seen through mvp past the occluders, the
+ * same mvp they were drawn with.  Boxes wholly off screen are hidden;
+ * boxes reaching behind the near plane are always visible.  The box's
+ * screen rectangle is compared at its nearest depth, first against
+ * the farthest depth of each tile and then pixel by pixel.
+ */
+static inline int occlusion_test_aabb(const occlusion_buffer *b,
+		const mat4 mvp, const aabb *box)
+{
+	__m128 lo[4], hi[4], r0, r1, sx, sy, z, n;
+	/* x and y are the corners, then the largest of their projections */
+	__m128 x = _mm_setr_ps(fidx(box->min, 0), fidx(box->max, 0),
+		fidx(box->min, 0), fidx(box->max, 0));
+	__m128 y = _mm_setr_ps(fidx(box->min, 1), fidx(box->min, 1),
+		fidx(box->max, 1), fidx(box->max, 1));
+	float lx, hx, ly, hy, zb;
+	int x0, x1, y0, y1;
+
+	occlusion_clip4(lo, mvp, x, y, _mm_set1_ps(fidx(box->min, 2)));
+	occlusion_clip4(hi, mvp, x, y, _mm_set1_ps(fidx(box->max, 2)));
+	n = _mm_or_ps(_mm_cmple_ps(lo[3], _mm_setzero_ps()),
+		_mm_cmple_ps(hi[3], _mm_setzero_ps()));
+	n = _mm_or_ps(n, _mm_or_ps(_mm_cmplt_ps(_mm_add_ps(lo[2], lo[3]),
+		_mm_setzero_ps()), _mm_cmplt_ps(_mm_add_ps(hi[2], hi[3]),
+		_mm_setzero_ps())));
+	if (_mm_movemask_ps(n))
+		return 1;
+
+	r0 = _mm_div_ps(_mm_set1_ps(1.0f), lo[3]);
+	r1 = _mm_div_ps(_mm_set1_ps(1.0f), hi[3]);
+	/* bounds of the eight corners, 1/w nearest in z */
+	lo[0] = _mm_mul_ps(lo[0], r0);
+	hi[0] = _mm_mul_ps(hi[0], r1);
+	lo[1] = _mm_mul_ps(lo[1], r0);
+	hi[1] = _mm_mul_ps(hi[1], r1);
+	sx = _mm_min_ps(lo[0], hi[0]);
+	x = _mm_max_ps(lo[0], hi[0]);
+	sy = _mm_min_ps(lo[1], hi[1]);
+	y = _mm_max_ps(lo[1], hi[1]);
+	z = _mm_max_ps(r0, r1);
+	sx = _mm_min_ps(sx, _mm_shuffle_ps(sx, sx, _MM_SHUFFLE(1,0,3,2)));
+	x = _mm_max_ps(x, _mm_shuffle_ps(x, x, _MM_SHUFFLE(1,0,3,2)));
+	sy = _mm_min_ps(sy, _mm_shuffle_ps(sy, sy, _MM_SHUFFLE(1,0,3,2)));
+	y = _mm_max_ps(y, _mm_shuffle_ps(y, y, _MM_SHUFFLE(1,0,3,2)));
+	z = _mm_max_ps(z, _mm_shuffle_ps(z, z, _MM_SHUFFLE(1,0,3,2)));
+	lx = fminf(_mm_cvtss_f32(sx), _mm_cvtss_f32(_mm_shuffle_ps(sx, sx, 1)));
+	hx = fmaxf(_mm_cvtss_f32(x), _mm_cvtss_f32(_mm_shuffle_ps(x, x, 1)));
+	ly = fminf(_mm_cvtss_f32(sy), _mm_cvtss_f32(_mm_shuffle_ps(sy, sy, 1)));
+	hy = fmaxf(_mm_cvtss_f32(y), _mm_cvtss_f32(_mm_shuffle_ps(y, y, 1)));
+	zb = fmaxf(_mm_cvtss_f32(z), _mm_cvtss_f32(_mm_shuffle_ps(z, z, 1)));
+
+	lx = fmaxf((lx + 1.0f) * 0.5f * b->width, 0.0f);
+	hx = fminf((hx + 1.0f) * 0.5f * b->width, (float)b->width);
+	ly = fmaxf((ly + 1.0f) * 0.5f * b->height, 0.0f);
+	hy = fminf((hy + 1.0f) * 0.5f * b->height, (float)b->height);
+	if (!(lx < hx && ly < hy))
+		return 0;
+	x0 = (int)lx;
+	x1 = (int)ceilf(hx);
+	y0 = (int)ly;
+	y1 = (int)ceilf(hy);
+	for (int ty = y0 / OCCLUSION_TILE_H; ty <= (y1 - 1) / OCCLUSION_TILE_H;
+			ty++)
+		for (int tx = x0 / OCCLUSION_TILE_W;
+				tx <= (x1 - 1) / OCCLUSION_TILE_W; tx++) {
+			int t = ty * b->tiles_x + tx;
+			if (zb < b->tile_far[t])
+				continue;
+			if (occlusion_scan(b, t, x0, x1, y0, y1, zb))
+				return 1;
+		}
+	return 0;
+}
+
+/**
+ * Tests count boxes, writing the indices of those that may be visible
+ * in order.  Returns how many were written.
+ */
+static inline int occlusion_cull_aabbs(const occlusion_buffer *b,
+		const mat4 mvp, const aabb *box, int count, int *visible)
+{
+	int n = 0;
+	for (int i = 0; i < count; i++) {
+		visible[n] = i;
+		n += occlusion_test_aabb(b, mvp, &box[i]);
+	}
+	return n;
+}
+
+#endif /* __SSE__ */
+
+#endif /* _GMATH_OCCLUSION_H_ */
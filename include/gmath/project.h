@@ -0,0 +1,198 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * project.h
+ * Handles projection of points to the screen with clip codes
+ *
+ */
+
+#ifndef _GMATH_PROJECT_H_
+#define _GMATH_PROJECT_H_
+
+#include <string.h>
+#include "constants.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "mat4.h"
+
+/**
+ * Clip code bits, set when a point lies outside that plane of the
+ * -w <= x, y, z <= w clip space.  A point behind the eye is outside the
+ * near plane; a code of 0 means the point is on screen.
+ */
+#define PROJECT_LEFT   1
+#define PROJECT_RIGHT  2
+#define PROJECT_BOTTOM 4
+#define PROJECT_TOP    8
+#define PROJECT_NEAR   16
+#define PROJECT_FAR    32
+
+/**
+ * Window rectangle and depth range, as glViewport and glDepthRange.
+ * For y growing down, put y at the bottom edge and negate height.
+ */
+typedef struct {
+	float x, y, width, height;
+	float near, far;
+} viewport;
+
+/**
+ * Projects p by the view projection vp into window coordinates and
+ * depth, returning its clip code.  Points with w <= 0 have no window
+ * position; only their code is meaningful.
+ */
+static inline int project_point(vec3 *screen, const mat4 vp,
+		const viewport *v, const vec3 p)
+{
+	vec4 c = mat4_transform4(vp, _mm_setr_ps(fidx(p, 0), fidx(p, 1),
+		fidx(p, 2), 1.0f));
+	float x = fidx(c, 0), y = fidx(c, 1), z = fidx(c, 2), w = fidx(c, 3);
+	float r = 1.0f / w;
+	*screen = _mm_setr_ps(v->x + (x * r + 1.0f) * 0.5f * v->width,
+		v->y + (y * r + 1.0f) * 0.5f * v->height,
+		v->near + (z * r + 1.0f) * 0.5f * (v->far - v->near), 0.0f);
+	return (x < -w) * PROJECT_LEFT | (x > w) * PROJECT_RIGHT |
+		(y < -w) * PROJECT_BOTTOM | (y > w) * PROJECT_TOP |
+		(z < -w) * PROJECT_NEAR | (z > w) * PROJECT_FAR;
+}
+
+#ifdef __SSE__
+/* Reciprocal to about 22 bits, one Newton step on rcp_ps. */
+static inline __m128 project_rcp(const __m128 w)
+{
+	__m128 r = _mm_rcp_ps(w);
+	return _mm_sub_ps(_mm_add_ps(r, r), _mm_mul_ps(w, _mm_mul_ps(r, r)));
+}
+
+/* Clip code bits where each mask is set, one int per lane. */
+static inline __m128i project_codes(const __m128 x, const __m128 y,
+		const __m128 z, const __m128 w)
+{
+	__m128 n = _mm_xor_ps(w, _mm_castsi128_ps(_mm_set1_epi32(SIGN_MASK)));
+	__m128i c = _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(x, n)),
+		_mm_set1_epi32(PROJECT_LEFT));
+	c = _mm_or_si128(c, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(x, w)),
+		_mm_set1_epi32(PROJECT_RIGHT)));
+	c = _mm_or_si128(c, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(y, n)),
+		_mm_set1_epi32(PROJECT_BOTTOM)));
+	c = _mm_or_si128(c, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(y, w)),
+		_mm_set1_epi32(PROJECT_TOP)));
+	c = _mm_or_si128(c, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(z, n)),
+		_mm_set1_epi32(PROJECT_NEAR)));
+	c = _mm_or_si128(c, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(z, w)),
+		_mm_set1_epi32(PROJECT_FAR)));
+	return c;
+}
+
+/**
+ * Projects four points in structure of arrays form, writing window
+ * coordinates to out and the four clip codes to codes.  Returns the
+ * lanes with a code of 0 as a four bit mask.
+ */
+static inline int project_soa4(vec3_soa *out, unsigned char *codes,
+		const mat4 vp, const viewport *v, const vec3_soa p)
+{
+	__m128 c[4], r;
+	__m128i k;
+	int bits, packed;
+	for (int i = 0; i < 4; i++)
+		c[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(
+			fidx(vp.col[0], i)), p.x), _mm_mul_ps(_mm_set1_ps(
+			fidx(vp.col[1], i)), p.y)), _mm_add_ps(_mm_mul_ps(
+			_mm_set1_ps(fidx(vp.col[2], i)), p.z),
+			_mm_set1_ps(fidx(vp.col[3], i))));
+	r = project_rcp(c[3]);
+	/* window = offset + scale * ndc, with the halving folded in */
+	out->x = _mm_add_ps(_mm_set1_ps(v->x + 0.5f * v->width), _mm_mul_ps(
+		_mm_set1_ps(0.5f * v->width), _mm_mul_ps(c[0], r)));
+	out->y = _mm_add_ps(_mm_set1_ps(v->y + 0.5f * v->height), _mm_mul_ps(
+		_mm_set1_ps(0.5f * v->height), _mm_mul_ps(c[1], r)));
+	out->z = _mm_add_ps(_mm_set1_ps(0.5f * (v->far + v->near)), _mm_mul_ps(
+		_mm_set1_ps(0.5f * (v->far - v->near)), _mm_mul_ps(c[2], r)));
+	k = project_codes(c[0], c[1], c[2], c[3]);
+	bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(k,
+		_mm_setzero_si128())));
+	k = _mm_packs_epi32(k, k);
+	k = _mm_packus_epi16(k, k);
+	packed = _mm_cvtsi128_si32(k);
+	memcpy(codes, &packed, sizeof(packed));
+	return bits;
+}
+#endif
+
+#ifdef __AVX__
+/* project_soa4 over eight points. */
+static inline int project_soa8(vec3_soa8 *out, unsigned char *codes,
+		const mat4 vp, const viewport *v, const vec3_soa8 p)
+{
+	__m256 c[4], r;
+	__m128i lo, hi;
+	int bits;
+	for (int i = 0; i < 4; i++)
+		c[i] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(
+			fidx(vp.col[0], i)), p.x), _mm256_mul_ps(_mm256_set1_ps(
+			fidx(vp.col[1], i)), p.y)), _mm256_add_ps(_mm256_mul_ps(
+			_mm256_set1_ps(fidx(vp.col[2], i)), p.z),
+			_mm256_set1_ps(fidx(vp.col[3], i))));
+	r = _mm256_rcp_ps(c[3]);
+	r = _mm256_sub_ps(_mm256_add_ps(r, r),
+		_mm256_mul_ps(c[3], _mm256_mul_ps(r, r)));
+	out->x = _mm256_add_ps(_mm256_set1_ps(v->x + 0.5f * v->width),
+		_mm256_mul_ps(_mm256_set1_ps(0.5f * v->width),
+		_mm256_mul_ps(c[0], r)));
+	out->y = _mm256_add_ps(_mm256_set1_ps(v->y + 0.5f * v->height),
+		_mm256_mul_ps(_mm256_set1_ps(0.5f * v->height),
+		_mm256_mul_ps(c[1], r)));
+	out->z = _mm256_add_ps(_mm256_set1_ps(0.5f * (v->far + v->near)),
+		_mm256_mul_ps(_mm256_set1_ps(0.5f * (v->far - v->near)),
+		_mm256_mul_ps(c[2], r)));
+	/* the integer codes are built a half at a time without AVX2 */
+	lo = project_codes(_mm256_castps256_ps128(c[0]),
+		_mm256_castps256_ps128(c[1]), _mm256_castps256_ps128(c[2]),
+		_mm256_castps256_ps128(c[3]));
+	hi = project_codes(_mm256_extractf128_ps(c[0], 1),
+		_mm256_extractf128_ps(c[1], 1), _mm256_extractf128_ps(c[2], 1),
+		_mm256_extractf128_ps(c[3], 1));
+	bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(lo,
+		_mm_setzero_si128()))) | _mm_movemask_ps(_mm_castsi128_ps(
+		_mm_cmpeq_epi32(hi, _mm_setzero_si128()))) << 4;
+	lo = _mm_packs_epi32(lo, hi);
+	_mm_storel_epi64((__m128i *)codes, _mm_packus_epi16(lo, lo));
+	return bits;
+}
+#endif
+
+/**
+ * Projects count points p by vp into window coordinates in screen and
+ * their clip codes in codes.  Returns how many have a code of 0.
+ */
+static inline int project_points(vec3 *screen, unsigned char *codes,
+		const mat4 vp, const viewport *v, const vec3 *p, int count)
+{
+	int i = 0, n = 0;
+#ifdef __AVX__
+	for (; i + 8 <= count; i += 8) {
+		vec3_soa8 s;
+		n += __builtin_popcount(project_soa8(&s, codes + i, vp, v,
+			vec3_soa8_load(p + i)));
+		vec3_soa8_store(screen + i, s);
+	}
+#endif
+#ifdef __SSE__
+	for (; i + 4 <= count; i += 4) {
+		vec3_soa s;
+		n += __builtin_popcount(project_soa4(&s, codes + i, vp, v,
+			vec3_soa_load(p + i)));
+		vec3_soa_store(screen + i, s);
+	}
+#endif
+	for (; i < count; i++) {
+		codes[i] = (unsigned char)project_point(&screen[i], vp, v, p[i]);
+		n += codes[i] == 0;
+	}
+	return n;
+}
+
+#endif /* _GMATH_PROJECT_H_ */
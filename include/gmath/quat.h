@@ -11,68 +11,71 @@
 #ifndef _GMATH_QUAT_H_
 #define _GMATH_QUAT_H_
 
+#include <float.h>
 #include "constants.h"
 #include "cephes/cos.h"
 #include "cephes/sin.h"
+#include "cephes/sincos.h"
 #include "cephes/atan.h"
 #include "cephes/rcp.h"
+#include "cephes/rsqrt.h"
+#include "vec3.h"
 #include "vec4.h"
+#include "mat4.h"
 
 static inline quat quat_mul(const quat q1, const quat q2)
 {
 #ifndef __SSE__
 	quat q;
-        q[0] = q1[1] * q2[2] - q1[2] * q2[1] +
-               q1[3] * q2[0] + q1[0] * q2[3];
-        q[1] = q1[2] * q2[0] - q1[0] * q2[2] +
-               q1[3] * q2[1] + q1[1] * q2[3];
-        q[2] = q1[0] * q2[1] - q1[1] * q2[0] +
-               q1[3] * q2[2] + q1[2] * q2[3];
-        q[3] = q1[3] * q2[3] - q1[0] * q2[0] +
-               q1[1] * q2[1] + q1[2] * q2[2]};
+	q[0] = q1[1] * q2[2] - q1[2] * q2[1] +
+	       q1[3] * q2[0] + q1[0] * q2[3];
+	q[1] = q1[2] * q2[0] - q1[0] * q2[2] +
+	       q1[3] * q2[1] + q1[1] * q2[3];
+	q[2] = q1[0] * q2[1] - q1[1] * q2[0] +
+	       q1[3] * q2[2] + q1[2] * q2[3];
+	q[3] = q1[3] * q2[3] - q1[0] * q2[0] -
+	       q1[1] * q2[1] - q1[2] * q2[2];
 	return q;
 #else
-	__m128 s1 = _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(3,3,3,3));
-	__m128 s2 = _mm_shuffle_ps(q1, q1, _MM_SHUFFLE(2,0,1,0));
-	__m128 s3 = _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(1,2,0,0));
-	__m128 s4 = _mm_shuffle_ps(q1, q1, _MM_SHUFFLE(3,3,3,1));
-	__m128 s5 = _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(0,1,2,1));
-	__m128 s6 = _mm_shuffle_ps(q1, q1, _MM_SHUFFLE(1,2,0,2));
-	__m128 s7 = _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(2,0,1,2));
-	__m128 mul4 = _mm_mul_ps(s6, s7);
-	__m128 mul3 = _mm_mul_ps(s4, s5);
-	__m128 mul2 = _mm_mul_ps(s2, s3);
-	__m128 mul1 = _mm_mul_ps(q1, s1);
-	__m128 flip1 = _mm_xor_ps(mul4, _mm_castsi128_ps(
-				_mm_set_epi32(0, 0, 0, 0x80000000)));
-	__m128 flip2 = _mm_xor_ps(mul3, _mm_castsi128_ps(
-				_mm_set_epi32(0, 0, 0, 0x80000000)));
-	__m128 ret =_mm_sub_ps(mul1, mul2);
-	__m128 ret2 =_mm_add_ps(flip1, flip2);
-	return _mm_add_ps(ret, ret2);
+	__m128 flip = _mm_castsi128_ps(_mm_set_epi32(0x80000000, 0, 0, 0));
+	__m128 mul1 = _mm_mul_ps(VEC4_WWWW(q1), q2);
+	__m128 mul2 = _mm_mul_ps(_mm_xor_ps(VEC4_XYZX(q1), flip),
+			VEC4_WWWX(q2));
+	__m128 mul3 = _mm_mul_ps(_mm_xor_ps(VEC4_YZXY(q1), flip),
+			VEC4_ZXYY(q2));
+	__m128 mul4 = _mm_mul_ps(VEC4_ZXYZ(q1), VEC4_YZXZ(q2));
+	return _mm_sub_ps(_mm_add_ps(_mm_add_ps(mul1, mul2), mul3), mul4);
 #endif
 }
 
+/**
+ * Builds a quaternion from (roll, pitch, yaw) applied in that order
+ * about x, y and z, matching mat4_from_angles.
+ */
 static inline quat quat_from_euler(const vec3 euler)
 {
 #ifndef __SSE__
-        quat roll  = { sinf(euler[0] * 0.5f), 0, 0, cosf(euler[0] * 0.5f)};
-        quat pitch = { 0, sinf(euler[1] * 0.5f), 0, cosf(euler[1] * 0.5f)};
-        quat yaw   = { 0, 0, sinf(euler[2] * 0.5f), cosf(euler[2] * 0.5f)};
+	float sr = sinf(euler[0] * 0.5f), cr = cosf(euler[0] * 0.5f);
+	float sp = sinf(euler[1] * 0.5f), cp = cosf(euler[1] * 0.5f);
+	float sy = sinf(euler[2] * 0.5f), cy = cosf(euler[2] * 0.5f);
+	quat q = {sr * cp * cy - cr * sp * sy, cr * sp * cy + sr * cp * sy,
+	          cr * cp * sy - sr * sp * cy, cr * cp * cy + sr * sp * sy};
+	return q;
 #else
-        __m128 half = { 0.5f, 0.5f, 0.5f, 0.0f };
-        __m128 e = _mm_shuffle_ps(euler, euler, _MM_SHUFFLE(3,0,1,2));
-        __m128 tmp0 = _mm_mul_ps(euler, half);
-        __m128 tmp1 = sin_ps(tmp0);
-        __m128 tmp2 = _mm_move_ss(cos_ps(tmp0), tmp1);
-        __m128 roll = _mm_shuffle_ps(tmp1, tmp2, _MM_SHUFFLE(1,0,0,1));
-        __m128 pitch = _mm_shuffle_ps(tmp1, tmp2, _MM_SHUFFLE(0,2,0,2));
-        __m128 yaw = _mm_shuffle_ps(tmp1, _mm_unpackhi_ps(tmp1, tmp2),
-		        _MM_SHUFFLE(0,0,2,3));
-#endif
-        return quat_mul(quat_mul(pitch, roll), yaw);
-}
- 
+	__m128 s, c;
+	sincos_ps(_mm_mul_ps(euler, _mm_set1_ps(0.5f)), &s, &c);
+	/* (sr, cr, sp, cp) and (sy, cy, -, -) */
+	__m128 rp = _mm_unpacklo_ps(s, c);
+	__m128 y = _mm_unpackhi_ps(s, c);
+	__m128 a = _mm_mul_ps(_mm_mul_ps(VEC4_XYYY(rp), VEC4_WZWW(rp)),
+			VEC4_YYXY(y));
+	__m128 b = _mm_mul_ps(_mm_mul_ps(VEC4_YXXX(rp), VEC4_ZWZZ(rp)),
+			VEC4_XXYX(y));
+	return _mm_add_ps(a, _mm_xor_ps(b, _mm_castsi128_ps(_mm_set_epi32
+		(0, 0x80000000, 0, 0x80000000))));
+#endif
+}
+
 static inline quat quat_slerp(const quat q1, const quat q2, const float t)
 {
 	quat out;
@@ -118,11 +121,11 @@ static inline quat quat_slerp_m128(const quat q1, const quat q2,
 static inline quat quat_lerp(const quat q1, const quat q2, const float t)
 {
 #ifdef __SSE__
-	return _mm_add_ps(q1, _mm_mul_ps(_mm_sub_ps(q1, q2), _mm_set1_ps(t)));
+	return _mm_add_ps(q1, _mm_mul_ps(_mm_sub_ps(q2, q1), _mm_set1_ps(t)));
 #else
 	quat out;
-	for (int i = 0; i < 3; i++)
-		out[i] = q1[i] + (q1[i] - q2[i]) * t;
+	for (int i = 0; i < 4; i++)
+		out[i] = q1[i] + (q2[i] - q1[i]) * t;
 	return out;
 #endif
 }
@@ -131,10 +134,891 @@ static inline quat quat_lerp_m128(const quat q1, const quat q2,
 		const m128_float t)
 {
 #ifdef __SSE__
-	return _mm_add_ps(q1, _mm_mul_ps(_mm_sub_ps(q1, q2), t));
+	return _mm_add_ps(q1, _mm_mul_ps(_mm_sub_ps(q2, q1), t));
 #else
 	return quat_lerp(q1, q2, m128_to_float(t));
 #endif
 }
 
+static inline quat quat_normalize(const quat q)
+{
+#ifndef __SSE__
+	quat out;
+	float r = 1.0f / sqrtf(vec4_dot(q, q));
+	for (int i = 0; i < 4; i++)
+		out[i] = q[i] * r;
+	return out;
+#else
+	return _mm_mul_ps(q, rsqrt_ps(vec4_dot_m128(q, q)));
+#endif
+}
+
+/**
+ * Normalized lerp along the shortest arc.  Unlike slerp the angular
+ * velocity is not constant, but it is much cheaper.
+ */
+static inline quat quat_nlerp(const quat q1, const quat q2, const float t)
+{
+#ifndef __SSE__
+	quat out;
+	float s = vec4_dot(q1, q2) < 0.0f ? -t : t;
+	for (int i = 0; i < 4; i++)
+		out[i] = q1[i] * (1.0f - t) + q2[i] * s;
+	return quat_normalize(out);
+#else
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	__m128 flip = _mm_and_ps(vec4_dot_m128(q1, q2), sign);
+	__m128 tt = _mm_set1_ps(t);
+	__m128 q = _mm_add_ps(_mm_mul_ps(q1, _mm_sub_ps(_mm_set1_ps(1.0f), tt)),
+			_mm_mul_ps(_mm_xor_ps(q2, flip), tt));
+	return quat_normalize(q);
+#endif
+}
+
+/**
+ * Adjusts t so that nlerp follows slerp closely, using the cubic
+ * correction from "Approximating slerp" (Kapoulkine).  d is the
+ * absolute value of the dot product between the two quaternions.
+ */
+static inline float quat_onlerp_t(const float t, const float d)
+{
+	float a = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+	float b = 0.848013f + d * (-1.06021f + d * 0.215638f);
+	float k = a * (t - 0.5f) * (t - 0.5f) + b;
+	return t + t * (t - 0.5f) * (t - 1.0f) * k;
+}
+
+/**
+ * Nlerp with the weight corrected to approximate slerp, a cheap drop
+ * in replacement for quat_slerp.
+ */
+static inline quat quat_onlerp(const quat q1, const quat q2, const float t)
+{
+	return quat_nlerp(q1, q2, quat_onlerp_t(t, fabsf(vec4_dot(q1, q2))));
+}
+
+static inline quat quat_conjugate(const quat q)
+{
+#ifndef __SSE__
+	quat out = {-q[0], -q[1], -q[2], q[3]};
+	return out;
+#else
+	return _mm_xor_ps(q, _mm_castsi128_ps(_mm_set_epi32
+		(0, 0x80000000, 0x80000000, 0x80000000)));
+#endif
+}
+
+static inline quat quat_inverse(const quat q)
+{
+#ifndef __SSE__
+	quat out;
+	float r = 1.0f / vec4_dot(q, q);
+	out[0] = -q[0] * r;
+	out[1] = -q[1] * r;
+	out[2] = -q[2] * r;
+	out[3] = q[3] * r;
+	return out;
+#else
+	return _mm_mul_ps(quat_conjugate(q), rcp_ps(vec4_dot_m128(q, q)));
+#endif
+}
+
+/**
+ * Rotates v by the unit quaternion q using
+ * v' = v + w t + q x t where t = 2 q x v.
+ */
+static inline vec3 quat_rotate_vec3(const quat q, const vec3 v)
+{
+#ifndef __SSE__
+	vec3 t, out;
+	t[0] = 2.0f * (q[1] * v[2] - q[2] * v[1]);
+	t[1] = 2.0f * (q[2] * v[0] - q[0] * v[2]);
+	t[2] = 2.0f * (q[0] * v[1] - q[1] * v[0]);
+	out[0] = v[0] + q[3] * t[0] + q[1] * t[2] - q[2] * t[1];
+	out[1] = v[1] + q[3] * t[1] + q[2] * t[0] - q[0] * t[2];
+	out[2] = v[2] + q[3] * t[2] + q[0] * t[1] - q[1] * t[0];
+	return out;
+#else
+	__m128 t = vec3_cross(q, v);
+	t = _mm_add_ps(t, t);
+	return _mm_add_ps(_mm_add_ps(v, _mm_mul_ps(VEC4_WWWW(q), t)),
+			vec3_cross(q, t));
+#endif
+}
+
+/**
+ * Converts the unit quaternion q into a rotation matrix.
+ */
+static inline mat4 quat_to_mat4(const quat q)
+{
+	mat4 out;
+#ifndef __SSE__
+	float x2 = q[0] + q[0], y2 = q[1] + q[1], z2 = q[2] + q[2];
+	float xx = q[0] * x2, yy = q[1] * y2, zz = q[2] * z2;
+	float xy = q[0] * y2, xz = q[0] * z2, yz = q[1] * z2;
+	float wx = q[3] * x2, wy = q[3] * y2, wz = q[3] * z2;
+	out.col[0] = {1.0f - yy - zz, xy + wz, xz - wy, 0};
+	out.col[1] = {xy - wz, 1.0f - xx - zz, yz + wx, 0};
+	out.col[2] = {xz + wy, yz - wx, 1.0f - xx - yy, 0};
+	out.col[3] = {0, 0, 0, 1};
+#else
+	__m128 q2 = _mm_add_ps(q, q);
+	/* (2yy, 2xy, 2xz) and (2zz, 2wz, 2wy) */
+	__m128 a0 = _mm_mul_ps(VEC4_YXXW(q), VEC4_YYZW(q2));
+	__m128 b0 = _mm_mul_ps(VEC4_ZWWW(q), VEC4_ZZYW(q2));
+	/* (2xy, 2xx, 2yz) and (2wz, 2zz, 2wx) */
+	__m128 a1 = _mm_mul_ps(VEC4_XXYW(q), VEC4_YXZW(q2));
+	__m128 b1 = _mm_mul_ps(VEC4_WZWW(q), VEC4_ZZXW(q2));
+	/* (2xz, 2yz, 2xx) and (2wy, 2wx, 2yy) */
+	__m128 a2 = _mm_mul_ps(VEC4_XYXW(q), VEC4_ZZXW(q2));
+	__m128 b2 = _mm_mul_ps(VEC4_WWYW(q), VEC4_YXYW(q2));
+	out.col[0] = _mm_add_ps(_mm_setr_ps(1, 0, 0, 0), _mm_add_ps(
+			_mm_mul_ps(a0, _mm_setr_ps(-1, 1, 1, 0)),
+			_mm_mul_ps(b0, _mm_setr_ps(-1, 1, -1, 0))));
+	out.col[1] = _mm_add_ps(_mm_setr_ps(0, 1, 0, 0), _mm_add_ps(
+			_mm_mul_ps(a1, _mm_setr_ps(1, -1, 1, 0)),
+			_mm_mul_ps(b1, _mm_setr_ps(-1, -1, 1, 0))));
+	out.col[2] = _mm_add_ps(_mm_setr_ps(0, 0, 1, 0), _mm_add_ps(
+			_mm_mul_ps(a2, _mm_setr_ps(1, 1, -1, 0)),
+			_mm_mul_ps(b2, _mm_setr_ps(1, -1, -1, 0))));
+	out.col[3] = _mm_setr_ps(0, 0, 0, 1);
+#endif
+	return out;
+}
+
+/**
+ * Extracts the rotation of an orthonormal matrix, picking the
+ * largest of w, x, y or z to divide by for stability.
+ */
+static inline quat quat_from_mat4(const mat4 m)
+{
+	float m00 = fidx(m.col[0], 0), m10 = fidx(m.col[0], 1);
+	float m20 = fidx(m.col[0], 2), m01 = fidx(m.col[1], 0);
+	float m11 = fidx(m.col[1], 1), m21 = fidx(m.col[1], 2);
+	float m02 = fidx(m.col[2], 0), m12 = fidx(m.col[2], 1);
+	float m22 = fidx(m.col[2], 2);
+	float t, x, y, z, w;
+
+	if (m22 < 0.0f) {
+		if (m00 > m11) {
+			t = 1.0f + m00 - m11 - m22;
+			x = t; y = m10 + m01; z = m02 + m20; w = m21 - m12;
+		} else {
+			t = 1.0f - m00 + m11 - m22;
+			x = m10 + m01; y = t; z = m21 + m12; w = m02 - m20;
+		}
+	} else {
+		if (m00 < -m11) {
+			t = 1.0f - m00 - m11 + m22;
+			x = m02 + m20; y = m21 + m12; z = t; w = m10 - m01;
+		} else {
+			t = 1.0f + m00 + m11 + m22;
+			x = m21 - m12; y = m02 - m20; z = m10 - m01; w = t;
+		}
+	}
+	t = 0.5f / sqrtf(t);
+#ifndef __SSE__
+	quat out = {x * t, y * t, z * t, w * t};
+	return out;
+#else
+	return _mm_mul_ps(_mm_setr_ps(x, y, z, w), _mm_set1_ps(t));
+#endif
+}
+
+/**
+ * Splits the affine m into translation t, rotation r and scale s with
+ * m = T R S.  A reflection is put on the x scale.  Shear is dropped by
+ * making the columns orthogonal to x, and a zero column is rebuilt
+ * from the other two, a normal to the first column left, or the unit
+ * axis, so that r stays a rotation.
+ */
+static inline void mat4_decompose(vec3 *t, quat *r, vec3 *s, const mat4 m)
+{
+	mat4 n = MAT4_IDENTITY, axis = MAT4_IDENTITY;
+	float l[3];
+
+	for (int j = 0; j < 3; j++) {
+		l[j] = vec3_length(m.col[j]);
+		n.col[j] = l[j] > FLT_MIN ? vec3_scale(m.col[j], 1.0f / l[j]) :
+			vec3_scale(m.col[j], 0.0f);
+	}
+	for (int j = 0; j < 3 && l[0] + l[1] + l[2] > 0.0f; j++) {
+		int k = j == 0;
+		vec3 x;
+		float d;
+		if (l[j] > FLT_MIN)
+			continue;
+		/* with the other two, or normal to the first unit one left */
+		x = vec3_cross(n.col[(j + 1) % 3], n.col[(j + 2) % 3]);
+		d = vec3_length(x);
+		if (vec3_dot(n.col[k], n.col[k]) == 0.0f)
+			k = 3 - j - k;
+		n.col[j] = d > FLT_MIN ? vec3_scale(x, 1.0f / d) :
+			vec3_perp(n.col[k]);
+	}
+	if (l[0] + l[1] + l[2] == 0.0f)
+		n = axis;
+	n.col[0] = vec3_scale(n.col[0], 1.0f / vec3_length(n.col[0]));
+	if (vec3_dot(n.col[0], vec3_cross(n.col[1], n.col[2])) < 0.0f) {
+		l[0] = -l[0];
+		n.col[0] = vec3_neg(n.col[0]);
+	}
+	n.col[1] = vec3_sub(n.col[1], vec3_scale(n.col[0],
+		vec3_dot(n.col[0], n.col[1])));
+	n.col[1] = vec3_scale(n.col[1], 1.0f / vec3_length(n.col[1]));
+	n.col[2] = vec3_cross(n.col[0], n.col[1]);
+
+	*t = m.col[3];
+	*r = quat_from_mat4(n);
+#ifndef __SSE__
+	*s = {l[0], l[1], l[2], 0};
+#else
+	*s = _mm_setr_ps(l[0], l[1], l[2], 0.0f);
+#endif
+}
+
+/* The affine T R S, the inverse of mat4_decompose. */
+static inline mat4 mat4_compose(const vec3 t, const quat r, const vec3 s)
+{
+	mat4 out = quat_to_mat4(r);
+	out.col[0] = vec4_mul(out.col[0], VEC4_XXXX(s));
+	out.col[1] = vec4_mul(out.col[1], VEC4_YYYY(s));
+	out.col[2] = vec4_mul(out.col[2], VEC4_ZZZZ(s));
+	out.col[3] = t;
+	fidx(out.col[3], 3) = 1.0f;
+	return out;
+}
+
+#ifdef __SSE__
+/**
+ * Transposes four quaternions into structure of arrays form.
+ */
+static inline quat_soa quat_soa_load(const quat *q)
+{
+	quat_soa out;
+	out.x = q[0];
+	out.y = q[1];
+	out.z = q[2];
+	out.w = q[3];
+	_MM_TRANSPOSE4_PS(out.x, out.y, out.z, out.w);
+	return out;
+}
+
+/**
+ * Transposes four quaternions in structure of arrays form back
+ * into four quaternions.
+ */
+static inline void quat_soa_store(quat *q, quat_soa s)
+{
+	_MM_TRANSPOSE4_PS(s.x, s.y, s.z, s.w);
+	q[0] = s.x;
+	q[1] = s.y;
+	q[2] = s.z;
+	q[3] = s.w;
+}
+
+static inline __m128 quat_soa_dot(const quat_soa q1, const quat_soa q2)
+{
+	__m128 x = _mm_mul_ps(q1.x, q2.x);
+	__m128 y = _mm_mul_ps(q1.y, q2.y);
+	__m128 z = _mm_mul_ps(q1.z, q2.z);
+	__m128 w = _mm_mul_ps(q1.w, q2.w);
+	return _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, w));
+}
+
+/**
+ * Computes the slerp weights of four quaternion pairs given their
+ * dot products.  Lanes where the angle is too small to divide by
+ * its sine fall back to lerp weights via a blend mask, so no lane
+ * branches.  The sign of the second weight is flipped when the
+ * quaternions lie in opposite hemispheres.
+ */
+static inline void quat_soa_slerp_weights(const __m128 cosom, const __m128 t,
+		__m128 *scale0, __m128 *scale1)
+{
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	__m128 flip = _mm_and_ps(cosom, sign);
+	__m128 abscosom = _mm_andnot_ps(sign, cosom);
+	__m128 t0 = _mm_sub_ps(one, t);
+
+	__m128 sinsqr = _mm_sub_ps(one, _mm_mul_ps(abscosom, abscosom));
+	__m128 sinom = rsqrt_ps(sinsqr);
+	__m128 omega = atan2_ps(_mm_mul_ps(sinsqr, sinom), abscosom);
+
+	/* omega lies in [0, PI/2] so the fast sine is sufficient */
+	__m128 s0 = _mm_mul_ps(sin_fast_ps(_mm_mul_ps(t0, omega)), sinom);
+	__m128 s1 = _mm_mul_ps(sin_fast_ps(_mm_mul_ps(t, omega)), sinom);
+
+	__m128 mask = _mm_cmpgt_ps(_mm_sub_ps(one, abscosom),
+			_mm_set1_ps(1e-6f));
+	s0 = _mm_or_ps(_mm_and_ps(mask, s0), _mm_andnot_ps(mask, t0));
+	s1 = _mm_or_ps(_mm_and_ps(mask, s1), _mm_andnot_ps(mask, t));
+
+	*scale0 = s0;
+	*scale1 = _mm_xor_ps(s1, flip);
+}
+
+static inline quat_soa quat_soa_blend(const quat_soa q1, const quat_soa q2,
+		const __m128 scale0, const __m128 scale1)
+{
+	quat_soa out;
+	out.x = _mm_add_ps(_mm_mul_ps(q1.x, scale0), _mm_mul_ps(q2.x, scale1));
+	out.y = _mm_add_ps(_mm_mul_ps(q1.y, scale0), _mm_mul_ps(q2.y, scale1));
+	out.z = _mm_add_ps(_mm_mul_ps(q1.z, scale0), _mm_mul_ps(q2.z, scale1));
+	out.w = _mm_add_ps(_mm_mul_ps(q1.w, scale0), _mm_mul_ps(q2.w, scale1));
+	return out;
+}
+
+/**
+ * Slerps four quaternion pairs at once, each lane with its own t.
+ */
+static inline quat_soa quat_soa_slerp(const quat_soa q1, const quat_soa q2,
+		const __m128 t)
+{
+	__m128 scale0, scale1;
+	quat_soa_slerp_weights(quat_soa_dot(q1, q2), t, &scale0, &scale1);
+	return quat_soa_blend(q1, q2, scale0, scale1);
+}
+
+static inline quat_soa quat_soa_normalize(const quat_soa q)
+{
+	__m128 r = rsqrt_ps(quat_soa_dot(q, q));
+	quat_soa out;
+	out.x = _mm_mul_ps(q.x, r);
+	out.y = _mm_mul_ps(q.y, r);
+	out.z = _mm_mul_ps(q.z, r);
+	out.w = _mm_mul_ps(q.w, r);
+	return out;
+}
+
+/**
+ * Corrects four nlerp weights as in quat_onlerp_t, d holds the
+ * absolute dot products.
+ */
+static inline __m128 quat_soa_onlerp_t(const __m128 t, const __m128 d)
+{
+	__m128 a = _mm_add_ps(_mm_set1_ps(3.55645f),
+			_mm_mul_ps(d, _mm_set1_ps(-1.43519f)));
+	a = _mm_add_ps(_mm_set1_ps(-3.2452f), _mm_mul_ps(d, a));
+	a = _mm_add_ps(_mm_set1_ps(1.0904f), _mm_mul_ps(d, a));
+	__m128 b = _mm_add_ps(_mm_set1_ps(-1.06021f),
+			_mm_mul_ps(d, _mm_set1_ps(0.215638f)));
+	b = _mm_add_ps(_mm_set1_ps(0.848013f), _mm_mul_ps(d, b));
+	__m128 th = _mm_sub_ps(t, _mm_set1_ps(0.5f));
+	__m128 k = _mm_add_ps(_mm_mul_ps(a, _mm_mul_ps(th, th)), b);
+	__m128 tk = _mm_mul_ps(_mm_mul_ps(t, th),
+			_mm_sub_ps(t, _mm_set1_ps(1.0f)));
+	return _mm_add_ps(t, _mm_mul_ps(tk, k));
+}
+
+static inline quat_soa quat_soa_nlerp_dot(const quat_soa q1,
+		const quat_soa q2, const __m128 cosom, const __m128 t)
+{
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	__m128 scale0 = _mm_sub_ps(_mm_set1_ps(1.0f), t);
+	__m128 scale1 = _mm_xor_ps(t, _mm_and_ps(cosom, sign));
+	return quat_soa_normalize(quat_soa_blend(q1, q2, scale0, scale1));
+}
+
+static inline quat_soa quat_soa_nlerp(const quat_soa q1, const quat_soa q2,
+		const __m128 t)
+{
+	return quat_soa_nlerp_dot(q1, q2, quat_soa_dot(q1, q2), t);
+}
+
+static inline quat_soa quat_soa_onlerp(const quat_soa q1, const quat_soa q2,
+		const __m128 t)
+{
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	__m128 cosom = quat_soa_dot(q1, q2);
+	__m128 ot = quat_soa_onlerp_t(t, _mm_andnot_ps(sign, cosom));
+	return quat_soa_nlerp_dot(q1, q2, cosom, ot);
+}
+
+static inline quat_soa quat_soa_conjugate(const quat_soa q)
+{
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	quat_soa out;
+	out.x = _mm_xor_ps(q.x, sign);
+	out.y = _mm_xor_ps(q.y, sign);
+	out.z = _mm_xor_ps(q.z, sign);
+	out.w = q.w;
+	return out;
+}
+
+static inline quat_soa quat_soa_inverse(const quat_soa q)
+{
+	__m128 r = rcp_ps(quat_soa_dot(q, q));
+	__m128 nr = _mm_xor_ps(r, _mm_castsi128_ps(_mm_set1_epi32(0x80000000)));
+	quat_soa out;
+	out.x = _mm_mul_ps(q.x, nr);
+	out.y = _mm_mul_ps(q.y, nr);
+	out.z = _mm_mul_ps(q.z, nr);
+	out.w = _mm_mul_ps(q.w, r);
+	return out;
+}
+
+static inline vec3_soa quat_soa_rotate_vec3(const quat_soa q,
+		const vec3_soa v)
+{
+	vec3_soa qv = {q.x, q.y, q.z};
+	vec3_soa t = vec3_soa_cross(qv, v);
+	vec3_soa u, out;
+	t.x = _mm_add_ps(t.x, t.x);
+	t.y = _mm_add_ps(t.y, t.y);
+	t.z = _mm_add_ps(t.z, t.z);
+	u = vec3_soa_cross(qv, t);
+	out.x = _mm_add_ps(_mm_add_ps(v.x, _mm_mul_ps(q.w, t.x)), u.x);
+	out.y = _mm_add_ps(_mm_add_ps(v.y, _mm_mul_ps(q.w, t.y)), u.y);
+	out.z = _mm_add_ps(_mm_add_ps(v.z, _mm_mul_ps(q.w, t.z)), u.z);
+	return out;
+}
+
+/**
+ * Converts four unit quaternions into four rotation matrices.
+ */
+static inline void quat_soa_to_mat4(mat4 *out, const quat_soa q)
+{
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 x2 = _mm_add_ps(q.x, q.x);
+	__m128 y2 = _mm_add_ps(q.y, q.y);
+	__m128 z2 = _mm_add_ps(q.z, q.z);
+	__m128 xx = _mm_mul_ps(q.x, x2), yy = _mm_mul_ps(q.y, y2);
+	__m128 zz = _mm_mul_ps(q.z, z2), xy = _mm_mul_ps(q.x, y2);
+	__m128 xz = _mm_mul_ps(q.x, z2), yz = _mm_mul_ps(q.y, z2);
+	__m128 wx = _mm_mul_ps(q.w, x2), wy = _mm_mul_ps(q.w, y2);
+	__m128 wz = _mm_mul_ps(q.w, z2);
+	__m128 c0x = _mm_sub_ps(one, _mm_add_ps(yy, zz));
+	__m128 c0y = _mm_add_ps(xy, wz);
+	__m128 c0z = _mm_sub_ps(xz, wy);
+	__m128 c1x = _mm_sub_ps(xy, wz);
+	__m128 c1y = _mm_sub_ps(one, _mm_add_ps(xx, zz));
+	__m128 c1z = _mm_add_ps(yz, wx);
+	__m128 c2x = _mm_add_ps(xz, wy);
+	__m128 c2y = _mm_sub_ps(yz, wx);
+	__m128 c2z = _mm_sub_ps(one, _mm_add_ps(xx, yy));
+	__m128 c0w = _mm_setzero_ps(), c1w = c0w, c2w = c0w;
+	__m128 c3 = _mm_setr_ps(0, 0, 0, 1);
+	_MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+	_MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+	_MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+	out[0].col[0] = c0x; out[0].col[1] = c1x;
+	out[0].col[2] = c2x; out[0].col[3] = c3;
+	out[1].col[0] = c0y; out[1].col[1] = c1y;
+	out[1].col[2] = c2y; out[1].col[3] = c3;
+	out[2].col[0] = c0z; out[2].col[1] = c1z;
+	out[2].col[2] = c2z; out[2].col[3] = c3;
+	out[3].col[0] = c0w; out[3].col[1] = c1w;
+	out[3].col[2] = c2w; out[3].col[3] = c3;
+}
+
+/**
+ * Extracts the rotations of four orthonormal matrices.  All four
+ * candidate divisors are computed and the largest selected per lane
+ * with masks, so unlike quat_from_mat4 there are no branches.
+ */
+static inline quat_soa quat_soa_from_cols(const vec3_soa c0,
+		const vec3_soa c1, const vec3_soa c2)
+{
+	/* mRC is row R of column C */
+	__m128 m00 = c0.x, m10 = c0.y, m20 = c0.z;
+	__m128 m01 = c1.x, m11 = c1.y, m21 = c1.z;
+	__m128 m02 = c2.x, m12 = c2.y, m22 = c2.z;
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 tw = _mm_add_ps(one, _mm_add_ps(m00, _mm_add_ps(m11, m22)));
+	__m128 tx = _mm_add_ps(one, _mm_sub_ps(m00, _mm_add_ps(m11, m22)));
+	__m128 ty = _mm_add_ps(one, _mm_sub_ps(m11, _mm_add_ps(m00, m22)));
+	__m128 tz = _mm_add_ps(one, _mm_sub_ps(m22, _mm_add_ps(m00, m11)));
+	__m128 s01 = _mm_add_ps(m10, m01), d01 = _mm_sub_ps(m10, m01);
+	__m128 s02 = _mm_add_ps(m02, m20), d02 = _mm_sub_ps(m02, m20);
+	__m128 s12 = _mm_add_ps(m21, m12), d12 = _mm_sub_ps(m21, m12);
+
+	quat_soa q = {d12, d02, d01, tw};
+	__m128 t = tw, mask;
+
+	mask = _mm_cmpgt_ps(tx, t);
+	t = _mm_max_ps(tx, t);
+	q.x = _mm_or_ps(_mm_and_ps(mask, tx), _mm_andnot_ps(mask, q.x));
+	q.y = _mm_or_ps(_mm_and_ps(mask, s01), _mm_andnot_ps(mask, q.y));
+	q.z = _mm_or_ps(_mm_and_ps(mask, s02), _mm_andnot_ps(mask, q.z));
+	q.w = _mm_or_ps(_mm_and_ps(mask, d12), _mm_andnot_ps(mask, q.w));
+
+	mask = _mm_cmpgt_ps(ty, t);
+	t = _mm_max_ps(ty, t);
+	q.x = _mm_or_ps(_mm_and_ps(mask, s01), _mm_andnot_ps(mask, q.x));
+	q.y = _mm_or_ps(_mm_and_ps(mask, ty), _mm_andnot_ps(mask, q.y));
+	q.z = _mm_or_ps(_mm_and_ps(mask, s12), _mm_andnot_ps(mask, q.z));
+	q.w = _mm_or_ps(_mm_and_ps(mask, d02), _mm_andnot_ps(mask, q.w));
+
+	mask = _mm_cmpgt_ps(tz, t);
+	t = _mm_max_ps(tz, t);
+	q.x = _mm_or_ps(_mm_and_ps(mask, s02), _mm_andnot_ps(mask, q.x));
+	q.y = _mm_or_ps(_mm_and_ps(mask, s12), _mm_andnot_ps(mask, q.y));
+	q.z = _mm_or_ps(_mm_and_ps(mask, tz), _mm_andnot_ps(mask, q.z));
+	q.w = _mm_or_ps(_mm_and_ps(mask, d01), _mm_andnot_ps(mask, q.w));
+
+	t = _mm_mul_ps(_mm_set1_ps(0.5f), rsqrt_ps(t));
+	q.x = _mm_mul_ps(q.x, t);
+	q.y = _mm_mul_ps(q.y, t);
+	q.z = _mm_mul_ps(q.z, t);
+	q.w = _mm_mul_ps(q.w, t);
+	return q;
+}
+
+/* Columns 0 to 2 of four matrices in structure of arrays form. */
+static inline void mat4_soa_cols(vec3_soa *c, const mat4 *m)
+{
+	for (int j = 0; j < 3; j++) {
+		__m128 w = m[3].col[j];
+		c[j].x = m[0].col[j];
+		c[j].y = m[1].col[j];
+		c[j].z = m[2].col[j];
+		_MM_TRANSPOSE4_PS(c[j].x, c[j].y, c[j].z, w);
+	}
+}
+
+static inline quat_soa quat_soa_from_mat4(const mat4 *m)
+{
+	vec3_soa c[3];
+	mat4_soa_cols(c, m);
+	return quat_soa_from_cols(c[0], c[1], c[2]);
+}
+
+/**
+ * mat4_decompose of four matrices at once, with every branch replaced
+ * by a select.
+ */
+static inline void mat4_soa_decompose(vec3 *t, quat *r, vec3 *s,
+		const mat4 *m)
+{
+	__m128 one = _mm_set1_ps(1.0f), l[3], flat[3], neg, d;
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(SIGN_MASK));
+	vec3_soa c[3], p, axis[3] = {
+		{one, _mm_setzero_ps(), _mm_setzero_ps()},
+		{_mm_setzero_ps(), one, _mm_setzero_ps()},
+		{_mm_setzero_ps(), _mm_setzero_ps(), one}};
+	for (int i = 0; i < 4; i++)
+		t[i] = m[i].col[3];
+
+	mat4_soa_cols(c, m);
+	for (int j = 0; j < 3; j++) {
+		l[j] = _mm_sqrt_ps(vec3_soa_dot(c[j], c[j]));
+		flat[j] = _mm_cmple_ps(l[j], _mm_set1_ps(FLT_MIN));
+		d = _mm_andnot_ps(flat[j], _mm_div_ps(one, l[j]));
+		c[j] = vec3_soa_scale(c[j], d);
+	}
+	for (int j = 0; j < 3; j++) {
+		int k = j == 0;
+		vec3_soa x = vec3_soa_cross(c[(j + 1) % 3], c[(j + 2) % 3]);
+		__m128 e = _mm_sqrt_ps(vec3_soa_dot(x, x));
+		d = _mm_cmpneq_ps(vec3_soa_dot(c[k], c[k]), _mm_setzero_ps());
+		p = vec3_soa_perp(vec3_soa_select(d, c[k], c[3 - j - k]));
+		d = _mm_cmpgt_ps(e, _mm_set1_ps(FLT_MIN));
+		x = vec3_soa_scale(x, _mm_and_ps(d, _mm_div_ps(one, e)));
+		c[j] = vec3_soa_select(flat[j], vec3_soa_select(d, x, p), c[j]);
+	}
+	d = _mm_and_ps(flat[0], _mm_and_ps(flat[1], flat[2]));
+	for (int j = 0; j < 3; j++)
+		c[j] = vec3_soa_select(d, axis[j], c[j]);
+	c[0] = vec3_soa_scale(c[0], _mm_div_ps(one,
+		_mm_sqrt_ps(vec3_soa_dot(c[0], c[0]))));
+
+	/* a reflection goes on x, shear is removed against x */
+	neg = _mm_and_ps(sign, _mm_cmplt_ps(vec3_soa_dot(c[0],
+		vec3_soa_cross(c[1], c[2])), _mm_setzero_ps()));
+	l[0] = _mm_xor_ps(l[0], neg);
+	c[0].x = _mm_xor_ps(c[0].x, neg);
+	c[0].y = _mm_xor_ps(c[0].y, neg);
+	c[0].z = _mm_xor_ps(c[0].z, neg);
+	c[1] = vec3_soa_sub(c[1], vec3_soa_scale(c[0], vec3_soa_dot(c[0], c[1])));
+	c[1] = vec3_soa_scale(c[1], _mm_div_ps(one,
+		_mm_sqrt_ps(vec3_soa_dot(c[1], c[1]))));
+	c[2] = vec3_soa_cross(c[0], c[1]);
+
+	quat_soa_store(r, quat_soa_from_cols(c[0], c[1], c[2]));
+	vec3_soa_store(s, (vec3_soa){l[0], l[1], l[2]});
+}
+#endif
+
+#ifdef __AVX__
+static inline quat_soa8 quat_soa8_load(const quat *q)
+{
+	quat_soa lo = quat_soa_load(q);
+	quat_soa hi = quat_soa_load(q + 4);
+	quat_soa8 out;
+	out.x = _mm256_insertf128_ps(_mm256_castps128_ps256(lo.x), hi.x, 1);
+	out.y = _mm256_insertf128_ps(_mm256_castps128_ps256(lo.y), hi.y, 1);
+	out.z = _mm256_insertf128_ps(_mm256_castps128_ps256(lo.z), hi.z, 1);
+	out.w = _mm256_insertf128_ps(_mm256_castps128_ps256(lo.w), hi.w, 1);
+	return out;
+}
+
+static inline void quat_soa8_store(quat *q, const quat_soa8 s)
+{
+	quat_soa lo, hi;
+	lo.x = _mm256_castps256_ps128(s.x);
+	lo.y = _mm256_castps256_ps128(s.y);
+	lo.z = _mm256_castps256_ps128(s.z);
+	lo.w = _mm256_castps256_ps128(s.w);
+	hi.x = _mm256_extractf128_ps(s.x, 1);
+	hi.y = _mm256_extractf128_ps(s.y, 1);
+	hi.z = _mm256_extractf128_ps(s.z, 1);
+	hi.w = _mm256_extractf128_ps(s.w, 1);
+	quat_soa_store(q, lo);
+	quat_soa_store(q + 4, hi);
+}
+
+static inline __m256 quat_soa8_dot(const quat_soa8 q1, const quat_soa8 q2)
+{
+	__m256 x = _mm256_mul_ps(q1.x, q2.x);
+	__m256 y = _mm256_mul_ps(q1.y, q2.y);
+	__m256 z = _mm256_mul_ps(q1.z, q2.z);
+	__m256 w = _mm256_mul_ps(q1.w, q2.w);
+	return _mm256_add_ps(_mm256_add_ps(x, y), _mm256_add_ps(z, w));
+}
+
+static inline quat_soa8 quat_soa8_blend(const quat_soa8 q1,
+		const quat_soa8 q2, const __m256 scale0, const __m256 scale1)
+{
+	quat_soa8 out;
+	out.x = _mm256_add_ps(_mm256_mul_ps(q1.x, scale0),
+			_mm256_mul_ps(q2.x, scale1));
+	out.y = _mm256_add_ps(_mm256_mul_ps(q1.y, scale0),
+			_mm256_mul_ps(q2.y, scale1));
+	out.z = _mm256_add_ps(_mm256_mul_ps(q1.z, scale0),
+			_mm256_mul_ps(q2.z, scale1));
+	out.w = _mm256_add_ps(_mm256_mul_ps(q1.w, scale0),
+			_mm256_mul_ps(q2.w, scale1));
+	return out;
+}
+
+/**
+ * Slerps eight quaternion pairs at once.  The trigonometry is done
+ * on each 128-bit half since the cephes routines are SSE only.
+ */
+static inline quat_soa8 quat_soa8_slerp(const quat_soa8 q1,
+		const quat_soa8 q2, const __m256 t)
+{
+	__m128 s0lo, s1lo, s0hi, s1hi;
+	__m256 cosom = quat_soa8_dot(q1, q2);
+	quat_soa_slerp_weights(_mm256_castps256_ps128(cosom),
+			_mm256_castps256_ps128(t), &s0lo, &s1lo);
+	quat_soa_slerp_weights(_mm256_extractf128_ps(cosom, 1),
+			_mm256_extractf128_ps(t, 1), &s0hi, &s1hi);
+	return quat_soa8_blend(q1, q2,
+			_mm256_insertf128_ps(_mm256_castps128_ps256(s0lo), s0hi, 1),
+			_mm256_insertf128_ps(_mm256_castps128_ps256(s1lo), s1hi, 1));
+}
+
+static inline quat_soa8 quat_soa8_normalize(const quat_soa8 q)
+{
+	__m256 d = quat_soa8_dot(q, q);
+	__m256 r = _mm256_rsqrt_ps(d);
+	r = _mm256_mul_ps(r, _mm256_sub_ps(_mm256_set1_ps(1.5f),
+			_mm256_mul_ps(_mm256_mul_ps(d, _mm256_set1_ps(0.5f)),
+				_mm256_mul_ps(r, r))));
+	quat_soa8 out;
+	out.x = _mm256_mul_ps(q.x, r);
+	out.y = _mm256_mul_ps(q.y, r);
+	out.z = _mm256_mul_ps(q.z, r);
+	out.w = _mm256_mul_ps(q.w, r);
+	return out;
+}
+
+static inline __m256 quat_soa8_onlerp_t(const __m256 t, const __m256 d)
+{
+	__m256 a = _mm256_add_ps(_mm256_set1_ps(3.55645f),
+			_mm256_mul_ps(d, _mm256_set1_ps(-1.43519f)));
+	a = _mm256_add_ps(_mm256_set1_ps(-3.2452f), _mm256_mul_ps(d, a));
+	a = _mm256_add_ps(_mm256_set1_ps(1.0904f), _mm256_mul_ps(d, a));
+	__m256 b = _mm256_add_ps(_mm256_set1_ps(-1.06021f),
+			_mm256_mul_ps(d, _mm256_set1_ps(0.215638f)));
+	b = _mm256_add_ps(_mm256_set1_ps(0.848013f), _mm256_mul_ps(d, b));
+	__m256 th = _mm256_sub_ps(t, _mm256_set1_ps(0.5f));
+	__m256 k = _mm256_add_ps(_mm256_mul_ps(a, _mm256_mul_ps(th, th)), b);
+	__m256 tk = _mm256_mul_ps(_mm256_mul_ps(t, th),
+			_mm256_sub_ps(t, _mm256_set1_ps(1.0f)));
+	return _mm256_add_ps(t, _mm256_mul_ps(tk, k));
+}
+
+static inline quat_soa8 quat_soa8_nlerp_dot(const quat_soa8 q1,
+		const quat_soa8 q2, const __m256 cosom, const __m256 t)
+{
+	__m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+	__m256 scale0 = _mm256_sub_ps(_mm256_set1_ps(1.0f), t);
+	__m256 scale1 = _mm256_xor_ps(t, _mm256_and_ps(cosom, sign));
+	return quat_soa8_normalize(quat_soa8_blend(q1, q2, scale0, scale1));
+}
+
+static inline quat_soa8 quat_soa8_nlerp(const quat_soa8 q1,
+		const quat_soa8 q2, const __m256 t)
+{
+	return quat_soa8_nlerp_dot(q1, q2, quat_soa8_dot(q1, q2), t);
+}
+
+static inline quat_soa8 quat_soa8_onlerp(const quat_soa8 q1,
+		const quat_soa8 q2, const __m256 t)
+{
+	__m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+	__m256 cosom = quat_soa8_dot(q1, q2);
+	__m256 ot = quat_soa8_onlerp_t(t, _mm256_andnot_ps(sign, cosom));
+	return quat_soa8_nlerp_dot(q1, q2, cosom, ot);
+}
+#endif
+
+/**
+ * Slerps count quaternion pairs, e.g. the two poses of a skeleton
+ * bracketing the sample time.  Each pair has its own t.
+ */
+static inline void quat_slerp_array(quat *out, const quat *q1, const quat *q2,
+		const float *t, int count)
+{
+	int i = 0;
+#ifdef __AVX__
+	for (; i + 8 <= count; i += 8)
+		quat_soa8_store(out + i, quat_soa8_slerp(quat_soa8_load(q1 + i),
+				quat_soa8_load(q2 + i), _mm256_loadu_ps(t + i)));
+#endif
+#ifdef __SSE__
+	for (; i + 4 <= count; i += 4)
+		quat_soa_store(out + i, quat_soa_slerp(quat_soa_load(q1 + i),
+				quat_soa_load(q2 + i), _mm_loadu_ps(t + i)));
+#endif
+	for (; i < count; i++)
+		out[i] = quat_slerp(q1[i], q2[i], t[i]);
+}
+
+static inline void quat_nlerp_array(quat *out, const quat *q1, const quat *q2,
+		const float *t, int count)
+{
+	int i = 0;
+#ifdef __AVX__
+	for (; i + 8 <= count; i += 8)
+		quat_soa8_store(out + i, quat_soa8_nlerp(quat_soa8_load(q1 + i),
+				quat_soa8_load(q2 + i), _mm256_loadu_ps(t + i)));
+#endif
+#ifdef __SSE__
+	for (; i + 4 <= count; i += 4)
+		quat_soa_store(out + i, quat_soa_nlerp(quat_soa_load(q1 + i),
+				quat_soa_load(q2 + i), _mm_loadu_ps(t + i)));
+#endif
+	for (; i < count; i++)
+		out[i] = quat_nlerp(q1[i], q2[i], t[i]);
+}
+
+static inline void quat_onlerp_array(quat *out, const quat *q1, const quat *q2,
+		const float *t, int count)
+{
+	int i = 0;
+#ifdef __AVX__
+	for (; i + 8 <= count; i += 8)
+		quat_soa8_store(out + i, quat_soa8_onlerp(quat_soa8_load(q1 + i),
+				quat_soa8_load(q2 + i), _mm256_loadu_ps(t + i)));
+#endif
+#ifdef __SSE__
+	for (; i + 4 <= count; i += 4)
+		quat_soa_store(out + i, quat_soa_onlerp(quat_soa_load(q1 + i),
+				quat_soa_load(q2 + i), _mm_loadu_ps(t + i)));
+#endif
+	for (; i < count; i++)
+		out[i] = quat_onlerp(q1[i], q2[i], t[i]);
+}
+
+static inline void quat_conjugate_array(quat *out, const quat *q, int count)
+{
+	for (int i = 0; i < count; i++)
+		out[i] = quat_conjugate(q[i]);
+}
+
+static inline void quat_inverse_array(quat *out, const quat *q, int count)
+{
+	int i = 0;
+#ifdef __SSE__
+	for (; i + 4 <= count; i += 4)
+		quat_soa_store(out + i, quat_soa_inverse(quat_soa_load(q + i)));
+#endif
+	for (; i < count; i++)
+		out[i] = quat_inverse(q[i]);
+}
+
+static inline void quat_normalize_array(quat *out, const quat *q, int count)
+{
+	int i = 0;
+#ifdef __AVX__
+	for (; i + 8 <= count; i += 8)
+		quat_soa8_store(out + i,
+				quat_soa8_normalize(quat_soa8_load(q + i)));
+#endif
+#ifdef __SSE__
+	for (; i + 4 <= count; i += 4)
+		quat_soa_store(out + i, quat_soa_normalize(quat_soa_load(q + i)));
+#endif
+	for (; i < count; i++)
+		out[i] = quat_normalize(q[i]);
+}
+
+/**
+ * Rotates each vector by the matching quaternion.
+ */
+static inline void quat_rotate_vec3_array(vec3 *out, const quat *q,
+		const vec3 *v, int count)
+{
+	int i = 0;
+#ifdef __SSE__
+	for (; i + 4 <= count; i += 4)
+		vec3_soa_store(out + i, quat_soa_rotate_vec3(quat_soa_load(q + i),
+				vec3_soa_load(v + i)));
+#endif
+	for (; i < count; i++)
+		out[i] = quat_rotate_vec3(q[i], v[i]);
+}
+
+/**
+ * Converts a palette of bone rotations into matrices.
+ */
+static inline void quat_to_mat4_array(mat4 *out, const quat *q, int count)
+{
+	int i = 0;
+#ifdef __SSE__
+	for (; i + 4 <= count; i += 4)
+		quat_soa_to_mat4(out + i, quat_soa_load(q + i));
+#endif
+	for (; i < count; i++)
+		out[i] = quat_to_mat4(q[i]);
+}
+
+static inline void quat_from_mat4_array(quat *out, const mat4 *m, int count)
+{
+	int i = 0;
+#ifdef __SSE__
+	for (; i + 4 <= count; i += 4)
+		quat_soa_store(out + i, quat_soa_from_mat4(m + i));
+#endif
+	for (; i < count; i++)
+		out[i] = quat_from_mat4(m[i]);
+}
+
+/**
+ * Decomposes a snapshot of world matrices, as mat4_decompose.
+ */
+static inline void mat4_decompose_array(vec3 *t, quat *r, vec3 *s,
+		const mat4 *m, int count)
+{
+	int i = 0;
+#ifdef __SSE__
+	for (; i + 4 <= count; i += 4)
+		mat4_soa_decompose(t + i, r + i, s + i, m + i);
+#endif
+	for (; i < count; i++)
+		mat4_decompose(t + i, r + i, s + i, m[i]);
+}
+
+static inline void mat4_compose_array(mat4 *out, const vec3 *t,
+		const quat *r, const vec3 *s, int count)
+{
+	for (int i = 0; i < count; i++)
+		out[i] = mat4_compose(t[i], r[i], s[i]);
+}
+
 #endif /* _GMATH_QUAT_H_ */
@@ -0,0 +1,216 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * quatpack.h
+ * Handles smallest three quaternion compression
+ *
+ */
+
+#ifndef _GMATH_QUATPACK_H_
+#define _GMATH_QUATPACK_H_
+
+#include "constants.h"
+#include "cephes/sqrt.h"
+#include "quat.h"
+
+/* The three smallest components of a unit quaternion lie in this range. */
+#define QUATPACK_RANGE 0.70710678118654752440f
+
+/**
+ * Finds the largest component, flips q so that it is positive and maps
+ * the other three from [-1/sqrt(2), 1/sqrt(2)] onto [0, max].
+ */
+static inline int quat_pack_common(const quat q, int max, int *c)
+{
+	float a[4] = {fidx(q, 0), fidx(q, 1), fidx(q, 2), fidx(q, 3)};
+	float scale = max * 0.5f / QUATPACK_RANGE;
+	int largest = 0;
+	for (int i = 1; i < 4; i++)
+		if (fabsf(a[i]) > fabsf(a[largest]))
+			largest = i;
+	if (a[largest] < 0.0f)
+		scale = -scale;
+	for (int i = 0, j = 0; i < 4; i++) {
+		if (i == largest)
+			continue;
+		int v = (int)(a[i] * scale + max * 0.5f + 0.5f);
+		c[j++] = v < 0 ? 0 : v > max ? max : v;
+	}
+	return largest;
+}
+
+/**
+ * Rebuilds a quaternion from its three smallest components, already
+ * mapped back to [-1/sqrt(2), 1/sqrt(2)].
+ */
+static inline quat quat_unpack_common(int largest, float a, float b, float c)
+{
+	float d = 1.0f - a * a - b * b - c * c;
+	float s[3] = {a, b, c}, v[4];
+	d = d > 0.0f ? sqrtf(d) : 0.0f;
+	for (int i = 0, j = 0; i < 4; i++)
+		v[i] = i == largest ? d : s[j++];
+#ifndef __SSE__
+	quat q = {v[0], v[1], v[2], v[3]};
+	return q;
+#else
+	return _mm_loadu_ps(v);
+#endif
+}
+
+/**
+ * Compresses a unit quaternion to 32 bits: the index of the dropped
+ * component in the top two bits, then three 10 bit components.
+ */
+static inline quat32 quat_pack32(const quat q)
+{
+	int c[3];
+	int largest = quat_pack_common(q, 1023, c);
+	return (quat32)largest << 30 | (quat32)c[0] << 20 |
+		(quat32)c[1] << 10 | (quat32)c[2];
+}
+
+static inline quat quat_unpack32(const quat32 p)
+{
+	float s = 2.0f * QUATPACK_RANGE / 1023.0f;
+	return quat_unpack_common(p >> 30,
+		((p >> 20) & 1023) * s - QUATPACK_RANGE,
+		((p >> 10) & 1023) * s - QUATPACK_RANGE,
+		(p & 1023) * s - QUATPACK_RANGE);
+}
+
+/**
+ * Compresses a unit quaternion to 48 bits: three 15 bit components, the
+ * index of the dropped component in the top bits of the first two.
+ */
+static inline quat48 quat_pack48(const quat q)
+{
+	int c[3];
+	int largest = quat_pack_common(q, 32767, c);
+	quat48 p;
+	p.v[0] = (unsigned short)(c[0] | (largest & 1) << 15);
+	p.v[1] = (unsigned short)(c[1] | (largest & 2) << 14);
+	p.v[2] = (unsigned short)c[2];
+	return p;
+}
+
+static inline quat quat_unpack48(const quat48 p)
+{
+	float s = 2.0f * QUATPACK_RANGE / 32767.0f;
+	return quat_unpack_common((p.v[0] >> 15) | (p.v[1] >> 15) << 1,
+		(p.v[0] & 32767) * s - QUATPACK_RANGE,
+		(p.v[1] & 32767) * s - QUATPACK_RANGE,
+		(p.v[2] & 32767) * s - QUATPACK_RANGE);
+}
+
+#ifdef __SSE__
+/**
+ * Rebuilds four quaternions from the integer fields of their packed
+ * forms.  The dropped component is placed with masks, not branches.
+ */
+static inline quat_soa quat_soa_unpack_common(const __m128i largest,
+		const __m128i ia, const __m128i ib, const __m128i ic,
+		const float max)
+{
+	__m128 s = _mm_set1_ps(2.0f * QUATPACK_RANGE / max);
+	__m128 o = _mm_set1_ps(QUATPACK_RANGE);
+	__m128 a = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(ia), s), o);
+	__m128 b = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(ib), s), o);
+	__m128 c = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(ic), s), o);
+	__m128 d = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_mul_ps(a, a),
+		_mm_add_ps(_mm_mul_ps(b, b), _mm_mul_ps(c, c))));
+	__m128 m0 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(0)));
+	__m128 m1 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(1)));
+	__m128 m2 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(2)));
+	__m128 m3 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(3)));
+	quat_soa q;
+
+	d = sqrt_ps(_mm_max_ps(d, _mm_setzero_ps()));
+	/* components after the dropped one shift up a slot */
+	q.x = _mm_or_ps(_mm_and_ps(m0, d), _mm_andnot_ps(m0, a));
+	q.y = _mm_or_ps(_mm_and_ps(m0, a), _mm_or_ps(_mm_and_ps(m1, d),
+		_mm_andnot_ps(_mm_or_ps(m0, m1), b)));
+	q.z = _mm_or_ps(_mm_and_ps(m3, c), _mm_or_ps(_mm_and_ps(m2, d),
+		_mm_andnot_ps(_mm_or_ps(m2, m3), b)));
+	q.w = _mm_or_ps(_mm_and_ps(m3, d), _mm_andnot_ps(m3, c));
+	return q;
+}
+
+/**
+ * Decompresses four 32 bit quaternions.
+ */
+static inline quat_soa quat_soa_unpack32(const quat32 *p)
+{
+	__m128i v = _mm_loadu_si128((const __m128i *)p);
+	__m128i mask = _mm_set1_epi32(1023);
+	return quat_soa_unpack_common(_mm_srli_epi32(v, 30),
+		_mm_and_si128(_mm_srli_epi32(v, 20), mask),
+		_mm_and_si128(_mm_srli_epi32(v, 10), mask),
+		_mm_and_si128(v, mask), 1023.0f);
+}
+
+/**
+ * Decompresses four 48 bit quaternions.
+ */
+static inline quat_soa quat_soa_unpack48(const quat48 *p)
+{
+	__m128i a = _mm_setr_epi32(p[0].v[0], p[1].v[0], p[2].v[0], p[3].v[0]);
+	__m128i b = _mm_setr_epi32(p[0].v[1], p[1].v[1], p[2].v[1], p[3].v[1]);
+	__m128i c = _mm_setr_epi32(p[0].v[2], p[1].v[2], p[2].v[2], p[3].v[2]);
+	__m128i mask = _mm_set1_epi32(32767);
+	__m128i largest = _mm_or_si128(_mm_srli_epi32(a, 15),
+		_mm_slli_epi32(_mm_srli_epi32(b, 15), 1));
+	return quat_soa_unpack_common(largest, _mm_and_si128(a, mask),
+		_mm_and_si128(b, mask), _mm_and_si128(c, mask), 32767.0f);
+}
+#endif
+
+/**
+ * Compresses count unit quaternions to 32 bits each.
+ */
+static inline void quat_pack32_array(quat32 *out, const quat *q, int count)
+{
+	for (int i = 0; i < count; i++)
+		out[i] = quat_pack32(q[i]);
+}
+
+/**
+ * Compresses count unit quaternions to 48 bits each.
+ */
+static inline void quat_pack48_array(quat48 *out, const quat *q, int count)
+{
+	for (int i = 0; i < count; i++)
+		out[i] = quat_pack48(q[i]);
+}
+
+/**
+ * Decompresses count 32 bit quaternions, four at a time with SSE.
+ */
+static inline void quat_unpack32_array(quat *out, const quat32 *p, int count)
+{
+	int i = 0;
+#ifdef __SSE__
+	for (; i + 4 <= count; i += 4)
+		quat_soa_store(out + i, quat_soa_unpack32(p + i));
+#endif
+	for (; i < count; i++)
+		out[i] = quat_unpack32(p[i]);
+}
+
+/**
+ * Decompresses count 48 bit quaternions, four at a time with SSE.
+ */
+static inline void quat_unpack48_array(quat *out, const quat48 *p, int count)
+{
+	int i = 0;
+#ifdef __SSE__
+	for (; i + 4 <= count; i += 4)
+		quat_soa_store(out + i, quat_soa_unpack48(p + i));
+#endif
+	for (; i < count; i++)
+		out[i] = quat_unpack48(p[i]);
+}
+
+#endif /* _GMATH_QUATPACK_H_ */
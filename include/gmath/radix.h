@@ -0,0 +1,357 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * radix.h
+ * Handles radix sorts of 32 and 64 bit keys with index permutations
+ *
+ */
+
+#ifndef _GMATH_RADIX_H_
+#define _GMATH_RADIX_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "types.h"
+#include "task.h"
+
+/* Digit width and passes over a 32 and a 64 bit key. */
+#define RADIX_BITS 11
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES ((32 + RADIX_BITS - 1) / RADIX_BITS)
+#define RADIX_PASSES64 ((64 + RADIX_BITS - 1) / RADIX_BITS)
+
+/**
+ * A least significant digit first sort split into tasks.  Each pass
+ * counts the digits of every task's range of keys, turns the counts
+ * into per-task write offsets, and scatters the ranges.  The count and
+ * scatter phases of a pass may run on any split of the tasks at once:
+ *
+ *   do {
+ *       radix_sort_count(&rs, t), for every task t;
+ *       radix_sort_offsets(&rs);
+ *       radix_sort_scatter(&rs, t), for every task t;
+ *   } while (radix_sort_next(&rs));
+ *   radix_sort_end(&rs);
+ *
+ * Keys ping-pong between the input and a temporary array; a pass whose
+ * digit every key shares is skipped.  perm ends up holding the input
+ * index of each sorted key.  Equal keys keep their order.  A sorter
+ * started by radix_sort64_begin moves the 64 bit keys instead.
+ */
+typedef struct {
+	uint32_t *keys, *key, *tkey;
+	uint64_t *keys64, *key64, *tkey64;
+	int *perm, *index, *tindex;
+	int count, tasks, pass, passes, skip, flip;
+	int *hist;
+} radix_sorter;
+
+static inline void radix_sorter_free(radix_sorter *rs)
+{
+	free(rs->tkey != rs->keys ? rs->tkey : rs->key);
+	free(rs->tkey64 != rs->keys64 ? rs->tkey64 : rs->key64);
+	free(rs->tindex != rs->perm ? rs->tindex : rs->index);
+	free(rs->hist);
+	memset(rs, 0, sizeof(*rs));
+}
+
+/**
+ * Maps float bits to keys of the same order: negatives have every bit
+ * flipped, the rest just the sign.  -0 sorts before +0, and NaNs at the
+ * end of their sign.  radix_unflip undoes it.
+ */
+static inline void radix_flip(uint32_t *keys, int first, int last)
+{
+	int i = first;
+#ifdef __SSE2__
+	__m128i sign = _mm_set1_epi32((int)0x80000000);
+	for (; i + 4 <= last; i += 4) {
+		__m128i k = _mm_loadu_si128((const __m128i *)(keys + i));
+		k = _mm_xor_si128(k, _mm_or_si128(_mm_srai_epi32(k, 31), sign));
+		_mm_storeu_si128((__m128i *)(keys + i), k);
+	}
+#endif
+	for (; i < last; i++)
+		keys[i] ^= (uint32_t)-(int32_t)(keys[i] >> 31) | 0x80000000u;
+}
+
+static inline void radix_unflip(uint32_t *keys, int first, int last)
+{
+	int i = first;
+#ifdef __SSE2__
+	__m128i sign = _mm_set1_epi32((int)0x80000000);
+	for (; i + 4 <= last; i += 4) {
+		__m128i k = _mm_loadu_si128((const __m128i *)(keys + i));
+		__m128i neg = _mm_srai_epi32(_mm_xor_si128(k, sign), 31);
+		k = _mm_xor_si128(k, _mm_or_si128(neg, sign));
+		_mm_storeu_si128((__m128i *)(keys + i), k);
+	}
+#endif
+	for (; i < last; i++)
+		keys[i] ^= (uint32_t)-(int32_t)(~keys[i] >> 31) | 0x80000000u;
+}
+
+/**
+ * Starts a sort of count keys in place with passes split into tasks.
+ * Returns 0 on success, -1 when out of memory.
+ */
+static inline int radix_sort_begin(radix_sorter *rs, uint32_t *keys,
+		int *perm, int count, int tasks)
+{
+	memset(rs, 0, sizeof(*rs));
+	rs->keys = rs->key = keys;
+	rs->perm = perm;
+	rs->count = count;
+	rs->tasks = tasks < 1 ? 1 : tasks;
+	rs->passes = RADIX_PASSES;
+	rs->tkey = malloc(sizeof(uint32_t) * (count + 1));
+	rs->tindex = malloc(sizeof(int) * (count + 1));
+	rs->hist = malloc(sizeof(int) * RADIX_BUCKETS * rs->tasks);
+	if (!rs->tkey || !rs->tindex || !rs->hist) {
+		radix_sorter_free(rs);
+		return -1;
+	}
+	return 0;
+}
+
+/* radix_sort_begin for 64 bit keys, in RADIX_PASSES64 passes. */
+static inline int radix_sort64_begin(radix_sorter *rs, uint64_t *keys,
+		int *perm, int count, int tasks)
+{
+	memset(rs, 0, sizeof(*rs));
+	rs->keys64 = rs->key64 = keys;
+	rs->perm = perm;
+	rs->count = count;
+	rs->tasks = tasks < 1 ? 1 : tasks;
+	rs->passes = RADIX_PASSES64;
+	rs->tkey64 = malloc(sizeof(uint64_t) * (count + 1));
+	rs->tindex = malloc(sizeof(int) * (count + 1));
+	rs->hist = malloc(sizeof(int) * RADIX_BUCKETS * rs->tasks);
+	if (!rs->tkey64 || !rs->tindex || !rs->hist) {
+		radix_sorter_free(rs);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * radix_sort_begin for float keys, which are flipped to ordered bits
+ * by the first count and back by radix_sort_end.
+ */
+static inline int radix_sortf_begin(radix_sorter *rs, float *keys,
+		int *perm, int count, int tasks)
+{
+	if (radix_sort_begin(rs, (uint32_t *)keys, perm, count, tasks) < 0)
+		return -1;
+	rs->flip = 1;
+	return 0;
+}
+
+/**
+ * Counts the digits of the current pass over the keys of task t, four
+ * or eight 32 bit digits to a register.  The histogram is split in two
+ * so runs of one digit do not wait on their own increments.
+ */
+static inline void radix_sort_count(radix_sorter *rs, int t)
+{
+	int first = task_first(rs->count, rs->tasks, t);
+	int last = task_first(rs->count, rs->tasks, t + 1);
+	int shift = rs->pass * RADIX_BITS, i = first;
+	int *hist = rs->hist + t * RADIX_BUCKETS, h2[RADIX_BUCKETS];
+	const uint32_t *k = rs->key;
+	const uint64_t *k64 = rs->key64;
+
+	if (rs->flip && !rs->pass)
+		radix_flip(rs->key, first, last);
+	memset(hist, 0, sizeof(int) * RADIX_BUCKETS);
+	memset(h2, 0, sizeof(h2));
+	for (; k64 && i + 2 <= last; i += 2) {
+		hist[(k64[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+		h2[(k64[i + 1] >> shift) & (RADIX_BUCKETS - 1)]++;
+	}
+	for (; k64 && i < last; i++)
+		hist[(k64[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+#ifdef __AVX2__
+	{
+		__m256i mask = _mm256_set1_epi32(RADIX_BUCKETS - 1);
+		__m128i s = _mm_cvtsi32_si128(shift);
+		for (; i + 8 <= last; i += 8) {
+			uint32_t d[8];
+			__m256i v = _mm256_loadu_si256((const __m256i *)(k + i));
+			_mm256_storeu_si256((__m256i *)d,
+				_mm256_and_si256(_mm256_srl_epi32(v, s), mask));
+			hist[d[0]]++, h2[d[1]]++, hist[d[2]]++, h2[d[3]]++;
+			hist[d[4]]++, h2[d[5]]++, hist[d[6]]++, h2[d[7]]++;
+		}
+	}
+#elif defined(__SSE2__)
+	{
+		__m128i mask = _mm_set1_epi32(RADIX_BUCKETS - 1);
+		__m128i s = _mm_cvtsi32_si128(shift);
+		for (; i + 4 <= last; i += 4) {
+			uint32_t d[4];
+			__m128i v = _mm_loadu_si128((const __m128i *)(k + i));
+			_mm_storeu_si128((__m128i *)d,
+				_mm_and_si128(_mm_srl_epi32(v, s), mask));
+			hist[d[0]]++, h2[d[1]]++, hist[d[2]]++, h2[d[3]]++;
+		}
+	}
+#endif
+	for (; i < last; i++)
+		hist[(k[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+	for (int b = 0; b < RADIX_BUCKETS; b++)
+		hist[b] += h2[b];
+}
+
+/**
+ * Turns the counts of every task into each task's write offsets, so
+ * keys keep their order within a digit.  Runs once per pass, after all
+ * counts and before any scatter.
+ */
+static inline void radix_sort_offsets(radix_sorter *rs)
+{
+	int sum = 0;
+	rs->skip = 0;
+	for (int b = 0; b < RADIX_BUCKETS; b++) {
+		int start = sum;
+		for (int t = 0; t < rs->tasks; t++) {
+			int *h = &rs->hist[t * RADIX_BUCKETS + b];
+			int n = *h;
+			*h = sum;
+			sum += n;
+		}
+		rs->skip |= sum - start == rs->count;
+	}
+}
+
+/**
+ * Moves the keys of task t and their indices into place for the
+ * current pass.  Until a pass has run, the index of a key is its
+ * position.
+ */
+static inline void radix_sort_scatter(radix_sorter *rs, int t)
+{
+	int first = task_first(rs->count, rs->tasks, t);
+	int last = task_first(rs->count, rs->tasks, t + 1);
+	int shift = rs->pass * RADIX_BITS;
+	int *offset = rs->hist + t * RADIX_BUCKETS;
+	const uint32_t *k = rs->key;
+	uint32_t *tk = rs->tkey;
+	int *tp = rs->tindex;
+
+	if (rs->skip)
+		return;
+	if (rs->key64) {
+		const uint64_t *k64 = rs->key64;
+		const int *p = rs->index;
+		for (int i = first; i < last; i++) {
+			int j = offset[(k64[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+			rs->tkey64[j] = k64[i];
+			tp[j] = p ? p[i] : i;
+		}
+	} else if (!rs->index) {
+		for (int i = first; i < last; i++) {
+			int j = offset[(k[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+			tk[j] = k[i];
+			tp[j] = i;
+		}
+	} else {
+		const int *p = rs->index;
+		for (int i = first; i < last; i++) {
+			int j = offset[(k[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+			tk[j] = k[i];
+			tp[j] = p[i];
+		}
+	}
+}
+
+/**
+ * Swaps the arrays after a pass that moved keys.  Returns 1 while
+ * passes remain, 0 when the keys are sorted.
+ */
+static inline int radix_sort_next(radix_sorter *rs)
+{
+	if (!rs->skip) {
+		uint32_t *k = rs->key;
+		uint64_t *k64 = rs->key64;
+		int *p = rs->index ? rs->index : rs->perm;
+		rs->key = rs->tkey;
+		rs->tkey = k;
+		rs->key64 = rs->tkey64;
+		rs->tkey64 = k64;
+		rs->index = rs->tindex;
+		rs->tindex = p;
+	}
+	return ++rs->pass < rs->passes;
+}
+
+/* Leaves the sorted keys and perm in the caller's arrays. */
+static inline void radix_sort_end(radix_sorter *rs)
+{
+	if (rs->key != rs->keys)
+		memcpy(rs->keys, rs->key, sizeof(uint32_t) * rs->count);
+	if (rs->key64 != rs->keys64)
+		memcpy(rs->keys64, rs->key64, sizeof(uint64_t) * rs->count);
+	if (!rs->index)
+		for (int i = 0; i < rs->count; i++)
+			rs->perm[i] = i;
+	else if (rs->index != rs->perm)
+		memcpy(rs->perm, rs->index, sizeof(int) * rs->count);
+	if (rs->flip)
+		radix_unflip(rs->keys, 0, rs->count);
+	radix_sorter_free(rs);
+}
+
+/**
+ * Sorts count keys on the calling thread and writes to perm the input
+ * index of each sorted key.  Returns 0 on success, -1 when out of
+ * memory.
+ */
+static inline int radix_sort(uint32_t *keys, int *perm, int count)
+{
+	radix_sorter rs;
+	if (radix_sort_begin(&rs, keys, perm, count, 1) < 0)
+		return -1;
+	do {
+		radix_sort_count(&rs, 0);
+		radix_sort_offsets(&rs);
+		radix_sort_scatter(&rs, 0);
+	} while (radix_sort_next(&rs));
+	radix_sort_end(&rs);
+	return 0;
+}
+
+/* radix_sort for 64 bit keys. */
+static inline int radix_sort64(uint64_t *keys, int *perm, int count)
+{
+	radix_sorter rs;
+	if (radix_sort64_begin(&rs, keys, perm, count, 1) < 0)
+		return -1;
+	do {
+		radix_sort_count(&rs, 0);
+		radix_sort_offsets(&rs);
+		radix_sort_scatter(&rs, 0);
+	} while (radix_sort_next(&rs));
+	radix_sort_end(&rs);
+	return 0;
+}
+
+/* radix_sort for float keys. */
+static inline int radix_sortf(float *keys, int *perm, int count)
+{
+	radix_sorter rs;
+	if (radix_sortf_begin(&rs, keys, perm, count, 1) < 0)
+		return -1;
+	do {
+		radix_sort_count(&rs, 0);
+		radix_sort_offsets(&rs);
+		radix_sort_scatter(&rs, 0);
+	} while (radix_sort_next(&rs));
+	radix_sort_end(&rs);
+	return 0;
+}
+
+#endif /* _GMATH_RADIX_H_ */
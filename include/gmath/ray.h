@@ -0,0 +1,406 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * ray.h
+ * Handles ray queries against triangles and boxes
+ *
+ */
+
+#ifndef _GMATH_RAY_H_
+#define _GMATH_RAY_H_
+
+#include "constants.h"
+#include "cephes/rcp.h"
+#include "vec3.h"
+#include "aabb.h"
+
+/* Determinants below this are treated as rays parallel to a triangle. */
+#define RAY_PARALLEL_EPSILON 1e-12f
+
+/**
+ * Moller-Trumbore ray triangle test.  On a hit with 0 <= t < tmax,
+ * writes the distance along dir and the barycentrics u, v of v1 and v2
+ * and returns nonzero.  Both windings are hit.
+ */
+static inline int ray_triangle(const ray *r, const vec3 v0, const vec3 v1,
+		const vec3 v2, float tmax, float *t, float *u, float *v)
+{
+	vec3 e1 = vec3_sub(v1, v0), e2 = vec3_sub(v2, v0);
+	vec3 p = vec3_cross(r->dir, e2);
+	float det = vec3_dot(e1, p);
+	if (fabsf(det) < RAY_PARALLEL_EPSILON)
+		return 0;
+	float inv = 1.0f / det;
+	vec3 s = vec3_sub(r->origin, v0);
+	float a = vec3_dot(s, p) * inv;
+	if (a < 0.0f || a > 1.0f)
+		return 0;
+	vec3 q = vec3_cross(s, e1);
+	float b = vec3_dot(r->dir, q) * inv;
+	if (b < 0.0f || a + b > 1.0f)
+		return 0;
+	float d = vec3_dot(e2, q) * inv;
+	if (d < 0.0f || d >= tmax)
+		return 0;
+	*t = d;
+	*u = a;
+	*v = b;
+	return 1;
+}
+
+#ifdef __SSE__
+/**
+ * Packs four triangles given by their vertices.
+ */
+static inline tri_soa tri_soa_load(const vec3 *v0, const vec3 *v1,
+		const vec3 *v2)
+{
+	tri_soa out;
+	out.v0 = vec3_soa_load(v0);
+	out.e1 = vec3_soa_sub(vec3_soa_load(v1), out.v0);
+	out.e2 = vec3_soa_sub(vec3_soa_load(v2), out.v0);
+	return out;
+}
+
+static inline ray_soa ray_soa_load(const ray *r)
+{
+	vec3 o[4] = {r[0].origin, r[1].origin, r[2].origin, r[3].origin};
+	vec3 d[4] = {r[0].dir, r[1].dir, r[2].dir, r[3].dir};
+	ray_soa out;
+	out.origin = vec3_soa_load(o);
+	out.dir = vec3_soa_load(d);
+	return out;
+}
+
+/**
+ * The shared Moller-Trumbore body, every lane is one ray and triangle
+ * pair.  Returns the lanes hit with 0 <= t < tmax.
+ */
+static inline int ray_tri_soa_test(const vec3_soa o, const vec3_soa d,
+		const vec3_soa v0, const vec3_soa e1, const vec3_soa e2,
+		const __m128 tmax, __m128 *t, __m128 *u, __m128 *v)
+{
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(SIGN_MASK));
+	__m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+	vec3_soa p = vec3_soa_cross(d, e2);
+	__m128 det = vec3_soa_dot(e1, p);
+	__m128 inv = rcp_ps(det);
+	vec3_soa s = vec3_soa_sub(o, v0);
+	vec3_soa q = vec3_soa_cross(s, e1);
+	__m128 a = _mm_mul_ps(vec3_soa_dot(s, p), inv);
+	__m128 b = _mm_mul_ps(vec3_soa_dot(d, q), inv);
+	__m128 c = _mm_mul_ps(vec3_soa_dot(e2, q), inv);
+	__m128 hit = _mm_cmpge_ps(_mm_andnot_ps(sign, det),
+		_mm_set1_ps(RAY_PARALLEL_EPSILON));
+	hit = _mm_and_ps(hit, _mm_cmpge_ps(a, zero));
+	hit = _mm_and_ps(hit, _mm_cmpge_ps(b, zero));
+	hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(a, b), one));
+	hit = _mm_and_ps(hit, _mm_cmpge_ps(c, zero));
+	hit = _mm_and_ps(hit, _mm_cmplt_ps(c, tmax));
+	*t = c;
+	*u = a;
+	*v = b;
+	return _mm_movemask_ps(hit);
+}
+
+/**
+ * Tests one ray against four triangles, returning a 4 bit hit mask.
+ * t, u and v are only meaningful in the hit lanes.
+ */
+static inline int ray_tri_soa(const ray *r, const tri_soa *tri, float tmax,
+		__m128 *t, __m128 *u, __m128 *v)
+{
+	return ray_tri_soa_test(vec3_soa_splat(r->origin),
+		vec3_soa_splat(r->dir), tri->v0, tri->e1, tri->e2,
+		_mm_set1_ps(tmax), t, u, v);
+}
+
+/**
+ * Tests four rays against one triangle, tmax holds a limit per ray.
+ */
+static inline int ray_soa_triangle(const ray_soa *r, const vec3 v0,
+		const vec3 v1, const vec3 v2, const __m128 tmax,
+		__m128 *t, __m128 *u, __m128 *v)
+{
+	return ray_tri_soa_test(r->origin, r->dir, vec3_soa_splat(v0),
+		vec3_soa_splat(vec3_sub(v1, v0)), vec3_soa_splat(vec3_sub(v2, v0)),
+		tmax, t, u, v);
+}
+#endif
+
+#ifdef __AVX__
+static inline tri_soa8 tri_soa8_load(const vec3 *v0, const vec3 *v1,
+		const vec3 *v2)
+{
+	tri_soa8 out;
+	out.v0 = vec3_soa8_load(v0);
+	out.e1 = vec3_soa8_sub(vec3_soa8_load(v1), out.v0);
+	out.e2 = vec3_soa8_sub(vec3_soa8_load(v2), out.v0);
+	return out;
+}
+
+/**
+ * Tests one ray against eight triangles, returning an 8 bit hit mask.
+ */
+static inline int ray_tri_soa8(const ray *r, const tri_soa8 *tri, float tmax,
+		__m256 *t, __m256 *u, __m256 *v)
+{
+	__m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32(SIGN_MASK));
+	__m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+	vec3_soa8 o = vec3_soa8_splat(r->origin), d = vec3_soa8_splat(r->dir);
+	vec3_soa8 p = vec3_soa8_cross(d, tri->e2);
+	__m256 det = vec3_soa8_dot(tri->e1, p);
+	__m256 inv = _mm256_rcp_ps(det);
+	inv = _mm256_sub_ps(_mm256_add_ps(inv, inv),
+		_mm256_mul_ps(_mm256_mul_ps(inv, det), inv));
+	vec3_soa8 s = vec3_soa8_sub(o, tri->v0);
+	vec3_soa8 q = vec3_soa8_cross(s, tri->e1);
+	__m256 a = _mm256_mul_ps(vec3_soa8_dot(s, p), inv);
+	__m256 b = _mm256_mul_ps(vec3_soa8_dot(d, q), inv);
+	__m256 c = _mm256_mul_ps(vec3_soa8_dot(tri->e2, q), inv);
+	__m256 hit = _mm256_cmp_ps(_mm256_andnot_ps(sign, det),
+		_mm256_set1_ps(RAY_PARALLEL_EPSILON), _CMP_GE_OQ);
+	hit = _mm256_and_ps(hit, _mm256_cmp_ps(a, zero, _CMP_GE_OQ));
+	hit = _mm256_and_ps(hit, _mm256_cmp_ps(b, zero, _CMP_GE_OQ));
+	hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_add_ps(a, b), one,
+		_CMP_LE_OQ));
+	hit = _mm256_and_ps(hit, _mm256_cmp_ps(c, zero, _CMP_GE_OQ));
+	hit = _mm256_and_ps(hit, _mm256_cmp_ps(c, _mm256_set1_ps(tmax),
+		_CMP_LT_OQ));
+	*t = c;
+	*u = a;
+	*v = b;
+	return _mm256_movemask_ps(hit);
+}
+#endif
+
+/**
+ * Finds the closest of count triangles hit before tmax, given as three
+ * vertex arrays.  Returns its index, or -1 with t, u, v untouched.
+ */
+static inline int ray_triangles_closest(const ray *r, const vec3 *v0,
+		const vec3 *v1, const vec3 *v2, int count, float tmax,
+		float *t, float *u, float *v)
+{
+	int best = -1, i = 0;
+#ifdef __AVX__
+	for (; i + 8 <= count; i += 8) {
+		tri_soa8 tri = tri_soa8_load(v0 + i, v1 + i, v2 + i);
+		__m256 tt, tu, tv;
+		int mask = ray_tri_soa8(r, &tri, tmax, &tt, &tu, &tv);
+		for (; mask; mask &= mask - 1) {
+			int j = __builtin_ctz(mask);
+			if (fidx(tt, j) < tmax) {
+				tmax = *t = fidx(tt, j);
+				*u = fidx(tu, j);
+				*v = fidx(tv, j);
+				best = i + j;
+			}
+		}
+	}
+#endif
+#ifdef __SSE__
+	for (; i + 4 <= count; i += 4) {
+		tri_soa tri = tri_soa_load(v0 + i, v1 + i, v2 + i);
+		__m128 tt, tu, tv;
+		int mask = ray_tri_soa(r, &tri, tmax, &tt, &tu, &tv);
+		for (; mask; mask &= mask - 1) {
+			int j = __builtin_ctz(mask);
+			if (fidx(tt, j) < tmax) {
+				tmax = *t = fidx(tt, j);
+				*u = fidx(tu, j);
+				*v = fidx(tv, j);
+				best = i + j;
+			}
+		}
+	}
+#endif
+	for (; i < count; i++)
+		if (ray_triangle(r, v0[i], v1[i], v2[i], tmax, t, u, v)) {
+			tmax = *t;
+			best = i;
+		}
+	return best;
+}
+
+/**
+ * Prepares a ray for slab tests.  A zero direction component gives an
+ * infinite inverse, and a box face through the origin then yields
+ * 0 * inf = NaN.  The tests fold each distance in as the first operand
+ * of min/max, which returns the second on NaN, so such a face adds no
+ * constraint and the box counts as closed.
+ */
+static inline ray_slab ray_slab_init(const ray *r)
+{
+	ray_slab out;
+	out.origin = r->origin;
+#ifndef __SSE__
+	for (int i = 0; i < 4; i++)
+		out.inv_dir[i] = 1.0f / r->dir[i];
+#else
+	out.inv_dir = _mm_div_ps(_mm_set1_ps(1.0f), r->dir);
+#endif
+	for (int i = 0; i < 3; i++)
+		out.sign[i] = signbit(fidx(r->dir, i)) ? 1 : 0;
+	return out;
+}
+
+/**
+ * Slab test of one ray against one box.  On a hit with the entry
+ * before tmax, writes the entry distance (0 when starting inside) and
+ * returns nonzero.
+ */
+static inline int ray_aabb(const ray_slab *r, const aabb *b, float tmax,
+		float *tnear)
+{
+	vec3 t[2];
+	float n = 0.0f, f = tmax;
+	t[0] = vec3_mul(vec3_sub(b->min, r->origin), r->inv_dir);
+	t[1] = vec3_mul(vec3_sub(b->max, r->origin), r->inv_dir);
+	for (int i = 0; i < 3; i++) {
+		float lo = fidx(t[r->sign[i]], i), hi = fidx(t[1 - r->sign[i]], i);
+		n = lo > n ? lo : n;
+		f = hi < f ? hi : f;
+	}
+	*tnear = n;
+	return n <= f;
+}
+
+#ifdef __SSE__
+static inline aabb_soa aabb_soa_load(const aabb *b)
+{
+	vec3 lo[4] = {b[0].min, b[1].min, b[2].min, b[3].min};
+	vec3 hi[4] = {b[0].max, b[1].max, b[2].max, b[3].max};
+	aabb_soa out;
+	out.min = vec3_soa_load(lo);
+	out.max = vec3_soa_load(hi);
+	return out;
+}
+
+static inline ray_slab_soa ray_slab_soa_load(const ray *r)
+{
+	vec3 o[4] = {r[0].origin, r[1].origin, r[2].origin, r[3].origin};
+	vec3 d[4] = {r[0].dir, r[1].dir, r[2].dir, r[3].dir};
+	ray_slab_soa out;
+	vec3_soa dir = vec3_soa_load(d);
+	__m128 one = _mm_set1_ps(1.0f);
+	out.origin = vec3_soa_load(o);
+	out.inv_dir.x = _mm_div_ps(one, dir.x);
+	out.inv_dir.y = _mm_div_ps(one, dir.y);
+	out.inv_dir.z = _mm_div_ps(one, dir.z);
+	out.neg.x = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(dir.x), 31));
+	out.neg.y = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(dir.y), 31));
+	out.neg.z = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(dir.z), 31));
+	return out;
+}
+
+/**
+ * The shared slab body, every lane is one ray and the faces it enters
+ * and leaves through.  Folds as ray_aabb does, with the lanes of
+ * vec3_max and vec3_min.  Returns the lanes whose entry is at most
+ * their exit and tmax.
+ */
+static inline int ray_aabb_soa_test(const vec3_soa o, const vec3_soa inv,
+		const vec3_soa in, const vec3_soa out, const __m128 tmax,
+		__m128 *tnear)
+{
+	__m128 n = _mm_setzero_ps(), f = tmax;
+	n = vec3_max(_mm_mul_ps(_mm_sub_ps(in.x, o.x), inv.x), n);
+	f = vec3_min(_mm_mul_ps(_mm_sub_ps(out.x, o.x), inv.x), f);
+	n = vec3_max(_mm_mul_ps(_mm_sub_ps(in.y, o.y), inv.y), n);
+	f = vec3_min(_mm_mul_ps(_mm_sub_ps(out.y, o.y), inv.y), f);
+	n = vec3_max(_mm_mul_ps(_mm_sub_ps(in.z, o.z), inv.z), n);
+	f = vec3_min(_mm_mul_ps(_mm_sub_ps(out.z, o.z), inv.z), f);
+	*tnear = n;
+	return _mm_movemask_ps(_mm_cmple_ps(n, f));
+}
+
+/**
+ * Tests one ray against four boxes, returning a 4 bit hit mask and the
+ * entry distances.
+ */
+static inline int ray_aabb_soa(const ray_slab *r, const aabb_soa *b,
+		float tmax, __m128 *tnear)
+{
+	const vec3_soa *bound = &b->min;
+	vec3_soa in, out;
+	in.x = bound[r->sign[0]].x;
+	in.y = bound[r->sign[1]].y;
+	in.z = bound[r->sign[2]].z;
+	out.x = bound[1 - r->sign[0]].x;
+	out.y = bound[1 - r->sign[1]].y;
+	out.z = bound[1 - r->sign[2]].z;
+	return ray_aabb_soa_test(vec3_soa_splat(r->origin),
+		vec3_soa_splat(r->inv_dir), in, out, _mm_set1_ps(tmax), tnear);
+}
+
+/**
+ * Tests four rays against one box, tmax holds a limit per ray.
+ */
+static inline int ray_soa_aabb(const ray_slab_soa *r, const aabb *b,
+		const __m128 tmax, __m128 *tnear)
+{
+	vec3_soa lo = vec3_soa_splat(b->min), hi = vec3_soa_splat(b->max);
+	vec3_soa in, out;
+	in.x = _mm_or_ps(_mm_and_ps(r->neg.x, hi.x),
+		_mm_andnot_ps(r->neg.x, lo.x));
+	in.y = _mm_or_ps(_mm_and_ps(r->neg.y, hi.y),
+		_mm_andnot_ps(r->neg.y, lo.y));
+	in.z = _mm_or_ps(_mm_and_ps(r->neg.z, hi.z),
+		_mm_andnot_ps(r->neg.z, lo.z));
+	out.x = _mm_or_ps(_mm_and_ps(r->neg.x, lo.x),
+		_mm_andnot_ps(r->neg.x, hi.x));
+	out.y = _mm_or_ps(_mm_and_ps(r->neg.y, lo.y),
+		_mm_andnot_ps(r->neg.y, hi.y));
+	out.z = _mm_or_ps(_mm_and_ps(r->neg.z, lo.z),
+		_mm_andnot_ps(r->neg.z, hi.z));
+	return ray_aabb_soa_test(r->origin, r->inv_dir, in, out, tmax, tnear);
+}
+#endif
+
+#ifdef __AVX__
+static inline aabb_soa8 aabb_soa8_load(const aabb *b)
+{
+	vec3 lo[8], hi[8];
+	aabb_soa8 out;
+	for (int i = 0; i < 8; i++) {
+		lo[i] = b[i].min;
+		hi[i] = b[i].max;
+	}
+	out.min = vec3_soa8_load(lo);
+	out.max = vec3_soa8_load(hi);
+	return out;
+}
+
+/**
+ * Tests one ray against eight boxes, returning an 8 bit hit mask.  The
+ * lanes are wider than vec3_max and vec3_min take, so the AVX min and
+ * max fold the faces in directly, in the same operand order.
+ */
+static inline int ray_aabb_soa8(const ray_slab *r, const aabb_soa8 *b,
+		float tmax, __m256 *tnear)
+{
+	const vec3_soa8 *bound = &b->min;
+	vec3_soa8 o = vec3_soa8_splat(r->origin);
+	vec3_soa8 inv = vec3_soa8_splat(r->inv_dir);
+	__m256 n = _mm256_setzero_ps(), f = _mm256_set1_ps(tmax);
+	n = _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(bound[r->sign[0]].x,
+		o.x), inv.x), n);
+	f = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(bound[1 - r->sign[0]].x,
+		o.x), inv.x), f);
+	n = _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(bound[r->sign[1]].y,
+		o.y), inv.y), n);
+	f = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(bound[1 - r->sign[1]].y,
+		o.y), inv.y), f);
+	n = _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(bound[r->sign[2]].z,
+		o.z), inv.z), n);
+	f = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(bound[1 - r->sign[2]].z,
+		o.z), inv.z), f);
+	*tnear = n;
+	return _mm256_movemask_ps(_mm256_cmp_ps(n, f, _CMP_LE_OQ));
+}
+#endif
+
+#endif /* _GMATH_RAY_H_ */
@@ -0,0 +1,217 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * sap.h
+ * Handles sort and sweep broadphase over box arrays
+ *
+ */
+
+#ifndef _GMATH_SAP_H_
+#define _GMATH_SAP_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "constants.h"
+#include "aabb.h"
+#include "radix.h"
+
+/* Floats of padding after each bound array, one AVX register. */
+#define SAP_PAD 8
+
+/* A pair of overlapping bodies, a < b. */
+typedef struct {
+	int a, b;
+} sap_pair;
+
+/**
+ * Sort and sweep state.  Bodies stay sorted by the min of their box on
+ * the sweep axis from frame to frame, so an update is an insertion sort
+ * over a nearly sorted array.  The bounds are kept as structure of
+ * arrays in sorted order, lo[0] and hi[0] on the sweep axis and the
+ * other two axes after, each padded by SAP_PAD.
+ */
+typedef struct {
+	int count;
+	int axis;
+	int *order;
+	float *lo[3], *hi[3];
+} sap;
+
+static inline void sap_free(sap *s)
+{
+	free(s->order);
+	free(s->lo[0]);
+	memset(s, 0, sizeof(*s));
+}
+
+/**
+ * Copies the bounds into sorted order, the sweep axis first.
+ */
+static inline void sap_gather(sap *s, const aabb *boxes)
+{
+	int a1 = (s->axis + 1) % 3, a2 = (s->axis + 2) % 3;
+	for (int i = 0; i < s->count; i++) {
+		const aabb *b = &boxes[s->order[i]];
+		s->lo[0][i] = fidx(b->min, s->axis);
+		s->hi[0][i] = fidx(b->max, s->axis);
+		s->lo[1][i] = fidx(b->min, a1);
+		s->hi[1][i] = fidx(b->max, a1);
+		s->lo[2][i] = fidx(b->min, a2);
+		s->hi[2][i] = fidx(b->max, a2);
+	}
+}
+
+/**
+ * Sets up a broadphase over count boxes.  The sweep axis is the one
+ * with the largest spread of box centres, and stays fixed until the
+ * next init.  Returns 0 on success, -1 when out of memory.
+ */
+static inline int sap_init(sap *s, const aabb *boxes, int count)
+{
+	int stride = count + SAP_PAD;
+	vec3 sum = _mm_setzero_ps(), sq = _mm_setzero_ps();
+	float *keys = malloc(sizeof(float) * (count + 1));
+	float *bounds;
+
+	memset(s, 0, sizeof(*s));
+	s->count = count;
+	s->order = malloc(sizeof(int) * (count + 1));
+	s->lo[0] = bounds = malloc(sizeof(float) * 6 * stride);
+	if (!keys || !s->order || !bounds)
+		goto fail;
+	for (int i = 0; i < 3; i++) {
+		s->lo[i] = bounds + 2 * i * stride;
+		s->hi[i] = s->lo[i] + stride;
+		/* a sweep block reaching past the end overlaps nothing */
+		for (int j = count; j < stride; j++) {
+			s->lo[i][j] = INFINITY;
+			s->hi[i][j] = -INFINITY;
+		}
+	}
+
+	for (int i = 0; i < count; i++) {
+		vec3 c = vec3_add(boxes[i].min, boxes[i].max);
+		sum = vec3_add(sum, c);
+		sq = vec3_add(sq, vec3_mul(c, c));
+	}
+	sq = vec3_sub(vec3_scale(sq, (float)count), vec3_mul(sum, sum));
+	s->axis = fidx(sq, 1) > fidx(sq, 0) ? 1 : 0;
+	s->axis = fidx(sq, 2) > fidx(sq, s->axis) ? 2 : s->axis;
+
+	for (int i = 0; i < count; i++)
+		keys[i] = fidx(boxes[i].min, s->axis);
+	if (radix_sortf(keys, s->order, count) < 0)
+		goto fail;
+	free(keys);
+	sap_gather(s, boxes);
+	return 0;
+
+fail:
+	free(keys);
+	sap_free(s);
+	return -1;
+}
+
+/**
+ * Takes the boxes of a new frame, indexed as at init.  Bodies that
+ * moved little since the last frame cost one comparison each; the
+ * insertion sort only pays for bodies that pass one another.
+ */
+static inline void sap_update(sap *s, const aabb *boxes)
+{
+	float *key = s->lo[0];
+	int *order = s->order;
+
+	for (int i = 0; i < s->count; i++)
+		key[i] = fidx(boxes[order[i]].min, s->axis);
+	for (int i = 1; i < s->count; i++) {
+		float k = key[i];
+		int o = order[i], j = i;
+		for (; j > 0 && key[j - 1] > k; j--) {
+			key[j] = key[j - 1];
+			order[j] = order[j - 1];
+		}
+		key[j] = k;
+		order[j] = o;
+	}
+	sap_gather(s, boxes);
+}
+
+/* Appends the pairs of sorted slot i and the set bits of mask at j. */
+static inline int sap_emit(const sap *s, int i, int j, int mask,
+		sap_pair *pairs, int found, int max)
+{
+	for (; mask; mask &= mask - 1) {
+		int a = s->order[i], b = s->order[j + __builtin_ctz(mask)];
+		if (found < max) {
+			pairs[found].a = a < b ? a : b;
+			pairs[found].b = a < b ? b : a;
+		}
+		found++;
+	}
+	return found;
+}
+
+/**
+ * Sweeps the sorted bodies.  Each body is tested against the bodies
+ * after it that start before it ends on the sweep axis, a register at
+ * a time, with the other two axes tested in the same lanes.  Touching
+ * boxes overlap.  Writes at most max pairs and returns how many were
+ * found.
+ */
+static inline int sap_pairs(const sap *s, sap_pair *pairs, int max)
+{
+	int found = 0;
+
+	for (int i = 0; i < s->count; i++) {
+#ifdef __AVX__
+		__m256 end = _mm256_set1_ps(s->hi[0][i]);
+		__m256 lo1 = _mm256_set1_ps(s->lo[1][i]);
+		__m256 hi1 = _mm256_set1_ps(s->hi[1][i]);
+		__m256 lo2 = _mm256_set1_ps(s->lo[2][i]);
+		__m256 hi2 = _mm256_set1_ps(s->hi[2][i]);
+		for (int j = i + 1; j < s->count; j += 8) {
+			__m256 in = _mm256_cmp_ps(_mm256_loadu_ps(s->lo[0] + j), end,
+				_CMP_LE_OQ);
+			__m256 m = _mm256_and_ps(in, _mm256_cmp_ps(
+				_mm256_loadu_ps(s->lo[1] + j), hi1, _CMP_LE_OQ));
+			m = _mm256_and_ps(m, _mm256_cmp_ps(
+				_mm256_loadu_ps(s->hi[1] + j), lo1, _CMP_GE_OQ));
+			m = _mm256_and_ps(m, _mm256_cmp_ps(
+				_mm256_loadu_ps(s->lo[2] + j), hi2, _CMP_LE_OQ));
+			m = _mm256_and_ps(m, _mm256_cmp_ps(
+				_mm256_loadu_ps(s->hi[2] + j), lo2, _CMP_GE_OQ));
+			found = sap_emit(s, i, j, _mm256_movemask_ps(m), pairs, found,
+				max);
+			if (_mm256_movemask_ps(in) != 0xff)
+				break;
+		}
+#elif defined(__SSE__)
+		__m128 end = _mm_set1_ps(s->hi[0][i]);
+		__m128 lo1 = _mm_set1_ps(s->lo[1][i]), hi1 = _mm_set1_ps(s->hi[1][i]);
+		__m128 lo2 = _mm_set1_ps(s->lo[2][i]), hi2 = _mm_set1_ps(s->hi[2][i]);
+		for (int j = i + 1; j < s->count; j += 4) {
+			__m128 in = _mm_cmple_ps(_mm_loadu_ps(s->lo[0] + j), end);
+			__m128 m = _mm_and_ps(in,
+				_mm_cmple_ps(_mm_loadu_ps(s->lo[1] + j), hi1));
+			m = _mm_and_ps(m, _mm_cmpge_ps(_mm_loadu_ps(s->hi[1] + j), lo1));
+			m = _mm_and_ps(m, _mm_cmple_ps(_mm_loadu_ps(s->lo[2] + j), hi2));
+			m = _mm_and_ps(m, _mm_cmpge_ps(_mm_loadu_ps(s->hi[2] + j), lo2));
+			found = sap_emit(s, i, j, _mm_movemask_ps(m), pairs, found, max);
+			if (_mm_movemask_ps(in) != 0xf)
+				break;
+		}
+#else
+		for (int j = i + 1; j < s->count && s->lo[0][j] <= s->hi[0][i]; j++)
+			if (s->lo[1][j] <= s->hi[1][i] && s->hi[1][j] >= s->lo[1][i] &&
+					s->lo[2][j] <= s->hi[2][i] && s->hi[2][j] >= s->lo[2][i])
+				found = sap_emit(s, i, j, 1, pairs, found, max);
+#endif
+	}
+	return found;
+}
+
+#endif /* _GMATH_SAP_H_ */
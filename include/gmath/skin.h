@@ -0,0 +1,436 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * skin.h
+ * Handles linear blend and dual quaternion skinning of vertex streams
+ *
+ */
+
+#ifndef _GMATH_SKIN_H_
+#define _GMATH_SKIN_H_
+
+#include "constants.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "mat4.h"
+#include "dquat.h"
+
+/**
+ * Up to four bone influences of a vertex.  Unused influences should
+ * have a zero weight, the weights are expected to sum to one.
+ */
+typedef struct {
+	unsigned short index[4];
+	float weight[4];
+} skin_influence;
+
+/**
+ * Blends the four palette matrices of a vertex by their weights.
+ */
+static inline mat4 skin_blend_mat4(const mat4 *palette,
+		const skin_influence *inf)
+{
+	mat4 out;
+#ifdef __AVX__
+	/* two columns per register halves the multiply-adds */
+	const float *m0 = (const float *)&palette[inf->index[0]];
+	const float *m1 = (const float *)&palette[inf->index[1]];
+	const float *m2 = (const float *)&palette[inf->index[2]];
+	const float *m3 = (const float *)&palette[inf->index[3]];
+	__m256 w0 = _mm256_broadcast_ss(&inf->weight[0]);
+	__m256 w1 = _mm256_broadcast_ss(&inf->weight[1]);
+	__m256 w2 = _mm256_broadcast_ss(&inf->weight[2]);
+	__m256 w3 = _mm256_broadcast_ss(&inf->weight[3]);
+	__m256 lo = _mm256_add_ps(
+		_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(m0), w0),
+			_mm256_mul_ps(_mm256_loadu_ps(m1), w1)),
+		_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(m2), w2),
+			_mm256_mul_ps(_mm256_loadu_ps(m3), w3)));
+	__m256 hi = _mm256_add_ps(
+		_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(m0 + 8), w0),
+			_mm256_mul_ps(_mm256_loadu_ps(m1 + 8), w1)),
+		_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(m2 + 8), w2),
+			_mm256_mul_ps(_mm256_loadu_ps(m3 + 8), w3)));
+	out.col[0] = _mm256_castps256_ps128(lo);
+	out.col[1] = _mm256_extractf128_ps(lo, 1);
+	out.col[2] = _mm256_castps256_ps128(hi);
+	out.col[3] = _mm256_extractf128_ps(hi, 1);
+#else
+	const mat4 *m0 = &palette[inf->index[0]];
+	const mat4 *m1 = &palette[inf->index[1]];
+	const mat4 *m2 = &palette[inf->index[2]];
+	const mat4 *m3 = &palette[inf->index[3]];
+	for (int i = 0; i < 4; i++) {
+		vec4 c0 = vec4_scale(m0->col[i], inf->weight[0]);
+		vec4 c1 = vec4_scale(m1->col[i], inf->weight[1]);
+		vec4 c2 = vec4_scale(m2->col[i], inf->weight[2]);
+		vec4 c3 = vec4_scale(m3->col[i], inf->weight[3]);
+		out.col[i] = vec4_add(vec4_add(c0, c1), vec4_add(c2, c3));
+	}
+#endif
+	return out;
+}
+
+/**
+ * Linear blend skinning of count vertices.  Positions are transformed
+ * as points, normals and tangents by the rotation part of the blended
+ * matrix; the tangent w (handedness) is kept.  Any of the normal or
+ * tangent streams may be NULL to skip them.  This is mat4_transform4
+ * with w = 1 and w = 0, without setting w or multiplying the column
+ * it drops.
+ */
+static inline void skin_lbs(vec3 *out_pos, vec3 *out_nrm, vec4 *out_tan,
+		const mat4 *palette, const skin_influence *inf,
+		const vec3 *pos, const vec3 *nrm, const vec4 *tan, int count)
+{
+	for (int i = 0; i < count; i++) {
+		mat4 m = skin_blend_mat4(palette, &inf[i]);
+		out_pos[i] = mat4_transform_point(m, pos[i]);
+		if (nrm)
+			out_nrm[i] = mat4_transform_normal(m, nrm[i]);
+		if (tan) {
+#ifdef __SSE__
+			vec4 t = mat4_transform_normal(m, tan[i]);
+			out_tan[i] = _mm_shuffle_ps(t,
+				_mm_unpackhi_ps(t, tan[i]), _MM_SHUFFLE(3,0,1,0));
+#else
+			out_tan[i] = mat4_transform_normal(m, tan[i]);
+			out_tan[i][3] = tan[i][3];
+#endif
+		}
+	}
+}
+
+/**
+ * Blends the four palette dual quaternions of a vertex, flipping each
+ * into the hemisphere of the first influence, and normalizes.
+ */
+static inline dquat skin_blend_dquat(const dquat *palette,
+		const skin_influence *inf)
+{
+#ifndef __SSE__
+	dquat dq[4] = {palette[inf->index[0]], palette[inf->index[1]],
+	               palette[inf->index[2]], palette[inf->index[3]]};
+	return dquat_blend(dq, inf->weight, 4);
+#else
+	const dquat *d0 = &palette[inf->index[0]];
+	const dquat *d1 = &palette[inf->index[1]];
+	const dquat *d2 = &palette[inf->index[2]];
+	const dquat *d3 = &palette[inf->index[3]];
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	__m128 w0 = _mm_set1_ps(inf->weight[0]);
+	__m128 w1 = _mm_xor_ps(_mm_set1_ps(inf->weight[1]),
+		_mm_and_ps(vec4_dot_m128(d0->real, d1->real), sign));
+	__m128 w2 = _mm_xor_ps(_mm_set1_ps(inf->weight[2]),
+		_mm_and_ps(vec4_dot_m128(d0->real, d2->real), sign));
+	__m128 w3 = _mm_xor_ps(_mm_set1_ps(inf->weight[3]),
+		_mm_and_ps(vec4_dot_m128(d0->real, d3->real), sign));
+	dquat out;
+#ifdef __AVX__
+	/* a dual quaternion fits one 256-bit register */
+	__m256 acc = _mm256_add_ps(
+		_mm256_add_ps(
+			_mm256_mul_ps(_mm256_loadu_ps((const float *)d0),
+				_mm256_insertf128_ps(_mm256_castps128_ps256(w0), w0, 1)),
+			_mm256_mul_ps(_mm256_loadu_ps((const float *)d1),
+				_mm256_insertf128_ps(_mm256_castps128_ps256(w1), w1, 1))),
+		_mm256_add_ps(
+			_mm256_mul_ps(_mm256_loadu_ps((const float *)d2),
+				_mm256_insertf128_ps(_mm256_castps128_ps256(w2), w2, 1)),
+			_mm256_mul_ps(_mm256_loadu_ps((const float *)d3),
+				_mm256_insertf128_ps(_mm256_castps128_ps256(w3), w3, 1))));
+	out.real = _mm256_castps256_ps128(acc);
+	out.dual = _mm256_extractf128_ps(acc, 1);
+#else
+	out.real = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(d0->real, w0), _mm_mul_ps(d1->real, w1)),
+		_mm_add_ps(_mm_mul_ps(d2->real, w2), _mm_mul_ps(d3->real, w3)));
+	out.dual = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(d0->dual, w0), _mm_mul_ps(d1->dual, w1)),
+		_mm_add_ps(_mm_mul_ps(d2->dual, w2), _mm_mul_ps(d3->dual, w3)));
+#endif
+	return dquat_normalize(out);
+#endif
+}
+
+#ifdef __SSE__
+/**
+ * Skins four vertices at once in structure of arrays form, so the
+ * hemisphere tests and normalization need no horizontal dot products.
+ */
+static inline void skin_dqs4(vec3 *out_pos, vec3 *out_nrm, vec4 *out_tan,
+		const dquat *palette, const skin_influence *inf,
+		const vec3 *pos, const vec3 *nrm, const vec4 *tan)
+{
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	__m128 w0 = _mm_loadu_ps(inf[0].weight);
+	__m128 w1 = _mm_loadu_ps(inf[1].weight);
+	__m128 w2 = _mm_loadu_ps(inf[2].weight);
+	__m128 w3 = _mm_loadu_ps(inf[3].weight);
+	quat_soa real, dual, r0;
+
+	/* after the transpose wk holds weight k of each vertex */
+	_MM_TRANSPOSE4_PS(w0, w1, w2, w3);
+	real.x = real.y = real.z = real.w = _mm_setzero_ps();
+	dual = r0 = real;
+	for (int k = 0; k < 4; k++) {
+		__m128 w = k == 0 ? w0 : k == 1 ? w1 : k == 2 ? w2 : w3;
+		const dquat *a = &palette[inf[0].index[k]];
+		const dquat *b = &palette[inf[1].index[k]];
+		const dquat *c = &palette[inf[2].index[k]];
+		const dquat *e = &palette[inf[3].index[k]];
+		quat_soa rk = {a->real, b->real, c->real, e->real};
+		quat_soa dk = {a->dual, b->dual, c->dual, e->dual};
+		_MM_TRANSPOSE4_PS(rk.x, rk.y, rk.z, rk.w);
+		_MM_TRANSPOSE4_PS(dk.x, dk.y, dk.z, dk.w);
+		if (k == 0)
+			r0 = rk;
+		w = _mm_xor_ps(w, _mm_and_ps(quat_soa_dot(r0, rk), sign));
+		real.x = _mm_add_ps(real.x, _mm_mul_ps(rk.x, w));
+		real.y = _mm_add_ps(real.y, _mm_mul_ps(rk.y, w));
+		real.z = _mm_add_ps(real.z, _mm_mul_ps(rk.z, w));
+		real.w = _mm_add_ps(real.w, _mm_mul_ps(rk.w, w));
+		dual.x = _mm_add_ps(dual.x, _mm_mul_ps(dk.x, w));
+		dual.y = _mm_add_ps(dual.y, _mm_mul_ps(dk.y, w));
+		dual.z = _mm_add_ps(dual.z, _mm_mul_ps(dk.z, w));
+		dual.w = _mm_add_ps(dual.w, _mm_mul_ps(dk.w, w));
+	}
+
+	/* normalize; the translation below ignores the non-orthogonal part */
+	__m128 n = rsqrt_ps(quat_soa_dot(real, real));
+	real.x = _mm_mul_ps(real.x, n);
+	real.y = _mm_mul_ps(real.y, n);
+	real.z = _mm_mul_ps(real.z, n);
+	real.w = _mm_mul_ps(real.w, n);
+	dual.x = _mm_mul_ps(dual.x, n);
+	dual.y = _mm_mul_ps(dual.y, n);
+	dual.z = _mm_mul_ps(dual.z, n);
+	dual.w = _mm_mul_ps(dual.w, n);
+
+	/* t = 2 (w_r d - w_d r + r x d) */
+	vec3_soa rv = {real.x, real.y, real.z};
+	vec3_soa dv = {dual.x, dual.y, dual.z};
+	vec3_soa t = vec3_soa_cross(rv, dv);
+	t.x = _mm_add_ps(t.x, _mm_sub_ps(_mm_mul_ps(real.w, dual.x),
+		_mm_mul_ps(dual.w, real.x)));
+	t.y = _mm_add_ps(t.y, _mm_sub_ps(_mm_mul_ps(real.w, dual.y),
+		_mm_mul_ps(dual.w, real.y)));
+	t.z = _mm_add_ps(t.z, _mm_sub_ps(_mm_mul_ps(real.w, dual.z),
+		_mm_mul_ps(dual.w, real.z)));
+
+	vec3_soa p = quat_soa_rotate_vec3(real, vec3_soa_load(pos));
+	__m128 pw = _mm_set1_ps(1.0f);
+	p.x = _mm_add_ps(p.x, _mm_add_ps(t.x, t.x));
+	p.y = _mm_add_ps(p.y, _mm_add_ps(t.y, t.y));
+	p.z = _mm_add_ps(p.z, _mm_add_ps(t.z, t.z));
+	_MM_TRANSPOSE4_PS(p.x, p.y, p.z, pw);
+	out_pos[0] = p.x;
+	out_pos[1] = p.y;
+	out_pos[2] = p.z;
+	out_pos[3] = pw;
+
+	if (nrm)
+		vec3_soa_store(out_nrm, quat_soa_rotate_vec3(real,
+			vec3_soa_load(nrm)));
+	if (tan) {
+		quat_soa ts = quat_soa_load(tan);
+		vec3_soa tv = {ts.x, ts.y, ts.z};
+		tv = quat_soa_rotate_vec3(real, tv);
+		ts.x = tv.x;
+		ts.y = tv.y;
+		ts.z = tv.z;
+		quat_soa_store(out_tan, ts);
+	}
+}
+#endif
+
+#ifdef __AVX__
+/** Rotates the x, y, z lanes of eight vectors by eight unit quaternions. */
+static inline quat_soa8 skin_rotate8(const quat_soa8 q, const quat_soa8 v)
+{
+	quat_soa8 t, out;
+	t.x = _mm256_sub_ps(_mm256_mul_ps(q.y, v.z), _mm256_mul_ps(q.z, v.y));
+	t.y = _mm256_sub_ps(_mm256_mul_ps(q.z, v.x), _mm256_mul_ps(q.x, v.z));
+	t.z = _mm256_sub_ps(_mm256_mul_ps(q.x, v.y), _mm256_mul_ps(q.y, v.x));
+	t.x = _mm256_add_ps(t.x, t.x);
+	t.y = _mm256_add_ps(t.y, t.y);
+	t.z = _mm256_add_ps(t.z, t.z);
+	out.x = _mm256_add_ps(_mm256_add_ps(v.x, _mm256_mul_ps(q.w, t.x)),
+		_mm256_sub_ps(_mm256_mul_ps(q.y, t.z), _mm256_mul_ps(q.z, t.y)));
+	out.y = _mm256_add_ps(_mm256_add_ps(v.y, _mm256_mul_ps(q.w, t.y)),
+		_mm256_sub_ps(_mm256_mul_ps(q.z, t.x), _mm256_mul_ps(q.x, t.z)));
+	out.z = _mm256_add_ps(_mm256_add_ps(v.z, _mm256_mul_ps(q.w, t.z)),
+		_mm256_sub_ps(_mm256_mul_ps(q.x, t.y), _mm256_mul_ps(q.y, t.x)));
+	out.w = v.w;
+	return out;
+}
+
+/**
+ * Eight wide skin_dqs4.  Each dual quaternion fills one AVX register,
+ * so an 8x8 transpose gathers the influences of eight vertices.
+ */
+static inline void skin_dqs8(vec3 *out_pos, vec3 *out_nrm, vec4 *out_tan,
+		const dquat *palette, const skin_influence *inf,
+		const vec3 *pos, const vec3 *nrm, const vec4 *tan)
+{
+	__m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+	__m256 w[4], r[8], t[8];
+	quat_soa8 real, dual, r0;
+
+	for (int v = 0; v < 4; v++)
+		w[v] = _mm256_insertf128_ps(_mm256_castps128_ps256(
+			_mm_loadu_ps(inf[v].weight)), _mm_loadu_ps(inf[v + 4].weight), 1);
+	t[0] = _mm256_unpacklo_ps(w[0], w[1]);
+	t[1] = _mm256_unpackhi_ps(w[0], w[1]);
+	t[2] = _mm256_unpacklo_ps(w[2], w[3]);
+	t[3] = _mm256_unpackhi_ps(w[2], w[3]);
+	w[0] = _mm256_shuffle_ps(t[0], t[2], _MM_SHUFFLE(1,0,1,0));
+	w[1] = _mm256_shuffle_ps(t[0], t[2], _MM_SHUFFLE(3,2,3,2));
+	w[2] = _mm256_shuffle_ps(t[1], t[3], _MM_SHUFFLE(1,0,1,0));
+	w[3] = _mm256_shuffle_ps(t[1], t[3], _MM_SHUFFLE(3,2,3,2));
+	real.x = real.y = real.z = real.w = _mm256_setzero_ps();
+	dual = r0 = real;
+
+	for (int k = 0; k < 4; k++) {
+		for (int v = 0; v < 8; v++)
+			r[v] = _mm256_loadu_ps((const float *)
+				&palette[inf[v].index[k]]);
+		for (int v = 0; v < 8; v += 2) {
+			t[v] = _mm256_unpacklo_ps(r[v], r[v + 1]);
+			t[v + 1] = _mm256_unpackhi_ps(r[v], r[v + 1]);
+		}
+		for (int v = 0; v < 8; v += 4) {
+			r[v] = _mm256_shuffle_ps(t[v], t[v + 2], _MM_SHUFFLE(1,0,1,0));
+			r[v + 1] = _mm256_shuffle_ps(t[v], t[v + 2], _MM_SHUFFLE(3,2,3,2));
+			r[v + 2] = _mm256_shuffle_ps(t[v + 1], t[v + 3], _MM_SHUFFLE(1,0,1,0));
+			r[v + 3] = _mm256_shuffle_ps(t[v + 1], t[v + 3], _MM_SHUFFLE(3,2,3,2));
+		}
+		/* r[0..3] hold vertices 0-3 and r[4..7] vertices 4-7, by lane */
+		quat_soa8 rk = {_mm256_permute2f128_ps(r[0], r[4], 0x20),
+			_mm256_permute2f128_ps(r[1], r[5], 0x20),
+			_mm256_permute2f128_ps(r[2], r[6], 0x20),
+			_mm256_permute2f128_ps(r[3], r[7], 0x20)};
+		quat_soa8 dk = {_mm256_permute2f128_ps(r[0], r[4], 0x31),
+			_mm256_permute2f128_ps(r[1], r[5], 0x31),
+			_mm256_permute2f128_ps(r[2], r[6], 0x31),
+			_mm256_permute2f128_ps(r[3], r[7], 0x31)};
+		if (k == 0)
+			r0 = rk;
+		__m256 wk = _mm256_xor_ps(w[k],
+			_mm256_and_ps(quat_soa8_dot(r0, rk), sign));
+		real.x = _mm256_add_ps(real.x, _mm256_mul_ps(rk.x, wk));
+		real.y = _mm256_add_ps(real.y, _mm256_mul_ps(rk.y, wk));
+		real.z = _mm256_add_ps(real.z, _mm256_mul_ps(rk.z, wk));
+		real.w = _mm256_add_ps(real.w, _mm256_mul_ps(rk.w, wk));
+		dual.x = _mm256_add_ps(dual.x, _mm256_mul_ps(dk.x, wk));
+		dual.y = _mm256_add_ps(dual.y, _mm256_mul_ps(dk.y, wk));
+		dual.z = _mm256_add_ps(dual.z, _mm256_mul_ps(dk.z, wk));
+		dual.w = _mm256_add_ps(dual.w, _mm256_mul_ps(dk.w, wk));
+	}
+
+	__m256 d = quat_soa8_dot(real, real);
+	__m256 n = _mm256_rsqrt_ps(d);
+	n = _mm256_mul_ps(n, _mm256_sub_ps(_mm256_set1_ps(1.5f),
+		_mm256_mul_ps(_mm256_mul_ps(d, _mm256_set1_ps(0.5f)),
+			_mm256_mul_ps(n, n))));
+	real.x = _mm256_mul_ps(real.x, n);
+	real.y = _mm256_mul_ps(real.y, n);
+	real.z = _mm256_mul_ps(real.z, n);
+	real.w = _mm256_mul_ps(real.w, n);
+	/* scaled by 2n, giving the translation directly */
+	n = _mm256_add_ps(n, n);
+	dual.x = _mm256_mul_ps(dual.x, n);
+	dual.y = _mm256_mul_ps(dual.y, n);
+	dual.z = _mm256_mul_ps(dual.z, n);
+	dual.w = _mm256_mul_ps(dual.w, n);
+
+	quat_soa8 p = skin_rotate8(real, quat_soa8_load(pos));
+	p.x = _mm256_add_ps(p.x, _mm256_add_ps(
+		_mm256_sub_ps(_mm256_mul_ps(real.w, dual.x), _mm256_mul_ps(dual.w, real.x)),
+		_mm256_sub_ps(_mm256_mul_ps(real.y, dual.z), _mm256_mul_ps(real.z, dual.y))));
+	p.y = _mm256_add_ps(p.y, _mm256_add_ps(
+		_mm256_sub_ps(_mm256_mul_ps(real.w, dual.y), _mm256_mul_ps(dual.w, real.y)),
+		_mm256_sub_ps(_mm256_mul_ps(real.z, dual.x), _mm256_mul_ps(real.x, dual.z))));
+	p.z = _mm256_add_ps(p.z, _mm256_add_ps(
+		_mm256_sub_ps(_mm256_mul_ps(real.w, dual.z), _mm256_mul_ps(dual.w, real.z)),
+		_mm256_sub_ps(_mm256_mul_ps(real.x, dual.y), _mm256_mul_ps(real.y, dual.x))));
+	p.w = _mm256_set1_ps(1.0f);
+	quat_soa8_store(out_pos, p);
+
+	if (nrm) {
+		quat_soa8 q = skin_rotate8(real, quat_soa8_load(nrm));
+		q.w = _mm256_setzero_ps();
+		quat_soa8_store(out_nrm, q);
+	}
+	if (tan)
+		quat_soa8_store(out_tan, skin_rotate8(real, quat_soa8_load(tan)));
+}
+#endif
+
+/**
+ * Dual quaternion skinning of count vertices, avoiding the volume
+ * loss of linear blending at twisting joints.  The streams are as for
+ * skin_lbs, the palette holds rigid bone transforms.  As from skin_lbs,
+ * positions come out with w 1 and normals with w 0, whatever the input
+ * w, on every vector width.
+ */
+static inline void skin_dqs(vec3 *out_pos, vec3 *out_nrm, vec4 *out_tan,
+		const dquat *palette, const skin_influence *inf,
+		const vec3 *pos, const vec3 *nrm, const vec4 *tan, int count)
+{
+	int i = 0;
+#ifdef __AVX__
+	for (; i + 8 <= count; i += 8)
+		skin_dqs8(out_pos + i, nrm ? out_nrm + i : NULL,
+			tan ? out_tan + i : NULL, palette, inf + i, pos + i,
+			nrm ? nrm + i : NULL, tan ? tan + i : NULL);
+#endif
+#ifdef __SSE__
+	for (; i + 4 <= count; i += 4)
+		skin_dqs4(out_pos + i, nrm ? out_nrm + i : NULL,
+			tan ? out_tan + i : NULL, palette, inf + i, pos + i,
+			nrm ? nrm + i : NULL, tan ? tan + i : NULL);
+#endif
+	for (; i < count; i++) {
+		dquat dq = skin_blend_dquat(palette, &inf[i]);
+#ifdef __SSE__
+		vec3 p = dquat_transform_point(dq, pos[i]);
+		out_pos[i] = _mm_shuffle_ps(p, _mm_unpackhi_ps(p,
+			_mm_set1_ps(1.0f)), _MM_SHUFFLE(3,0,1,0));
+		if (nrm)
+			out_nrm[i] = _mm_and_ps(dquat_transform_normal(dq, nrm[i]),
+				_mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)));
+#else
+		out_pos[i] = dquat_transform_point(dq, pos[i]);
+		out_pos[i][3] = 1.0f;
+		if (nrm) {
+			out_nrm[i] = dquat_transform_normal(dq, nrm[i]);
+			out_nrm[i][3] = 0.0f;
+		}
+#endif
+		if (tan) {
+#ifdef __SSE__
+			vec4 t = dquat_transform_normal(dq, tan[i]);
+			out_tan[i] = _mm_shuffle_ps(t,
+				_mm_unpackhi_ps(t, tan[i]), _MM_SHUFFLE(3,0,1,0));
+#else
+			out_tan[i] = dquat_transform_normal(dq, tan[i]);
+			out_tan[i][3] = tan[i][3];
+#endif
+		}
+	}
+}
+
+/**
+ * Converts a palette of rigid bone matrices for skin_dqs.
+ */
+static inline void skin_dquat_palette(dquat *out, const mat4 *palette,
+		int count)
+{
+	for (int i = 0; i < count; i++)
+		out[i] = dquat_from_mat4(palette[i]);
+}
+
+#endif /* _GMATH_SKIN_H_ */
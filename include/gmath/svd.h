@@ -0,0 +1,811 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * svd.h
+ * Handles 3x3 symmetric eigen and singular value decompositions
+ *
+ */
+
+#ifndef _GMATH_SVD_H_
+#define _GMATH_SVD_H_
+
+#include <float.h>
+#include <string.h>
+#include "constants.h"
+#include "cephes/rsqrt.h"
+#include "quat.h"
+
+#ifdef __SSE__
+
+/**
+ * After McAdams et al., "Computing the Singular Value Decomposition of
+ * 3x3 matrices with minimal branching and elementary floating point
+ * operations".  A fixed number of Jacobi sweeps with approximate Givens
+ * rotations accumulated in a quaternion, then a Givens QR, so that all
+ * lanes run the same instructions.  Matrices are float[3][3], row major,
+ * and are scaled to unit norm first so results do not depend on units.
+ */
+
+/* Sweeps of the three Jacobi rotations, five reach float precision. */
+#ifndef SVD3_SWEEPS
+#define SVD3_SWEEPS 5
+#endif
+
+/* 3 + sqrt(8), past this the half angle is clamped to pi / 8. */
+#define SVD3_GAMMA 5.8284271247f
+#define SVD3_CSTAR 0.9238795325f
+#define SVD3_SSTAR 0.3826834324f
+
+/* QR columns shorter than this, relative to the norm, are left alone. */
+#define SVD3_EPSILON 1e-12f
+
+/**
+ * Off diagonal terms below this, relative to the norm, are zeroed
+ * instead of rotated.  Converged lanes would otherwise keep squaring
+ * them down into denormals, which cost far more than the whole sweep.
+ */
+#define SVD3_TINY 1e-15f
+
+static inline __m128 svd3_select(const __m128 mask, const __m128 a,
+		const __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/* Four float[3][3] into structure of arrays form. */
+static inline mat3_soa mat3_soa_load(const float (*a)[3][3])
+{
+	const float *f = &a[0][0][0];
+	mat3_soa out;
+	__m128 *e = &out.m[0][0];
+	for (int i = 0; i < 8; i += 4) {
+		__m128 r0 = _mm_loadu_ps(f + i), r1 = _mm_loadu_ps(f + 9 + i);
+		__m128 r2 = _mm_loadu_ps(f + 18 + i), r3 = _mm_loadu_ps(f + 27 + i);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		e[i] = r0;
+		e[i + 1] = r1;
+		e[i + 2] = r2;
+		e[i + 3] = r3;
+	}
+	e[8] = _mm_setr_ps(f[8], f[17], f[26], f[35]);
+	return out;
+}
+
+static inline void mat3_soa_store(float (*a)[3][3], const mat3_soa *m)
+{
+	float *f = &a[0][0][0], t[4];
+	const __m128 *e = &m->m[0][0];
+	for (int i = 0; i < 8; i += 4) {
+		__m128 r0 = e[i], r1 = e[i + 1], r2 = e[i + 2], r3 = e[i + 3];
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(f + i, r0);
+		_mm_storeu_ps(f + 9 + i, r1);
+		_mm_storeu_ps(f + 18 + i, r2);
+		_mm_storeu_ps(f + 27 + i, r3);
+	}
+	_mm_storeu_ps(t, e[8]);
+	for (int j = 0; j < 4; j++)
+		f[9 * j + 8] = t[j];
+}
+
+/* One float[3][3] in every lane. */
+static inline mat3_soa mat3_soa_set1(const float a[3][3])
+{
+	mat3_soa out;
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+			out.m[r][c] = _mm_set1_ps(a[r][c]);
+	return out;
+}
+
+static inline void svd3_soa_store_vec3(float (*out)[3], const vec3_soa v)
+{
+	float t[3][4];
+	_mm_storeu_ps(t[0], v.x);
+	_mm_storeu_ps(t[1], v.y);
+	_mm_storeu_ps(t[2], v.z);
+	for (int i = 0; i < 4; i++)
+		for (int k = 0; k < 3; k++)
+			out[i][k] = t[k][i];
+}
+
+/* q = q * (sh along axis k, ch), with p and q following k. */
+static inline void svd3_soa_qmul(__m128 *qk, __m128 *qp, __m128 *qq,
+		__m128 *qw, const __m128 ch, const __m128 sh)
+{
+	__m128 k = *qk, p = *qp, q = *qq, w = *qw;
+	*qk = _mm_add_ps(_mm_mul_ps(ch, k), _mm_mul_ps(sh, w));
+	*qp = _mm_add_ps(_mm_mul_ps(ch, p), _mm_mul_ps(sh, q));
+	*qq = _mm_sub_ps(_mm_mul_ps(ch, q), _mm_mul_ps(sh, p));
+	*qw = _mm_sub_ps(_mm_mul_ps(ch, w), _mm_mul_ps(sh, k));
+}
+
+/**
+ * One rotation of the symmetric s in its (p, q) plane, about the third
+ * axis k.  tan of the half angle is taken as s_pq / 2(s_pp - s_qq),
+ * which is poor for large angles, so those get pi / 8 instead.
+ */
+static inline void svd3_soa_jacobi(__m128 *spp, __m128 *sqq, __m128 *spq,
+		__m128 *spk, __m128 *sqk, __m128 *qk, __m128 *qp, __m128 *qq,
+		__m128 *qw)
+{
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(SIGN_MASK));
+	__m128 flat = _mm_cmplt_ps(_mm_andnot_ps(sign, *spq),
+		_mm_set1_ps(SVD3_TINY));
+	__m128 ch = _mm_mul_ps(_mm_set1_ps(2.0f), _mm_sub_ps(*spp, *sqq));
+	__m128 sh = _mm_andnot_ps(flat, *spq), ch2 = _mm_mul_ps(ch, ch);
+	__m128 sh2 = _mm_mul_ps(sh, sh);
+	__m128 b = _mm_cmplt_ps(_mm_mul_ps(_mm_set1_ps(SVD3_GAMMA), sh2), ch2);
+	__m128 w = rsqrt_ps(_mm_add_ps(ch2, sh2));
+	__m128 c, s, cc, ss, cs, pp = *spp, pq, qq2 = *sqq, pk = *spk;
+
+	ch = svd3_select(b, _mm_mul_ps(w, ch), _mm_set1_ps(SVD3_CSTAR));
+	sh = svd3_select(b, _mm_mul_ps(w, sh), _mm_set1_ps(SVD3_SSTAR));
+	ch = svd3_select(flat, _mm_set1_ps(1.0f), ch);
+	sh = _mm_andnot_ps(flat, sh);
+	c = _mm_sub_ps(_mm_mul_ps(ch, ch), _mm_mul_ps(sh, sh));
+	s = _mm_mul_ps(_mm_add_ps(ch, ch), sh);
+	cc = _mm_mul_ps(c, c);
+	ss = _mm_mul_ps(s, s);
+	cs = _mm_mul_ps(c, s);
+
+	/* s = r^T s r with r_pp = r_qq = c, r_qp = -r_pq = s */
+	pq = _mm_mul_ps(_mm_add_ps(cs, cs), *spq);
+	*spp = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cc, pp), pq),
+		_mm_mul_ps(ss, qq2));
+	*sqq = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(ss, pp), _mm_mul_ps(cc, qq2)),
+		pq);
+	*spq = _mm_andnot_ps(flat, _mm_add_ps(_mm_mul_ps(cs, _mm_sub_ps(qq2, pp)),
+		_mm_mul_ps(_mm_sub_ps(cc, ss), *spq)));
+	*spk = _mm_add_ps(_mm_mul_ps(c, pk), _mm_mul_ps(s, *sqk));
+	*sqk = _mm_sub_ps(_mm_mul_ps(c, *sqk), _mm_mul_ps(s, pk));
+	svd3_soa_qmul(qk, qp, qq, qw, ch, sh);
+}
+
+/**
+ * Diagonalises the symmetric s, held as 00, 11, 22, 01, 02, 12, and
+ * returns the rotation that does it.
+ */
+static inline quat_soa svd3_soa_eigen(__m128 s[6])
+{
+	quat_soa q;
+	q.x = q.y = q.z = _mm_setzero_ps();
+	q.w = _mm_set1_ps(1.0f);
+	for (int i = 0; i < SVD3_SWEEPS; i++) {
+		svd3_soa_jacobi(&s[0], &s[1], &s[3], &s[4], &s[5],
+			&q.z, &q.x, &q.y, &q.w);
+		svd3_soa_jacobi(&s[1], &s[2], &s[5], &s[3], &s[4],
+			&q.x, &q.y, &q.z, &q.w);
+		svd3_soa_jacobi(&s[2], &s[0], &s[4], &s[5], &s[3],
+			&q.y, &q.z, &q.x, &q.w);
+	}
+	return q;
+}
+
+static inline void svd3_soa_quat_to_mat3(mat3_soa *m, const quat_soa q)
+{
+	quat_soa n = quat_soa_normalize(q);
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 x2 = _mm_add_ps(n.x, n.x), y2 = _mm_add_ps(n.y, n.y);
+	__m128 z2 = _mm_add_ps(n.z, n.z);
+	__m128 xx = _mm_mul_ps(n.x, x2), yy = _mm_mul_ps(n.y, y2);
+	__m128 zz = _mm_mul_ps(n.z, z2), xy = _mm_mul_ps(n.x, y2);
+	__m128 xz = _mm_mul_ps(n.x, z2), yz = _mm_mul_ps(n.y, z2);
+	__m128 wx = _mm_mul_ps(n.w, x2), wy = _mm_mul_ps(n.w, y2);
+	__m128 wz = _mm_mul_ps(n.w, z2);
+	m->m[0][0] = _mm_sub_ps(one, _mm_add_ps(yy, zz));
+	m->m[0][1] = _mm_sub_ps(xy, wz);
+	m->m[0][2] = _mm_add_ps(xz, wy);
+	m->m[1][0] = _mm_add_ps(xy, wz);
+	m->m[1][1] = _mm_sub_ps(one, _mm_add_ps(xx, zz));
+	m->m[1][2] = _mm_sub_ps(yz, wx);
+	m->m[2][0] = _mm_sub_ps(xz, wy);
+	m->m[2][1] = _mm_add_ps(yz, wx);
+	m->m[2][2] = _mm_sub_ps(one, _mm_add_ps(xx, yy));
+}
+
+/* Where mask is set, column j moves to i and minus column i to j. */
+static inline void svd3_soa_swap(const __m128 mask, mat3_soa *m, int i, int j)
+{
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(SIGN_MASK));
+	for (int r = 0; r < 3; r++) {
+		__m128 a = m->m[r][i], b = m->m[r][j];
+		m->m[r][i] = svd3_select(mask, b, a);
+		m->m[r][j] = svd3_select(mask, _mm_xor_ps(a, sign), b);
+	}
+}
+
+/* Orders k descending, moving the columns of m and n along with it. */
+static inline void svd3_soa_sort(__m128 k[3], mat3_soa *m, mat3_soa *n)
+{
+	static const int pair[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+	for (int i = 0; i < 3; i++) {
+		int a = pair[i][0], b = pair[i][1];
+		__m128 mask = _mm_cmplt_ps(k[a], k[b]), t = k[a];
+		k[a] = svd3_select(mask, k[b], t);
+		k[b] = svd3_select(mask, t, k[b]);
+		svd3_soa_swap(mask, m, a, b);
+		if (n)
+			svd3_soa_swap(mask, n, a, b);
+	}
+}
+
+/**
+ * Half angle of the Givens rotation taking (a1, a2) to (|a|, 0).  The
+ * quadrant is flipped for a1 < 0 so that nothing cancels.
+ */
+static inline void svd3_soa_givens(const __m128 a1, const __m128 a2,
+		__m128 *ch, __m128 *sh)
+{
+	__m128 eps = _mm_set1_ps(SVD3_EPSILON);
+	__m128 sign = _mm_castsi128_ps(_mm_set1_epi32(SIGN_MASK));
+	__m128 rho = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(a1, a1),
+		_mm_mul_ps(a2, a2)));
+	__m128 s = _mm_and_ps(_mm_cmpgt_ps(rho, eps), a2);
+	__m128 c = _mm_add_ps(_mm_andnot_ps(sign, a1), _mm_max_ps(rho, eps));
+	__m128 neg = _mm_cmplt_ps(a1, _mm_setzero_ps());
+	__m128 t = svd3_select(neg, s, c), w;
+	s = svd3_select(neg, c, s);
+	w = rsqrt_ps(_mm_add_ps(_mm_mul_ps(t, t), _mm_mul_ps(s, s)));
+	*ch = _mm_mul_ps(t, w);
+	*sh = _mm_mul_ps(s, w);
+}
+
+/* Rows p and q of b through the transpose of the Givens (ch, sh). */
+static inline void svd3_soa_rows(mat3_soa *b, int p, int q, const __m128 ch,
+		const __m128 sh)
+{
+	__m128 c = _mm_sub_ps(_mm_mul_ps(ch, ch), _mm_mul_ps(sh, sh));
+	__m128 s = _mm_mul_ps(_mm_add_ps(ch, ch), sh);
+	for (int j = 0; j < 3; j++) {
+		__m128 bp = b->m[p][j], bq = b->m[q][j];
+		b->m[p][j] = _mm_add_ps(_mm_mul_ps(c, bp), _mm_mul_ps(s, bq));
+		b->m[q][j] = _mm_sub_ps(_mm_mul_ps(c, bq), _mm_mul_ps(s, bp));
+	}
+}
+
+/* Norm of a, clamped away from zero, and its reciprocal. */
+static inline __m128 svd3_soa_norm(const mat3_soa *a, __m128 *rcp)
+{
+	__m128 f = _mm_setzero_ps();
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+			f = _mm_add_ps(f, _mm_mul_ps(a->m[r][c], a->m[r][c]));
+	f = _mm_sqrt_ps(_mm_max_ps(f, _mm_set1_ps(FLT_MIN)));
+	*rcp = _mm_div_ps(_mm_set1_ps(1.0f), f);
+	return f;
+}
+
+/**
+ * Eigenvectors of four symmetric matrices as the columns of v, a
+ * rotation, with the eigenvalues in l from largest to smallest.  Only
+ * the upper triangle of a is read.
+ */
+static inline void eig3_sym_soa(mat3_soa *v, vec3_soa *l, const mat3_soa *a)
+{
+	__m128 s[6], k, n = svd3_soa_norm(a, &k);
+	s[0] = _mm_mul_ps(a->m[0][0], k);
+	s[1] = _mm_mul_ps(a->m[1][1], k);
+	s[2] = _mm_mul_ps(a->m[2][2], k);
+	s[3] = _mm_mul_ps(a->m[0][1], k);
+	s[4] = _mm_mul_ps(a->m[0][2], k);
+	s[5] = _mm_mul_ps(a->m[1][2], k);
+	svd3_soa_quat_to_mat3(v, svd3_soa_eigen(s));
+	s[0] = _mm_mul_ps(s[0], n);
+	s[1] = _mm_mul_ps(s[1], n);
+	s[2] = _mm_mul_ps(s[2], n);
+	svd3_soa_sort(s, v, NULL);
+	l->x = s[0];
+	l->y = s[1];
+	l->z = s[2];
+}
+
+/**
+ * a = u diag(s) v^T for four matrices with u and v rotations.  The
+ * values are ordered by size and only s.z can be negative, taking the
+ * sign of the determinant, so that a reflection never hides in u or v.
+ */
+static inline void svd3_soa(mat3_soa *u, vec3_soa *s, mat3_soa *v,
+		const mat3_soa *a)
+{
+	mat3_soa b, t;
+	__m128 k, n = svd3_soa_norm(a, &k), m[6], rho[3], ch, sh;
+	quat_soa q;
+
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+			b.m[r][c] = _mm_mul_ps(a->m[r][c], k);
+
+	/* v from the eigenvectors of b^T b */
+	for (int i = 0; i < 6; i++) {
+		static const int ij[6][2] = {{0, 0}, {1, 1}, {2, 2}, {0, 1},
+			{0, 2}, {1, 2}};
+		int c0 = ij[i][0], c1 = ij[i][1];
+		m[i] = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(b.m[0][c0], b.m[0][c1]),
+			_mm_mul_ps(b.m[1][c0], b.m[1][c1])),
+			_mm_mul_ps(b.m[2][c0], b.m[2][c1]));
+	}
+	svd3_soa_quat_to_mat3(v, svd3_soa_eigen(m));
+
+	/* b v has orthogonal columns, sort them by length */
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+			t.m[r][c] = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(b.m[r][0], v->m[0][c]),
+				_mm_mul_ps(b.m[r][1], v->m[1][c])),
+				_mm_mul_ps(b.m[r][2], v->m[2][c]));
+	for (int c = 0; c < 3; c++)
+		rho[c] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(t.m[0][c], t.m[0][c]),
+			_mm_mul_ps(t.m[1][c], t.m[1][c])),
+			_mm_mul_ps(t.m[2][c], t.m[2][c]));
+	svd3_soa_sort(rho, &t, v);
+
+	/* QR by Givens leaves u in q and diag(s) on the diagonal */
+	svd3_soa_givens(t.m[0][0], t.m[1][0], &ch, &sh);
+	svd3_soa_rows(&t, 0, 1, ch, sh);
+	q.x = q.y = _mm_setzero_ps();
+	q.z = sh;
+	q.w = ch;
+	svd3_soa_givens(t.m[0][0], t.m[2][0], &ch, &sh);
+	svd3_soa_rows(&t, 0, 2, ch, sh);
+	svd3_soa_qmul(&q.y, &q.z, &q.x, &q.w, ch,
+		_mm_xor_ps(sh, _mm_castsi128_ps(_mm_set1_epi32(SIGN_MASK))));
+	svd3_soa_givens(t.m[1][1], t.m[2][1], &ch, &sh);
+	svd3_soa_rows(&t, 1, 2, ch, sh);
+	svd3_soa_qmul(&q.x, &q.y, &q.z, &q.w, ch, sh);
+	svd3_soa_quat_to_mat3(u, q);
+
+	s->x = _mm_mul_ps(t.m[0][0], n);
+	s->y = _mm_mul_ps(t.m[1][1], n);
+	s->z = _mm_mul_ps(t.m[2][2], n);
+}
+
+/**
+ * Rotation part r = u v^T of the polar decomposition of four matrices,
+ * the closest rotation to each even when it has a reflection.
+ */
+static inline void polar3_soa(mat3_soa *r, const mat3_soa *a)
+{
+	mat3_soa u, v;
+	vec3_soa s;
+	svd3_soa(&u, &s, &v, a);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			r->m[i][j] = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(u.m[i][0], v.m[j][0]),
+				_mm_mul_ps(u.m[i][1], v.m[j][1])),
+				_mm_mul_ps(u.m[i][2], v.m[j][2]));
+}
+
+#ifdef __AVX__
+static inline __m256 svd3_select8(const __m256 mask, const __m256 a,
+		const __m256 b)
+{
+	return _mm256_blendv_ps(b, a, mask);
+}
+
+static inline __m256 svd3_rsqrt8(const __m256 x)
+{
+	__m256 r = _mm256_rsqrt_ps(x);
+	return _mm256_mul_ps(r, _mm256_sub_ps(_mm256_set1_ps(1.5f),
+		_mm256_mul_ps(_mm256_mul_ps(x, _mm256_set1_ps(0.5f)),
+			_mm256_mul_ps(r, r))));
+}
+
+static inline mat3_soa8 mat3_soa8_load(const float (*a)[3][3])
+{
+	mat3_soa lo = mat3_soa_load(a), hi = mat3_soa_load(a + 4);
+	mat3_soa8 out;
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+			out.m[r][c] = _mm256_insertf128_ps(
+				_mm256_castps128_ps256(lo.m[r][c]), hi.m[r][c], 1);
+	return out;
+}
+
+static inline void mat3_soa8_store(float (*a)[3][3], const mat3_soa8 *m)
+{
+	mat3_soa lo, hi;
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++) {
+			lo.m[r][c] = _mm256_castps256_ps128(m->m[r][c]);
+			hi.m[r][c] = _mm256_extractf128_ps(m->m[r][c], 1);
+		}
+	mat3_soa_store(a, &lo);
+	mat3_soa_store(a + 4, &hi);
+}
+
+static inline void svd3_soa8_store_vec3(float (*out)[3], const vec3_soa8 v)
+{
+	vec3_soa lo, hi;
+	lo.x = _mm256_castps256_ps128(v.x);
+	lo.y = _mm256_castps256_ps128(v.y);
+	lo.z = _mm256_castps256_ps128(v.z);
+	hi.x = _mm256_extractf128_ps(v.x, 1);
+	hi.y = _mm256_extractf128_ps(v.y, 1);
+	hi.z = _mm256_extractf128_ps(v.z, 1);
+	svd3_soa_store_vec3(out, lo);
+	svd3_soa_store_vec3(out + 4, hi);
+}
+
+static inline void svd3_soa8_qmul(__m256 *qk, __m256 *qp, __m256 *qq,
+		__m256 *qw, const __m256 ch, const __m256 sh)
+{
+	__m256 k = *qk, p = *qp, q = *qq, w = *qw;
+	*qk = _mm256_add_ps(_mm256_mul_ps(ch, k), _mm256_mul_ps(sh, w));
+	*qp = _mm256_add_ps(_mm256_mul_ps(ch, p), _mm256_mul_ps(sh, q));
+	*qq = _mm256_sub_ps(_mm256_mul_ps(ch, q), _mm256_mul_ps(sh, p));
+	*qw = _mm256_sub_ps(_mm256_mul_ps(ch, w), _mm256_mul_ps(sh, k));
+}
+
+static inline void svd3_soa8_jacobi(__m256 *spp, __m256 *sqq, __m256 *spq,
+		__m256 *spk, __m256 *sqk, __m256 *qk, __m256 *qp, __m256 *qq,
+		__m256 *qw)
+{
+	__m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32(SIGN_MASK));
+	__m256 flat = _mm256_cmp_ps(_mm256_andnot_ps(sign, *spq),
+		_mm256_set1_ps(SVD3_TINY), _CMP_LT_OQ);
+	__m256 ch = _mm256_mul_ps(_mm256_set1_ps(2.0f),
+		_mm256_sub_ps(*spp, *sqq));
+	__m256 sh = _mm256_andnot_ps(flat, *spq), ch2 = _mm256_mul_ps(ch, ch);
+	__m256 sh2 = _mm256_mul_ps(sh, sh);
+	__m256 b = _mm256_cmp_ps(_mm256_mul_ps(_mm256_set1_ps(SVD3_GAMMA), sh2),
+		ch2, _CMP_LT_OQ);
+	__m256 w = svd3_rsqrt8(_mm256_add_ps(ch2, sh2));
+	__m256 c, s, cc, ss, cs, pp = *spp, pq, qq2 = *sqq, pk = *spk;
+
+	ch = svd3_select8(b, _mm256_mul_ps(w, ch), _mm256_set1_ps(SVD3_CSTAR));
+	sh = svd3_select8(b, _mm256_mul_ps(w, sh), _mm256_set1_ps(SVD3_SSTAR));
+	ch = svd3_select8(flat, _mm256_set1_ps(1.0f), ch);
+	sh = _mm256_andnot_ps(flat, sh);
+	c = _mm256_sub_ps(_mm256_mul_ps(ch, ch), _mm256_mul_ps(sh, sh));
+	s = _mm256_mul_ps(_mm256_add_ps(ch, ch), sh);
+	cc = _mm256_mul_ps(c, c);
+	ss = _mm256_mul_ps(s, s);
+	cs = _mm256_mul_ps(c, s);
+
+	pq = _mm256_mul_ps(_mm256_add_ps(cs, cs), *spq);
+	*spp = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cc, pp), pq),
+		_mm256_mul_ps(ss, qq2));
+	*sqq = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(ss, pp),
+		_mm256_mul_ps(cc, qq2)), pq);
+	*spq = _mm256_andnot_ps(flat, _mm256_add_ps(_mm256_mul_ps(cs,
+		_mm256_sub_ps(qq2, pp)), _mm256_mul_ps(_mm256_sub_ps(cc, ss), *spq)));
+	*spk = _mm256_add_ps(_mm256_mul_ps(c, pk), _mm256_mul_ps(s, *sqk));
+	*sqk = _mm256_sub_ps(_mm256_mul_ps(c, *sqk), _mm256_mul_ps(s, pk));
+	svd3_soa8_qmul(qk, qp, qq, qw, ch, sh);
+}
+
+static inline quat_soa8 svd3_soa8_eigen(__m256 s[6])
+{
+	quat_soa8 q;
+	q.x = q.y = q.z = _mm256_setzero_ps();
+	q.w = _mm256_set1_ps(1.0f);
+	for (int i = 0; i < SVD3_SWEEPS; i++) {
+		svd3_soa8_jacobi(&s[0], &s[1], &s[3], &s[4], &s[5],
+			&q.z, &q.x, &q.y, &q.w);
+		svd3_soa8_jacobi(&s[1], &s[2], &s[5], &s[3], &s[4],
+			&q.x, &q.y, &q.z, &q.w);
+		svd3_soa8_jacobi(&s[2], &s[0], &s[4], &s[5], &s[3],
+			&q.y, &q.z, &q.x, &q.w);
+	}
+	return q;
+}
+
+static inline void svd3_soa8_quat_to_mat3(mat3_soa8 *m, const quat_soa8 q)
+{
+	quat_soa8 n = quat_soa8_normalize(q);
+	__m256 one = _mm256_set1_ps(1.0f);
+	__m256 x2 = _mm256_add_ps(n.x, n.x), y2 = _mm256_add_ps(n.y, n.y);
+	__m256 z2 = _mm256_add_ps(n.z, n.z);
+	__m256 xx = _mm256_mul_ps(n.x, x2), yy = _mm256_mul_ps(n.y, y2);
+	__m256 zz = _mm256_mul_ps(n.z, z2), xy = _mm256_mul_ps(n.x, y2);
+	__m256 xz = _mm256_mul_ps(n.x, z2), yz = _mm256_mul_ps(n.y, z2);
+	__m256 wx = _mm256_mul_ps(n.w, x2), wy = _mm256_mul_ps(n.w, y2);
+	__m256 wz = _mm256_mul_ps(n.w, z2);
+	m->m[0][0] = _mm256_sub_ps(one, _mm256_add_ps(yy, zz));
+	m->m[0][1] = _mm256_sub_ps(xy, wz);
+	m->m[0][2] = _mm256_add_ps(xz, wy);
+	m->m[1][0] = _mm256_add_ps(xy, wz);
+	m->m[1][1] = _mm256_sub_ps(one, _mm256_add_ps(xx, zz));
+	m->m[1][2] = _mm256_sub_ps(yz, wx);
+	m->m[2][0] = _mm256_sub_ps(xz, wy);
+	m->m[2][1] = _mm256_add_ps(yz, wx);
+	m->m[2][2] = _mm256_sub_ps(one, _mm256_add_ps(xx, yy));
+}
+
+static inline void svd3_soa8_swap(const __m256 mask, mat3_soa8 *m, int i,
+		int j)
+{
+	__m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32(SIGN_MASK));
+	for (int r = 0; r < 3; r++) {
+		__m256 a = m->m[r][i], b = m->m[r][j];
+		m->m[r][i] = svd3_select8(mask, b, a);
+		m->m[r][j] = svd3_select8(mask, _mm256_xor_ps(a, sign), b);
+	}
+}
+
+static inline void svd3_soa8_sort(__m256 k[3], mat3_soa8 *m, mat3_soa8 *n)
+{
+	static const int pair[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+	for (int i = 0; i < 3; i++) {
+		int a = pair[i][0], b = pair[i][1];
+		__m256 mask = _mm256_cmp_ps(k[a], k[b], _CMP_LT_OQ), t = k[a];
+		k[a] = svd3_select8(mask, k[b], t);
+		k[b] = svd3_select8(mask, t, k[b]);
+		svd3_soa8_swap(mask, m, a, b);
+		if (n)
+			svd3_soa8_swap(mask, n, a, b);
+	}
+}
+
+static inline void svd3_soa8_givens(const __m256 a1, const __m256 a2,
+		__m256 *ch, __m256 *sh)
+{
+	__m256 eps = _mm256_set1_ps(SVD3_EPSILON);
+	__m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32(SIGN_MASK));
+	__m256 rho = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(a1, a1),
+		_mm256_mul_ps(a2, a2)));
+	__m256 s = _mm256_and_ps(_mm256_cmp_ps(rho, eps, _CMP_GT_OQ), a2);
+	__m256 c = _mm256_add_ps(_mm256_andnot_ps(sign, a1),
+		_mm256_max_ps(rho, eps));
+	__m256 neg = _mm256_cmp_ps(a1, _mm256_setzero_ps(), _CMP_LT_OQ);
+	__m256 t = svd3_select8(neg, s, c), w;
+	s = svd3_select8(neg, c, s);
+	w = svd3_rsqrt8(_mm256_add_ps(_mm256_mul_ps(t, t), _mm256_mul_ps(s, s)));
+	*ch = _mm256_mul_ps(t, w);
+	*sh = _mm256_mul_ps(s, w);
+}
+
+static inline void svd3_soa8_rows(mat3_soa8 *b, int p, int q,
+		const __m256 ch, const __m256 sh)
+{
+	__m256 c = _mm256_sub_ps(_mm256_mul_ps(ch, ch), _mm256_mul_ps(sh, sh));
+	__m256 s = _mm256_mul_ps(_mm256_add_ps(ch, ch), sh);
+	for (int j = 0; j < 3; j++) {
+		__m256 bp = b->m[p][j], bq = b->m[q][j];
+		b->m[p][j] = _mm256_add_ps(_mm256_mul_ps(c, bp),
+			_mm256_mul_ps(s, bq));
+		b->m[q][j] = _mm256_sub_ps(_mm256_mul_ps(c, bq),
+			_mm256_mul_ps(s, bp));
+	}
+}
+
+static inline __m256 svd3_soa8_norm(const mat3_soa8 *a, __m256 *rcp)
+{
+	__m256 f = _mm256_setzero_ps();
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+			f = _mm256_add_ps(f, _mm256_mul_ps(a->m[r][c], a->m[r][c]));
+	f = _mm256_sqrt_ps(_mm256_max_ps(f, _mm256_set1_ps(FLT_MIN)));
+	*rcp = _mm256_div_ps(_mm256_set1_ps(1.0f), f);
+	return f;
+}
+
+static inline void eig3_sym_soa8(mat3_soa8 *v, vec3_soa8 *l,
+		const mat3_soa8 *a)
+{
+	__m256 s[6], k, n = svd3_soa8_norm(a, &k);
+	s[0] = _mm256_mul_ps(a->m[0][0], k);
+	s[1] = _mm256_mul_ps(a->m[1][1], k);
+	s[2] = _mm256_mul_ps(a->m[2][2], k);
+	s[3] = _mm256_mul_ps(a->m[0][1], k);
+	s[4] = _mm256_mul_ps(a->m[0][2], k);
+	s[5] = _mm256_mul_ps(a->m[1][2], k);
+	svd3_soa8_quat_to_mat3(v, svd3_soa8_eigen(s));
+	s[0] = _mm256_mul_ps(s[0], n);
+	s[1] = _mm256_mul_ps(s[1], n);
+	s[2] = _mm256_mul_ps(s[2], n);
+	svd3_soa8_sort(s, v, NULL);
+	l->x = s[0];
+	l->y = s[1];
+	l->z = s[2];
+}
+
+static inline void svd3_soa8(mat3_soa8 *u, vec3_soa8 *s, mat3_soa8 *v,
+		const mat3_soa8 *a)
+{
+	mat3_soa8 b, t;
+	__m256 k, n = svd3_soa8_norm(a, &k), m[6], rho[3], ch, sh;
+	quat_soa8 q;
+
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+			b.m[r][c] = _mm256_mul_ps(a->m[r][c], k);
+	for (int i = 0; i < 6; i++) {
+		static const int ij[6][2] = {{0, 0}, {1, 1}, {2, 2}, {0, 1},
+			{0, 2}, {1, 2}};
+		int c0 = ij[i][0], c1 = ij[i][1];
+		m[i] = _mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(b.m[0][c0], b.m[0][c1]),
+			_mm256_mul_ps(b.m[1][c0], b.m[1][c1])),
+			_mm256_mul_ps(b.m[2][c0], b.m[2][c1]));
+	}
+	svd3_soa8_quat_to_mat3(v, svd3_soa8_eigen(m));
+
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+			t.m[r][c] = _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(b.m[r][0], v->m[0][c]),
+				_mm256_mul_ps(b.m[r][1], v->m[1][c])),
+				_mm256_mul_ps(b.m[r][2], v->m[2][c]));
+	for (int c = 0; c < 3; c++)
+		rho[c] = _mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(t.m[0][c], t.m[0][c]),
+			_mm256_mul_ps(t.m[1][c], t.m[1][c])),
+			_mm256_mul_ps(t.m[2][c], t.m[2][c]));
+	svd3_soa8_sort(rho, &t, v);
+
+	svd3_soa8_givens(t.m[0][0], t.m[1][0], &ch, &sh);
+	svd3_soa8_rows(&t, 0, 1, ch, sh);
+	q.x = q.y = _mm256_setzero_ps();
+	q.z = sh;
+	q.w = ch;
+	svd3_soa8_givens(t.m[0][0], t.m[2][0], &ch, &sh);
+	svd3_soa8_rows(&t, 0, 2, ch, sh);
+	svd3_soa8_qmul(&q.y, &q.z, &q.x, &q.w, ch, _mm256_xor_ps(sh,
+		_mm256_castsi256_ps(_mm256_set1_epi32(SIGN_MASK))));
+	svd3_soa8_givens(t.m[1][1], t.m[2][1], &ch, &sh);
+	svd3_soa8_rows(&t, 1, 2, ch, sh);
+	svd3_soa8_qmul(&q.x, &q.y, &q.z, &q.w, ch, sh);
+	svd3_soa8_quat_to_mat3(u, q);
+
+	s->x = _mm256_mul_ps(t.m[0][0], n);
+	s->y = _mm256_mul_ps(t.m[1][1], n);
+	s->z = _mm256_mul_ps(t.m[2][2], n);
+}
+
+static inline void polar3_soa8(mat3_soa8 *r, const mat3_soa8 *a)
+{
+	mat3_soa8 u, v;
+	vec3_soa8 s;
+	svd3_soa8(&u, &s, &v, a);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			r->m[i][j] = _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(u.m[i][0], v.m[j][0]),
+				_mm256_mul_ps(u.m[i][1], v.m[j][1])),
+				_mm256_mul_ps(u.m[i][2], v.m[j][2]));
+}
+#endif
+
+/* Single matrix forms, running the four lane kernels on one lane. */
+static inline void eig3_sym(float v[3][3], float l[3], const float a[3][3])
+{
+	mat3_soa m = mat3_soa_set1(a), mv;
+	vec3_soa ml;
+	eig3_sym_soa(&mv, &ml, &m);
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+			v[r][c] = _mm_cvtss_f32(mv.m[r][c]);
+	l[0] = _mm_cvtss_f32(ml.x);
+	l[1] = _mm_cvtss_f32(ml.y);
+	l[2] = _mm_cvtss_f32(ml.z);
+}
+
+static inline void svd3(float u[3][3], float s[3], float v[3][3],
+		const float a[3][3])
+{
+	mat3_soa m = mat3_soa_set1(a), mu, mv;
+	vec3_soa ms;
+	svd3_soa(&mu, &ms, &mv, &m);
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++) {
+			u[r][c] = _mm_cvtss_f32(mu.m[r][c]);
+			v[r][c] = _mm_cvtss_f32(mv.m[r][c]);
+		}
+	s[0] = _mm_cvtss_f32(ms.x);
+	s[1] = _mm_cvtss_f32(ms.y);
+	s[2] = _mm_cvtss_f32(ms.z);
+}
+
+static inline void polar3(float r[3][3], const float a[3][3])
+{
+	mat3_soa m = mat3_soa_set1(a), mr;
+	polar3_soa(&mr, &m);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			r[i][j] = _mm_cvtss_f32(mr.m[i][j]);
+}
+
+/**
+ * Batched forms.  Eight or four matrices go through the lane kernels
+ * at a time and the last few are padded out with zero matrices.
+ */
+static inline void eig3_sym_array(float (*v)[3][3], float (*l)[3],
+		const float (*a)[3][3], int count)
+{
+	float pa[4][3][3] = {{{0}}}, pv[4][3][3], pl[4][3];
+	mat3_soa m, mv;
+	vec3_soa ml;
+	int i = 0;
+#ifdef __AVX__
+	for (; i + 8 <= count; i += 8) {
+		mat3_soa8 m8 = mat3_soa8_load(a + i), mv8;
+		vec3_soa8 ml8;
+		eig3_sym_soa8(&mv8, &ml8, &m8);
+		mat3_soa8_store(v + i, &mv8);
+		svd3_soa8_store_vec3(l + i, ml8);
+	}
+#endif
+	for (; i < count; i += 4) {
+		int n = count - i < 4 ? count - i : 4;
+		if (n < 4) {
+			memcpy(pa, a + i, sizeof(pa[0]) * n);
+			m = mat3_soa_load((const float (*)[3][3])pa);
+		} else
+			m = mat3_soa_load(a + i);
+		eig3_sym_soa(&mv, &ml, &m);
+		mat3_soa_store(pv, &mv);
+		svd3_soa_store_vec3(pl, ml);
+		memcpy(v + i, pv, sizeof(pv[0]) * n);
+		memcpy(l + i, pl, sizeof(pl[0]) * n);
+	}
+}
+
+static inline void svd3_array(float (*u)[3][3], float (*s)[3],
+		float (*v)[3][3], const float (*a)[3][3], int count)
+{
+	float pa[4][3][3] = {{{0}}}, pu[4][3][3], pv[4][3][3], ps[4][3];
+	mat3_soa m, mu, mv;
+	vec3_soa ms;
+	int i = 0;
+#ifdef __AVX__
+	for (; i + 8 <= count; i += 8) {
+		mat3_soa8 m8 = mat3_soa8_load(a + i), mu8, mv8;
+		vec3_soa8 ms8;
+		svd3_soa8(&mu8, &ms8, &mv8, &m8);
+		mat3_soa8_store(u + i, &mu8);
+		mat3_soa8_store(v + i, &mv8);
+		svd3_soa8_store_vec3(s + i, ms8);
+	}
+#endif
+	for (; i < count; i += 4) {
+		int n = count - i < 4 ? count - i : 4;
+		if (n < 4) {
+			memcpy(pa, a + i, sizeof(pa[0]) * n);
+			m = mat3_soa_load((const float (*)[3][3])pa);
+		} else
+			m = mat3_soa_load(a + i);
+		svd3_soa(&mu, &ms, &mv, &m);
+		mat3_soa_store(pu, &mu);
+		mat3_soa_store(pv, &mv);
+		svd3_soa_store_vec3(ps, ms);
+		memcpy(u + i, pu, sizeof(pu[0]) * n);
+		memcpy(v + i, pv, sizeof(pv[0]) * n);
+		memcpy(s + i, ps, sizeof(ps[0]) * n);
+	}
+}
+
+static inline void polar3_array(float (*r)[3][3], const float (*a)[3][3],
+		int count)
+{
+	float pa[4][3][3] = {{{0}}}, pr[4][3][3];
+	mat3_soa m, mr;
+	int i = 0;
+#ifdef __AVX__
+	for (; i + 8 <= count; i += 8) {
+		mat3_soa8 m8 = mat3_soa8_load(a + i), mr8;
+		polar3_soa8(&mr8, &m8);
+		mat3_soa8_store(r + i, &mr8);
+	}
+#endif
+	for (; i < count; i += 4) {
+		int n = count - i < 4 ? count - i : 4;
+		if (n < 4) {
+			memcpy(pa, a + i, sizeof(pa[0]) * n);
+			m = mat3_soa_load((const float (*)[3][3])pa);
+		} else
+			m = mat3_soa_load(a + i);
+		polar3_soa(&mr, &m);
+		mat3_soa_store(pr, &mr);
+		memcpy(r + i, pr, sizeof(pr[0]) * n);
+	}
+}
+
+#endif
+
+#endif /* _GMATH_SVD_H_ */
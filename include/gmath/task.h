@@ -0,0 +1,23 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * task.h
+ * Handles splitting work into ranges for threaded builders
+ *
+ */
+
+#ifndef _GMATH_TASK_H_
+#define _GMATH_TASK_H_
+
+/**
+ * First item of task t of tasks over count items.  Task t covers
+ * task_first(count, tasks, t) up to task_first(count, tasks, t + 1).
+ */
+static inline int task_first(int count, int tasks, int t)
+{
+	return (int)((long long)count * t / tasks);
+}
+
+#endif /* _GMATH_TASK_H_ */
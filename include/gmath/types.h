@@ -19,6 +19,10 @@
 #include <emmintrin.h>
 #endif
 
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
 #include "constants.h"
 
 #ifndef __SSE__
@@ -45,4 +49,134 @@ typedef float[4] vec4;
 typedef vec4 vec3;
 typedef vec4 quat;
 
+/**
+ * Dual quaternion real + e dual, representing a rigid transform.
+ */
+typedef struct {
+	quat real;
+	quat dual;
+} dquat;
+
+/**
+ * Axis aligned box, w lanes are ignored.  An empty box has min above
+ * max so that merging anything into it gives that thing.
+ */
+typedef struct {
+	vec3 min;
+	vec3 max;
+} aabb;
+
+/**
+ * Oriented box: the centre, three orthonormal axes and the half size
+ * along each, w lanes are ignored.
+ */
+typedef struct {
+	vec3 center;
+	vec3 axis[3];
+	vec3 half;
+} obb;
+
+/**
+ * Six planes (nx, ny, nz, d) with normals pointing inwards, a point p
+ * is inside a plane when n.p + d >= 0.  Ordered left, right, bottom,
+ * top, near, far.
+ */
+typedef struct {
+	vec4 plane[6];
+} frustum;
+
+/* Ray with origin and direction, w lanes are ignored. */
+typedef struct {
+	vec3 origin;
+	vec3 dir;
+} ray;
+
+/**
+ * Ray prepared for slab tests, sign[i] is 1 where the direction is
+ * negative and selects which bound of each axis is entered first.
+ */
+typedef struct {
+	vec3 origin;
+	vec3 inv_dir;
+	int sign[3];
+} ray_slab;
+
+/**
+ * Smallest three compressed unit quaternions.  The largest component
+ * is dropped and rebuilt from the other three, its index is kept in
+ * two bits.  quat32 stores 10 bits per component, quat48 stores 15.
+ */
+typedef unsigned int quat32;
+
+typedef struct {
+	unsigned short v[3];
+} quat48;
+
+#ifdef __SSE__
+/* Four 3d vectors in structure of arrays form. */
+typedef struct {
+	__m128 x, y, z;
+} vec3_soa;
+
+/* Four rays in structure of arrays form. */
+typedef struct {
+	vec3_soa origin, dir;
+} ray_soa;
+
+/* Four rays prepared for slab tests, neg is all ones where dir < 0. */
+typedef struct {
+	vec3_soa origin, inv_dir, neg;
+} ray_slab_soa;
+
+/* Four boxes in structure of arrays form. */
+typedef struct {
+	vec3_soa min, max;
+} aabb_soa;
+
+/* Four triangles as a vertex and the two edges leaving it. */
+typedef struct {
+	vec3_soa v0, e1, e2;
+} tri_soa;
+
+/**
+ * Four quaternions in structure of arrays form, each register
+ * holds one component of all four quaternions.
+ */
+typedef struct {
+	__m128 x, y, z, w;
+} quat_soa;
+
+/* Four 3x3 matrices in structure of arrays form, m[row][column]. */
+typedef struct {
+	__m128 m[3][3];
+} mat3_soa;
+#endif
+
+#ifdef __AVX__
+/* Eight 3d vectors in structure of arrays form. */
+typedef struct {
+	__m256 x, y, z;
+} vec3_soa8;
+
+/* Eight quaternions in structure of arrays form. */
+typedef struct {
+	__m256 x, y, z, w;
+} quat_soa8;
+
+/* Eight boxes in structure of arrays form. */
+typedef struct {
+	vec3_soa8 min, max;
+} aabb_soa8;
+
+/* Eight triangles as a vertex and two edges. */
+typedef struct {
+	vec3_soa8 v0, e1, e2;
+} tri_soa8;
+
+/* Eight 3x3 matrices in structure of arrays form. */
+typedef struct {
+	__m256 m[3][3];
+} mat3_soa8;
+#endif
+
 #endif /* _GMATH_TYPES_H_ */
@@ -57,6 +57,23 @@ static inline vec3 vec3_cross(const vec3 v1, const vec3 v2)
 	return v;
 }
 
+/**
+ * A unit vector perpendicular to the unit n with no branches, after
+ * Duff et al., "Building an orthonormal basis, revisited".
+ */
+static inline vec3 vec3_perp(const vec3 n)
+{
+	float x = fidx(n, 0), y = fidx(n, 1), z = fidx(n, 2);
+	float sign = copysignf(1.0f, z), a = -1.0f / (sign + z);
+#ifndef __SSE__
+	vec3 v = {1.0f + sign * x * x * a, sign * x * y * a, -sign * x};
+	return v;
+#else
+	return _mm_setr_ps(1.0f + sign * x * x * a, sign * x * y * a,
+		-sign * x, 0.0f);
+#endif
+}
+
 static inline m128_float vec3_dot_m128(const vec3 v1, const vec3 v2)
 {
 #ifndef __SSE__
@@ -67,9 +84,176 @@ static inline m128_float vec3_dot_m128(const vec3 v1, const vec3 v2)
 	__m128 xy = _mm_add_ss(xyzw, yxwz);
 	__m128 zzww = _mm_unpackhi_ps(xyzw, xyzw);
 	__m128 ___r = _mm_add_ss(xy, zzww);
-	__m128 rrrr = _mm_shuffle_ps(___r, ___r, _MM_SHUFFLE(3,3,3,3));
+	__m128 rrrr = _mm_shuffle_ps(___r, ___r, _MM_SHUFFLE(0,0,0,0));
 	return rrrr;
 #endif
 }
 
+#ifdef __SSE__
+/**
+ * Transposes four 3d vectors into structure of arrays form.
+ */
+static inline vec3_soa vec3_soa_load(const vec3 *v)
+{
+	vec3_soa out;
+	__m128 w = v[3];
+	out.x = v[0];
+	out.y = v[1];
+	out.z = v[2];
+	_MM_TRANSPOSE4_PS(out.x, out.y, out.z, w);
+	return out;
+}
+
+/**
+ * Transposes four 3d vectors in structure of arrays form back into
+ * four vectors, the w components are cleared.
+ */
+static inline void vec3_soa_store(vec3 *v, vec3_soa s)
+{
+	__m128 w = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(s.x, s.y, s.z, w);
+	v[0] = s.x;
+	v[1] = s.y;
+	v[2] = s.z;
+	v[3] = w;
+}
+
+static inline __m128 vec3_soa_dot(const vec3_soa v1, const vec3_soa v2)
+{
+	__m128 x = _mm_mul_ps(v1.x, v2.x);
+	__m128 y = _mm_mul_ps(v1.y, v2.y);
+	__m128 z = _mm_mul_ps(v1.z, v2.z);
+	return _mm_add_ps(_mm_add_ps(x, y), z);
+}
+
+static inline vec3_soa vec3_soa_cross(const vec3_soa v1, const vec3_soa v2)
+{
+	vec3_soa v;
+	v.x = _mm_sub_ps(_mm_mul_ps(v1.y, v2.z), _mm_mul_ps(v1.z, v2.y));
+	v.y = _mm_sub_ps(_mm_mul_ps(v1.z, v2.x), _mm_mul_ps(v1.x, v2.z));
+	v.z = _mm_sub_ps(_mm_mul_ps(v1.x, v2.y), _mm_mul_ps(v1.y, v2.x));
+	return v;
+}
+
+static inline vec3_soa vec3_soa_add(const vec3_soa v1, const vec3_soa v2)
+{
+	vec3_soa v;
+	v.x = _mm_add_ps(v1.x, v2.x);
+	v.y = _mm_add_ps(v1.y, v2.y);
+	v.z = _mm_add_ps(v1.z, v2.z);
+	return v;
+}
+
+static inline vec3_soa vec3_soa_sub(const vec3_soa v1, const vec3_soa v2)
+{
+	vec3_soa v;
+	v.x = _mm_sub_ps(v1.x, v2.x);
+	v.y = _mm_sub_ps(v1.y, v2.y);
+	v.z = _mm_sub_ps(v1.z, v2.z);
+	return v;
+}
+
+static inline vec3_soa vec3_soa_scale(const vec3_soa v, const __m128 s)
+{
+	vec3_soa out;
+	out.x = _mm_mul_ps(v.x, s);
+	out.y = _mm_mul_ps(v.y, s);
+	out.z = _mm_mul_ps(v.z, s);
+	return out;
+}
+
+/* Lanes of a where mask is set and of b elsewhere. */
+static inline vec3_soa vec3_soa_select(const __m128 mask, const vec3_soa a,
+		const vec3_soa b)
+{
+	vec3_soa out;
+	out.x = _mm_or_ps(_mm_and_ps(mask, a.x), _mm_andnot_ps(mask, b.x));
+	out.y = _mm_or_ps(_mm_and_ps(mask, a.y), _mm_andnot_ps(mask, b.y));
+	out.z = _mm_or_ps(_mm_and_ps(mask, a.z), _mm_andnot_ps(mask, b.z));
+	return out;
+}
+
+/* vec3_perp of four vectors. */
+static inline vec3_soa vec3_soa_perp(const vec3_soa n)
+{
+	__m128 sign = _mm_or_ps(_mm_set1_ps(1.0f), _mm_and_ps(n.z,
+		_mm_castsi128_ps(_mm_set1_epi32(SIGN_MASK))));
+	__m128 a = _mm_div_ps(_mm_set1_ps(-1.0f), _mm_add_ps(sign, n.z));
+	__m128 sx = _mm_mul_ps(sign, n.x);
+	vec3_soa out;
+	out.x = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_mul_ps(sx, n.x), a));
+	out.y = _mm_mul_ps(_mm_mul_ps(sx, n.y), a);
+	out.z = _mm_sub_ps(_mm_setzero_ps(), sx);
+	return out;
+}
+
+/* Broadcasts one 3d vector to all lanes. */
+static inline vec3_soa vec3_soa_splat(const vec3 v)
+{
+	vec3_soa out;
+	out.x = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0,0,0,0));
+	out.y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1,1,1,1));
+	out.z = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2,2,2,2));
+	return out;
+}
+#endif
+
+#ifdef __AVX__
+static inline vec3_soa8 vec3_soa8_load(const vec3 *v)
+{
+	vec3_soa lo = vec3_soa_load(v), hi = vec3_soa_load(v + 4);
+	vec3_soa8 out;
+	out.x = _mm256_insertf128_ps(_mm256_castps128_ps256(lo.x), hi.x, 1);
+	out.y = _mm256_insertf128_ps(_mm256_castps128_ps256(lo.y), hi.y, 1);
+	out.z = _mm256_insertf128_ps(_mm256_castps128_ps256(lo.z), hi.z, 1);
+	return out;
+}
+
+static inline void vec3_soa8_store(vec3 *v, const vec3_soa8 s)
+{
+	vec3_soa lo = {_mm256_castps256_ps128(s.x), _mm256_castps256_ps128(s.y),
+		_mm256_castps256_ps128(s.z)};
+	vec3_soa hi = {_mm256_extractf128_ps(s.x, 1),
+		_mm256_extractf128_ps(s.y, 1), _mm256_extractf128_ps(s.z, 1)};
+	vec3_soa_store(v, lo);
+	vec3_soa_store(v + 4, hi);
+}
+
+static inline __m256 vec3_soa8_dot(const vec3_soa8 v1, const vec3_soa8 v2)
+{
+	__m256 x = _mm256_mul_ps(v1.x, v2.x);
+	__m256 y = _mm256_mul_ps(v1.y, v2.y);
+	__m256 z = _mm256_mul_ps(v1.z, v2.z);
+	return _mm256_add_ps(_mm256_add_ps(x, y), z);
+}
+
+static inline vec3_soa8 vec3_soa8_cross(const vec3_soa8 v1, const vec3_soa8 v2)
+{
+	vec3_soa8 v;
+	v.x = _mm256_sub_ps(_mm256_mul_ps(v1.y, v2.z), _mm256_mul_ps(v1.z, v2.y));
+	v.y = _mm256_sub_ps(_mm256_mul_ps(v1.z, v2.x), _mm256_mul_ps(v1.x, v2.z));
+	v.z = _mm256_sub_ps(_mm256_mul_ps(v1.x, v2.y), _mm256_mul_ps(v1.y, v2.x));
+	return v;
+}
+
+static inline vec3_soa8 vec3_soa8_sub(const vec3_soa8 v1, const vec3_soa8 v2)
+{
+	vec3_soa8 v;
+	v.x = _mm256_sub_ps(v1.x, v2.x);
+	v.y = _mm256_sub_ps(v1.y, v2.y);
+	v.z = _mm256_sub_ps(v1.z, v2.z);
+	return v;
+}
+
+static inline vec3_soa8 vec3_soa8_splat(const vec3 v)
+{
+	vec3_soa s = vec3_soa_splat(v);
+	vec3_soa8 out;
+	out.x = _mm256_set_m128(s.x, s.x);
+	out.y = _mm256_set_m128(s.y, s.y);
+	out.z = _mm256_set_m128(s.z, s.z);
+	return out;
+}
+#endif
+
 #endif /* _GMATH_VEC3_H_ */
@@ -39,15 +39,16 @@ static inline float vec4_dot(const vec4 v1, const vec4 v2)
 
 #include "internal/vec.h"
 
+#ifndef __SSE__
 static inline vec4 vec4_swizzle(const vec4 v, int x, int y, int z, int w)
 {
-#ifndef __SSE__
 	return {v[x], v[y], v[z], v[w]};
+}
 #else
-	return _mm_shuffle_ps(v, v,
-			_MM_SHUFFLE((3-x)&3, (3-y)&3, (3-z)&3, (3-w)&3));
+/* _mm_shuffle_ps needs an immediate so this has to be a macro */
+#define vec4_swizzle(v,x,y,z,w) \
+	(_mm_shuffle_ps((v), (v), _MM_SHUFFLE((w)&3, (z)&3, (y)&3, (x)&3)))
 #endif
-}
 
 static inline m128_float vec4_dot_m128(const vec4 v1, const vec4 v2)
 {
@@ -61,7 +62,7 @@ static inline m128_float vec4_dot_m128(const vec4 v1, const vec4 v2)
 	__m128 xy2zw2 = _mm_add_ps(xyzw, yxwz);
 	__m128 zw4 = _mm_unpackhi_ps(xy2zw2, xy2zw2);
 	__m128 ___r = _mm_add_ss(xy2zw2, zw4);
-	__m128 rrrr = _mm_shuffle_ps(___r, ___r, _MM_SHUFFLE(3,3,3,3));
+	__m128 rrrr = _mm_shuffle_ps(___r, ___r, _MM_SHUFFLE(0,0,0,0));
 	return rrrr;
 #endif
 }
@@ -0,0 +1,180 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * xform.h
+ * Handles transform hierarchies updated level by level
+ *
+ */
+
+#ifndef _GMATH_XFORM_H_
+#define _GMATH_XFORM_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include "constants.h"
+#include "mat4.h"
+
+/**
+ * A forest of transforms in breadth first order.  Every parent comes
+ * before its children and the nodes of one depth are contiguous, from
+ * level[d] up to level[d + 1], with siblings next to each other.  Node
+ * data lives in parallel arrays indexed by node.
+ */
+typedef struct {
+	int count;
+	int levels;
+	int *level;
+	int *parent;
+	unsigned char *dirty;
+	mat4 *local;
+	mat4 *world;
+} xform_tree;
+
+static inline void xform_tree_free(xform_tree *tree)
+{
+	free(tree->level);
+	free(tree->parent);
+	free(tree->dirty);
+	free(tree->local);
+	free(tree->world);
+	memset(tree, 0, sizeof(*tree));
+}
+
+/**
+ * Builds a tree from a parent index per node, -1 for roots, in any
+ * order.  Nodes are renumbered breadth first; remap, when not NULL,
+ * receives the new index of each input node.  Locals start as identity
+ * and every node is dirty.  Returns 0 on success, -1 when out of
+ * memory, when a parent is out of range or when the parents form a
+ * cycle.
+ */
+static inline int xform_tree_init(xform_tree *tree, const int *parent,
+		int count, int *remap)
+{
+	mat4 identity = MAT4_IDENTITY;
+	int *first = malloc(sizeof(int) * (count + 1));
+	int *child = malloc(sizeof(int) * (count + 1));
+	int *order = malloc(sizeof(int) * (count + 1));
+	int *index = malloc(sizeof(int) * (count + 1));
+	int head = 0, tail = 0;
+
+	memset(tree, 0, sizeof(*tree));
+	tree->count = count;
+	tree->level = malloc(sizeof(int) * (count + 1));
+	tree->parent = malloc(sizeof(int) * (count + 1));
+	tree->dirty = malloc(count + 1);
+	tree->local = malloc(sizeof(mat4) * (count + 1));
+	tree->world = malloc(sizeof(mat4) * (count + 1));
+	if (!first || !child || !order || !index || !tree->level ||
+			!tree->parent || !tree->dirty || !tree->local || !tree->world)
+		goto fail;
+
+	/* children of each node, grouped by a counting sort on the parent */
+	memset(first, 0, sizeof(int) * (count + 1));
+	for (int i = 0; i < count; i++)
+		if (parent[i] >= count)
+			goto fail;
+	for (int i = 0; i < count; i++)
+		if (parent[i] >= 0)
+			first[parent[i] + 1]++;
+	for (int i = 0; i < count; i++)
+		first[i + 1] += first[i];
+	for (int i = 0; i < count; i++)
+		if (parent[i] >= 0)
+			child[first[parent[i]]++] = i;
+	for (int i = count; i > 0; i--)
+		first[i] = first[i - 1];
+	first[0] = 0;
+
+	for (int i = 0; i < count; i++)
+		if (parent[i] < 0)
+			order[tail++] = i;
+	while (head < tail) {
+		int end = tail;
+		tree->level[tree->levels++] = head;
+		for (; head < end; head++) {
+			int n = order[head];
+			for (int c = first[n]; c < first[n + 1]; c++)
+				order[tail++] = child[c];
+		}
+	}
+	tree->level[tree->levels] = tail;
+	if (tail != count)
+		goto fail;
+
+	for (int i = 0; i < tail; i++)
+		index[order[i]] = i;
+	for (int i = 0; i < tail; i++) {
+		int p = parent[order[i]];
+		tree->parent[i] = p < 0 ? -1 : index[p];
+		tree->local[i] = identity;
+		tree->world[i] = identity;
+	}
+	memset(tree->dirty, 1, count);
+	if (remap)
+		memcpy(remap, index, sizeof(int) * count);
+
+	free(first);
+	free(child);
+	free(order);
+	free(index);
+	return 0;
+
+fail:
+	free(first);
+	free(child);
+	free(order);
+	free(index);
+	xform_tree_free(tree);
+	return -1;
+}
+
+/**
+ * Replaces a local transform and marks its subtree for update.
+ */
+static inline void xform_set_local(xform_tree *tree, int node, const mat4 m)
+{
+	tree->local[node] = m;
+	tree->dirty[node] = 1;
+}
+
+/**
+ * Recomputes the world transforms of nodes first to last - 1 whose
+ * subtree is dirty.  All shallower levels must already be updated, so
+ * threads may split one level and meet at a barrier before the next.
+ */
+static inline void xform_update_range(xform_tree *tree, int first, int last)
+{
+	const int *parent = tree->parent;
+	unsigned char *dirty = tree->dirty;
+
+	for (int i = first; i < last; i++) {
+		int p = parent[i];
+		if (p < 0) {
+			if (dirty[i])
+				tree->world[i] = tree->local[i];
+			continue;
+		}
+		dirty[i] |= dirty[p];
+		if (dirty[i])
+			tree->world[i] = mat4_mul(tree->world[p], tree->local[i]);
+	}
+}
+
+/**
+ * Clears the dirty flags once every level is updated.
+ */
+static inline void xform_tree_clean(xform_tree *tree)
+{
+	memset(tree->dirty, 0, tree->count);
+}
+
+static inline void xform_tree_update(xform_tree *tree)
+{
+	xform_update_range(tree, 0, tree->count);
+	xform_tree_clean(tree);
+}
+
+#endif /* _GMATH_XFORM_H_ */
@@ -11,8 +11,8 @@ solution "gmath"
 	files {
 		"include/gmath/*.h",
 		"include/gmath/internal/*.h",
-		"testing/*.h",
-		"testing/vec.c",
+		"tests/*.h",
+		"tests/vec.c",
 	}
 	
 	configuration "linux"
@@ -36,8 +36,8 @@ solution "gmath"
 		"include/gmath/*.h",
 		"include/gmath/internal/*.h",
 		"include/cephes/*.h",
-		"testing/*.h",
-		"testing/cephes.c",
+		"tests/*.h",
+		"tests/cephes.c",
 	}
 
 	configuration "linux"
@@ -53,3 +53,1028 @@ solution "gmath"
 		defines { "NDEBUG", "USE_SSE2" }
 		flags { "OptimizeSpeed" }
 		targetdir "bin/release"
+
+	project "quat"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/quat.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "mat4"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/mat4.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "skin"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/skin.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_skin"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/skin.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "dquat"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/dquat.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "quatpack"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/quatpack.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "anim"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/anim.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_anim"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/anim.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "xform"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/xform.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_xform"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/xform.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m", "pthread" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "aabb"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/aabb.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "frustum"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/frustum.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_frustum"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/frustum.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "ray"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/ray.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bvh"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/bvh.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_bvh"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/bvh.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m", "pthread" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "sap"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/sap.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_sap"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/sap.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "grid"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/grid.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_grid"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/grid.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m", "pthread" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "morton"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/morton.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_morton"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/morton.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "lbvh"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/lbvh.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_lbvh"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/lbvh.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m", "pthread" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "radix"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/radix.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_radix"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/radix.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m", "pthread" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "gjk"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/gjk.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_gjk"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/gjk.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "obb"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/obb.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_obb"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/obb.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "svd"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/svd.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_svd"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/svd.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_quat"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/quat.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_mat4"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/mat4.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "project"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/project.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_project"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/project.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "occlusion"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"tests/*.h",
+		"tests/occlusion.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_occlusion"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/occlusion.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_aabb"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/aabb.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_quatpack"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/quatpack.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
+
+	project "bench_ray"
+	kind "ConsoleApp"
+	language "C"
+	files {
+		"include/gmath/*.h",
+		"include/gmath/internal/*.h",
+		"include/cephes/*.h",
+		"bench/*.h",
+		"bench/ray.c",
+	}
+
+	configuration "linux"
+		buildoptions { "-std=gnu99" }
+		links { "m" }
+
+	configuration "Debug"
+		defines { "DEBUG", "USE_SSE2" }
+		flags { "Symbols" }
+		targetdir "bin/debug"
+	
+	configuration "Release"
+		defines { "NDEBUG", "USE_SSE2" }
+		flags { "OptimizeSpeed" }
+		targetdir "bin/release"
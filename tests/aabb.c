@@ -0,0 +1,113 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * aabb.c
+ * Tests aabb.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/aabb.h>
+
+#ifdef DBL_EPSILON
+#undef DBL_EPSILON
+#endif
+#define DBL_EPSILON 1e-5
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("aabb")
+	{
+		aabb a, b;
+
+		FCT_SETUP_BGN()
+		{
+			a.min = _mm_setr_ps(-1.0f, -2.0f, -3.0f, 0.0f);
+			a.max = _mm_setr_ps(1.0f, 2.0f, 3.0f, 0.0f);
+			b.min = _mm_setr_ps(0.5f, 1.0f, 2.5f, 0.0f);
+			b.max = _mm_setr_ps(4.0f, 5.0f, 6.0f, 0.0f);
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("aabb_merge")
+		{
+			aabb m = aabb_merge(a, b);
+			aabb e = aabb_merge(aabb_empty(), a);
+			fct_chk_eq_dbl(fidx(m.min, 1), -2.0f);
+			fct_chk_eq_dbl(fidx(m.max, 2), 6.0f);
+			fct_chk_eq_dbl(fidx(e.min, 0), -1.0f);
+			fct_chk_eq_dbl(fidx(e.max, 0), 1.0f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("aabb_contains")
+		{
+			aabb inner = {_mm_setzero_ps(), _mm_set1_ps(0.5f)};
+			fct_chk(aabb_contains(a, _mm_setr_ps(1.0f, -2.0f, 0.0f, 9.0f)));
+			fct_chk(!aabb_contains(a, _mm_setr_ps(0.0f, 0.0f, 3.5f, 0.0f)));
+			fct_chk(aabb_contains_aabb(a, inner));
+			fct_chk(!aabb_contains_aabb(a, b));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("aabb_overlap")
+		{
+			aabb c = {_mm_setr_ps(1.0f, 2.0f, 3.0f, 0.0f),
+				_mm_set1_ps(7.0f)};
+			aabb d = {_mm_setr_ps(1.5f, 0.0f, 0.0f, 0.0f),
+				_mm_set1_ps(7.0f)};
+			fct_chk(aabb_overlap(a, b));
+			fct_chk(aabb_overlap(a, c));
+			fct_chk(!aabb_overlap(a, d));
+			fct_chk(!aabb_overlap(d, a));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("aabb_transform")
+		{
+			mat4 m = mat4_from_angles(0.4f, -0.3f, 1.1f);
+			m.col[3] = _mm_setr_ps(5.0f, -1.0f, 2.0f, 1.0f);
+			aabb t = aabb_transform(m, b), r = aabb_empty();
+			/* the tight bounds of the eight transformed corners */
+			for (int i = 0; i < 8; i++) {
+				vec3 c = _mm_setr_ps(i & 1 ? fidx(b.max, 0) : fidx(b.min, 0),
+					i & 2 ? fidx(b.max, 1) : fidx(b.min, 1),
+					i & 4 ? fidx(b.max, 2) : fidx(b.min, 2), 0.0f);
+				r = aabb_merge_point(r, mat4_transform_point(m, c));
+			}
+			for (int j = 0; j < 3; j++) {
+				fct_chk_eq_dbl(fidx(t.min, j), fidx(r.min, j));
+				fct_chk_eq_dbl(fidx(t.max, j), fidx(r.max, j));
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("aabb_from_points")
+		{
+			vec3 p[11];
+			for (int n = 0; n <= 11; n++) {
+				aabb r = aabb_empty();
+				for (int i = 0; i < n; i++) {
+					p[i] = _mm_setr_ps(sinf(i * 1.7f), i * 0.5f - 2.0f,
+						cosf(i * 2.3f) * i, 1.0f);
+					r = aabb_merge_point(r, p[i]);
+				}
+				aabb t = aabb_from_points(p, n);
+				for (int j = 0; j < 3; j++) {
+					fct_chk_eq_dbl(fidx(t.min, j), fidx(r.min, j));
+					fct_chk_eq_dbl(fidx(t.max, j), fidx(r.max, j));
+				}
+			}
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
@@ -0,0 +1,81 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * anim.c
+ * Tests anim.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/anim.h>
+
+#define TRACKS 7
+#define FRAMES 40
+
+static anim_clip clip;
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("anim")
+	{
+		quat rot[FRAMES * TRACKS];
+		vec3 trans[FRAMES * TRACKS];
+
+		FCT_SETUP_BGN()
+		{
+			for (int f = 0; f < FRAMES; f++)
+				for (int i = 0; i < TRACKS; i++) {
+					rot[f * TRACKS + i] = quat_normalize(_mm_setr_ps(
+						sinf(0.1f * f + i), 0.3f * i - 1.0f,
+						cosf(0.05f * f * i), 1.0f));
+					trans[f * TRACKS + i] = _mm_setr_ps(0.1f * f,
+						i, sinf(0.2f * f) * i, 0.0f);
+				}
+			fct_req(anim_clip_build(&clip, rot, trans, TRACKS, FRAMES,
+				30.0f) == 0);
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+			anim_clip_free(&clip);
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("anim_clip_build")
+		{
+			fct_chk_eq_int(clip.segments, 3);
+			fct_chk(fabsf(anim_clip_duration(&clip) - 1.3f) < 1e-5f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("anim_sample")
+		{
+			quat r[TRACKS];
+			vec3 t[TRACKS];
+			/* keys, segment borders, between keys and past the end */
+			float frame[] = {0.0f, 5.0f, 16.0f, 16.5f, 31.25f, 39.0f, 50.0f};
+			for (int n = 0; n < 7; n++) {
+				float f = frame[n] < FRAMES - 1 ? frame[n] : FRAMES - 1;
+				int k = f < FRAMES - 1 ? (int)f : FRAMES - 2;
+				anim_sample(&clip, frame[n] / 30.0f, r, t);
+				for (int i = 0; i < TRACKS; i++) {
+					quat q = quat_nlerp(rot[k * TRACKS + i],
+						rot[(k + 1) * TRACKS + i], f - k);
+					vec3 p = vec3_lerp(trans[k * TRACKS + i],
+						trans[(k + 1) * TRACKS + i], f - k);
+					float s = vec4_dot(q, r[i]) < 0.0f ? -1.0f : 1.0f;
+					for (int j = 0; j < 4; j++)
+						fct_chk(fabsf(fidx(r[i], j) - s * fidx(q, j)) < 1e-4f);
+					for (int j = 0; j < 3; j++)
+						fct_chk(fabsf(fidx(t[i], j) - fidx(p, j)) < 1e-4f);
+				}
+			}
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
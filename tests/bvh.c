@@ -0,0 +1,222 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * bvh.c
+ * Tests bvh.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/bvh.h>
+
+#define N 700
+#define RAYS 64
+
+#include "bvh_scene.h"
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("bvh")
+	{
+		bvh tree;
+
+		FCT_SETUP_BGN()
+		{
+			make_scene(1, 0.0f);
+			make_rays();
+			bvh_build(&tree, boxes, N);
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+			bvh_free(&tree);
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("bvh_build")
+		{
+			fct_chk_eq_int(tree.count, N);
+			fct_chk(tree.nodes > 0);
+			fct_chk(tree.nodes < N);
+			fct_chk(check_tree(&tree, boxes));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("bvh_build_triangles")
+		{
+			bvh tri;
+			fct_req(bvh_build_triangles(&tri, v0, v1, v2, N) == 0);
+			fct_chk_eq_int(tri.nodes, tree.nodes);
+			for (int i = 0; i < N; i++)
+				fct_chk_eq_int(tri.prim[i], tree.prim[i]);
+			bvh_free(&tri);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("bvh_closest_triangle")
+		{
+			int hits = 0;
+			for (int i = 0; i < RAYS; i++) {
+				float t = -1.0f, u, v, bt = -1.0f;
+				int best = brute_closest(&rays[i], &bt);
+				int p = bvh_closest_triangle(&tree, v0, v1, v2, &rays[i],
+					100.0f, &t, &u, &v);
+				fct_chk_eq_int(p, best);
+				fct_chk_eq_int(bvh_any_triangle(&tree, v0, v1, v2, &rays[i],
+					100.0f), best >= 0);
+				if (best >= 0) {
+					CHK_NEAR(t, bt);
+					hits++;
+					/* nothing in front of the closest hit */
+					fct_chk(!bvh_any_triangle(&tree, v0, v1, v2, &rays[i],
+						t * 0.999f));
+				}
+			}
+			fct_chk(hits > RAYS / 4);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("bvh_closest_triangle4")
+		{
+			for (int i = 0; i < RAYS; i += 4) {
+				int prim[4], mask;
+				float t[4], u[4], v[4];
+				mask = bvh_closest_triangle4(&tree, v0, v1, v2, &rays[i],
+					100.0f, prim, t, u, v);
+				for (int k = 0; k < 4; k++) {
+					float bt = -1.0f;
+					int best = brute_closest(&rays[i + k], &bt);
+					fct_chk_eq_int(prim[k], best);
+					fct_chk_eq_int((mask >> k) & 1, best >= 0);
+					if (best >= 0)
+						CHK_NEAR(t[k], bt);
+				}
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("bvh_closest_aabb")
+		{
+			for (int i = 0; i < RAYS; i++) {
+				ray_slab rs = ray_slab_init(&rays[i]);
+				float t = -1.0f, bt = 50.0f, rt;
+				int best = -1;
+				for (int j = 0; j < N; j++)
+					if (ray_aabb(&rs, &boxes[j], bt, &rt) && rt < bt) {
+						bt = rt;
+						best = j;
+					}
+				int p = bvh_closest_aabb(&tree, boxes, &rays[i], 50.0f, &t);
+				if (p != best)
+					fct_chk(p >= 0 && best >= 0 && t == bt);
+				else if (best >= 0)
+					CHK_NEAR(t, bt);
+				fct_chk_eq_int(bvh_any_aabb(&tree, boxes, &rays[i], 50.0f),
+					best >= 0);
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("bvh_overlap")
+		{
+			int out[N];
+			for (int q = 0; q < 16; q++) {
+				aabb box;
+				int count = 0, found;
+				box.min = _mm_setr_ps(q - 9.0f, -3.0f + q * 0.2f, -4.0f, 0.0f);
+				box.max = vec3_add(box.min, _mm_set1_ps(1.0f + q * 0.5f));
+				for (int j = 0; j < N; j++)
+					count += aabb_overlap(boxes[j], box);
+				found = bvh_overlap(&tree, boxes, box, out, N);
+				fct_chk_eq_int(found, count);
+				for (int j = 0; j < found && j < N; j++)
+					fct_chk(aabb_overlap(boxes[out[j]], box));
+				/* leaf candidates are a superset */
+				fct_chk(bvh_overlap(&tree, NULL, box, out, N) >= count);
+				/* a short buffer still counts everything */
+				fct_chk_eq_int(bvh_overlap(&tree, boxes, box, out, 2), count);
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("bvh_refit")
+		{
+			make_scene(7, 1.5f);
+			bvh_refit_triangles(&tree, v0, v1, v2);
+			fct_chk(check_tree(&tree, boxes));
+			fct_chk(aabb_contains_aabb(tree.bounds,
+				aabb_from_points(v0, N)));
+			for (int i = 0; i < RAYS; i++) {
+				float t = -1.0f, u, v, bt = -1.0f;
+				int best = brute_closest(&rays[i], &bt);
+				fct_chk_eq_int(bvh_closest_triangle(&tree, v0, v1, v2,
+					&rays[i], 100.0f, &t, &u, &v), best);
+				if (best >= 0)
+					CHK_NEAR(t, bt);
+			}
+			bvh_refit(&tree, boxes);
+			fct_chk(check_tree(&tree, boxes));
+			make_scene(1, 0.0f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("bvh_build_task")
+		{
+			bvh_builder b;
+			bvh tasked;
+			fct_req(bvh_build_begin(&b, boxes, N, 8) == 0);
+			fct_chk_eq_int(b.tasks, 8);
+			/* any order, as threads would pick them */
+			for (int t = b.tasks - 1; t >= 0; t--)
+				bvh_build_task(&b, t);
+			fct_req(bvh_build_end(&b, &tasked) == 0);
+			fct_chk(check_tree(&tasked, boxes));
+			for (int i = 0; i < RAYS; i++) {
+				float t = -1.0f, u, v, bt = -1.0f;
+				int best = brute_closest(&rays[i], &bt);
+				fct_chk_eq_int(bvh_closest_triangle(&tasked, v0, v1, v2,
+					&rays[i], 100.0f, &t, &u, &v), best);
+			}
+			bvh_free(&tasked);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("bvh_degenerate")
+		{
+			bvh small;
+			aabb same[40];
+			int out[40];
+			ray r = {{0.5f, 0.5f, 5.0f, 0.0f}, {0.0f, 0.0f, -1.0f, 0.0f}};
+			float t;
+
+			fct_req(bvh_build(&small, boxes, 0) == 0);
+			fct_chk_eq_int(small.nodes, 0);
+			fct_chk_eq_int(bvh_closest_aabb(&small, boxes, &r, 10.0f, &t), -1);
+			fct_chk_eq_int(bvh_overlap(&small, boxes, boxes[0], out, 40), 0);
+			bvh_free(&small);
+
+			/* coincident boxes can only be halved */
+			for (int i = 0; i < 40; i++) {
+				same[i].min = _mm_setzero_ps();
+				same[i].max = _mm_set1_ps(1.0f);
+			}
+			fct_req(bvh_build(&small, same, 40) == 0);
+			fct_chk(check_tree(&small, same));
+			fct_chk_eq_int(bvh_overlap(&small, same, same[0], out, 40), 40);
+			fct_chk(bvh_closest_aabb(&small, same, &r, 10.0f, &t) >= 0);
+			CHK_NEAR(t, 4.0f);
+			bvh_free(&small);
+
+			fct_req(bvh_build(&small, boxes, 1) == 0);
+			fct_chk_eq_int(small.nodes, 1);
+			fct_chk(check_tree(&small, boxes));
+			bvh_free(&small);
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
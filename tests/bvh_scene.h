@@ -0,0 +1,90 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * bvh_scene.h
+ * Scene and checks shared by the bvh.h and lbvh.h tests, which define
+ * N triangles and RAYS rays before including it
+ *
+ */
+
+#ifndef _GMATH_TESTS_BVH_SCENE_H_
+#define _GMATH_TESTS_BVH_SCENE_H_
+
+#include <gmath/bvh.h>
+
+#define CHK_NEAR(a, b) fct_chk(fabsf((a) - (b)) <= 1e-4f * (1.0f + fabsf(b)))
+
+static vec3 v0[N], v1[N], v2[N];
+static aabb boxes[N];
+static ray rays[RAYS];
+
+/* Triangles of five sizes around a ball, and their boxes. */
+static void make_scene(unsigned int seed, float shift)
+{
+	for (int i = 0; i < N; i++) {
+		float f = (float)i;
+		vec3 c = _mm_setr_ps(sinf(f * 1.7f + seed) * 8.0f + shift,
+			cosf(f * 0.9f) * 8.0f, sinf(f * 0.31f + 1.0f) * 8.0f, 0.0f);
+		float s = 0.2f + 0.6f * (i % 5);
+		v0[i] = _mm_add_ps(c, _mm_setr_ps(-s, -0.5f * s, 0.1f * s, 0.0f));
+		v1[i] = _mm_add_ps(c, _mm_setr_ps(s, -0.3f * s, -0.2f * s, 0.0f));
+		v2[i] = _mm_add_ps(c, _mm_setr_ps(0.2f * s, s, 0.3f * s, 0.0f));
+	}
+	bvh_triangle_boxes(boxes, v0, v1, v2, N);
+}
+
+/* Rays from a ring around the scene towards its middle. */
+static void make_rays(void)
+{
+	for (int i = 0; i < RAYS; i++) {
+		float a = i * 0.37f, b = i * 0.11f;
+		rays[i].origin = _mm_setr_ps(cosf(a) * 20.0f, sinf(b) * 5.0f,
+			sinf(a) * 20.0f, 0.0f);
+		rays[i].dir = vec3_normalize(vec3_sub(_mm_setr_ps(
+			sinf(i * 1.3f) * 4.0f, 0.0f, cosf(i * 0.7f) * 4.0f, 0.0f),
+			rays[i].origin));
+	}
+	/* axis aligned directions exercise the infinite inverses */
+	rays[0].dir = _mm_setr_ps(-1.0f, 0.0f, 0.0f, 0.0f);
+	rays[1].dir = _mm_setr_ps(0.0f, 0.0f, -1.0f, 0.0f);
+}
+
+/* Every primitive sits in exactly one leaf, inside every box above it. */
+static int check_tree(const bvh *tree, const aabb *b)
+{
+	static int seen[N];
+	int ok = 1;
+	memset(seen, 0, sizeof(seen));
+	for (int k = 0; k < tree->nodes; k++) {
+		const bvh_node *node = &tree->node[k];
+		for (int i = 0; i < BVH_WIDTH; i++) {
+			aabb box;
+			box.min = _mm_setr_ps(node->bounds[0][i], node->bounds[1][i],
+				node->bounds[2][i], 0.0f);
+			box.max = _mm_setr_ps(node->bounds[3][i], node->bounds[4][i],
+				node->bounds[5][i], 0.0f);
+			if (node->child[i] > k || node->count[i]) {
+				for (int j = 0; j < node->count[i]; j++) {
+					int p = tree->prim[node->child[i] + j];
+					seen[p]++;
+					ok &= aabb_contains_aabb(box, b[p]);
+				}
+			} else {
+				ok &= node->child[i] == -1;
+			}
+		}
+	}
+	for (int i = 0; i < tree->count; i++)
+		ok &= seen[i] == 1;
+	return ok;
+}
+
+static int brute_closest(const ray *r, float *t)
+{
+	float u, v;
+	return ray_triangles_closest(r, v0, v1, v2, N, 100.0f, t, &u, &v);
+}
+
+#endif /* _GMATH_TESTS_BVH_SCENE_H_ */
@@ -0,0 +1,95 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * dquat.c
+ * Tests dquat.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/dquat.h>
+
+#ifdef DBL_EPSILON
+#undef DBL_EPSILON
+#endif
+#define DBL_EPSILON 1e-5
+
+static quat r1, r2;
+static vec3 t1, t2, v;
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("dquat")
+	{
+		FCT_SETUP_BGN()
+		{
+			r1 = quat_normalize(_mm_setr_ps(0.3f, -0.2f, 0.5f, 1.0f));
+			r2 = quat_normalize(_mm_setr_ps(-0.1f, 0.7f, 0.2f, 0.6f));
+			t1 = _mm_setr_ps(1.0f, 2.0f, 3.0f, 0.0f);
+			t2 = _mm_setr_ps(-4.0f, 0.5f, 0.0f, 0.0f);
+			v = _mm_setr_ps(0.5f, 1.0f, -2.0f, 1.0f);
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("dquat_transform_point")
+		{
+			dquat dq = dquat_from_rt(r1, t1);
+			vec3 p = dquat_transform_point(dq, v);
+			vec3 r = vec3_add(quat_rotate_vec3(r1, v), t1);
+			vec3 t = dquat_get_translation(dq);
+			for (int j = 0; j < 3; j++) {
+				fct_chk_eq_dbl(fidx(p, j), fidx(r, j));
+				fct_chk_eq_dbl(fidx(t, j), fidx(t1, j));
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("dquat_mat4")
+		{
+			mat4 m = quat_to_mat4(r2);
+			m.col[3] = _mm_setr_ps(-4.0f, 0.5f, 0.0f, 1.0f);
+			mat4 b = dquat_to_mat4(dquat_from_mat4(m));
+			for (int i = 0; i < 4; i++)
+				for (int j = 0; j < 4; j++)
+					fct_chk_eq_dbl(fidx(b.col[i], j), fidx(m.col[i], j));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("dquat_mul")
+		{
+			dquat a = dquat_from_rt(r1, t1), b = dquat_from_rt(r2, t2);
+			vec3 p = dquat_transform_point(dquat_mul(a, b), v);
+			vec3 r = dquat_transform_point(a, dquat_transform_point(b, v));
+			vec3 c = dquat_transform_point(dquat_mul(a, dquat_conjugate(a)), v);
+			for (int j = 0; j < 3; j++) {
+				fct_chk_eq_dbl(fidx(p, j), fidx(r, j));
+				fct_chk_eq_dbl(fidx(c, j), fidx(v, j));
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("dquat_blend")
+		{
+			dquat dq[2] = {dquat_from_rt(r1, t1),
+				dquat_from_rt(vec4_neg(r1), t1)};
+			float w[2] = {0.3f, 0.7f};
+			/* antipodal copies of one transform blend back to it */
+			dquat b = dquat_blend(dq, w, 2);
+			vec3 p = dquat_transform_point(b, v);
+			vec3 r = dquat_transform_point(dq[0], v);
+			fct_chk_eq_dbl(vec4_dot(b.real, b.real), 1.0f);
+			for (int j = 0; j < 3; j++)
+				fct_chk_eq_dbl(fidx(p, j), fidx(r, j));
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
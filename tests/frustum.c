@@ -0,0 +1,121 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * frustum.c
+ * Tests frustum.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/frustum.h>
+
+#ifdef DBL_EPSILON
+#undef DBL_EPSILON
+#endif
+#define DBL_EPSILON 1e-5
+
+#define N 37
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("frustum")
+	{
+		/* 90 degree perspective looking down -z, near 1, far 100 */
+		mat4 proj = {{{1.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f, 0.0f},
+			{0.0f, 0.0f, -101.0f / 99.0f, -1.0f},
+			{0.0f, 0.0f, -200.0f / 99.0f, 0.0f}}};
+		vec4 s[N];
+		aabb b[N];
+		frustum f;
+
+		FCT_SETUP_BGN()
+		{
+			f = frustum_from_mat4(proj);
+			for (int i = 0; i < N; i++) {
+				vec4 c = _mm_setr_ps(sinf(i * 1.3f) * 20.0f,
+					cosf(i * 0.7f) * 10.0f, -60.0f * sinf(i * 0.37f), 0.0f);
+				s[i] = _mm_add_ps(c, _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f + i % 5));
+				b[i].min = _mm_sub_ps(c, _mm_set1_ps(0.5f + i % 3));
+				b[i].max = _mm_add_ps(c, _mm_set1_ps(1.5f));
+			}
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("frustum_from_mat4")
+		{
+			/* the left plane x = z passes through the origin */
+			fct_chk_eq_dbl(fidx(f.plane[0], 0), sqrtf(0.5f));
+			fct_chk_eq_dbl(fidx(f.plane[0], 2), -sqrtf(0.5f));
+			fct_chk_eq_dbl(fidx(f.plane[0], 3), 0.0f);
+			/* near and far distances along -z */
+			fct_chk_eq_dbl(fidx(f.plane[4], 2), -1.0f);
+			fct_chk_eq_dbl(fidx(f.plane[4], 3), -1.0f);
+			fct_chk_eq_dbl(fidx(f.plane[5], 2), 1.0f);
+			fct_chk(fabsf(fidx(f.plane[5], 3) - 100.0f) < 1e-3f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("frustum_test")
+		{
+			aabb in = {_mm_set1_ps(-1.0f), _mm_setr_ps(1.0f, 1.0f, -0.5f, 0.0f)};
+			aabb out = {_mm_setr_ps(-1.0f, -1.0f, 0.5f, 0.0f), _mm_set1_ps(1.0f)};
+			fct_chk(frustum_test_sphere(&f, _mm_setr_ps(0.0f, 0.0f, -10.0f, 1.0f)));
+			fct_chk(frustum_test_sphere(&f, _mm_setr_ps(0.0f, 0.0f, -0.5f, 1.0f)));
+			fct_chk(!frustum_test_sphere(&f, _mm_setr_ps(0.0f, 0.0f, 5.0f, 1.0f)));
+			fct_chk(!frustum_test_sphere(&f, _mm_setr_ps(20.0f, 0.0f, -10.0f, 1.0f)));
+			fct_chk(frustum_test_aabb(&f, &in));
+			fct_chk(!frustum_test_aabb(&f, &out));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("frustum_cull_spheres")
+		{
+			for (int count = 0; count <= N; count++) {
+				int visible[N], n, k = 0;
+				unsigned char mask[(N + 7) / 8];
+				n = frustum_cull_spheres(&f, s, count, visible);
+				frustum_cull_spheres_mask(&f, s, count, mask);
+				for (int i = 0; i < count; i++) {
+					int v = frustum_test_sphere(&f, s[i]);
+					fct_chk_eq_int((mask[i / 8] >> (i % 8)) & 1, v);
+					if (v) {
+						fct_chk_eq_int(visible[k], i);
+						k++;
+					}
+				}
+				fct_chk_eq_int(n, k);
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("frustum_cull_aabbs")
+		{
+			int visible[N], n, k = 0, seen = 0;
+			unsigned char mask[(N + 7) / 8];
+			n = frustum_cull_aabbs(&f, b, N, visible);
+			frustum_cull_aabbs_mask(&f, b, N, mask);
+			for (int i = 0; i < N; i++) {
+				int v = frustum_test_aabb(&f, &b[i]);
+				fct_chk_eq_int((mask[i / 8] >> (i % 8)) & 1, v);
+				if (v) {
+					fct_chk_eq_int(visible[k], i);
+					k++;
+				}
+				seen += v;
+			}
+			fct_chk_eq_int(n, k);
+			/* the fixture should exercise both outcomes */
+			fct_chk(seen > 0 && seen < N);
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
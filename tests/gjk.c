@@ -0,0 +1,170 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * gjk.c
+ * Tests gjk.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/gjk.h>
+
+#define N 256
+
+#define CHK_NEAR(a, b, e) fct_chk(fabsf((a) - (b)) <= (e) * (1.0f + fabsf(b)))
+
+static vec3 cube[8];
+static gjk_shape sa[N], sb[N];
+
+static float randf(unsigned int *seed)
+{
+	*seed = *seed * 1664525u + 1013904223u;
+	return (*seed >> 8) / (float)(1 << 24);
+}
+
+/* Exact distance from a sphere to a box, centre outside or in. */
+static float sphere_box(const gjk_shape *s, const gjk_shape *box)
+{
+	vec3 l = quat_rotate_vec3(quat_conjugate(box->rot),
+		vec3_sub(s->pos, box->pos));
+	float out = 0.0f, in = INFINITY;
+	for (int i = 0; i < 3; i++) {
+		float d = fabsf(fidx(l, i)) - fidx(box->half, i);
+		out += d > 0.0f ? d * d : 0.0f;
+		in = fminf(in, -d);
+	}
+	return (out > 0.0f ? sqrtf(out) : -in) - s->radius;
+}
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("gjk")
+	{
+		FCT_SETUP_BGN()
+		{
+			unsigned int seed = 9;
+			for (int i = 0; i < 8; i++)
+				cube[i] = _mm_setr_ps(i & 1 ? 0.5f : -0.5f,
+					i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f, 0.0f);
+			for (int i = 0; i < N; i++) {
+				vec3 p = _mm_setr_ps(randf(&seed) * 4.0f - 2.0f,
+					randf(&seed) * 4.0f - 2.0f, randf(&seed) * 4.0f - 2.0f,
+					0.0f);
+				quat q = quat_normalize(_mm_setr_ps(randf(&seed) - 0.5f,
+					randf(&seed) - 0.5f, randf(&seed) - 0.5f,
+					randf(&seed) - 0.5f));
+				vec3 h = _mm_setr_ps(0.2f + randf(&seed),
+					0.2f + randf(&seed), 0.2f + randf(&seed), 0.0f);
+				sa[i] = gjk_sphere(_mm_setzero_ps(), 0.1f + randf(&seed));
+				switch (i % 4) {
+				case 0:
+					sb[i] = gjk_box(p, q, h);
+					break;
+				case 1:
+					sb[i] = gjk_capsule(p, q, fidx(h, 1), fidx(h, 0));
+					break;
+				case 2:
+					sb[i] = gjk_hull(p, q, cube, 8);
+					break;
+				default:
+					sb[i] = gjk_sphere(p, fidx(h, 2));
+				}
+				if (i % 8 >= 4)
+					sa[i] = gjk_box(_mm_setr_ps(0.3f, 0.0f, 0.0f, 0.0f),
+						quat_normalize(_mm_setr_ps(0.1f, 0.2f, 0.3f, 0.9f)),
+						_mm_set1_ps(0.4f));
+			}
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("gjk_spheres")
+		{
+			gjk_shape a = gjk_sphere(_mm_setr_ps(1.0f, 2.0f, 3.0f, 0.0f), 1.0f);
+			gjk_shape b = gjk_sphere(_mm_setr_ps(4.0f, 6.0f, 3.0f, 0.0f), 0.5f);
+			gjk_contact c;
+
+			CHK_NEAR(gjk_distance(&a, &b, &c), 3.5f, 1e-5f);
+			CHK_NEAR(c.distance, 3.5f, 1e-5f);
+			CHK_NEAR(fidx(c.normal, 0), 0.6f, 1e-5f);
+			CHK_NEAR(fidx(c.normal, 1), 0.8f, 1e-5f);
+			CHK_NEAR(fidx(c.pa, 0), 1.6f, 1e-5f);
+			CHK_NEAR(fidx(c.pb, 1), 5.6f, 1e-5f);
+			fct_chk(!gjk_overlap(&a, &b));
+
+			/* overlapping margins are exact too */
+			b.pos = _mm_setr_ps(1.0f, 3.0f, 3.0f, 0.0f);
+			CHK_NEAR(gjk_distance(&a, &b, &c), -0.5f, 1e-5f);
+			CHK_NEAR(fidx(c.normal, 1), 1.0f, 1e-5f);
+			fct_chk(gjk_overlap(&a, &b));
+
+			/* coincident centres go through EPA */
+			b.pos = a.pos;
+			CHK_NEAR(gjk_distance(&a, &b, &c), -1.5f, 0.05f);
+			CHK_NEAR(vec3_length(c.normal), 1.0f, 1e-4f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("gjk_boxes")
+		{
+			quat id = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+			gjk_shape a = gjk_box(_mm_setzero_ps(), id, _mm_set1_ps(1.0f));
+			gjk_shape b = gjk_box(_mm_setr_ps(2.5f, 0.5f, 0.0f, 0.0f), id,
+				_mm_set1_ps(1.0f));
+			gjk_shape h = gjk_hull(b.pos, id, cube, 8);
+			gjk_contact c;
+
+			CHK_NEAR(gjk_distance(&a, &b, &c), 0.5f, 1e-5f);
+			CHK_NEAR(fidx(c.normal, 0), 1.0f, 1e-5f);
+			CHK_NEAR(fidx(c.pa, 0), 1.0f, 1e-5f);
+			CHK_NEAR(fidx(c.pb, 0), 1.5f, 1e-5f);
+
+			/* unit cube hull */
+			CHK_NEAR(gjk_distance(&a, &h, &c), 1.0f, 1e-5f);
+
+			/* penetration by 0.25 along x */
+			b.pos = _mm_setr_ps(1.75f, 0.3f, -0.2f, 0.0f);
+			fct_chk(gjk_overlap(&a, &b));
+			CHK_NEAR(gjk_distance(&a, &b, &c), -0.25f, 1e-3f);
+			CHK_NEAR(fidx(c.normal, 0), 1.0f, 1e-3f);
+			CHK_NEAR(fidx(c.pa, 0) - fidx(c.pb, 0), 0.25f, 1e-3f);
+
+			/* rotated 45 degrees about z, corner towards a */
+			b = gjk_box(_mm_setr_ps(2.3f, 0.0f, 0.0f, 0.0f),
+				_mm_setr_ps(0.0f, 0.0f, sinf(PI / 8), cosf(PI / 8)),
+				_mm_set1_ps(1.0f));
+			CHK_NEAR(gjk_distance(&a, &b, &c), 1.3f - sqrtf(2.0f), 1e-3f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("gjk_distance")
+		{
+			int checked = 0;
+			for (int i = 0; i < N; i++) {
+				gjk_contact c;
+				float d = gjk_distance(&sa[i], &sb[i], &c);
+				vec3 gap = vec3_sub(c.pb, c.pa);
+				fct_chk_eq_int(gjk_overlap(&sa[i], &sb[i]), d <= 1e-5f);
+				CHK_NEAR(vec3_length(c.normal), 1.0f, 1e-4f);
+				/* the points are distance apart along the normal */
+				CHK_NEAR(vec3_dot(gap, c.normal), d, 2e-3f);
+				if (i % 8 < 4 && i % 4 == 0) {
+					CHK_NEAR(d, sphere_box(&sa[i], &sb[i]), 2e-3f);
+					checked++;
+				}
+				/* swapping the shapes flips the normal */
+				CHK_NEAR(gjk_distance(&sb[i], &sa[i], NULL), d, 2e-3f);
+			}
+			fct_chk(checked == N / 8);
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
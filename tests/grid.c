@@ -0,0 +1,171 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * grid.c
+ * Tests grid.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/grid.h>
+
+#define N 3000
+#define QUERIES 64
+
+static vec3 points[N];
+static int out[N];
+static char seen[N];
+
+static void make_points(void)
+{
+	for (int i = 0; i < N; i++) {
+		float f = (float)i;
+		points[i] = _mm_setr_ps(sinf(f * 1.7f) * 10.0f,
+			cosf(f * 0.9f) * 10.0f - 4.0f, sinf(f * 0.31f + 1.0f) * 10.0f,
+			0.0f);
+	}
+}
+
+/* The found points are exactly those within radius, each once. */
+static int check_radius(const grid *g, vec3 c, float r)
+{
+	int found = grid_radius(g, c, r, out, N), count = 0, ok = 1;
+	memset(seen, 0, sizeof(seen));
+	for (int i = 0; i < found && i < N; i++) {
+		vec3 d = vec3_sub(points[out[i]], c);
+		ok &= !seen[out[i]] && vec3_dot(d, d) <= r * r;
+		seen[out[i]] = 1;
+	}
+	for (int i = 0; i < N; i++) {
+		vec3 d = vec3_sub(points[i], c);
+		count += vec3_dot(d, d) <= r * r;
+	}
+	return ok && found == count;
+}
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("grid")
+	{
+		grid g;
+
+		FCT_SETUP_BGN()
+		{
+			make_points();
+			grid_build(&g, points, N, 1.5f);
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+			grid_free(&g);
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("grid_build")
+		{
+			int ok = 1;
+			fct_chk_eq_int(g.count, N);
+			fct_chk_eq_int(g.mask, 4095);
+			fct_chk_eq_int(g.start[g.mask + 1], N);
+			memset(seen, 0, sizeof(seen));
+			for (int b = 0; b <= g.mask; b++)
+				for (int j = g.start[b]; j < g.start[b + 1]; j++) {
+					int i = g.index[j];
+					ok &= !seen[i] && g.x[j] == fidx(points[i], 0) &&
+						g.y[j] == fidx(points[i], 1) &&
+						g.z[j] == fidx(points[i], 2) &&
+						grid_hash(&g, grid_coord(&g, g.x[j], 0),
+						grid_coord(&g, g.y[j], 1),
+						grid_coord(&g, g.z[j], 2)) == b;
+					seen[i] = 1;
+				}
+			fct_chk(ok);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("grid_radius")
+		{
+			for (int q = 0; q < QUERIES; q++) {
+				float f = (float)q;
+				vec3 c = _mm_setr_ps(sinf(f * 2.3f) * 12.0f,
+					cosf(f * 1.1f) * 12.0f, sinf(f * 0.7f) * 12.0f, 0.0f);
+				fct_chk(check_radius(&g, c, 0.5f + (q % 4)));
+				/* around a point, which finds itself */
+				fct_chk(check_radius(&g, points[q * 17], 1.5f));
+				fct_chk(grid_radius(&g, points[q * 17], 0.0f, out, N) >= 1);
+			}
+			/* far outside the bounds */
+			fct_chk_eq_int(grid_radius(&g, _mm_set1_ps(100.0f), 5.0f, out, N),
+				0);
+			fct_chk(check_radius(&g, _mm_set1_ps(100.0f), 160.0f));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("grid_radius_max")
+		{
+			int found = grid_radius(&g, points[0], 4.0f, out, N);
+			fct_chk(found > 2);
+			fct_chk_eq_int(grid_radius(&g, points[0], 4.0f, out, 2), found);
+			fct_chk_eq_int(grid_radius(&g, points[0], 4.0f, NULL, 0), found);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("grid_build_task")
+		{
+			grid_builder b;
+			grid tasked;
+			int ok = 1;
+			fct_req(grid_build_begin(&b, &tasked, points, N, 1.5f, 7) == 0);
+			/* any order within a pass, as threads would pick them */
+			for (int t = b.tasks - 1; t >= 0; t--)
+				grid_build_count(&b, t);
+			grid_build_offsets(&b);
+			for (int t = 0; t < b.tasks; t++)
+				grid_build_scatter(&b, (t * 3) % b.tasks);
+			grid_build_end(&b);
+			for (int k = 0; k <= g.mask; k++)
+				ok &= tasked.start[k] == g.start[k];
+			for (int i = 0; i < N; i++)
+				ok &= tasked.index[i] == g.index[i];
+			fct_chk(ok);
+			grid_free(&tasked);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("grid_collisions")
+		{
+			grid small;
+			/* a tiny table and fine cells, most rows share buckets and
+			 * the longer rows wrap the whole table */
+			fct_req(grid_build(&small, points, 40, 0.25f) == 0);
+			fct_chk_eq_int(small.mask, 63);
+			for (int q = 0; q < 8; q++) {
+				float r = q < 4 ? 3.0f : 10.0f;
+				int found = grid_radius(&small, points[q], r, out, N);
+				int count = 0, ok = 1;
+				memset(seen, 0, sizeof(seen));
+				for (int i = 0; i < found; i++) {
+					ok &= !seen[out[i]] && out[i] < 40;
+					seen[out[i]] = 1;
+				}
+				for (int i = 0; i < 40; i++) {
+					vec3 d = vec3_sub(points[i], points[q]);
+					count += vec3_dot(d, d) <= r * r;
+				}
+				fct_chk(ok);
+				fct_chk_eq_int(found, count);
+			}
+			grid_free(&small);
+
+			fct_req(grid_build(&small, points, 0, 1.0f) == 0);
+			fct_chk_eq_int(grid_radius(&small, points[0], 5.0f, out, N), 0);
+			grid_free(&small);
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
@@ -0,0 +1,145 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * lbvh.c
+ * Tests lbvh.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/lbvh.h>
+
+#define N 900
+#define RAYS 64
+
+#include "bvh_scene.h"
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("lbvh")
+	{
+		bvh tree;
+
+		FCT_SETUP_BGN()
+		{
+			make_scene(0, 0.0f);
+			make_rays();
+			lbvh_build(&tree, boxes, N);
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+			bvh_free(&tree);
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("lbvh_build")
+		{
+			fct_chk_eq_int(tree.count, N);
+			fct_chk(tree.nodes > 0);
+			fct_chk(tree.nodes < N);
+			fct_chk(check_tree(&tree, boxes));
+			fct_chk(aabb_contains_aabb(tree.bounds, boxes[0]));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("lbvh_closest_triangle")
+		{
+			int hits = 0;
+			for (int i = 0; i < RAYS; i++) {
+				float t = -1.0f, u, v, bt = -1.0f;
+				int best = brute_closest(&rays[i], &bt);
+				fct_chk_eq_int(bvh_closest_triangle(&tree, v0, v1, v2,
+					&rays[i], 100.0f, &t, &u, &v), best);
+				if (best >= 0) {
+					CHK_NEAR(t, bt);
+					hits++;
+				}
+			}
+			fct_chk(hits > RAYS / 4);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("lbvh_packet")
+		{
+			for (int i = 0; i < RAYS; i += 4) {
+				int prim[4], mask, best;
+				float t[4], u[4], v[4];
+				mask = bvh_closest_triangle4(&tree, v0, v1, v2, &rays[i],
+					100.0f, prim, t, u, v);
+				for (int k = 0; k < 4; k++) {
+					float bt = -1.0f;
+					best = brute_closest(&rays[i + k], &bt);
+					fct_chk_eq_int(prim[k], best);
+					fct_chk_eq_int((mask >> k) & 1, best >= 0);
+					if (best >= 0)
+						CHK_NEAR(t[k], bt);
+				}
+				mask = bvh_any_triangle4(&tree, v0, v1, v2, &rays[i], 100.0f);
+				for (int k = 0; k < 4; k++)
+					fct_chk_eq_int((mask >> k) & 1, bvh_any_triangle(&tree,
+						v0, v1, v2, &rays[i + k], 100.0f));
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("lbvh_build_task")
+		{
+			lbvh_builder lb;
+			bvh tasked;
+			fct_req(lbvh_build_begin(&lb, boxes, N, 6) == 0);
+			/* any order within a pass, as threads would pick them */
+			for (int t = lb.tasks - 1; t >= 0; t--)
+				lbvh_build_nodes(&lb, t);
+			lbvh_build_subtrees(&lb);
+			fct_chk_eq_int(lb.b.tasks, 6);
+			for (int t = 0; t < lb.tasks; t++)
+				lbvh_build_bounds(&lb, (t * 5) % lb.tasks);
+			fct_req(lbvh_build_end(&lb, &tasked) == 0);
+			fct_chk(check_tree(&tasked, boxes));
+			fct_chk_eq_int(tasked.nodes, tree.nodes);
+			fct_chk(!memcmp(tasked.prim, tree.prim, sizeof(int) * N));
+			fct_chk(!memcmp(tasked.node, tree.node,
+				sizeof(bvh_node) * tree.nodes));
+			bvh_free(&tasked);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("lbvh_degenerate")
+		{
+			bvh small;
+			aabb same[40];
+			int out[40];
+			ray r = {{0.5f, 0.5f, 5.0f, 0.0f}, {0.0f, 0.0f, -1.0f, 0.0f}};
+			float t;
+
+			fct_req(lbvh_build(&small, boxes, 0) == 0);
+			fct_chk_eq_int(small.nodes, 0);
+			fct_chk_eq_int(bvh_closest_aabb(&small, boxes, &r, 10.0f, &t), -1);
+			bvh_free(&small);
+
+			/* one Morton code for all, split by index */
+			for (int i = 0; i < 40; i++) {
+				same[i].min = _mm_setzero_ps();
+				same[i].max = _mm_set1_ps(1.0f);
+			}
+			fct_req(lbvh_build(&small, same, 40) == 0);
+			fct_chk(check_tree(&small, same));
+			fct_chk_eq_int(bvh_overlap(&small, same, same[0], out, 40), 40);
+			fct_chk(bvh_closest_aabb(&small, same, &r, 10.0f, &t) >= 0);
+			CHK_NEAR(t, 4.0f);
+			bvh_free(&small);
+
+			fct_req(lbvh_build(&small, boxes, 1) == 0);
+			fct_chk_eq_int(small.nodes, 1);
+			fct_chk(check_tree(&small, boxes));
+			bvh_free(&small);
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
@@ -0,0 +1,218 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * mat4.c
+ * Tests mat4.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/mat4.h>
+
+/* Inverses and the cephes trigonometry will not reach DBL_EPSILON. */
+#ifdef DBL_EPSILON
+#undef DBL_EPSILON
+#endif
+#define DBL_EPSILON 1e-5
+
+#define CHK_MAT4(M,R) \
+	for (int i = 0; i < 4; i++) \
+		for (int j = 0; j < 4; j++) \
+			fct_chk_eq_dbl(fidx((M).col[i], j), (R)[i][j])
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("mat4")
+	{
+		mat4 a = {{
+			{2.0f, 0.5f, -1.0f, 0.0f},
+			{1.0f, 3.0f, 0.25f, 0.0f},
+			{0.0f, -2.0f, 1.5f, 0.0f},
+			{4.0f, 5.0f, 6.0f, 1.0f}
+		}};
+		mat4 b = {{
+			{1.0f, 2.0f, 3.0f, 4.0f},
+			{-1.0f, 0.5f, 2.0f, 0.0f},
+			{0.0f, 1.0f, -3.0f, 2.0f},
+			{2.0f, 0.0f, 1.0f, 1.0f}
+		}};
+
+		FCT_SETUP_BGN()
+		{
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("mat4_mul")
+		{
+			float r[4][4];
+			mat4 m = mat4_mul(a, b);
+			for (int i = 0; i < 4; i++)
+				for (int j = 0; j < 4; j++) {
+					r[i][j] = 0.0f;
+					for (int k = 0; k < 4; k++)
+						r[i][j] += fidx(a.col[k], j) *
+							fidx(b.col[i], k);
+				}
+			CHK_MAT4(m, r);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("mat4_transpose")
+		{
+			float r[4][4];
+			mat4 m = mat4_transpose(b);
+			for (int i = 0; i < 4; i++)
+				for (int j = 0; j < 4; j++)
+					r[i][j] = fidx(b.col[j], i);
+			CHK_MAT4(m, r);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("mat4_inverse")
+		{
+			float r[4][4] = {{1,0,0,0},{0,1,0,0},{0,0,1,0},{0,0,0,1}};
+			mat4 m = mat4_mul(b, mat4_inverse(b));
+			CHK_MAT4(m, r);
+			m = mat4_mul(mat4_inverse(a), a);
+			CHK_MAT4(m, r);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("mat4_affine_inverse")
+		{
+			float r[4][4] = {{1,0,0,0},{0,1,0,0},{0,0,1,0},{0,0,0,1}};
+			mat4 rot = mat4_from_angles(0.3f, -1.1f, 2.0f);
+			rot.col[3] = _mm_setr_ps(1.0f, -2.0f, 3.0f, 1.0f);
+			mat4 m = mat4_mul(mat4_affine_inverse(rot), rot);
+			CHK_MAT4(m, r);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("mat4_transform")
+		{
+			vec4 v = {1.0f, -2.0f, 0.5f, 1.0f};
+			vec4 p = mat4_transform4(a, v);
+			vec3 t = mat4_transform_point(a, v);
+			vec3 n = mat4_transform_normal(a, v);
+			for (int j = 0; j < 3; j++) {
+				float r = fidx(a.col[0], j) * 1.0f -
+					fidx(a.col[1], j) * 2.0f +
+					fidx(a.col[2], j) * 0.5f;
+				fct_chk_eq_dbl(fidx(n, j), r);
+				fct_chk_eq_dbl(fidx(t, j), r + fidx(a.col[3], j));
+				fct_chk_eq_dbl(fidx(p, j), r + fidx(a.col[3], j));
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("mat4_from_angles")
+		{
+			mat4 m = mat4_from_angles(PI / 2.0f, 0.0f, 0.0f);
+			float r[4][4] = {{0,1,0,0},{-1,0,0,0},{0,0,1,0},{0,0,0,1}};
+			CHK_MAT4(m, r);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("mat4_perspective")
+		{
+			/* the projection tests/frustum.c writes out by hand */
+			float r[4][4] = {{1,0,0,0},{0,1,0,0},
+				{0,0,-101.0f / 99.0f,-1},{0,0,-200.0f / 99.0f,0}};
+			mat4 m = mat4_perspective(PI / 2.0f, 1.0f, 1.0f, 100.0f);
+			vec4 p;
+			CHK_MAT4(m, r);
+			m = mat4_perspective(1.0f, 16.0f / 9.0f, 0.5f, 300.0f);
+			p = mat4_transform4(m, _mm_setr_ps(0.0f, 0.0f, -0.5f, 1.0f));
+			fct_chk_eq_dbl(fidx(p, 2) / fidx(p, 3), -1.0f);
+			p = mat4_transform4(m, _mm_setr_ps(0.0f, tanf(0.5f) * 300.0f,
+				-300.0f, 1.0f));
+			fct_chk_eq_dbl(fidx(p, 1) / fidx(p, 3), 1.0f);
+			fct_chk_eq_dbl(fidx(p, 2) / fidx(p, 3), 1.0f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("mat4_perspective_reverse_z")
+		{
+			mat4 m = mat4_perspective_reverse_z(1.2f, 1.5f, 0.1f);
+			vec4 p = mat4_transform4(m, _mm_setr_ps(0.0f, 0.0f, -0.1f, 1.0f));
+			float d = 1.0f;
+			fct_chk_eq_dbl(fidx(p, 2) / fidx(p, 3), 1.0f);
+			/* depth falls towards but never reaches zero */
+			for (float z = 1.0f; z < 1e6f; z *= 10.0f) {
+				p = mat4_transform4(m, _mm_setr_ps(z, z, -z, 1.0f));
+				fct_chk(fidx(p, 2) / fidx(p, 3) < d);
+				d = fidx(p, 2) / fidx(p, 3);
+				fct_chk(d > 0.0f);
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("mat4_ortho")
+		{
+			mat4 m = mat4_ortho(-2.0f, 6.0f, 1.0f, 3.0f, 0.5f, 10.0f);
+			vec4 lo = mat4_transform4(m, _mm_setr_ps(-2.0f, 1.0f, -0.5f, 1.0f));
+			vec4 hi = mat4_transform4(m, _mm_setr_ps(6.0f, 3.0f, -10.0f, 1.0f));
+			for (int j = 0; j < 3; j++) {
+				fct_chk_eq_dbl(fidx(lo, j), -1.0f);
+				fct_chk_eq_dbl(fidx(hi, j), 1.0f);
+			}
+			fct_chk_eq_dbl(fidx(hi, 3), 1.0f);
+			fct_chk_eq_dbl(fidx(m.col[0], 1), 0.0f);
+			fct_chk_eq_dbl(fidx(m.col[2], 3), 0.0f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("mat4_look_at")
+		{
+			float r[4][4] = {{1,0,0,0},{0,1,0,0},{0,0,1,0},{0,0,0,1}};
+			vec3 eye = {3.0f, 4.0f, -2.0f, 0.0f};
+			vec3 center = {-1.0f, 0.5f, 6.0f, 0.0f};
+			vec3 up = {0.0f, 1.0f, 0.0f, 0.0f};
+			mat4 m = mat4_look_at(eye, center, up), w;
+			vec3 p = mat4_transform_point(m, eye);
+			for (int j = 0; j < 3; j++)
+				fct_chk_eq_dbl(fidx(p, j), 0.0f);
+			p = mat4_transform_point(m, center);
+			fct_chk_eq_dbl(fidx(p, 0), 0.0f);
+			fct_chk_eq_dbl(fidx(p, 1), 0.0f);
+			fct_chk_eq_dbl(fidx(p, 2), -vec3_length(vec3_sub(center, eye)));
+			/* up stays in the upper half of the view */
+			p = mat4_transform_normal(m, up);
+			fct_chk(fidx(p, 1) > 0.0f);
+			fct_chk_eq_dbl(fidx(p, 0), 0.0f);
+			w = mat4_mul(mat4_affine_inverse(m), m);
+			CHK_MAT4(w, r);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("mat4_projection_inverse")
+		{
+			float r[4][4] = {{1,0,0,0},{0,1,0,0},{0,0,1,0},{0,0,0,1}};
+			mat4 p = mat4_perspective(0.9f, 1.3f, 0.25f, 500.0f), m;
+			m = mat4_mul(mat4_perspective_inverse(p), p);
+			CHK_MAT4(m, r);
+			p = mat4_perspective_reverse_z(0.9f, 1.3f, 0.25f);
+			m = mat4_mul(p, mat4_perspective_inverse(p));
+			CHK_MAT4(m, r);
+			/* off centre, as for one eye of a stereo pair */
+			p = mat4_perspective(1.1f, 0.8f, 1.0f, 50.0f);
+			fidx(p.col[2], 0) = 0.15f;
+			fidx(p.col[2], 1) = -0.05f;
+			m = mat4_mul(mat4_perspective_inverse(p), p);
+			CHK_MAT4(m, r);
+			p = mat4_ortho(-2.0f, 6.0f, 1.0f, 3.0f, 0.5f, 10.0f);
+			m = mat4_mul(mat4_ortho_inverse(p), p);
+			CHK_MAT4(m, r);
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
@@ -0,0 +1,232 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * morton.c
+ * Tests morton.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/morton.h>
+
+#define N 1003
+
+static vec3 points[N];
+static uint32_t code30[N];
+static uint64_t code63[N];
+static int perm[N];
+
+/* One bit at a time, the definition the fast paths must match. */
+static uint64_t slow_interleave(uint32_t x, uint32_t y, uint32_t z, int bits)
+{
+	uint64_t out = 0;
+	for (int i = 0; i < bits; i++) {
+		out |= (uint64_t)(x >> i & 1) << (3 * i);
+		out |= (uint64_t)(y >> i & 1) << (3 * i + 1);
+		out |= (uint64_t)(z >> i & 1) << (3 * i + 2);
+	}
+	return out;
+}
+
+static uint32_t slow_cell(const vec3 p, const aabb b, int axis, int bits)
+{
+	float top = (float)((1 << bits) - 1);
+	float extent = fidx(b.max, axis) - fidx(b.min, axis);
+	float scale = extent > 0.0f ? top / extent : 0.0f;
+	float q = (fidx(p, axis) - fidx(b.min, axis)) * scale;
+	q = q > 0.0f ? q : 0.0f;
+	return (uint32_t)(q < top ? q : top);
+}
+
+/* The first 512 codes fill the 8x8x8 corner, each a step from the last. */
+static int check_hilbert(int wide)
+{
+	static int seen[512][3];
+	int ok = 1;
+	for (int i = 0; i < 512; i++)
+		seen[i][0] = -1;
+	for (int x = 0; x < 8; x++)
+		for (int y = 0; y < 8; y++)
+			for (int z = 0; z < 8; z++) {
+				uint64_t h = wide ? hilbert63(x, y, z) : hilbert30(x, y, z);
+				if (h >= 512 || seen[h][0] >= 0)
+					return 0;
+				seen[h][0] = x;
+				seen[h][1] = y;
+				seen[h][2] = z;
+			}
+	for (int i = 1; i < 512; i++)
+		ok &= abs(seen[i][0] - seen[i - 1][0]) +
+			abs(seen[i][1] - seen[i - 1][1]) +
+			abs(seen[i][2] - seen[i - 1][2]) == 1;
+	return ok && seen[0][0] == 0 && seen[0][1] == 0 && seen[0][2] == 0;
+}
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("morton")
+	{
+		aabb bounds;
+
+		FCT_SETUP_BGN()
+		{
+			for (int i = 0; i < N; i++) {
+				float f = (float)i;
+				points[i] = _mm_setr_ps(sinf(f * 1.7f) * 10.0f,
+					cosf(f * 0.9f) * 3.0f - 4.0f, sinf(f * 0.31f) * 7.0f,
+					0.0f);
+			}
+			bounds = aabb_from_points(points, N);
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("morton_interleave")
+		{
+			int ok = 1;
+			fct_chk_eq_int(morton30(1, 0, 0), 1);
+			fct_chk_eq_int(morton30(0, 1, 0), 2);
+			fct_chk_eq_int(morton30(0, 0, 1), 4);
+			fct_chk(morton30(1023, 1023, 1023) == (1u << 30) - 1);
+			fct_chk(morton63(0x1fffff, 0x1fffff, 0x1fffff) ==
+				(1ull << 63) - 1);
+			for (uint32_t i = 0; i < 4096; i++) {
+				uint32_t x = i * 2654435761u, y = x * 40503u, z = y ^ x >> 7;
+				ok &= morton30(x & 1023, y & 1023, z & 1023) ==
+					slow_interleave(x & 1023, y & 1023, z & 1023, 10);
+				ok &= morton63(x & 0x1fffff, y & 0x1fffff, z & 0x1fffff) ==
+					slow_interleave(x & 0x1fffff, y & 0x1fffff,
+					z & 0x1fffff, 21);
+				ok &= (morton_spread10(x) | morton_spread10(y) << 1 |
+					morton_spread10(z) << 2) ==
+					morton30(x & 1023, y & 1023, z & 1023);
+				ok &= (morton_spread21(x) | morton_spread21(y) << 1 |
+					morton_spread21(z) << 2) ==
+					morton63(x & 0x1fffff, y & 0x1fffff, z & 0x1fffff);
+			}
+			fct_chk(ok);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("hilbert")
+		{
+			fct_chk(check_hilbert(0));
+			fct_chk(check_hilbert(1));
+			fct_chk_eq_int(hilbert30(0, 0, 0), 0);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("morton_encode")
+		{
+			int ok = 1;
+			/* outside the bounds and NaN clamp into the grid */
+			points[5] = _mm_set1_ps(100.0f);
+			points[6] = _mm_set1_ps(-100.0f);
+			points[7] = _mm_set1_ps(NAN);
+			for (int n = 0; n < 12; n++) {
+				memset(code30, 0xff, sizeof(code30));
+				morton30_encode(code30, points, n, bounds);
+				for (int i = 0; i < n; i++)
+					ok &= code30[i] == slow_interleave(
+						slow_cell(points[i], bounds, 0, 10),
+						slow_cell(points[i], bounds, 1, 10),
+						slow_cell(points[i], bounds, 2, 10), 10);
+				/* nothing written past count */
+				ok &= code30[n] == 0xffffffffu;
+			}
+			morton30_encode(code30, points, N, bounds);
+			morton63_encode(code63, points, N, bounds);
+			for (int i = 0; i < N; i++) {
+				ok &= code30[i] == slow_interleave(
+					slow_cell(points[i], bounds, 0, 10),
+					slow_cell(points[i], bounds, 1, 10),
+					slow_cell(points[i], bounds, 2, 10), 10);
+				ok &= code63[i] == slow_interleave(
+					slow_cell(points[i], bounds, 0, 21),
+					slow_cell(points[i], bounds, 1, 21),
+					slow_cell(points[i], bounds, 2, 21), 21);
+			}
+			fct_chk(ok);
+			fct_chk(code30[5] == (1u << 30) - 1);
+			fct_chk_eq_int(code30[6], 0);
+			fct_chk_eq_int(code30[7], 0);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("hilbert_encode")
+		{
+			int ok = 1;
+			hilbert30_encode(code30, points, N, bounds);
+			hilbert63_encode(code63, points, N, bounds);
+			for (int i = 0; i < N; i++) {
+				ok &= code30[i] == hilbert30(
+					slow_cell(points[i], bounds, 0, 10),
+					slow_cell(points[i], bounds, 1, 10),
+					slow_cell(points[i], bounds, 2, 10));
+				ok &= code63[i] == hilbert63(
+					slow_cell(points[i], bounds, 0, 21),
+					slow_cell(points[i], bounds, 1, 21),
+					slow_cell(points[i], bounds, 2, 21));
+			}
+			fct_chk(ok);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("morton_sort")
+		{
+			static uint32_t keys[N];
+			static uint64_t keys63[N];
+			static vec3 sorted[N];
+			static int ids[N], moved[N];
+			int ok = 1;
+
+			morton30_encode(code30, points, N, bounds);
+			memcpy(keys, code30, sizeof(keys));
+			fct_req(morton_sort30(keys, perm, N) == 0);
+			for (int i = 0; i < N; i++) {
+				ok &= keys[i] == code30[perm[i]];
+				if (i)
+					ok &= keys[i - 1] < keys[i] || (keys[i - 1] == keys[i] &&
+						perm[i - 1] < perm[i]);
+			}
+			fct_chk(ok);
+
+			morton_permute(sorted, points, sizeof(vec3), perm, N);
+			for (int i = 0; i < N; i++)
+				ids[i] = i * 3;
+			morton_permute(moved, ids, sizeof(int), perm, N);
+			for (int i = 0; i < N; i++)
+				ok &= moved[i] == perm[i] * 3 &&
+					!memcmp(&sorted[i], &points[perm[i]], sizeof(vec3));
+			fct_chk(ok);
+
+			hilbert63_encode(code63, points, N, bounds);
+			memcpy(keys63, code63, sizeof(keys63));
+			fct_req(morton_sort63(keys63, perm, N) == 0);
+			for (int i = 0; i < N; i++) {
+				ok &= keys63[i] == code63[perm[i]];
+				if (i)
+					ok &= keys63[i - 1] <= keys63[i];
+			}
+			fct_chk(ok);
+
+			/* every digit shared, no pass moves anything */
+			for (int i = 0; i < N; i++)
+				keys[i] = 77;
+			fct_req(morton_sort30(keys, perm, N) == 0);
+			for (int i = 0; i < N; i++)
+				ok &= perm[i] == i;
+			fct_chk(ok);
+			fct_chk(morton_sort30(keys, perm, 0) == 0);
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
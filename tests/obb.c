@@ -0,0 +1,240 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * obb.c
+ * Tests obb.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/quat.h>
+#include <gmath/obb.h>
+
+#define N 2000
+
+#define CHK_NEAR(a, b) fct_chk(fabsf((a) - (b)) <= 1e-4f * (1.0f + fabsf(b)))
+
+static float randf(unsigned int *seed)
+{
+	*seed = *seed * 1664525u + 1013904223u;
+	return (*seed >> 8) / (float)(1 << 24);
+}
+
+static obb random_obb(unsigned int *seed, float spread)
+{
+	mat4 m;
+	quat q = quat_normalize(_mm_setr_ps(randf(seed) - 0.5f,
+		randf(seed) - 0.5f, randf(seed) - 0.5f, randf(seed) - 0.5f));
+	m = quat_to_mat4(q);
+	m.col[3] = _mm_setr_ps((randf(seed) - 0.5f) * spread,
+		(randf(seed) - 0.5f) * spread, (randf(seed) - 0.5f) * spread, 1.0f);
+	return obb_from_mat4(m, _mm_setr_ps(0.1f + randf(seed),
+		0.1f + randf(seed), 0.1f + randf(seed), 0.0f));
+}
+
+static void corners(const obb *b, vec3 *out)
+{
+	for (int i = 0; i < 8; i++) {
+		vec3 p = b->center;
+		for (int k = 0; k < 3; k++)
+			p = vec3_add(p, vec3_scale(b->axis[k], (i >> k & 1 ?
+				1.0f : -1.0f) * fidx(b->half, k)));
+		out[i] = p;
+	}
+}
+
+/* Whether l separates the corners of a and b, 0 for a zero axis. */
+static int separates(const vec3 *ca, const vec3 *cb, const vec3 l)
+{
+	float alo = INFINITY, ahi = -INFINITY, blo = INFINITY, bhi = -INFINITY;
+	if (vec3_dot(l, l) < 1e-10f)
+		return 0;
+	for (int i = 0; i < 8; i++) {
+		float a = vec3_dot(ca[i], l), b = vec3_dot(cb[i], l);
+		alo = fminf(alo, a), ahi = fmaxf(ahi, a);
+		blo = fminf(blo, b), bhi = fmaxf(bhi, b);
+	}
+	return ahi < blo || bhi < alo;
+}
+
+/* 1 for a face axis gap, 2 when only an edge pair separates, else 0. */
+static int brute_separated(const obb *a, const obb *b)
+{
+	vec3 ca[8], cb[8];
+	corners(a, ca);
+	corners(b, cb);
+	for (int i = 0; i < 3; i++)
+		if (separates(ca, cb, a->axis[i]) || separates(ca, cb, b->axis[i]))
+			return 1;
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			if (separates(ca, cb, vec3_cross(a->axis[i], b->axis[j])))
+				return 2;
+	return 0;
+}
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("obb")
+	{
+		FCT_SETUP_BGN()
+		{
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("obb_from_mat4")
+		{
+			mat4 m;
+			obb b;
+			aabb a = {{-1.0f, -2.0f, -3.0f, 0.0f}, {3.0f, 2.0f, 1.0f, 0.0f}};
+			aabb t, ob;
+			vec3 o;
+			m = quat_to_mat4(quat_normalize(_mm_setr_ps(0.2f, 0.4f, -0.1f,
+				0.9f)));
+			m.col[0] = vec3_scale(m.col[0], 2.0f);
+			m.col[3] = _mm_setr_ps(5.0f, 6.0f, 7.0f, 1.0f);
+			b = obb_from_mat4(m, _mm_setr_ps(1.0f, 2.0f, 3.0f, 0.0f));
+			CHK_NEAR(vec3_length(b.axis[0]), 1.0f);
+			CHK_NEAR(vec3_dot(b.axis[0], b.axis[1]), 0.0f);
+			CHK_NEAR(fidx(b.half, 0), 2.0f);
+			CHK_NEAR(fidx(b.half, 2), 3.0f);
+			CHK_NEAR(fidx(b.center, 1), 6.0f);
+
+			/* back to a matrix taking the unit cube onto the box */
+			m = obb_to_mat4(&b);
+			CHK_NEAR(vec3_length(m.col[1]), 2.0f);
+			o = mat4_transform_point(m, _mm_setzero_ps());
+			CHK_NEAR(fidx(o, 2), 7.0f);
+
+			/* the bounds match those of the transformed box */
+			b = obb_from_aabb(m, a);
+			t = aabb_transform(m, a);
+			ob = obb_bounds(&b);
+			CHK_NEAR(fidx(ob.min, 0), fidx(t.min, 0));
+			CHK_NEAR(fidx(ob.max, 1), fidx(t.max, 1));
+			CHK_NEAR(fidx(ob.max, 2), fidx(t.max, 2));
+			fct_chk(obb_contains(&b, mat4_transform_point(m,
+				_mm_setr_ps(2.9f, -1.9f, 0.9f, 0.0f))));
+			fct_chk(!obb_contains(&b, mat4_transform_point(m,
+				_mm_setr_ps(3.1f, 0.0f, 0.0f, 0.0f))));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("obb_overlap")
+		{
+			unsigned int seed = 5;
+			int overlaps = 0, edges = 0;
+			for (int i = 0; i < N; i++) {
+				obb a = random_obb(&seed, 3.0f), b = random_obb(&seed, 3.0f);
+				int s = brute_separated(&a, &b);
+				fct_chk_eq_int(obb_overlap(&a, &b), !s);
+				fct_chk_eq_int(obb_overlap(&b, &a), !s);
+				overlaps += !s;
+				edges += s == 2;
+				if (!s)
+					fct_chk(aabb_overlap(obb_bounds(&a), obb_bounds(&b)));
+			}
+			/* all three kinds of outcome were seen */
+			fct_chk(overlaps > N / 10 && overlaps < N - N / 10);
+			fct_chk(edges > 0);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("obb_overlap_parallel")
+		{
+			mat4 m = MAT4_IDENTITY;
+			obb a = obb_from_mat4(m, _mm_set1_ps(1.0f)), b = a;
+			fct_chk(obb_overlap(&a, &b));
+			b.center = _mm_setr_ps(2.0f, 0.0f, 0.0f, 0.0f);
+			fct_chk(obb_overlap(&a, &b));
+			b.center = _mm_setr_ps(2.01f, 0.5f, 0.0f, 0.0f);
+			fct_chk(!obb_overlap(&a, &b));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("obb_ray")
+		{
+			mat4 m;
+			obb b;
+			ray r = {{-5.0f, 0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f, 0.0f}};
+			float t;
+			m = quat_to_mat4(_mm_setr_ps(0.0f, 0.0f, sinf(PI / 8),
+				cosf(PI / 8)));
+			m.col[3] = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+			b = obb_from_mat4(m, _mm_set1_ps(1.0f));
+
+			/* the corner at -sqrt(2) along x comes first */
+			fct_chk(obb_ray(&b, &r, 100.0f, &t));
+			CHK_NEAR(t, 5.0f - sqrtf(2.0f));
+			fct_chk(!obb_ray(&b, &r, 3.0f, &t));
+			r.origin = _mm_setr_ps(-5.0f, 1.5f, 0.0f, 0.0f);
+			fct_chk(!obb_ray(&b, &r, 100.0f, &t));
+			r.origin = _mm_setr_ps(0.2f, 0.1f, 0.0f, 0.0f);
+			fct_chk(obb_ray(&b, &r, 100.0f, &t));
+			CHK_NEAR(t, 0.0f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("obb_from_points")
+		{
+			unsigned int seed = 3;
+			static vec3 p[N];
+			obb b = random_obb(&seed, 4.0f), f;
+			vec3 c[8], s = _mm_set1_ps(1.0f + 1e-4f), e;
+
+			/* box corners and points inside */
+			corners(&b, c);
+			for (int i = 0; i < N; i++)
+				p[i] = i < 8 ? c[i] : vec3_add(b.center, vec3_add(vec3_add(
+					vec3_scale(b.axis[0], (randf(&seed) * 2.0f - 1.0f) *
+					fidx(b.half, 0)),
+					vec3_scale(b.axis[1], (randf(&seed) * 2.0f - 1.0f) *
+					fidx(b.half, 1))),
+					vec3_scale(b.axis[2], (randf(&seed) * 2.0f - 1.0f) *
+					fidx(b.half, 2))));
+			f = obb_from_points(p, N);
+			e = aabb_extent(aabb_from_points(p, N));
+			f.half = vec3_mul(f.half, s);
+			for (int i = 0; i < N; i++)
+				fct_chk(obb_contains(&f, p[i]));
+			CHK_NEAR(vec3_dot(vec3_cross(f.axis[0], f.axis[1]), f.axis[2]),
+				1.0f);
+			fct_chk(obb_volume(&f) < 8.0f * fidx(e, 0) * fidx(e, 1) *
+				fidx(e, 2));
+
+			/* the corners alone give back the box */
+			f = obb_from_points(c, 8);
+			CHK_NEAR(obb_volume(&f), obb_volume(&b));
+			CHK_NEAR(vec3_length(vec3_sub(f.center, b.center)), 0.0f);
+
+			/* an axis aligned cloud keeps its bounds */
+			for (int i = 0; i < 8; i++)
+				p[i] = _mm_setr_ps(i & 1 ? 2.0f : -1.0f, i & 2 ? 1.0f : 0.0f,
+					i & 4 ? 0.5f : 0.0f, 0.0f);
+			f = obb_from_points(p, 8);
+			CHK_NEAR(obb_volume(&f), 3.0f * 1.0f * 0.5f);
+			CHK_NEAR(fidx(f.center, 0), 0.5f);
+
+			/* flat and single point clouds */
+			for (int i = 0; i < 4; i++)
+				p[i] = _mm_setr_ps((float)(i & 1), (float)(i >> 1), 2.0f,
+					0.0f);
+			f = obb_from_points(p, 4);
+			CHK_NEAR(obb_volume(&f), 0.0f);
+			fct_chk(obb_contains(&f, _mm_setr_ps(0.5f, 0.5f, 2.0f, 0.0f)));
+			f = obb_from_points(p, 1);
+			CHK_NEAR(fidx(f.center, 2), 2.0f);
+			CHK_NEAR(fidx(f.half, 0), 0.0f);
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
@@ -0,0 +1,193 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * occlusion.c
+ * Tests occlusion.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/occlusion.h>
+
+#define W 160
+#define H 96
+#define TRIS 300
+
+static float randf(unsigned int *seed)
+{
+	*seed = *seed * 1664525u + 1013904223u;
+	return (*seed >> 8) / (float)(1 << 24);
+}
+
+static aabb box(float x0, float y0, float z0, float x1, float y1, float z1)
+{
+	aabb b = {{x0, y0, z0, 0.0f}, {x1, y1, z1, 0.0f}};
+	return b;
+}
+
+/* Depth of pixel (x, y) wherever its tile is stored. */
+static float depth_at(const occlusion_buffer *b, int x, int y)
+{
+	int t = y / OCCLUSION_TILE_H * b->tiles_x + x / OCCLUSION_TILE_W;
+	return b->depth[(size_t)t * OCCLUSION_TILE + y % OCCLUSION_TILE_H *
+		OCCLUSION_TILE_W + x % OCCLUSION_TILE_W];
+}
+
+static occlusion_buffer b;
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("occlusion")
+	{
+		/* a wall two units wide and high, ten units down -z */
+		vec3 wall[4] = {{-1.0f, -1.0f, -10.0f, 0.0f},
+			{1.0f, -1.0f, -10.0f, 0.0f}, {1.0f, 1.0f, -10.0f, 0.0f},
+			{-1.0f, 1.0f, -10.0f, 0.0f}};
+		int quad[6] = {0, 1, 2, 0, 2, 3};
+		mat4 proj;
+
+		FCT_SETUP_BGN()
+		{
+			proj = mat4_perspective(PI / 2.0f, (float)W / H, 0.5f, 100.0f);
+			fct_req(occlusion_init(&b, W, H, 1) == 0);
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+			occlusion_free(&b);
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("occlusion_draw")
+		{
+			int covered = 0, ok = occlusion_draw(&b, proj, wall, quad, 2);
+			fct_chk_eq_int(ok, 0);
+			/* 1/w is the distance to the wall wherever it is drawn */
+			for (int y = 0; y < H; y++)
+				for (int x = 0; x < W; x++) {
+					float d = depth_at(&b, x, y);
+					if (d != 0.0f) {
+						fct_chk(fabsf(d - 0.1f) < 1e-6f);
+						covered++;
+					}
+				}
+			/* the wall spans a tenth of the view in each direction */
+			fct_chk(fabsf(covered - 0.1f * H * 0.1f * H) <= 0.1f * (W + H));
+			fct_chk_eq_dbl(depth_at(&b, W / 2, H / 2), 0.1f);
+			fct_chk_eq_dbl(depth_at(&b, 0, 0), 0.0f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("occlusion_test_aabb")
+		{
+			aabb behind = box(-0.5f, -0.5f, -30.0f, 0.5f, 0.5f, -20.0f);
+			aabb front = box(-0.5f, -0.5f, -8.0f, 0.5f, 0.5f, -6.0f);
+			aabb side = box(0.5f, -0.5f, -30.0f, 3.0f, 0.5f, -20.0f);
+			aabb eye = box(-0.5f, -0.5f, -30.0f, 0.5f, 0.5f, 1.0f);
+			aabb off = box(50.0f, -0.5f, -30.0f, 60.0f, 0.5f, -20.0f);
+			vec3 tilt[4];
+			occlusion_draw(&b, proj, wall, quad, 2);
+			fct_chk(!occlusion_test_aabb(&b, proj, &behind));
+			fct_chk(occlusion_test_aabb(&b, proj, &front));
+			fct_chk(occlusion_test_aabb(&b, proj, &side));
+			fct_chk(occlusion_test_aabb(&b, proj, &eye));
+			fct_chk(!occlusion_test_aabb(&b, proj, &off));
+
+			/* a wall leaning away hides what it is in front of */
+			for (int i = 0; i < 4; i++)
+				tilt[i] = _mm_add_ps(wall[i], _mm_setr_ps(0.0f, 0.0f,
+					fidx(wall[i], 1) * -3.0f, 0.0f));
+			occlusion_draw(&b, proj, tilt, quad, 2);
+			behind = box(-0.2f, -0.2f, -12.0f, 0.2f, 0.2f, -11.0f);
+			fct_chk(!occlusion_test_aabb(&b, proj, &behind));
+			behind = box(-0.2f, 0.4f, -12.0f, 0.2f, 0.6f, -11.0f);
+			fct_chk(occlusion_test_aabb(&b, proj, &behind));
+
+			/* nothing behind the near plane is drawn */
+			for (int i = 0; i < 4; i++)
+				tilt[i] = _mm_setr_ps(fidx(wall[i], 0) * 5.0f,
+					fidx(wall[i], 1) * 5.0f, i & 1 ? 1.0f : -3.0f, 0.0f);
+			occlusion_draw(&b, proj, tilt, quad, 2);
+			for (int t = 0; t < b.tiles; t++)
+				fct_chk_eq_dbl(b.tile_far[t], 0.0f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("occlusion_tasks")
+		{
+			static vec3 v[3 * TRIS];
+			static int idx[3 * TRIS];
+			static aabb q[64];
+			static int vis1[64], vis3[64];
+			unsigned int seed = 9;
+			occlusion_buffer b3;
+			int n1, n3, ok, edges = 0;
+
+			for (int i = 0; i < 3 * TRIS; i++) {
+				float z = -2.0f - 30.0f * randf(&seed);
+				v[i] = _mm_setr_ps((randf(&seed) * 2.0f - 1.0f) * -z,
+					(randf(&seed) * 2.0f - 1.0f) * -z * 0.6f, z, 0.0f);
+				idx[i] = i;
+			}
+			occlusion_draw(&b, proj, v, idx, TRIS);
+			/* counted out of order, and rendered in two halves */
+			ok = occlusion_init(&b3, W, H, 3) == 0;
+			ok = ok && occlusion_bin_begin(&b3, proj, v, idx, TRIS) == 0;
+			for (int t = 2; t >= 0; t--)
+				occlusion_bin_count(&b3, t);
+			ok = ok && occlusion_bin_offsets(&b3) == 0;
+			fct_chk(ok);
+			for (int t = 0; t < 3; t++)
+				occlusion_bin_scatter(&b3, t);
+			occlusion_render(&b3, b3.tiles / 2, b3.tiles);
+			occlusion_render(&b3, 0, b3.tiles / 2);
+			fct_chk(!memcmp(b.depth, b3.depth,
+				sizeof(float) * b.tiles * OCCLUSION_TILE));
+
+			/* every pixel holds the nearest triangle covering its centre */
+			for (int y = 0; y < H; y += 3)
+				for (int x = 0; x < W; x += 3) {
+					float best = 0.0f, d = depth_at(&b, x, y);
+					int sure = 1;
+					for (int i = 0; i < TRIS; i++) {
+						occlusion_tri r;
+						float e[3], m;
+						occlusion_setup(&b, &r, i);
+						if (r.x0 == r.x1)
+							continue;
+						for (int k = 0; k < 3; k++)
+							e[k] = r.ex[k] * x + r.ey[k] * y + r.e0[k];
+						m = fminf(fminf(e[0], e[1]), e[2]);
+						sure &= fabsf(m) > 1e-3f;
+						if (m >= 0.0f)
+							best = fmaxf(best, r.zx * x + r.zy * y + r.z0);
+					}
+					if (sure)
+						fct_chk(fabsf(d - best) <= 1e-5f * best);
+					else
+						edges++;
+				}
+			fct_chk(edges < W * H / 90);
+
+			for (int i = 0; i < 64; i++) {
+				float x = randf(&seed) * 40.0f - 20.0f;
+				float y = randf(&seed) * 20.0f - 10.0f;
+				float z = -5.0f - 40.0f * randf(&seed);
+				q[i] = box(x, y, z, x + 1.0f, y + 1.0f, z + 1.0f);
+			}
+			n1 = occlusion_cull_aabbs(&b, proj, q, 64, vis1);
+			n3 = occlusion_cull_aabbs(&b3, proj, q, 64, vis3);
+			fct_chk_eq_int(n1, n3);
+			fct_chk(n1 > 0 && n1 < 64);
+			for (int i = 0; i < n1; i++)
+				fct_chk_eq_int(vis1[i], vis3[i]);
+			occlusion_free(&b3);
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
@@ -0,0 +1,111 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * project.c
+ * Tests project.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/project.h>
+
+#define N 43
+
+#define CHK_NEAR(a, b) fct_chk(fabsf((a) - (b)) <= 1e-4f * (1.0f + fabsf(b)))
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("project")
+	{
+		viewport v = {10.0f, 20.0f, 640.0f, 480.0f, 0.0f, 1.0f};
+		mat4 vp;
+
+		FCT_SETUP_BGN()
+		{
+			vec3 eye = {0.0f, 2.0f, 10.0f, 0.0f};
+			vec3 at = {0.0f, 0.0f, 0.0f, 0.0f};
+			vec3 up = {0.0f, 1.0f, 0.0f, 0.0f};
+			vp = mat4_mul(mat4_perspective(PI / 3.0f, 640.0f / 480.0f, 0.5f,
+				50.0f), mat4_look_at(eye, at, up));
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("project_point")
+		{
+			mat4 m = mat4_ortho(-1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 3.0f);
+			vec3 s;
+			fct_chk_eq_int(project_point(&s, m, &v,
+				_mm_setr_ps(0.0f, 0.0f, -2.0f, 0.0f)), 0);
+			CHK_NEAR(fidx(s, 0), 330.0f);
+			CHK_NEAR(fidx(s, 1), 260.0f);
+			CHK_NEAR(fidx(s, 2), 0.5f);
+			fct_chk_eq_int(project_point(&s, m, &v,
+				_mm_setr_ps(-1.0f, 1.0f, -1.0f, 0.0f)), 0);
+			CHK_NEAR(fidx(s, 0), 10.0f);
+			CHK_NEAR(fidx(s, 1), 500.0f);
+			CHK_NEAR(fidx(s, 2), 0.0f);
+
+			/* each plane on its own */
+			fct_chk_eq_int(project_point(&s, m, &v, _mm_setr_ps(-1.5f, 0.0f,
+				-2.0f, 0.0f)), PROJECT_LEFT);
+			fct_chk_eq_int(project_point(&s, m, &v, _mm_setr_ps(1.5f, 0.0f,
+				-2.0f, 0.0f)), PROJECT_RIGHT);
+			fct_chk_eq_int(project_point(&s, m, &v, _mm_setr_ps(0.0f, -1.5f,
+				-2.0f, 0.0f)), PROJECT_BOTTOM);
+			fct_chk_eq_int(project_point(&s, m, &v, _mm_setr_ps(0.0f, 1.5f,
+				-2.0f, 0.0f)), PROJECT_TOP);
+			fct_chk_eq_int(project_point(&s, m, &v, _mm_setr_ps(0.0f, 0.0f,
+				-0.5f, 0.0f)), PROJECT_NEAR);
+			fct_chk_eq_int(project_point(&s, m, &v, _mm_setr_ps(2.0f, 2.0f,
+				-4.0f, 0.0f)), PROJECT_RIGHT | PROJECT_TOP | PROJECT_FAR);
+
+			/* behind the eye is outside the near plane */
+			fct_chk(project_point(&s, vp, &v, _mm_setr_ps(0.0f, 2.0f, 12.0f,
+				0.0f)) & PROJECT_NEAR);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("project_points")
+		{
+			vec3 p[N], s[N], r;
+			unsigned char codes[N + 1];
+			int n, inside = 0, outside = 0;
+			for (int i = 0; i < N; i++)
+				p[i] = _mm_setr_ps(sinf(i * 1.3f) * 8.0f, cosf(i * 0.7f) * 5.0f,
+					12.0f * sinf(i * 0.37f), 0.0f);
+			codes[N] = 0xaa;
+			n = project_points(s, codes, vp, &v, p, N);
+			fct_chk_eq_int(codes[N], 0xaa);
+			for (int i = 0; i < N; i++) {
+				int c = project_point(&r, vp, &v, p[i]);
+				fct_chk_eq_int(codes[i], c);
+				inside += c == 0;
+				outside += c != 0;
+				if (c == 0)
+					for (int j = 0; j < 3; j++)
+						CHK_NEAR(fidx(s[i], j), fidx(r, j));
+			}
+			fct_chk_eq_int(n, inside);
+			fct_chk(inside > 0 && outside > 0);
+
+			/* a flipped viewport gives y down from the top edge */
+			v.y = 480.0f;
+			v.height = -480.0f;
+			p[0] = _mm_setr_ps(0.25f, 0.75f, 0.0f, 0.0f);
+			project_points(s, codes, mat4_ortho(0.0f, 1.0f, 0.0f, 1.0f,
+				-1.0f, 1.0f), &v, p, 1);
+			CHK_NEAR(fidx(s[0], 0), 170.0f);
+			CHK_NEAR(fidx(s[0], 1), 120.0f);
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
@@ -0,0 +1,416 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * quat.c
+ * Tests quat.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/quat.h>
+
+/* The approximate trigonometry will not reach DBL_EPSILON. */
+#ifdef DBL_EPSILON
+#undef DBL_EPSILON
+#endif
+#define DBL_EPSILON 1e-5
+
+/* Reference slerp in double precision. */
+static void ref_slerp(double *out, const float *a, const float *b, double t)
+{
+	double cosom = a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3];
+	double s = cosom < 0.0 ? -1.0 : 1.0;
+	double omega = acos(fabs(cosom) > 1.0 ? 1.0 : fabs(cosom));
+	double scale0 = 1.0 - t, scale1 = t;
+	if (omega > 1e-6) {
+		scale0 = sin((1.0 - t) * omega) / sin(omega);
+		scale1 = sin(t * omega) / sin(omega);
+	}
+	for (int i = 0; i < 4; i++)
+		out[i] = scale0 * a[i] + s * scale1 * b[i];
+}
+
+static quat axis_angle(float x, float y, float z, float a)
+{
+	float s = sinf(a * 0.5f) / sqrtf(x*x + y*y + z*z);
+	quat q = {x * s, y * s, z * s, cosf(a * 0.5f)};
+	return q;
+}
+
+/* Largest difference between the entries of two affine matrices. */
+static float mat4_diff(const mat4 a, const mat4 b)
+{
+	float e = 0.0f;
+	for (int i = 0; i < 4; i++) {
+		vec4 d = vec4_sub(a.col[i], b.col[i]);
+		for (int j = 0; j < 3; j++)
+			e = fmaxf(e, fabsf(fidx(d, j)));
+	}
+	return e;
+}
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("quat")
+	{
+		quat q1[8], q2[8];
+		float t[8];
+
+		FCT_SETUP_BGN()
+		{
+			for (int i = 0; i < 8; i++) {
+				q1[i] = axis_angle(1.0f, 0.5f * i, -0.25f, 0.3f * i);
+				q2[i] = axis_angle(-0.5f, 1.0f, 0.1f * i, 2.9f - 0.4f * i);
+				t[i] = i / 7.0f;
+			}
+			/* opposite hemisphere and nearly identical pairs */
+			q2[2] = vec4_neg(q2[2]);
+			q2[5] = vec4_add(q1[5], float_to_m128_const(1e-8f));
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("quat_slerp")
+		{
+			for (int i = 0; i < 8; i++) {
+				double r[4];
+				quat q = quat_slerp(q1[i], q2[i], t[i]);
+				ref_slerp(r, (float *)&q1[i], (float *)&q2[i], t[i]);
+				for (int j = 0; j < 4; j++)
+					fct_chk_eq_dbl(fidx(q, j), r[j]);
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_soa_load_store")
+		{
+			quat out[4];
+			quat_soa s = quat_soa_load(q1);
+			fct_chk_eq_dbl(fidx(s.x, 1), fidx(q1[1], 0));
+			fct_chk_eq_dbl(fidx(s.w, 2), fidx(q1[2], 3));
+			quat_soa_store(out, s);
+			for (int i = 0; i < 4; i++)
+				for (int j = 0; j < 4; j++)
+					fct_chk_eq_dbl(fidx(out[i], j), fidx(q1[i], j));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_soa_slerp")
+		{
+			quat out[4];
+			quat_soa_store(out, quat_soa_slerp(quat_soa_load(q1),
+					quat_soa_load(q2), _mm_loadu_ps(t)));
+			for (int i = 0; i < 4; i++) {
+				double r[4];
+				ref_slerp(r, (float *)&q1[i], (float *)&q2[i], t[i]);
+				for (int j = 0; j < 4; j++)
+					fct_chk_eq_dbl(fidx(out[i], j), r[j]);
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_slerp_array")
+		{
+			quat out[7];
+			quat_slerp_array(out, q1, q2, t, 7);
+			for (int i = 0; i < 7; i++) {
+				double r[4];
+				ref_slerp(r, (float *)&q1[i], (float *)&q2[i], t[i]);
+				for (int j = 0; j < 4; j++)
+					fct_chk_eq_dbl(fidx(out[i], j), r[j]);
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_lerp")
+		{
+			quat q = quat_lerp(q1[1], q2[1], 0.25f);
+			for (int j = 0; j < 4; j++)
+				fct_chk_eq_dbl(fidx(q, j), fidx(q1[1], j) * 0.75f +
+						fidx(q2[1], j) * 0.25f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_nlerp")
+		{
+			/* q2[2] is in the opposite hemisphere, the flip is undone */
+			quat q = quat_nlerp(q1[2], q2[2], 0.5f);
+			quat r = quat_normalize(vec4_sub(q1[2], q2[2]));
+			fct_chk_eq_dbl(vec4_dot(q, q), 1.0f);
+			for (int j = 0; j < 4; j++)
+				fct_chk_eq_dbl(fidx(q, j), fidx(r, j));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_onlerp")
+		{
+			for (int i = 0; i < 8; i++) {
+				double r[4];
+				quat q = quat_onlerp(q1[i], q2[i], t[i]);
+				ref_slerp(r, (float *)&q1[i], (float *)&q2[i], t[i]);
+				for (int j = 0; j < 4; j++)
+					fct_chk(fabs(fidx(q, j) - r[j]) < 1e-3);
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_nlerp_array")
+		{
+			quat out[7];
+			quat_nlerp_array(out, q1, q2, t, 7);
+			for (int i = 0; i < 7; i++) {
+				quat q = quat_nlerp(q1[i], q2[i], t[i]);
+				for (int j = 0; j < 4; j++)
+					fct_chk_eq_dbl(fidx(out[i], j), fidx(q, j));
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_onlerp_array")
+		{
+			quat out[7];
+			quat_onlerp_array(out, q1, q2, t, 7);
+			for (int i = 0; i < 7; i++) {
+				quat q = quat_onlerp(q1[i], q2[i], t[i]);
+				for (int j = 0; j < 4; j++)
+					fct_chk_eq_dbl(fidx(out[i], j), fidx(q, j));
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_mul")
+		{
+			quat a = {0.1f, 0.2f, 0.3f, 0.9f};
+			quat b = {-0.4f, 0.5f, 0.1f, 0.7f};
+			quat q = quat_mul(a, b);
+			fct_chk_eq_dbl(fidx(q, 0), -0.42f);
+			fct_chk_eq_dbl(fidx(q, 1), 0.46f);
+			fct_chk_eq_dbl(fidx(q, 2), 0.43f);
+			fct_chk_eq_dbl(fidx(q, 3), 0.54f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_inverse")
+		{
+			quat a = {0.2f, -0.4f, 1.0f, 2.0f};
+			quat q = quat_mul(a, quat_inverse(a));
+			quat c = quat_conjugate(a);
+			fct_chk_eq_dbl(fidx(q, 0), 0.0f);
+			fct_chk_eq_dbl(fidx(q, 1), 0.0f);
+			fct_chk_eq_dbl(fidx(q, 2), 0.0f);
+			fct_chk_eq_dbl(fidx(q, 3), 1.0f);
+			fct_chk_eq_dbl(fidx(c, 1), 0.4f);
+			fct_chk_eq_dbl(fidx(c, 3), 2.0f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_rotate_vec3")
+		{
+			vec3 v = {1.0f, 2.0f, 3.0f, 0.0f};
+			quat q = axis_angle(0.0f, 0.0f, 1.0f, PI / 2.0f);
+			vec3 r = quat_rotate_vec3(q, v);
+			fct_chk_eq_dbl(fidx(r, 0), -2.0f);
+			fct_chk_eq_dbl(fidx(r, 1), 1.0f);
+			fct_chk_eq_dbl(fidx(r, 2), 3.0f);
+			/* matches the sandwich product q v q* */
+			quat s = quat_mul(quat_mul(q1[3], v), quat_conjugate(q1[3]));
+			r = quat_rotate_vec3(q1[3], v);
+			for (int j = 0; j < 3; j++)
+				fct_chk_eq_dbl(fidx(r, j), fidx(s, j));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_to_mat4")
+		{
+			vec3 v = {1.0f, -2.0f, 0.5f, 0.0f};
+			for (int i = 0; i < 8; i++) {
+				mat4 m = quat_to_mat4(q2[i]);
+				vec3 r = quat_rotate_vec3(q2[i], v);
+				vec3 t = mat4_transform_normal(m, v);
+				for (int j = 0; j < 3; j++)
+					fct_chk_eq_dbl(fidx(t, j), fidx(r, j));
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_from_mat4")
+		{
+			for (int i = 0; i < 8; i++) {
+				quat q = quat_from_mat4(quat_to_mat4(q2[i]));
+				float s = vec4_dot(q, q2[i]) < 0.0f ? -1.0f : 1.0f;
+				for (int j = 0; j < 4; j++)
+					fct_chk_eq_dbl(fidx(q, j), s * fidx(q2[i], j));
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_toolkit_array")
+		{
+			vec3 v[7], rv[7];
+			mat4 m[7];
+			quat qi[7], qm[7], qn[7];
+			for (int i = 0; i < 7; i++)
+				v[i] = _mm_setr_ps(i, 1.0f - i, 0.5f * i, 0.0f);
+			quat_rotate_vec3_array(rv, q1, v, 7);
+			quat_inverse_array(qi, q2, 7);
+			quat_to_mat4_array(m, q2, 7);
+			quat_from_mat4_array(qm, m, 7);
+			quat_normalize_array(qn, qm, 7);
+			for (int i = 0; i < 7; i++) {
+				vec3 r = quat_rotate_vec3(q1[i], v[i]);
+				quat a = quat_inverse(q2[i]);
+				mat4 b = quat_to_mat4(q2[i]);
+				quat c = quat_from_mat4(b);
+				for (int j = 0; j < 4; j++) {
+					if (j < 3)
+						fct_chk_eq_dbl(fidx(rv[i], j), fidx(r, j));
+					fct_chk_eq_dbl(fidx(qi[i], j), fidx(a, j));
+					fct_chk_eq_dbl(fidx(qm[i], j), fidx(c, j));
+					fct_chk_eq_dbl(fidx(qn[i], j), fidx(c, j));
+					for (int k = 0; k < 4; k++)
+						fct_chk_eq_dbl(fidx(m[i].col[k], j),
+							fidx(b.col[k], j));
+				}
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("mat4_decompose")
+		{
+			vec3 tv = {4.0f, -1.0f, 2.5f, 0.0f}, t, s;
+			quat r;
+			for (int i = 0; i < 8; i++) {
+				vec3 sv = _mm_setr_ps(0.5f + i, 2.0f, 1.0f + 0.1f * i, 0.0f);
+				mat4 m;
+				float d;
+
+				/* positive and mirrored scale come back as given */
+				for (int k = 0; k < 2; k++) {
+					m = mat4_compose(tv, q2[i], sv);
+					mat4_decompose(&t, &r, &s, m);
+					d = vec4_dot(r, q2[i]) < 0.0f ? -1.0f : 1.0f;
+					for (int j = 0; j < 3; j++) {
+						fct_chk_eq_dbl(fidx(t, j), fidx(tv, j));
+						fct_chk_eq_dbl(fidx(s, j), fidx(sv, j));
+					}
+					for (int j = 0; j < 4; j++)
+						fct_chk_eq_dbl(fidx(r, j), d * fidx(q2[i], j));
+					fidx(sv, 0) = -fidx(sv, 0);
+				}
+
+				/* other reflections and zero scales still compose back */
+				sv = _mm_setr_ps(-1.0f, -2.0f, -0.5f * i, 0.0f);
+				m = mat4_compose(tv, q2[i], sv);
+				mat4_decompose(&t, &r, &s, m);
+				fct_chk(mat4_diff(mat4_compose(t, r, s), m) < 1e-5f);
+				fct_chk(fabsf(vec4_dot(r, r) - 1.0f) < 1e-5f);
+				sv = _mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f);
+				m = mat4_compose(tv, q2[i], sv);
+				mat4_decompose(&t, &r, &s, m);
+				fct_chk(mat4_diff(mat4_compose(t, r, s), m) < 1e-5f);
+				fct_chk(fabsf(vec4_dot(r, r) - 1.0f) < 1e-5f);
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("mat4_decompose_shear")
+		{
+			mat4 m = MAT4_IDENTITY, n;
+			vec3 t, s;
+			quat r;
+			m.col[1] = _mm_setr_ps(0.5f, 2.0f, 0.0f, 0.0f);
+			mat4_decompose(&t, &r, &s, m);
+			n = quat_to_mat4(r);
+			/* the rotation is kept and x is left where it was */
+			fct_chk(fabsf(vec4_dot(r, r) - 1.0f) < 1e-5f);
+			fct_chk_eq_dbl(fidx(n.col[0], 0), 1.0f);
+			fct_chk_eq_dbl(fidx(n.col[1], 1), 1.0f);
+			fct_chk_eq_dbl(fidx(s, 1), sqrtf(4.25f));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("mat4_decompose_flat")
+		{
+			vec3 y = {0.6f, 0.0f, 0.8f, 0.0f}, t[4], s[4], ts, ss;
+			mat4 m[4] = {MAT4_IDENTITY, MAT4_IDENTITY, MAT4_IDENTITY,
+				MAT4_IDENTITY}, c;
+			quat r[4], rs;
+			/* x zero, with y and z apart, equal and opposite */
+			for (int i = 0; i < 3; i++)
+				m[i].col[0] = _mm_setzero_ps();
+			m[0].col[2] = _mm_setr_ps(0.0f, 0.6f, 0.8f, 0.0f);
+			m[1].col[1] = m[1].col[2] = y;
+			m[2].col[1] = y;
+			m[2].col[2] = vec3_neg(y);
+			/* y zero with z opposite to x */
+			m[3].col[0] = y;
+			m[3].col[1] = _mm_setzero_ps();
+			m[3].col[2] = vec3_neg(y);
+			mat4_decompose_array(t, r, s, m, 4);
+			for (int i = 0; i < 4; i++) {
+				mat4_decompose(&ts, &rs, &ss, m[i]);
+				fct_chk(fabsf(vec4_dot(r[i], r[i]) - 1.0f) < 1e-5f);
+				fct_chk(fabsf(vec4_dot(rs, rs) - 1.0f) < 1e-5f);
+				/* the first two columns survive, z may lose its shear */
+				for (int k = 0; k < 2; k++) {
+					quat q = k ? r[i] : rs;
+					vec3 v = k ? s[i] : ss;
+					c = mat4_compose(t[i], q, v);
+					for (int j = 0; j < 6; j++)
+						fct_chk(fabsf(fidx(c.col[j / 3], j % 3) -
+							fidx(m[i].col[j / 3], j % 3)) < 1e-5f);
+				}
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("mat4_decompose_array")
+		{
+			mat4 m[7], c[7];
+			vec3 t[7], s[7];
+			quat r[7];
+			for (int i = 0; i < 7; i++) {
+				vec3 tv = _mm_setr_ps(i, 1.0f - i, 3.0f, 0.0f);
+				vec3 sv = _mm_setr_ps(i & 1 ? -1.0f : 2.0f, 0.5f,
+					i == 2 ? 0.0f : 1.5f, 0.0f);
+				m[i] = mat4_compose(tv, q1[i], sv);
+			}
+			mat4_decompose_array(t, r, s, m, 7);
+			mat4_compose_array(c, t, r, s, 7);
+			for (int i = 0; i < 7; i++) {
+				vec3 ts, ss;
+				quat rs;
+				mat4_decompose(&ts, &rs, &ss, m[i]);
+				fct_chk(mat4_diff(c[i], m[i]) < 1e-5f);
+				for (int j = 0; j < 4; j++) {
+					if (j < 3) {
+						fct_chk_eq_dbl(fidx(t[i], j), fidx(ts, j));
+						fct_chk_eq_dbl(fidx(s[i], j), fidx(ss, j));
+					}
+					fct_chk_eq_dbl(fidx(r[i], j), fidx(rs, j));
+				}
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_from_euler")
+		{
+			vec3 e = {0.3f, -0.7f, 1.2f, 0.0f};
+			mat4 r = mat4_from_angles(1.2f, -0.7f, 0.3f);
+			mat4 m = quat_to_mat4(quat_from_euler(e));
+			for (int i = 0; i < 3; i++)
+				for (int j = 0; j < 3; j++)
+					fct_chk_eq_dbl(fidx(m.col[i], j),
+						fidx(r.col[i], j));
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
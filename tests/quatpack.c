@@ -0,0 +1,98 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * quatpack.c
+ * Tests quatpack.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/quatpack.h>
+
+#ifdef DBL_EPSILON
+#undef DBL_EPSILON
+#endif
+#define DBL_EPSILON 1e-6
+
+#define N 13
+
+/* Largest component error, allowing for the q/-q ambiguity. */
+static float quat_error(const quat a, const quat b)
+{
+	float s = vec4_dot(a, b) < 0.0f ? -1.0f : 1.0f, e = 0.0f;
+	for (int j = 0; j < 4; j++) {
+		float d = fabsf(fidx(a, j) - s * fidx(b, j));
+		e = d > e ? d : e;
+	}
+	return e;
+}
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("quatpack")
+	{
+		quat q[N];
+
+		FCT_SETUP_BGN()
+		{
+			for (int i = 0; i < N; i++)
+				q[i] = quat_normalize(_mm_setr_ps(sinf(i * 1.3f),
+					cosf(i * 0.7f), 0.5f - 0.1f * i, i % 3 - 1.0f));
+			/* each component largest, and a negative largest */
+			q[0] = _mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f);
+			q[1] = _mm_setr_ps(0.0f, -1.0f, 0.0f, 0.0f);
+			q[2] = quat_normalize(_mm_setr_ps(0.1f, 0.2f, -0.9f, 0.3f));
+			q[3] = _mm_setr_ps(0.5f, 0.5f, 0.5f, 0.5f);
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("quat_pack32")
+		{
+			for (int i = 0; i < N; i++) {
+				quat r = quat_unpack32(quat_pack32(q[i]));
+				fct_chk(quat_error(q[i], r) < 2e-3f);
+				fct_chk(fabsf(vec4_dot(r, r) - 1.0f) < 4e-3f);
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_pack48")
+		{
+			fct_chk_eq_int(sizeof(quat48), 6);
+			for (int i = 0; i < N; i++) {
+				quat r = quat_unpack48(quat_pack48(q[i]));
+				fct_chk(quat_error(q[i], r) < 1e-4f);
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("quat_unpack_array")
+		{
+			quat32 p32[N];
+			quat48 p48[N];
+			quat r32[N], r48[N];
+			quat_pack32_array(p32, q, N);
+			quat_pack48_array(p48, q, N);
+			quat_unpack32_array(r32, p32, N);
+			quat_unpack48_array(r48, p48, N);
+			for (int i = 0; i < N; i++) {
+				quat a = quat_unpack32(p32[i]);
+				quat b = quat_unpack48(p48[i]);
+				for (int j = 0; j < 4; j++) {
+					fct_chk_eq_dbl(fidx(r32[i], j), fidx(a, j));
+					fct_chk_eq_dbl(fidx(r48[i], j), fidx(b, j));
+				}
+			}
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
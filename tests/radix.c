@@ -0,0 +1,186 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * radix.c
+ * Tests radix.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/radix.h>
+
+#define N 1003
+
+static uint32_t input[N], keys[N];
+static float finput[N], fkeys[N];
+static int perm[N];
+
+/* Sorted, stable, and perm maps each key back to its input. */
+static int check_sorted(const uint32_t *k, const uint32_t *in, int count)
+{
+	int ok = 1;
+	for (int i = 0; i < count; i++) {
+		ok &= k[i] == in[perm[i]];
+		if (i)
+			ok &= k[i - 1] < k[i] || (k[i - 1] == k[i] &&
+				perm[i - 1] < perm[i]);
+	}
+	return ok;
+}
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("radix")
+	{
+		FCT_SETUP_BGN()
+		{
+			unsigned int x = 12345;
+			for (int i = 0; i < N; i++) {
+				x = x * 1664525u + 1013904223u;
+				input[i] = x;
+				finput[i] = ((int)(x >> 8) - (1 << 23)) * 1e-3f;
+			}
+			/* repeats, extremes and signed zeros */
+			input[5] = input[6] = input[700];
+			input[7] = 0;
+			input[8] = 0xffffffffu;
+			finput[3] = finput[4] = finput[900];
+			finput[10] = 0.0f;
+			finput[11] = -0.0f;
+			finput[12] = INFINITY;
+			finput[13] = -INFINITY;
+			finput[14] = -1e30f;
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("radix_sort")
+		{
+			memcpy(keys, input, sizeof(keys));
+			fct_req(radix_sort(keys, perm, N) == 0);
+			fct_chk(check_sorted(keys, input, N));
+
+			/* high digits shared, only the low passes move */
+			for (int i = 0; i < N; i++)
+				input[i] &= 0xfff;
+			memcpy(keys, input, sizeof(keys));
+			fct_req(radix_sort(keys, perm, N) == 0);
+			fct_chk(check_sorted(keys, input, N));
+
+			/* one pass moves, the sort ends in the temporary */
+			for (int i = 0; i < N; i++)
+				input[i] <<= 24;
+			memcpy(keys, input, sizeof(keys));
+			fct_req(radix_sort(keys, perm, N) == 0);
+			fct_chk(check_sorted(keys, input, N));
+
+			/* every digit shared, no pass moves anything */
+			for (int i = 0; i < N; i++)
+				keys[i] = 77;
+			fct_req(radix_sort(keys, perm, N) == 0);
+			for (int i = 0; i < N; i++)
+				fct_chk_eq_int(perm[i], i);
+			fct_chk(radix_sort(keys, perm, 0) == 0);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("radix_sortf")
+		{
+			int ok = 1;
+			memcpy(fkeys, finput, sizeof(fkeys));
+			fct_req(radix_sortf(fkeys, perm, N) == 0);
+			for (int i = 0; i < N; i++) {
+				ok &= !memcmp(&fkeys[i], &finput[perm[i]], sizeof(float));
+				if (i)
+					ok &= fkeys[i - 1] <= fkeys[i];
+			}
+			fct_chk(ok);
+			fct_chk(fkeys[0] == -INFINITY);
+			fct_chk(fkeys[1] == -1e30f);
+			fct_chk(fkeys[N - 1] == INFINITY);
+			for (int i = 1; i < N; i++)
+				if (fkeys[i] == 0.0f && fkeys[i - 1] == 0.0f)
+					fct_chk(signbit(fkeys[i - 1]) && !signbit(fkeys[i]));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("radix_sort_task")
+		{
+			static uint32_t serial[N];
+			static int sperm[N];
+			radix_sorter rs;
+
+			memcpy(serial, input, sizeof(serial));
+			fct_req(radix_sort(serial, sperm, N) == 0);
+			memcpy(fkeys, finput, sizeof(fkeys));
+			fct_req(radix_sortf_begin(&rs, fkeys, perm, N, 7) == 0);
+			do {
+				/* any order, as threads would pick them */
+				for (int t = rs.tasks - 1; t >= 0; t--)
+					radix_sort_count(&rs, t);
+				radix_sort_offsets(&rs);
+				for (int t = 0; t < rs.tasks; t++)
+					radix_sort_scatter(&rs, t);
+			} while (radix_sort_next(&rs));
+			radix_sort_end(&rs);
+			for (int i = 1; i < N; i++)
+				fct_chk(fkeys[i - 1] <= fkeys[i]);
+
+			/* more tasks than keys */
+			memcpy(keys, input, sizeof(uint32_t) * 5);
+			fct_req(radix_sort_begin(&rs, keys, perm, 5, 16) == 0);
+			do {
+				for (int t = 0; t < rs.tasks; t++)
+					radix_sort_count(&rs, t);
+				radix_sort_offsets(&rs);
+				for (int t = 0; t < rs.tasks; t++)
+					radix_sort_scatter(&rs, t);
+			} while (radix_sort_next(&rs));
+			radix_sort_end(&rs);
+			fct_chk(check_sorted(keys, input, 5));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("radix_sort64")
+		{
+			static uint64_t in64[N], k64[N];
+			radix_sorter rs;
+			int ok = 1;
+
+			/* high halves from a few values, so low digits break ties */
+			for (int i = 0; i < N; i++)
+				in64[i] = (uint64_t)(input[i] % 5) << 59 | input[N - 1 - i];
+			in64[9] = ~(uint64_t)0;
+			memcpy(k64, in64, sizeof(k64));
+			fct_req(radix_sort64_begin(&rs, k64, perm, N, 3) == 0);
+			do {
+				for (int t = rs.tasks - 1; t >= 0; t--)
+					radix_sort_count(&rs, t);
+				radix_sort_offsets(&rs);
+				for (int t = 0; t < rs.tasks; t++)
+					radix_sort_scatter(&rs, t);
+			} while (radix_sort_next(&rs));
+			radix_sort_end(&rs);
+			for (int i = 0; i < N; i++) {
+				ok &= k64[i] == in64[perm[i]];
+				if (i)
+					ok &= k64[i - 1] < k64[i] || (k64[i - 1] == k64[i] &&
+						perm[i - 1] < perm[i]);
+			}
+			fct_chk(ok);
+			fct_chk(k64[N - 1] == ~(uint64_t)0);
+			fct_req(radix_sort64(k64, perm, N) == 0);
+			for (int i = 0; i < N; i++)
+				fct_chk_eq_int(perm[i], i);
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
@@ -0,0 +1,266 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * ray.c
+ * Tests ray.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/ray.h>
+
+#define N 29
+
+/* Relative comparison, the packet kernels use a refined reciprocal. */
+#define CHK_NEAR(a, b) fct_chk(fabsf((a) - (b)) <= 1e-4f * (1.0f + fabsf(b)))
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("ray")
+	{
+		vec3 v0[N], v1[N], v2[N];
+		ray r[4];
+
+		FCT_SETUP_BGN()
+		{
+			for (int i = 0; i < N; i++) {
+				vec3 c = _mm_setr_ps(sinf(i * 2.1f), cosf(i * 1.3f),
+					-2.0f - i * 0.3f, 0.0f);
+				v0[i] = _mm_add_ps(c, _mm_setr_ps(-1.0f, -0.8f, 0.3f, 0.0f));
+				v1[i] = _mm_add_ps(c, _mm_setr_ps(1.2f, -0.5f, 0.0f, 0.0f));
+				v2[i] = _mm_add_ps(c, _mm_setr_ps(0.1f, 1.0f, -0.2f, 0.0f));
+			}
+			/* a degenerate triangle must never hit */
+			v2[5] = v1[5];
+			for (int i = 0; i < 4; i++) {
+				r[i].origin = _mm_setr_ps(0.1f * i, -0.2f, 0.5f, 0.0f);
+				r[i].dir = vec3_normalize(_mm_setr_ps(0.05f * i - 0.1f,
+					0.1f, -1.0f, 0.0f));
+			}
+			/* parallel to every triangle's plane it cannot hit */
+			r[3].dir = _mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f);
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("ray_triangle")
+		{
+			vec3 a = {0.0f, 0.0f, 0.0f, 0.0f}, b = {1.0f, 0.0f, 0.0f, 0.0f};
+			vec3 c = {0.0f, 1.0f, 0.0f, 0.0f};
+			ray s = {{0.25f, 0.5f, 2.0f, 0.0f}, {0.0f, 0.0f, -1.0f, 0.0f}};
+			float t = -1.0f, u = -1.0f, v = -1.0f;
+			int hit = ray_triangle(&s, a, b, c, 100.0f, &t, &u, &v);
+			fct_chk(hit);
+			if (hit) {
+				CHK_NEAR(t, 2.0f);
+				CHK_NEAR(u, 0.25f);
+				CHK_NEAR(v, 0.5f);
+			}
+			fct_chk(!ray_triangle(&s, a, b, c, 1.5f, &t, &u, &v));
+			s.origin = _mm_setr_ps(0.75f, 0.5f, 2.0f, 0.0f);
+			fct_chk(!ray_triangle(&s, a, b, c, 100.0f, &t, &u, &v));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("ray_tri_soa")
+		{
+			int hits = 0;
+			for (int k = 0; k < 4; k++)
+				for (int i = 0; i + 4 <= N; i += 4) {
+					tri_soa tri = tri_soa_load(v0 + i, v1 + i, v2 + i);
+					__m128 t, u, v;
+					int mask = ray_tri_soa(&r[k], &tri, 10.0f, &t, &u, &v);
+					for (int j = 0; j < 4; j++) {
+						float rt, ru, rv;
+						int hit = ray_triangle(&r[k], v0[i + j], v1[i + j],
+							v2[i + j], 10.0f, &rt, &ru, &rv);
+						fct_chk_eq_int((mask >> j) & 1, hit);
+						if (hit) {
+							CHK_NEAR(fidx(t, j), rt);
+							CHK_NEAR(fidx(u, j), ru);
+							CHK_NEAR(fidx(v, j), rv);
+						}
+						hits += hit;
+					}
+				}
+			fct_chk(hits > 0);
+		}
+		FCT_TEST_END();
+
+#ifdef __AVX__
+		FCT_TEST_BGN("ray_tri_soa8")
+		{
+			for (int k = 0; k < 4; k++)
+				for (int i = 0; i + 8 <= N; i += 8) {
+					tri_soa8 tri = tri_soa8_load(v0 + i, v1 + i, v2 + i);
+					__m256 t, u, v;
+					int mask = ray_tri_soa8(&r[k], &tri, 10.0f, &t, &u, &v);
+					for (int j = 0; j < 8; j++) {
+						float rt, ru, rv;
+						int hit = ray_triangle(&r[k], v0[i + j], v1[i + j],
+							v2[i + j], 10.0f, &rt, &ru, &rv);
+						fct_chk_eq_int((mask >> j) & 1, hit);
+						if (hit) {
+							CHK_NEAR(fidx(t, j), rt);
+							CHK_NEAR(fidx(u, j), ru);
+							CHK_NEAR(fidx(v, j), rv);
+						}
+					}
+				}
+		}
+		FCT_TEST_END();
+#endif
+
+		FCT_TEST_BGN("ray_soa_triangle")
+		{
+			ray_soa rs = ray_soa_load(r);
+			__m128 tmax = _mm_setr_ps(10.0f, 10.0f, 2.5f, 10.0f);
+			for (int i = 0; i < N; i++) {
+				__m128 t, u, v;
+				int mask = ray_soa_triangle(&rs, v0[i], v1[i], v2[i], tmax,
+					&t, &u, &v);
+				for (int k = 0; k < 4; k++) {
+					float rt, ru, rv;
+					int hit = ray_triangle(&r[k], v0[i], v1[i], v2[i],
+						fidx(tmax, k), &rt, &ru, &rv);
+					fct_chk_eq_int((mask >> k) & 1, hit);
+					if (hit)
+						CHK_NEAR(fidx(t, k), rt);
+				}
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("ray_triangles_closest")
+		{
+			for (int k = 0; k < 4; k++) {
+				float t = -1.0f, u, v, bt = 10.0f, bu, bv;
+				int best = -1;
+				for (int i = 0; i < N; i++)
+					if (ray_triangle(&r[k], v0[i], v1[i], v2[i], bt,
+							&bt, &bu, &bv))
+						best = i;
+				fct_chk_eq_int(ray_triangles_closest(&r[k], v0, v1, v2, N,
+					10.0f, &t, &u, &v), best);
+				if (best >= 0)
+					CHK_NEAR(t, bt);
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("ray_aabb")
+		{
+			aabb b = {{-1.0f, -1.0f, -1.0f, 0.0f}, {1.0f, 1.0f, 1.0f, 0.0f}};
+			ray s = {{0.5f, 0.25f, 4.0f, 0.0f}, {0.0f, 0.0f, -1.0f, 0.0f}};
+			ray_slab rs = ray_slab_init(&s);
+			float t;
+			fct_chk(ray_aabb(&rs, &b, 100.0f, &t));
+			CHK_NEAR(t, 3.0f);
+			fct_chk(!ray_aabb(&rs, &b, 2.5f, &t));
+			/* starting inside enters at zero */
+			s.origin = _mm_setr_ps(0.0f, 0.0f, 0.0f, 0.0f);
+			rs = ray_slab_init(&s);
+			fct_chk(ray_aabb(&rs, &b, 100.0f, &t));
+			CHK_NEAR(t, 0.0f);
+			/* zero direction components on a slab plane must not be NaN */
+			s.origin = _mm_setr_ps(1.0f, -1.0f, 4.0f, 0.0f);
+			rs = ray_slab_init(&s);
+			fct_chk(ray_aabb(&rs, &b, 100.0f, &t));
+			CHK_NEAR(t, 3.0f);
+			s.dir = _mm_setr_ps(-0.0f, -0.0f, -1.0f, 0.0f);
+			rs = ray_slab_init(&s);
+			fct_chk(ray_aabb(&rs, &b, 100.0f, &t));
+			s.origin = _mm_setr_ps(1.001f, 0.0f, 4.0f, 0.0f);
+			rs = ray_slab_init(&s);
+			fct_chk(!ray_aabb(&rs, &b, 100.0f, &t));
+			/* behind the origin */
+			s.origin = _mm_setr_ps(0.0f, 0.0f, -4.0f, 0.0f);
+			rs = ray_slab_init(&s);
+			fct_chk(!ray_aabb(&rs, &b, 100.0f, &t));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("ray_aabb_soa")
+		{
+			aabb b[8];
+			for (int i = 0; i < 8; i++) {
+				b[i].min = vec3_min(v0[i], vec3_min(v1[i], v2[i]));
+				b[i].max = vec3_max(v0[i], vec3_max(v1[i], v2[i]));
+			}
+			/* a flat box the axis aligned ray grazes */
+			b[6].min = _mm_setr_ps(-1.0f, -0.2f, -3.0f, 0.0f);
+			b[6].max = _mm_setr_ps(1.0f, -0.2f, -2.0f, 0.0f);
+			for (int k = 0; k < 4; k++) {
+				ray s = r[k];
+				if (k == 2)
+					s.dir = _mm_setr_ps(0.0f, 0.0f, -1.0f, 0.0f);
+				ray_slab rs = ray_slab_init(&s);
+				for (int i = 0; i < 8; i += 4) {
+					aabb_soa p = aabb_soa_load(b + i);
+					__m128 t;
+					int mask = ray_aabb_soa(&rs, &p, 10.0f, &t);
+					for (int j = 0; j < 4; j++) {
+						float rt;
+						int hit = ray_aabb(&rs, &b[i + j], 10.0f, &rt);
+						fct_chk_eq_int(((mask >> j) & 1), hit);
+						if (hit)
+							CHK_NEAR(fidx(t, j), rt);
+					}
+				}
+#ifdef __AVX__
+				aabb_soa8 p8 = aabb_soa8_load(b);
+				__m256 t8;
+				int mask8 = ray_aabb_soa8(&rs, &p8, 10.0f, &t8);
+				for (int j = 0; j < 8; j++) {
+					float rt;
+					int hit = ray_aabb(&rs, &b[j], 10.0f, &rt);
+					fct_chk_eq_int(((mask8 >> j) & 1), hit);
+					if (hit)
+						CHK_NEAR(fidx(t8, j), rt);
+				}
+#endif
+			}
+			{
+				ray s = r[0];
+				s.dir = _mm_setr_ps(0.0f, 0.0f, -1.0f, 0.0f);
+				s.origin = _mm_setr_ps(0.0f, -0.2f, 0.0f, 0.0f);
+				ray_slab rs = ray_slab_init(&s);
+				float rt;
+				fct_chk(ray_aabb(&rs, &b[6], 10.0f, &rt));
+				CHK_NEAR(rt, 2.0f);
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("ray_soa_aabb")
+		{
+			aabb b = {{-0.5f, -0.5f, -3.0f, 0.0f}, {0.5f, 0.5f, -1.0f, 0.0f}};
+			ray s[4];
+			for (int k = 0; k < 4; k++)
+				s[k] = r[k];
+			s[2].dir = _mm_setr_ps(0.0f, 0.0f, -1.0f, 0.0f);
+			ray_slab_soa p = ray_slab_soa_load(s);
+			__m128 tmax = _mm_setr_ps(10.0f, 10.0f, 1.0f, 10.0f), t;
+			int mask = ray_soa_aabb(&p, &b, tmax, &t);
+			for (int k = 0; k < 4; k++) {
+				ray_slab rs = ray_slab_init(&s[k]);
+				float rt;
+				int hit = ray_aabb(&rs, &b, fidx(tmax, k), &rt);
+				fct_chk_eq_int(((mask >> k) & 1), hit);
+				if (hit)
+					CHK_NEAR(fidx(t, k), rt);
+			}
+			fct_chk(mask & 1);
+			fct_chk(!(mask & 4));
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
@@ -0,0 +1,133 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * sap.c
+ * Tests sap.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/sap.h>
+
+#define N 500
+#define MAXPAIRS (N * N / 2)
+
+static aabb boxes[N];
+static sap_pair pairs[MAXPAIRS];
+static char hit[N][N];
+
+static void make_boxes(int frame)
+{
+	for (int i = 0; i < N; i++) {
+		float f = (float)i, t = frame * 0.05f;
+		vec3 c = _mm_setr_ps(sinf(f * 1.7f + t) * 20.0f,
+			cosf(f * 0.9f - t) * 6.0f, sinf(f * 0.31f + 1.0f) * 6.0f, 0.0f);
+		vec3 h = _mm_set1_ps(0.2f + 0.3f * (i % 4));
+		boxes[i].min = vec3_sub(c, h);
+		boxes[i].max = vec3_add(c, h);
+	}
+}
+
+/* Every pair found overlaps, appears once and the count matches. */
+static int check_pairs(int found)
+{
+	int count = 0, ok = 1;
+	memset(hit, 0, sizeof(hit));
+	for (int i = 0; i < found; i++) {
+		int a = pairs[i].a, b = pairs[i].b;
+		ok &= a < b && !hit[a][b] && aabb_overlap(boxes[a], boxes[b]);
+		hit[a][b] = 1;
+	}
+	for (int i = 0; i < N; i++)
+		for (int j = i + 1; j < N; j++)
+			count += aabb_overlap(boxes[i], boxes[j]);
+	return ok && count == found;
+}
+
+static sap s;
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("sap")
+	{
+
+		FCT_SETUP_BGN()
+		{
+			make_boxes(0);
+			fct_req(sap_init(&s, boxes, N) == 0);
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+			sap_free(&s);
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("sap_init")
+		{
+			int found;
+			fct_chk_eq_int(s.count, N);
+			/* the centres spread furthest along x */
+			fct_chk_eq_int(s.axis, 0);
+			for (int i = 1; i < N; i++)
+				fct_chk(s.lo[0][i - 1] <= s.lo[0][i]);
+			found = sap_pairs(&s, pairs, MAXPAIRS);
+			fct_chk(found > 0);
+			fct_chk(check_pairs(found));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("sap_update")
+		{
+			for (int frame = 1; frame < 40; frame++) {
+				int found, ok = 1;
+				make_boxes(frame);
+				sap_update(&s, boxes);
+				for (int i = 1; i < N; i++)
+					ok &= s.lo[0][i - 1] <= s.lo[0][i];
+				fct_chk(ok);
+				found = sap_pairs(&s, pairs, MAXPAIRS);
+				fct_chk(check_pairs(found));
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("sap_pairs_max")
+		{
+			int found = sap_pairs(&s, pairs, MAXPAIRS);
+			sap_pair first = pairs[0];
+			/* a short buffer still counts everything */
+			fct_chk_eq_int(sap_pairs(&s, pairs, 1), found);
+			fct_chk_eq_int(pairs[0].a, first.a);
+			fct_chk_eq_int(pairs[0].b, first.b);
+			fct_chk_eq_int(sap_pairs(&s, NULL, 0), found);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("sap_touching")
+		{
+			sap t;
+			aabb b[20];
+			/* a row of unit boxes sharing faces, plus a stack at the end */
+			for (int i = 0; i < 20; i++) {
+				float x = i < 10 ? (float)i : 12.0f;
+				b[i].min = _mm_setr_ps(x, 0.0f, 0.0f, 0.0f);
+				b[i].max = _mm_setr_ps(x + 1.0f, 1.0f, 1.0f, 0.0f);
+			}
+			fct_req(sap_init(&t, b, 20) == 0);
+			fct_chk_eq_int(sap_pairs(&t, pairs, MAXPAIRS), 9 + 45);
+			sap_free(&t);
+
+			fct_req(sap_init(&t, b, 0) == 0);
+			fct_chk_eq_int(sap_pairs(&t, pairs, MAXPAIRS), 0);
+			sap_update(&t, b);
+			sap_free(&t);
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
@@ -0,0 +1,131 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * skin.c
+ * Tests skin.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/quat.h>
+#include <gmath/skin.h>
+
+#ifdef DBL_EPSILON
+#undef DBL_EPSILON
+#endif
+#define DBL_EPSILON 1e-5
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("skin")
+	{
+		mat4 palette[3];
+		dquat dpalette[3];
+		vec3 pos[2], nrm[2];
+		vec4 tan[2];
+		skin_influence inf[2] = {
+			{{1, 0, 0, 0}, {1.0f, 0.0f, 0.0f, 0.0f}},
+			{{0, 2, 1, 1}, {0.25f, 0.75f, 0.0f, 0.0f}}
+		};
+
+		FCT_SETUP_BGN()
+		{
+			palette[0] = quat_to_mat4(quat_normalize(
+				_mm_setr_ps(0.3f, -0.2f, 0.5f, 1.0f)));
+			palette[0].col[3] = _mm_setr_ps(1.0f, 2.0f, 3.0f, 1.0f);
+			palette[1] = quat_to_mat4(quat_normalize(
+				_mm_setr_ps(-0.1f, 0.7f, 0.2f, 0.6f)));
+			palette[1].col[3] = _mm_setr_ps(-4.0f, 0.5f, 0.0f, 1.0f);
+			palette[2] = quat_to_mat4(quat_normalize(
+				_mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f)));
+			palette[2].col[3] = _mm_setr_ps(0.0f, -1.0f, 2.0f, 1.0f);
+			pos[0] = pos[1] = _mm_setr_ps(0.5f, 1.0f, -2.0f, 1.0f);
+			nrm[0] = nrm[1] = _mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f);
+			tan[0] = tan[1] = _mm_setr_ps(1.0f, 0.0f, 0.0f, -1.0f);
+			skin_dquat_palette(dpalette, palette, 3);
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("skin_blend_mat4")
+		{
+			mat4 m = skin_blend_mat4(palette, &inf[1]);
+			for (int i = 0; i < 4; i++)
+				for (int j = 0; j < 4; j++)
+					fct_chk_eq_dbl(fidx(m.col[i], j),
+						0.25f * fidx(palette[0].col[i], j) +
+						0.75f * fidx(palette[2].col[i], j));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("skin_lbs")
+		{
+			vec3 p[2], n[2];
+			vec4 t[2];
+			skin_lbs(p, n, t, palette, inf, pos, nrm, tan, 2);
+			vec3 rp = mat4_transform_point(palette[1], pos[0]);
+			vec3 rn = mat4_transform_normal(palette[1], nrm[0]);
+			vec3 rt = mat4_transform_normal(palette[1], tan[0]);
+			vec3 bp = vec3_add(
+				vec3_scale(mat4_transform_point(palette[0], pos[1]), 0.25f),
+				vec3_scale(mat4_transform_point(palette[2], pos[1]), 0.75f));
+			for (int j = 0; j < 3; j++) {
+				fct_chk_eq_dbl(fidx(p[0], j), fidx(rp, j));
+				fct_chk_eq_dbl(fidx(n[0], j), fidx(rn, j));
+				fct_chk_eq_dbl(fidx(t[0], j), fidx(rt, j));
+				fct_chk_eq_dbl(fidx(p[1], j), fidx(bp, j));
+			}
+			fct_chk_eq_dbl(fidx(t[0], 3), -1.0f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("skin_dqs")
+		{
+			/* enough vertices for every vector width and a tail */
+			skin_influence vi[9];
+			vec3 vp[9], vn[9], p[9], n[9];
+			vec4 vt[9], t[9];
+			for (int i = 0; i < 9; i++) {
+				for (int j = 0; j < 4; j++) {
+					vi[i].index[j] = (i + j) % 3;
+					vi[i].weight[j] = j == 3 ? 0.0f : (1.0f + i + j) /
+						(6.0f + 3.0f * i);
+				}
+				/* any input w gives positions w 1 and normals w 0 */
+				vp[i] = _mm_setr_ps(i, 1.0f - i, 0.5f * i, 0.0f);
+				vn[i] = vec3_normalize(_mm_setr_ps(1.0f, i, -1.0f, 0.0f));
+				fidx(vn[i], 3) = 1.0f;
+				vt[i] = _mm_setr_ps(0.0f, 1.0f, i, i & 1 ? 1.0f : -1.0f);
+			}
+			skin_dqs(p, n, t, dpalette, vi, vp, vn, vt, 9);
+			for (int i = 0; i < 9; i++) {
+				dquat dq = skin_blend_dquat(dpalette, &vi[i]);
+				vec3 rp = dquat_transform_point(dq, vp[i]);
+				vec3 rn = dquat_transform_normal(dq, vn[i]);
+				vec3 rt = dquat_transform_normal(dq, vt[i]);
+				for (int j = 0; j < 3; j++) {
+					fct_chk_eq_dbl(fidx(p[i], j), fidx(rp, j));
+					fct_chk_eq_dbl(fidx(n[i], j), fidx(rn, j));
+					fct_chk_eq_dbl(fidx(t[i], j), fidx(rt, j));
+				}
+				fct_chk_eq_dbl(fidx(p[i], 3), 1.0f);
+				fct_chk_eq_dbl(fidx(n[i], 3), 0.0f);
+				fct_chk_eq_dbl(fidx(t[i], 3), fidx(vt[i], 3));
+			}
+			/* a single influence reproduces the rigid transform */
+			skin_dqs(p, NULL, NULL, dpalette, inf, pos, NULL, NULL, 1);
+			vec3 rp = mat4_transform_point(palette[1], pos[0]);
+			for (int j = 0; j < 3; j++)
+				fct_chk_eq_dbl(fidx(p[0], j), fidx(rp, j));
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
@@ -0,0 +1,251 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * svd.c
+ * Tests svd.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/svd.h>
+
+#define N 1000
+#define TOL 2e-5f
+
+static float randf(unsigned int *seed)
+{
+	*seed = *seed * 1664525u + 1013904223u;
+	return (*seed >> 8) / (float)(1 << 24);
+}
+
+static void random_mat3(unsigned int *seed, float a[3][3], float scale)
+{
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+			a[r][c] = (randf(seed) * 2.0f - 1.0f) * scale;
+}
+
+static float norm3(const float a[3][3])
+{
+	float f = 0.0f;
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+			f += a[r][c] * a[r][c];
+	return sqrtf(f);
+}
+
+static float det3(const float a[3][3])
+{
+	return a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) -
+		a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) +
+		a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+}
+
+/* Largest entry of r^T r - I, and the determinant in *d. */
+static float rotation_error(const float r[3][3], float *d)
+{
+	float e = 0.0f;
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++) {
+			float t = r[0][i] * r[0][j] + r[1][i] * r[1][j] +
+				r[2][i] * r[2][j];
+			e = fmaxf(e, fabsf(t - (i == j ? 1.0f : 0.0f)));
+		}
+	*d = det3(r);
+	return e;
+}
+
+/* Largest entry of u diag(s) v^T - a over the norm of a. */
+static float svd_error(const float u[3][3], const float s[3],
+		const float v[3][3], const float a[3][3])
+{
+	float e = 0.0f, n = fmaxf(norm3(a), FLT_MIN);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++) {
+			float t = u[i][0] * s[0] * v[j][0] + u[i][1] * s[1] * v[j][1] +
+				u[i][2] * s[2] * v[j][2];
+			e = fmaxf(e, fabsf(t - a[i][j]) / n);
+		}
+	return e;
+}
+
+/* Whether svd3 of a reconstructs it with rotations and ordered values. */
+static int check_svd(const float a[3][3])
+{
+	float u[3][3], s[3], v[3][3], du, dv, n = norm3(a);
+	int ok;
+	svd3(u, s, v, a);
+	ok = svd_error(u, s, v, a) < TOL;
+	ok &= rotation_error(u, &du) < TOL && rotation_error(v, &dv) < TOL;
+	ok &= du > 0.0f && dv > 0.0f;
+	ok &= s[0] >= 0.0f && s[1] >= 0.0f;
+	ok &= s[0] >= s[1] && s[1] >= fabsf(s[2]) * (1.0f - TOL);
+	/* the sign of the determinant ends up on the smallest value */
+	if (fabsf(det3(a)) > 1e-3f * n * n * n)
+		ok &= (s[2] < 0.0f) == (det3(a) < 0.0f);
+	return ok;
+}
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("svd")
+	{
+		FCT_SETUP_BGN()
+		{
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("eig3_sym")
+		{
+			unsigned int seed = 7;
+			for (int i = 0; i < N; i++) {
+				float a[3][3], v[3][3], l[3], d;
+				random_mat3(&seed, a, i & 1 ? 1e3f : 1e-3f);
+				for (int r = 0; r < 3; r++)
+					for (int c = 0; c < r; c++)
+						a[r][c] = a[c][r];
+				eig3_sym(v, l, a);
+				fct_chk(rotation_error(v, &d) < TOL);
+				fct_chk(d > 0.0f);
+				fct_chk(l[0] >= l[1] && l[1] >= l[2]);
+				/* a v_k = l_k v_k */
+				for (int k = 0; k < 3; k++)
+					for (int r = 0; r < 3; r++) {
+						float t = a[r][0] * v[0][k] + a[r][1] * v[1][k] +
+							a[r][2] * v[2][k];
+						fct_chk(fabsf(t - l[k] * v[r][k]) <
+							TOL * norm3(a));
+					}
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("eig3_sym_degenerate")
+		{
+			float a[3][3] = {{2.0f, 0.0f, 0.0f}, {0.0f, 5.0f, 0.0f},
+				{0.0f, 0.0f, -1.0f}};
+			float z[3][3] = {{0.0f}}, v[3][3], l[3], d;
+			eig3_sym(v, l, a);
+			fct_chk(fabsf(l[0] - 5.0f) < 1e-5f);
+			fct_chk(fabsf(l[1] - 2.0f) < 1e-5f);
+			fct_chk(fabsf(l[2] + 1.0f) < 1e-5f);
+			fct_chk(fabsf(fabsf(v[1][0]) - 1.0f) < 1e-5f);
+
+			/* repeated and zero eigenvalues */
+			a[0][0] = a[1][1] = a[2][2] = 3.0f;
+			eig3_sym(v, l, a);
+			fct_chk(fabsf(l[0] - 3.0f) < 1e-5f && fabsf(l[2] - 3.0f) < 1e-5f);
+			fct_chk(rotation_error(v, &d) < TOL && d > 0.0f);
+			eig3_sym(v, l, (const float (*)[3])z);
+			fct_chk(l[0] == 0.0f && l[2] == 0.0f);
+			fct_chk(rotation_error(v, &d) < TOL && d > 0.0f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("svd3")
+		{
+			unsigned int seed = 11;
+			static const float scale[4] = {1.0f, 1e-20f, 1e15f, 3.0f};
+			for (int i = 0; i < N; i++) {
+				float a[3][3];
+				random_mat3(&seed, a, scale[i & 3]);
+				fct_chk(check_svd(a));
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("svd3_degenerate")
+		{
+			float a[3][3] = {{1.0f, 2.0f, 3.0f}, {2.0f, 4.0f, 6.0f},
+				{-1.0f, -2.0f, -3.0f}};
+			float z[3][3] = {{0.0f}}, u[3][3], s[3], v[3][3], d;
+			float m[3][3] = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f},
+				{0.0f, 0.0f, -1.0f}};
+
+			/* rank one */
+			fct_chk(check_svd(a));
+			svd3(u, s, v, a);
+			fct_chk(fabsf(s[0] - sqrtf(14.0f * 6.0f)) < 1e-4f);
+			fct_chk(fabsf(s[1]) < 1e-4f && fabsf(s[2]) < 1e-4f);
+
+			/* rank two, a reflection, and nothing at all */
+			a[2][0] = 0.5f;
+			fct_chk(check_svd(a));
+			fct_chk(check_svd(m));
+			svd3(u, s, v, m);
+			fct_chk(fabsf(s[2] + 1.0f) < 1e-5f);
+			svd3(u, s, v, (const float (*)[3])z);
+			fct_chk(s[0] == 0.0f && s[1] == 0.0f && s[2] == 0.0f);
+			fct_chk(rotation_error(u, &d) < TOL && d > 0.0f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("polar3")
+		{
+			unsigned int seed = 13;
+			for (int i = 0; i < N; i++) {
+				float a[3][3], r[3][3], d;
+				random_mat3(&seed, a, 2.0f);
+				polar3(r, a);
+				fct_chk(rotation_error(r, &d) < TOL && d > 0.0f);
+				/* r^T a is the symmetric stretch when a keeps handedness */
+				if (det3(a) > 0.1f)
+					for (int p = 0; p < 3; p++)
+						for (int q = 0; q < p; q++) {
+							float pq = r[0][p] * a[0][q] + r[1][p] * a[1][q] +
+								r[2][p] * a[2][q];
+							float qp = r[0][q] * a[0][p] + r[1][q] * a[1][p] +
+								r[2][q] * a[2][p];
+							fct_chk(fabsf(pq - qp) < 1e-4f);
+						}
+			}
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("svd3_array")
+		{
+			unsigned int seed = 17;
+			static float a[23][3][3], u[23][3][3], v[23][3][3], s[23][3];
+			static float r[23][3][3], l[23][3];
+			float su[3][3], ss[3], sv[3][3], sr[3][3];
+			for (int i = 0; i < 23; i++)
+				random_mat3(&seed, a[i], 1.0f);
+			svd3_array(u, s, v, (const float (*)[3][3])a, 23);
+			polar3_array(r, (const float (*)[3][3])a, 23);
+			for (int i = 0; i < 23; i++) {
+				svd3(su, ss, sv, a[i]);
+				polar3(sr, a[i]);
+				for (int k = 0; k < 3; k++) {
+					fct_chk(fabsf(s[i][k] - ss[k]) < 1e-5f);
+					for (int j = 0; j < 3; j++) {
+						fct_chk(fabsf(u[i][k][j] - su[k][j]) < 1e-4f);
+						fct_chk(fabsf(v[i][k][j] - sv[k][j]) < 1e-4f);
+						fct_chk(fabsf(r[i][k][j] - sr[k][j]) < 1e-4f);
+					}
+				}
+			}
+
+			/* symmetric parts through the eigen array */
+			for (int i = 0; i < 23; i++)
+				for (int p = 0; p < 3; p++)
+					for (int q = 0; q < p; q++)
+						a[i][p][q] = a[i][q][p];
+			eig3_sym_array(v, l, (const float (*)[3][3])a, 23);
+			for (int i = 0; i < 23; i++) {
+				eig3_sym(sv, ss, a[i]);
+				for (int k = 0; k < 3; k++)
+					fct_chk(fabsf(l[i][k] - ss[k]) < 1e-5f);
+			}
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();
@@ -124,6 +124,22 @@ FCT_BGN()
 		}
 		FCT_TEST_END();
 
+		FCT_TEST_BGN("vec3_dot")
+		{
+			vec3 v1 = {1.0f, 2.0f, 3.0f, 5.0f};
+			vec3 v2 = {3.0f, 2.0f, 1.0f, 7.0f};
+			fct_chk_eq_dbl(vec3_dot(v1, v2), 10.0f);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("vec4_dot")
+		{
+			vec4 v1 = {1.0f, 2.0f, 3.0f, 5.0f};
+			vec4 v2 = {3.0f, 2.0f, 1.0f, 7.0f};
+			fct_chk_eq_dbl(vec4_dot(v1, v2), 45.0f);
+		}
+		FCT_TEST_END();
+
 		FCT_TEST_BGN("vec3_cross")
 		{
 			vec3 v1 = {1.0f, 2.0f, 3.0f};
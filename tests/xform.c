@@ -0,0 +1,141 @@
+/**
+ * gmath
+ * (C) 2009 Tai Chi Minh Ralph Eastwood
+ * Released under the MIT license.
+ *
+ * xform.c
+ * Tests xform.h
+ *
+ */
+
+#include "fct.h"
+#include <gmath/xform.h>
+
+#ifdef DBL_EPSILON
+#undef DBL_EPSILON
+#endif
+#define DBL_EPSILON 1e-4
+
+#define N 11
+
+/* Reference world transform by walking up the parents. */
+static mat4 world_of(const int *parent, const mat4 *local, int i)
+{
+	mat4 m = local[i];
+	for (int p = parent[i]; p >= 0; p = parent[p])
+		m = mat4_mul(local[p], m);
+	return m;
+}
+
+static mat4 make_local(int i)
+{
+	mat4 m = mat4_from_angles(0.1f * i, 0.2f - 0.05f * i, 0.3f);
+	m.col[3] = _mm_setr_ps(i, 1.0f, -0.5f * i, 1.0f);
+	return m;
+}
+
+static xform_tree tree;
+
+FCT_BGN()
+{
+	FCT_FIXTURE_SUITE_BGN("xform")
+	{
+		/* two roots, input order deliberately not breadth first */
+		int parent[N] = {5, 0, -1, 1, 0, 2, -1, 3, 6, 5, 8};
+		int remap[N];
+		mat4 local[N];
+
+		FCT_SETUP_BGN()
+		{
+			fct_req(xform_tree_init(&tree, parent, N, remap) == 0);
+			for (int i = 0; i < N; i++) {
+				local[i] = make_local(i);
+				xform_set_local(&tree, remap[i], local[i]);
+			}
+		}
+		FCT_SETUP_END();
+
+		FCT_TEARDOWN_BGN()
+		{
+			xform_tree_free(&tree);
+		}
+		FCT_TEARDOWN_END();
+
+		FCT_TEST_BGN("xform_tree_init")
+		{
+			int cyclic[3] = {1, 2, 1}, range[3] = {-1, 0, 3};
+			xform_tree bad;
+			fct_chk_eq_int(tree.levels, 6);
+			fct_chk_eq_int(tree.level[1], 2);
+			for (int i = 0; i < N; i++)
+				fct_chk(tree.parent[i] < i);
+			for (int i = 0; i < N; i++)
+				fct_chk_eq_int(tree.parent[remap[i]],
+					parent[i] < 0 ? -1 : remap[parent[i]]);
+			fct_chk(xform_tree_init(&bad, cyclic, 3, NULL) == -1);
+			fct_chk(xform_tree_init(&bad, range, 3, NULL) == -1);
+			fct_req(xform_tree_init(&bad, range, 0, NULL) == 0);
+			fct_chk_eq_int(bad.levels, 0);
+			xform_tree_update(&bad);
+			xform_tree_free(&bad);
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("xform_tree_update")
+		{
+			mat4 before[N];
+			xform_tree_update(&tree);
+			for (int i = 0; i < N; i++) {
+				mat4 m = world_of(parent, local, i);
+				for (int c = 0; c < 4; c++)
+					for (int j = 0; j < 4; j++)
+						fct_chk_eq_dbl(fidx(tree.world[remap[i]].col[c], j),
+							fidx(m.col[c], j));
+				before[i] = tree.world[remap[i]];
+			}
+
+			/*
+			 * only the subtree of node 5 (5, 0, 9, 1, 4, 3, 7) moves,
+			 * a clobbered clean node stays untouched
+			 */
+			local[5] = make_local(20);
+			xform_set_local(&tree, remap[5], local[5]);
+			memset(&tree.world[remap[8]], 0, sizeof(mat4));
+			xform_tree_update(&tree);
+			for (int i = 0; i < N; i++) {
+				mat4 m = world_of(parent, local, i);
+				if (i == 8) {
+					fct_chk_eq_dbl(fidx(tree.world[remap[i]].col[0], 0), 0.0f);
+					continue;
+				}
+				for (int c = 0; c < 4; c++)
+					for (int j = 0; j < 4; j++)
+						fct_chk_eq_dbl(fidx(tree.world[remap[i]].col[c], j),
+							fidx(m.col[c], j));
+				fct_chk_eq_int(tree.dirty[remap[i]], 0);
+			}
+			fct_chk_eq_dbl(fidx(tree.world[remap[6]].col[3], 0),
+				fidx(before[6].col[3], 0));
+		}
+		FCT_TEST_END();
+
+		FCT_TEST_BGN("xform_update_range")
+		{
+			/* split each level into single node ranges, as threads would */
+			for (int l = 0; l < tree.levels; l++)
+				for (int i = tree.level[l + 1] - 1; i >= tree.level[l]; i--)
+					xform_update_range(&tree, i, i + 1);
+			xform_tree_clean(&tree);
+			for (int i = 0; i < N; i++) {
+				mat4 m = world_of(parent, local, i);
+				for (int c = 0; c < 4; c++)
+					for (int j = 0; j < 4; j++)
+						fct_chk_eq_dbl(fidx(tree.world[remap[i]].col[c], j),
+							fidx(m.col[c], j));
+			}
+		}
+		FCT_TEST_END();
+	}
+	FCT_FIXTURE_SUITE_END();
+}
+FCT_END();